@@ -4,6 +4,7 @@
  */
 
 #include "ConnectServer/Managers/ServerListManager.h"
+#include "ConnectServer/Packets/PocketDef.h"
 
 #include <cstddef>
 #include <filesystem>
@@ -33,6 +34,7 @@ void ServerListManager::Load() {
 
 bool ServerListManager::LoadFromFile(const std::string& filename) {
     servers_.clear();
+    version_.fetch_add(1, std::memory_order_relaxed);
 
     std::filesystem::path path(filename);
     std::ifstream input(path);
@@ -185,6 +187,7 @@ bool ServerListManager::LoadFromFile(const std::string& filename) {
         servers_.push_back(std::move(info));
         ++index;
     }
+    version_.fetch_add(1, std::memory_order_relaxed);
 
     if (servers_.empty()) {
         std::cerr << "ServerListManager: no valid server entries loaded from " << path << '\n';
@@ -204,9 +207,19 @@ void ServerListManager::AddServer(uint16_t code, std::string name, std::string i
     info.Port = port;
     info.Visible = visible;
     servers_.push_back(std::move(info));
+    version_.fetch_add(1, std::memory_order_relaxed);
 }
 
 void ServerListManager::GetPacket(std::vector<uint8_t>& buffer) const {
+    PacketWriter<kServerListInlineSize> writer;
+    WritePacket(writer);
+    const std::span<const uint8_t> packet = writer.finish();
+    buffer.assign(packet.begin(), packet.end());
+}
+
+template <typename Protocol>
+void ServerListManager::WritePacket(PacketWriterBase& writer) const {
+    using Packets = ConnectPackets<Protocol>;
     // Packet layout: C2 <size:2> F4 06 <count:2> followed by entries.
     uint16_t count = 0;
     for (const auto& server : servers_) {
@@ -215,30 +228,17 @@ void ServerListManager::GetPacket(std::vector<uint8_t>& buffer) const {
         }
     }
 
-    const uint16_t size = static_cast<uint16_t>(7 + (count * 4));
-
-    buffer.clear();
-    buffer.reserve(size);
-
-    buffer.push_back(0xC2);
-    buffer.push_back(static_cast<uint8_t>((size >> 8) & 0xFF));
-    buffer.push_back(static_cast<uint8_t>(size & 0xFF));
-    buffer.push_back(0xF4);
-    buffer.push_back(0x06);
-    buffer.push_back(static_cast<uint8_t>((count >> 8) & 0xFF));
-    buffer.push_back(static_cast<uint8_t>(count & 0xFF));
-
+    writer.begin<typename Packets::ServerListResponse>().count = count;
     for (const auto& server : servers_) {
-        if (!server.Visible) {
-            continue;
+        if (server.Visible) {
+            writer.writeStruct(typename Packets::ServerListEntry{server.ServerCode, server.UserTotal, server.ListType});
         }
-        buffer.push_back(static_cast<uint8_t>(server.ServerCode & 0xFF));
-        buffer.push_back(static_cast<uint8_t>((server.ServerCode >> 8) & 0xFF));
-        buffer.push_back(server.UserTotal);
-        buffer.push_back(server.ListType);
     }
 }
 
+template void ServerListManager::WritePacket<Season6Protocol>(PacketWriterBase&) const;
+template void ServerListManager::WritePacket<Season9Protocol>(PacketWriterBase&) const;
+
 const GameServerInfo* ServerListManager::FindByCode(uint16_t serverCode) const {
     // Linear search is sufficient for the small server list size.
     for (const auto& server : servers_) {
@@ -248,3 +248,7 @@ const GameServerInfo* ServerListManager::FindByCode(uint16_t serverCode) const {
     }
     return nullptr;
 }
+
+uint64_t ServerListManager::Version() const noexcept {
+    return version_.load(std::memory_order_relaxed);
+}
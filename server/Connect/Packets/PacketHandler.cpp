@@ -5,13 +5,34 @@
 #include "ConnectServer/Packets/PacketHandler.h"
 
 #include <algorithm>
-#include <array>
 #include <cerrno>
 #include <cstring>
 #include <iostream>
-#include <vector>
 
 #include "ConnectServer/Managers/ServerListManager.h"
+#include "ConnectServer/Packets/PocketDef.h"
+
+#include "Common/Network/DispatchTable.h"
+#include "Common/Network/PacketFramer.h"
+#include "Common/Network/PacketWriter.h"
+#include "Common/Utils/Tracer.h"
+
+namespace {
+
+// ConnectServer sessions have a single state: connected, waiting for one request.
+constexpr uint8_t kConnectedState = 0x01;
+
+} // namespace
+
+template <typename Protocol>
+struct PacketHandler::Routes {
+    using Packets = ConnectPackets<Protocol>;
+    using Table = DispatchTable<PacketHandler, Socket, BasicPacketFramer<typename Protocol::Frames>,
+                                PacketRoute<typename Packets::ServerListRequest,
+                                            &PacketHandler::HandleServerList<Protocol>, kConnectedState>,
+                                PacketRoute<typename Packets::ServerInfoRequest,
+                                            &PacketHandler::HandleServerInfo<Protocol>, kConnectedState>>;
+};
 
 PacketHandler* PacketHandler::Instance() {
     // Function-local static keeps initialization thread-safe since C++11.
@@ -19,86 +40,85 @@ PacketHandler* PacketHandler::Instance() {
     return &instance;
 }
 
+PacketHandler::PacketHandler() :
+    packets_handled_(MetricsRegistry::Instance()->counter("darkemu_connect_packets_handled_total",
+                                                          "ConnectServer packets routed to a handler.")),
+    packets_dropped_(MetricsRegistry::Instance()->counter("darkemu_connect_packets_dropped_total",
+                                                          "ConnectServer packets rejected before dispatch.")),
+    bytes_sent_(MetricsRegistry::Instance()->counter("darkemu_connect_bytes_sent_total",
+                                                     "Response bytes written to ConnectServer clients.")) {}
+
+template <typename Protocol>
 void PacketHandler::HandlePacket(Socket& client, std::span<const uint8_t> packet) {
+    DARKEMU_TRACE_SPAN("dispatch", packet.size() >= 4 ? packet[3] : -1);
     // Require a minimal header before parsing.
     if (packet.size() < 4) {
+        packets_dropped_.inc();
         return;
     }
 
     // Only handle standard C1 packets for now.
-    if (packet[0] != 0xC1) {
+    if (packet[0] != Protocol::Frames::kC1) {
+        packets_dropped_.inc();
         return;
     }
 
-    // Dispatch only ConnectServer (F4) packets.
-    if (packet[2] != 0xF4) {
-        return;
-    }
-
-    // Switch on the subtype byte.
-    switch (packet[3]) {
-        case 0x06:
-            HandleServerList(client);
-            break;
-        case 0x03:
-            HandleServerInfo(client, packet);
-            break;
-        default:
-            break;
+    // One table lookup validates length and routes to the handler; there is no rate limiting here.
+    const DispatchStatus status =
+        Routes<Protocol>::Table::dispatch(*this, client, packet, kConnectedState, [](uint8_t) { return true; });
+    if (status == DispatchStatus::Dispatched) {
+        packets_handled_.inc();
+    } else {
+        packets_dropped_.inc();
     }
 }
 
-void PacketHandler::HandleServerList(Socket& client) {
-    // Build the server list response from the current manager data.
-    std::vector<uint8_t> response;
-    ServerListManager::Instance()->GetPacket(response);
-    SendPacket(client, response);
+template <typename Protocol>
+void PacketHandler::HandleServerList(Socket& client, std::span<const uint8_t>) {
+    DARKEMU_TRACE_SPAN("handler.server_list");
+    // Build the server list response on the stack from the current manager data.
+    PacketWriter<kServerListInlineSize> writer;
+    ServerListManager::Instance()->WritePacket<Protocol>(writer);
+    SendPacket(client, writer.finish());
 }
 
+template <typename Protocol>
 void PacketHandler::HandleServerInfo(Socket& client, std::span<const uint8_t> packet) {
-    // Ensure the packet contains the 2-byte server id.
-    if (packet.size() < 6) {
+    using Packets = ConnectPackets<Protocol>;
+    DARKEMU_TRACE_SPAN("handler.server_info");
+    // The dispatch table has already checked the opcode and length.
+    const auto* request = viewPacket<typename Packets::ServerInfoRequest>(packet);
+    if (request == nullptr) {
         return;
     }
 
-    // Extract server id as little-endian (low byte first).
-    uint16_t server_id = static_cast<uint16_t>(packet[4])
-        | (static_cast<uint16_t>(packet[5]) << 8);
-
     // Look up the requested server in the server list manager.
-    const GameServerInfo* info = ServerListManager::Instance()->FindByCode(server_id);
+    const GameServerInfo* info = ServerListManager::Instance()->FindByCode(request->server_code);
     if (info == nullptr) {
         return;
     }
 
-    // Build response: C1 <size> F4 03 [IP:16 bytes] [Port:2 bytes].
-    std::vector<uint8_t> response;
-    response.reserve(4 + 16 + 2);
-    response.push_back(0xC1);
-    response.push_back(static_cast<uint8_t>(4 + 16 + 2));
-    response.push_back(0xF4);
-    response.push_back(0x03);
-
-    // Write a null-terminated IP string, padded to 16 bytes.
-    std::array<uint8_t, 16> ip_bytes{};
-    const size_t copy_len = std::min(info->IP.size(), ip_bytes.size() - 1);
-    std::memcpy(ip_bytes.data(), info->IP.data(), copy_len);
-    response.insert(response.end(), ip_bytes.begin(), ip_bytes.end());
-
-    // Append the port as little-endian (low byte first).
-    response.push_back(static_cast<uint8_t>(info->Port & 0xFF));
-    response.push_back(static_cast<uint8_t>((info->Port >> 8) & 0xFF));
-
-    SendPacket(client, response);
+    // Build the response in place; the IP string stays NUL-terminated within its 16 bytes.
+    PacketWriter<sizeof(typename Packets::ServerInfoResponse)> writer;
+    auto& response = writer.template begin<typename Packets::ServerInfoResponse>();
+    std::memcpy(response.ip, info->IP.data(), std::min(info->IP.size(), sizeof(response.ip) - 1));
+    response.port = info->Port;
+
+    SendPacket(client, writer.finish());
 }
 
+template void PacketHandler::HandlePacket<Season6Protocol>(Socket&, std::span<const uint8_t>);
+template void PacketHandler::HandlePacket<Season9Protocol>(Socket&, std::span<const uint8_t>);
+
 void PacketHandler::SendPacket(Socket& client, std::span<const uint8_t> payload) {
+    DARKEMU_TRACE_SPAN("send", static_cast<int64_t>(payload.size()));
     // Send the payload, handling partial writes on non-blocking sockets.
     size_t offset = 0;
     while (offset < payload.size()) {
         ssize_t sent = client.send(payload.subspan(offset));
         if (sent > 0) {
             offset += static_cast<size_t>(sent);
+            bytes_sent_.inc(static_cast<uint64_t>(sent));
             continue;
         }
         if (sent == 0) {
@@ -8,17 +8,37 @@
 #include "ConnectServer/Managers/ServerListManager.h"
 #include "ConnectServer/Packets/PacketHandler.h"
 
+#include "Common/Network/PacketFramer.h"
+#include "Common/Utils/Tracer.h"
+
 #include <algorithm>
 #include <array>
 #include <arpa/inet.h>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include <netinet/in.h>
 #include <span>
 #include <sys/socket.h>
 
-ServerEngine::ServerEngine(uint16_t port) : events_(64), port_(port) {
+ServerEngine::ServerEngine(uint16_t port, ProtocolVersion protocol) :
+    events_(64),
+    port_(port),
+    metrics_{MetricsRegistry::Instance()->counter("darkemu_connect_connections_accepted_total",
+                                                  "Client connections accepted by the ConnectServer."),
+             MetricsRegistry::Instance()->gauge("darkemu_connect_connections_active",
+                                                "Client connections currently open on the ConnectServer."),
+             MetricsRegistry::Instance()->counter("darkemu_connect_bytes_received_total",
+                                                  "Bytes received from ConnectServer clients."),
+             MetricsRegistry::Instance()->histogram("darkemu_connect_request_duration_seconds",
+                                                    "Time from first read to response sent.", 1e-6)},
+    monitor_("darkemu_connect_loop", "ConnectServer"),
+    protocol_(protocol) {
+    // Pick the protocol's framer and dispatch table once; requests never branch on the version.
+    withProtocol(protocol_, [this]<typename Protocol>(Protocol) {
+        handle_frame_ = &ServerEngine::handleFrame<Protocol>;
+    });
     // Create and configure the listening socket.
     listen_socket_ = Socket::createTcp();
     listen_socket_.setNonBlocking(true);
@@ -36,42 +56,29 @@ ServerEngine::ServerEngine(uint16_t port) : events_(64), port_(port) {
 
     // Load server list data at startup.
     ServerListManager::Instance()->Load();
+    MetricsRegistry::Instance()->gaugeFunction("darkemu_connect_serverlist_version",
+                                               "Version of the server list snapshot being served.",
+                                               [] { return static_cast<double>(ServerListManager::Instance()->Version()); });
 }
 
 void ServerEngine::run() {
     // Main event loop: wait for epoll events and dispatch them.
     std::cout << "ConnectServer listening on port " << port_ << '\n';
+    Tracer::Instance()->setThreadName("ConnectServer reactor");
+    // While capturing, wake up at least once per flush interval so an idle server still writes its tail.
+    const int timeout = recorder_ ? static_cast<int>(SessionRecorder::kFlushInterval.count()) : -1;
     while (true) {
-        int ready = epoll_.wait(events_, -1);
-        for (int i = 0; i < ready; ++i) {
-            const epoll_event& ev = events_[i];
-            int fd = ev.data.fd;
-            if (fd == listen_socket_.fd()) {
-                // Accept new connections from the listening socket.
-                if (ev.events & EPOLLIN) {
-                    handleAccept();
-                }
-                continue;
-            }
-            // Close clients on error or hang-up events.
-            if (ev.events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
-                closeClient(fd);
-                continue;
-            }
-            // Read available data from connected clients.
-            if (ev.events & EPOLLIN) {
-                handleRead(fd);
-            }
-        }
+        runOnce(timeout);
     }
 }
 
 void ServerEngine::runOnce(int timeoutMs) {
     // Single iteration of the event loop (useful for tests).
-    int ready = epoll_.wait(events_, timeoutMs);
+    int ready = monitor_.wait(epoll_, events_, timeoutMs);
     for (int i = 0; i < ready; ++i) {
         const epoll_event& ev = events_[i];
         int fd = ev.data.fd;
+        LoopMonitor::HandlerScope scope(monitor_, fd);
         if (fd == listen_socket_.fd()) {
             // Accept new connections from the listening socket.
             if (ev.events & EPOLLIN) {
@@ -79,6 +86,11 @@ void ServerEngine::runOnce(int timeoutMs) {
             }
             continue;
         }
+        // Status endpoint sockets share this reactor but never touch game clients.
+        if (status_ && status_->owns(fd)) {
+            status_->handleEvent(fd, ev.events);
+            continue;
+        }
         // Close clients on error or hang-up events.
         if (ev.events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
             closeClient(fd);
@@ -89,12 +101,44 @@ void ServerEngine::runOnce(int timeoutMs) {
             handleRead(fd);
         }
     }
+    if (recorder_) {
+        recorder_->flushIfDue();
+    }
+    monitor_.endIteration();
 }
 
 uint16_t ServerEngine::port() const noexcept {
     return port_;
 }
 
+ProtocolVersion ServerEngine::protocol() const noexcept {
+    return protocol_;
+}
+
+void ServerEngine::enableStatusEndpoint(uint16_t port) {
+    // Bind the metrics port on this reactor; rendering runs on its own thread.
+    status_ = std::make_unique<StatusServer>(epoll_, port);
+    std::cout << "ConnectServer status endpoint on port " << status_->port() << '\n';
+}
+
+uint16_t ServerEngine::statusPort() const noexcept {
+    return status_ ? status_->port() : 0;
+}
+
+void ServerEngine::setHandlerBudget(std::chrono::microseconds budget) noexcept {
+    monitor_.setHandlerBudget(budget);
+}
+
+const LoopMonitor& ServerEngine::loopMonitor() const noexcept {
+    return monitor_;
+}
+
+void ServerEngine::enableCapture(const std::string& path) {
+    // Sessions accepted from now on are recorded; open ones are not back-filled.
+    recorder_ = std::make_unique<SessionRecorder>(path);
+    std::cout << "ConnectServer capturing sessions to " << path << '\n';
+}
+
 void ServerEngine::handleAccept() {
     // Drain all pending accept calls until the listen socket would block.
     while (true) {
@@ -106,7 +150,10 @@ void ServerEngine::handleAccept() {
         int fd = client.fd();
         // Register the new client for read and hang-up events.
         epoll_.add(fd, EPOLLIN | EPOLLRDHUP);
-        clients_.emplace(fd, ClientState{std::move(client), {}});
+        const uint32_t capture_id = recorder_ ? recorder_->open() : 0;
+        clients_.emplace(fd, ClientState{std::move(client), {}, capture_id});
+        metrics_.accepted.inc();
+        metrics_.active.add(1);
     }
 }
 
@@ -128,34 +175,64 @@ void ServerEngine::handleRead(int fd) {
     }
 
     ClientState& client = it->second;
+    const auto started = std::chrono::steady_clock::now();
     std::array<uint8_t, 512> temp{};
-    // Read until the socket would block or closes.
-    while (true) {
-        ssize_t bytes = client.socket.recv(temp);
-        if (bytes > 0) {
-            client.buffer.insert(client.buffer.end(), temp.begin(), temp.begin() + static_cast<size_t>(bytes));
-            continue;
-        }
-        if (bytes == 0) {
-            // Peer closed the connection.
+    {
+        DARKEMU_TRACE_SPAN("recv", fd);
+        // Read until the socket would block or closes.
+        while (true) {
+            ssize_t bytes = client.socket.recv(temp);
+            if (bytes > 0) {
+                client.buffer.insert(client.buffer.end(), temp.begin(), temp.begin() + static_cast<size_t>(bytes));
+                metrics_.bytes_received.inc(static_cast<uint64_t>(bytes));
+                continue;
+            }
+            if (bytes == 0) {
+                // Peer closed the connection.
+                closeClient(fd);
+                return;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            std::cerr << "recv error: " << std::strerror(errno) << '\n';
             closeClient(fd);
             return;
         }
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            break;
-        }
-        std::cerr << "recv error: " << std::strerror(errno) << '\n';
-        closeClient(fd);
-        return;
     }
 
-    // Wait for at least a minimal header before parsing.
-    if (client.buffer.size() < 3) {
+    (this->*handle_frame_)(fd, client, started);
+}
+
+template <typename Protocol>
+void ServerEngine::handleFrame(int fd, ClientState& client, std::chrono::steady_clock::time_point started) {
+    using Framer = BasicPacketFramer<typename Protocol::Frames>;
+    // Wait for a complete frame before parsing; malformed headers end the session.
+    size_t frame_size = 0;
+    typename Framer::Status status;
+    {
+        DARKEMU_TRACE_SPAN("frame", fd);
+        status = Framer::peek(client.buffer, frame_size);
+    }
+    if (status == Framer::Status::Incomplete) {
+        return;
+    }
+    if (status == Framer::Status::Invalid) {
+        closeClient(fd);
         return;
     }
 
     // Dispatch the packet to the central handler (server list, server info, etc.).
-    PacketHandler::Instance()->HandlePacket(client.socket, client.buffer);
+    const std::span<const uint8_t> frame(client.buffer.data(), frame_size);
+    if (frame.size() >= 4) {
+        monitor_.noteOpcode((frame[2] << 8) | frame[3]);
+    }
+    if (recorder_) {
+        recorder_->clientData(client.capture_id, frame);
+    }
+    PacketHandler::Instance()->HandlePacket<Protocol>(client.socket, frame);
+    metrics_.request_time.observe(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count()));
     // Close the client after responding (ConnectServer behavior).
     closeClient(fd);
 }
@@ -163,5 +240,13 @@ void ServerEngine::handleRead(int fd) {
 void ServerEngine::closeClient(int fd) {
     // Remove from epoll and erase from the connection map.
     epoll_.remove(fd);
-    clients_.erase(fd);
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+    if (recorder_) {
+        recorder_->close(it->second.capture_id);
+    }
+    clients_.erase(it);
+    metrics_.active.add(-1);
 }
@@ -5,14 +5,34 @@
 
 #include "ConnectServer/ServerEngine.h"
 
+#include <chrono>
+#include <cstdlib>
 #include <exception>
 #include <iostream>
 #include <memory>
+#include <string>
 
 int main() {
     try {
+        // Client build to serve, e.g. DARKEMU_CS_PROTOCOL=season9 (default season6).
+        ProtocolVersion protocol = ProtocolVersion::Season6;
+        if (const char* name = std::getenv("DARKEMU_CS_PROTOCOL")) {
+            protocol = parseProtocolVersion(name);
+        }
         // Instantiate and run the ConnectServer until it is terminated.
-        auto server = std::make_unique<ServerEngine>();
+        auto server = std::make_unique<ServerEngine>(44405, protocol);
+        // Optional metrics endpoint, e.g. DARKEMU_CS_STATUS_PORT=9405.
+        if (const char* status_port = std::getenv("DARKEMU_CS_STATUS_PORT")) {
+            server->enableStatusEndpoint(static_cast<uint16_t>(std::stoul(status_port)));
+        }
+        // Optional per-handler budget for the slow-handler log, e.g. DARKEMU_HANDLER_BUDGET_US=500.
+        if (const char* budget = std::getenv("DARKEMU_HANDLER_BUDGET_US")) {
+            server->setHandlerBudget(std::chrono::microseconds(std::stoul(budget)));
+        }
+        // Optional session capture for replay, e.g. DARKEMU_CS_CAPTURE=/tmp/cs.demucap.
+        if (const char* capture = std::getenv("DARKEMU_CS_CAPTURE")) {
+            server->enableCapture(capture);
+        }
         server->run();
     } catch (const std::exception& ex) {
         // Report startup/runtime failures to stderr for debugging.
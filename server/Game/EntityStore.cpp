@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) DarkEmu
+ * Structure-of-arrays storage for players, monsters and NPCs, with per-tick systems.
+ */
+
+#include "GameServer/EntityStore.h"
+
+#include <algorithm>
+#include <utility>
+
+EntityHandle EntityStore::create(const EntitySpawn& spawn) {
+    uint32_t slot = 0;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
+    Slot& entry = slots_[slot];
+    // Generation 0 is reserved for the empty handle.
+    entry.generation = entry.generation + 1 == 0 ? 1 : entry.generation + 1;
+    entry.index = static_cast<uint32_t>(kind_.size());
+    kind_.push_back(spawn.kind);
+    id_.push_back(spawn.id);
+    map_.push_back(spawn.map);
+    x_.push_back(spawn.x);
+    y_.push_back(spawn.y);
+    dest_x_.push_back(spawn.x);
+    dest_y_.push_back(spawn.y);
+    life_.push_back(spawn.life);
+    max_life_.push_back(spawn.life);
+    mana_.push_back(spawn.mana);
+    max_mana_.push_back(spawn.mana);
+    flags_.push_back(spawn.life == 0 ? kFlagDead : 0);
+    target_.emplace_back();
+    home_x_.push_back(spawn.x);
+    home_y_.push_back(spawn.y);
+    view_range_.push_back(spawn.view_range);
+    attack_range_.push_back(spawn.attack_range);
+    ai_state_.push_back(0);
+    owners_.push_back(slot);
+    return {slot, entry.generation};
+}
+
+bool EntityStore::destroy(EntityHandle handle) {
+    const uint32_t index = indexOf(handle);
+    if (index == kNoIndex) {
+        return false;
+    }
+    // Move the last entity into the hole so the columns stay dense.
+    const uint32_t last = static_cast<uint32_t>(kind_.size() - 1);
+    if (index != last) {
+        kind_[index] = kind_[last];
+        id_[index] = id_[last];
+        map_[index] = map_[last];
+        x_[index] = x_[last];
+        y_[index] = y_[last];
+        dest_x_[index] = dest_x_[last];
+        dest_y_[index] = dest_y_[last];
+        life_[index] = life_[last];
+        max_life_[index] = max_life_[last];
+        mana_[index] = mana_[last];
+        max_mana_[index] = max_mana_[last];
+        flags_[index] = flags_[last];
+        target_[index] = target_[last];
+        home_x_[index] = home_x_[last];
+        home_y_[index] = home_y_[last];
+        view_range_[index] = view_range_[last];
+        attack_range_[index] = attack_range_[last];
+        ai_state_[index] = ai_state_[last];
+        owners_[index] = owners_[last];
+        slots_[owners_[index]].index = index;
+    }
+    kind_.pop_back();
+    id_.pop_back();
+    map_.pop_back();
+    x_.pop_back();
+    y_.pop_back();
+    dest_x_.pop_back();
+    dest_y_.pop_back();
+    life_.pop_back();
+    max_life_.pop_back();
+    mana_.pop_back();
+    max_mana_.pop_back();
+    flags_.pop_back();
+    target_.pop_back();
+    home_x_.pop_back();
+    home_y_.pop_back();
+    view_range_.pop_back();
+    attack_range_.pop_back();
+    ai_state_.pop_back();
+    owners_.pop_back();
+    // The generation stays until the slot is reused, which is what makes old handles stale.
+    slots_[handle.slot].index = kNoIndex;
+    free_slots_.push_back(handle.slot);
+    return true;
+}
+
+bool EntityStore::place(EntityHandle handle, uint8_t x, uint8_t y) noexcept {
+    const uint32_t index = indexOf(handle);
+    if (index == kNoIndex) {
+        return false;
+    }
+    x_[index] = dest_x_[index] = x;
+    y_[index] = dest_y_[index] = y;
+    flags_[index] &= ~kFlagMoving;
+    return true;
+}
+
+void regenerate(EntityStore& store, uint32_t life, uint32_t mana) noexcept {
+    // Branch-free so the loops vectorize: the dead get an increment of zero.
+    const std::span<const uint32_t> flags = store.flags();
+    const std::span<uint32_t> current_life = store.life();
+    const std::span<const uint32_t> max_life = store.maxLife();
+    for (size_t i = 0; i < flags.size(); ++i) {
+        const uint32_t gain = (flags[i] & EntityStore::kFlagDead) == 0 ? life : 0;
+        current_life[i] = std::min(current_life[i] + gain, max_life[i]);
+    }
+    const std::span<uint32_t> current_mana = store.mana();
+    const std::span<const uint32_t> max_mana = store.maxMana();
+    for (size_t i = 0; i < flags.size(); ++i) {
+        const uint32_t gain = (flags[i] & EntityStore::kFlagDead) == 0 ? mana : 0;
+        current_mana[i] = std::min(current_mana[i] + gain, max_mana[i]);
+    }
+}
+
+size_t stepTowardDestinations(EntityStore& store) noexcept {
+    const std::span<uint8_t> xs = store.x();
+    const std::span<uint8_t> ys = store.y();
+    const std::span<const uint8_t> dest_x = std::as_const(store).destX();
+    const std::span<const uint8_t> dest_y = std::as_const(store).destY();
+    const std::span<uint32_t> flags = store.flags();
+    size_t moved = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        // One tile per axis: +1, 0 or -1 from two compares, no branches.
+        const int step_x = (dest_x[i] > xs[i]) - (dest_x[i] < xs[i]);
+        const int step_y = (dest_y[i] > ys[i]) - (dest_y[i] < ys[i]);
+        xs[i] = static_cast<uint8_t>(xs[i] + step_x);
+        ys[i] = static_cast<uint8_t>(ys[i] + step_y);
+        const uint32_t moving = (step_x | step_y) != 0 ? EntityStore::kFlagMoving : 0;
+        flags[i] = (flags[i] & ~EntityStore::kFlagMoving) | moving;
+        moved += moving != 0;
+    }
+    return moved;
+}
+
+size_t clearStaleTargets(EntityStore& store) noexcept {
+    const std::span<EntityHandle> targets = store.target();
+    const std::span<const uint32_t> flags = std::as_const(store).flags();
+    size_t cleared = 0;
+    for (EntityHandle& target : targets) {
+        if (!target) {
+            continue;
+        }
+        const uint32_t index = store.indexOf(target);
+        if (index == EntityStore::kNoIndex || (flags[index] & EntityStore::kFlagDead) != 0) {
+            target = {};
+            ++cleared;
+        }
+    }
+    return cleared;
+}
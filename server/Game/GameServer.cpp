@@ -1,24 +1,168 @@
 /**
  * Copyright (c) DarkEmu
- * GameServer event loop and packet logging.
+ * GameServer event loop, packet decoding and dispatch.
  */
 
 #include "GameServer/GameServer.h"
 
+#include "GameServer/GamePackets.h"
+#include "GameServer/WorldMap.h"
+
+#include "Common/Network/DispatchTable.h"
+#include "Common/Network/PacketFramer.h"
+#include "Common/Network/PacketWriter.h"
 #include "Common/Utils/Logger.h"
+#include "Common/Utils/Tracer.h"
 
+#include <algorithm>
 #include <array>
 #include <arpa/inet.h>
 #include <cerrno>
 #include <cstring>
 #include <iomanip>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// First player index handed out; lower indices are reserved for monsters and NPCs.
+constexpr uint16_t kFirstPlayerIndex = 10000;
+// Player indices available, and so the most players connected at once.
+constexpr uint16_t kMaxPlayers = 50000;
+// Dispatch keys keep the batch index in their low 28 bits.
+constexpr uint64_t kBatchIndexMask = (uint64_t{1} << 28) - 1;
+// Slots in the player-index ownership table: one per possible uint16_t index.
+constexpr size_t kPlayerIndexSlots = 65536;
+// Unsent bytes a client may pile up while its socket is full before it is dropped as too slow.
+constexpr size_t kMaxOutboxBytes = 1024 * 1024;
+// Events of a client socket, without and with a pending write.
+constexpr uint32_t kClientEvents = EPOLLIN | EPOLLRDHUP;
+constexpr uint32_t kBlockedClientEvents = kClientEvents | EPOLLOUT;
+// Life and mana of a player entity; there is no character store yet, so everyone has a level 1 Dark Knight's.
+constexpr uint32_t kPlayerLife = 110;
+constexpr uint32_t kPlayerMana = 20;
+
+// Default per-client limits in packets per second, indexed by RateClass (0 = unlimited).
+constexpr std::array<uint32_t, static_cast<size_t>(GameServer::RateClass::Count)> kDefaultRateLimits{0, 10, 50, 10};
+
+// Copy a NUL-padded name field into a string.
+template <typename Char, size_t N>
+std::string nameField(const Char (&field)[N]) {
+    const auto* begin = reinterpret_cast<const char*>(field);
+    return std::string(begin, std::find(begin, begin + N, '\0'));
+}
+
+// Pin the calling thread to the n-th CPU it may run on (modulo their count).
+// Failure only costs cache locality, so callers just log it.
+bool pinToCpu(size_t n) {
+    cpu_set_t allowed;
+    if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+        return false;
+    }
+    n %= static_cast<size_t>(CPU_COUNT(&allowed));
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed) && n-- == 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+template <typename ProtocolT>
+struct GameServer::Routes {
+    using Packets = GamePackets<ProtocolT>;
+    static constexpr auto kLogin = static_cast<uint8_t>(RateClass::Login);
+    static constexpr auto kMovement = static_cast<uint8_t>(RateClass::Movement);
+    static constexpr auto kChat = static_cast<uint8_t>(RateClass::Chat);
+
+    using Table = DispatchTable<
+        GameServer, Session, BasicPacketFramer<typename ProtocolT::Frames>,
+        PacketRoute<typename Packets::LoginRequest, &GameServer::HandleLogin<ProtocolT>, kStateConnected, kLogin>,
+        PacketRoute<typename Packets::CharacterListRequest, &GameServer::HandleCharacterList<ProtocolT>,
+                    kStateAuthenticated, kLogin>,
+        PacketRoute<typename Packets::SelectCharacterRequest, &GameServer::HandleSelectCharacter<ProtocolT>,
+                    kStateAuthenticated, kLogin>,
+        PacketRoute<typename Packets::WalkRequest, &GameServer::HandleWalk<ProtocolT>, kStateInGame, kMovement>,
+        PacketRoute<typename Packets::WarpRequest, &GameServer::HandleWarp<ProtocolT>, kStateInGame, kLogin>,
+        PacketRoute<typename Packets::Whisper, &GameServer::HandleWhisper<ProtocolT>, kStateInGame, kChat>,
+        PacketRoute<typename Packets::PartyRequest, &GameServer::HandlePartyRequest<ProtocolT>, kStateInGame, kChat>>;
+};
+
+GameServer::Reactor::Reactor(uint32_t id, const std::string& name) :
+    id(id), events(64), monitor("darkemu_game_loop", name) {
+    // The wake eventfd is always registered; only threaded mode ever signals it.
+    wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd == -1) {
+        throw std::runtime_error(std::string("eventfd failed: ") + std::strerror(errno));
+    }
+    epoll.add(wake_fd, EPOLLIN);
+}
+
+GameServer::Reactor::~Reactor() {
+    ::close(wake_fd);
+}
+
+GameServer::GameServer(uint16_t port, ProtocolVersion protocol) :
+    port_(port),
+    metrics_{MetricsRegistry::Instance()->counter("darkemu_game_connections_accepted_total",
+                                                  "Client connections accepted by the GameServer."),
+             MetricsRegistry::Instance()->counter("darkemu_game_connections_refused_total",
+                                                  "Connections closed at accept because the server was full."),
+             MetricsRegistry::Instance()->gauge("darkemu_game_connections_active",
+                                                "Client connections currently open on the GameServer."),
+             MetricsRegistry::Instance()->counter("darkemu_game_bytes_received_total",
+                                                  "Bytes received from GameServer clients."),
+             MetricsRegistry::Instance()->counter("darkemu_game_recv_calls_total",
+                                                  "recv() calls on GameServer clients that returned data."),
+             MetricsRegistry::Instance()->counter("darkemu_game_bytes_sent_total",
+                                                  "Bytes written to GameServer clients."),
+             MetricsRegistry::Instance()->counter("darkemu_game_send_calls_total",
+                                                  "send() calls on GameServer client sockets."),
+             MetricsRegistry::Instance()->counter("darkemu_game_packets_dispatched_total",
+                                                  "GameServer frames routed to a handler."),
+             MetricsRegistry::Instance()->counter("darkemu_game_packets_rejected_total",
+                                                  "GameServer frames dropped for opcode, length, state or rate."),
+             MetricsRegistry::Instance()->counter("darkemu_game_ticks_total",
+                                                  "Simulation ticks run by the GameServer."),
+             MetricsRegistry::Instance()->histogram("darkemu_game_tick_duration_seconds",
+                                                    "Work time of one simulation tick.", 1e-6),
+             MetricsRegistry::Instance()->counter("darkemu_game_tick_overruns_total",
+                                                  "Simulation ticks whose work exceeded the tick period."),
+             MetricsRegistry::Instance()->counter("darkemu_game_queue_full_total",
+                                                  "Messages parked because a reactor queue or shard mailbox was full."),
+             MetricsRegistry::Instance()->counter("darkemu_game_shard_migrations_total",
+                                                  "Sessions handed to another shard by a warp or character select."),
+             MetricsRegistry::Instance()->counter("darkemu_game_shard_messages_total",
+                                                  "Messages sent between shards through their mailboxes.")},
+    rate_limits_(kDefaultRateLimits),
+    protocol_(protocol),
+    player_shards_(std::make_unique<std::atomic<uint32_t>[]>(kPlayerIndexSlots)) {
+    // Pick the protocol's instantiations once; the per-packet path never looks at protocol_ again.
+    withProtocol(protocol_, [this]<typename ProtocolT>(ProtocolT) {
+        send_welcome_ = &GameServer::SendWelcome<ProtocolT>;
+        process_batch_ = &GameServer::ProcessBatch<ProtocolT>;
+        run_tick_ = &GameServer::RunTick<ProtocolT>;
+        update_viewports_ = &GameServer::UpdateViewports<ProtocolT>;
+    });
+    reactors_.push_back(std::make_unique<Reactor>(0, "GameServer"));
+    shards_.push_back(std::make_unique<Shard>(0));
+    for (size_t i = 0; i < kPlayerIndexSlots; ++i) {
+        player_shards_[i].store(kNoShard, std::memory_order_relaxed);
+    }
+    SetPlayerCapacity(kMaxPlayers);
 
-GameServer::GameServer(uint16_t port) : events_(64), port_(port) {
     // Create and configure the listening socket.
     listen_socket_ = Socket::createTcp();
     listen_socket_.setNonBlocking(true);
@@ -33,40 +177,559 @@ GameServer::GameServer(uint16_t port) : events_(64), port_(port) {
     }
     port_ = ntohs(addr.sin_port);
 
-    // Register the listening socket for read events.
-    epoll_.add(listen_socket_.fd(), EPOLLIN);
+    // Register the listening socket for read events on the accepting reactor.
+    reactors_[0]->epoll.add(listen_socket_.fd(), EPOLLIN);
+}
+
+GameServer::~GameServer() {
+    Stop();
 }
 
 void GameServer::Run() {
     // Main event loop: wait for epoll events and dispatch them.
     Log::Info("GameServer listening on port " + std::to_string(port_));
+    Tracer::Instance()->setThreadName("GameServer reactor");
+    // While capturing, wake up at least once per flush interval so an idle server still writes its tail.
+    const int timeout = recorder_ ? static_cast<int>(SessionRecorder::kFlushInterval.count()) : -1;
     while (true) {
-        RunOnce(-1);
+        RunOnce(timeout);
     }
 }
 
+void GameServer::Run(const ThreadingOptions& options) {
+    Start(options);
+    // The worker threads do everything; block until Stop() flips the flag.
+    running_.wait(true);
+}
+
 void GameServer::RunOnce(int timeoutMs) {
     // Single iteration of the event loop (used by tests).
-    int ready = epoll_.wait(events_, timeoutMs);
+    RunReactor(*reactors_[0], timeoutMs);
+}
+
+void GameServer::RunReactor(Reactor& reactor, int timeoutMs) {
+    int ready = reactor.monitor.wait(reactor.epoll, reactor.events, timeoutMs);
     for (int i = 0; i < ready; ++i) {
-        const epoll_event& ev = events_[i];
+        const epoll_event& ev = reactor.events[i];
         int fd = ev.data.fd;
-        if (fd == listen_socket_.fd()) {
+        LoopMonitor::HandlerScope scope(reactor.monitor, fd);
+        if (fd == reactor.wake_fd) {
+            // Handed-off connections and replies from the simulation.
+            DrainWake(reactor);
+            continue;
+        }
+        if (reactor.id == 0 && fd == listen_socket_.fd()) {
             // Accept new connections from the listening socket.
             if (ev.events & EPOLLIN) {
-                HandleAccept();
+                HandleAccept(reactor);
+            }
+            continue;
+        }
+        // Status endpoint sockets share the accepting reactor but never touch game clients.
+        if (reactor.id == 0 && status_ && status_->owns(fd)) {
+            status_->handleEvent(fd, ev.events);
+            continue;
+        }
+        // Close clients on error or hang-up events. A half-close (EPOLLRDHUP alone) is read like any other
+        // input, so the frames the client sent before shutting down its side are still dispatched.
+        if (ev.events & (EPOLLERR | EPOLLHUP)) {
+            CloseClient(reactor, fd);
+            continue;
+        }
+        // A full socket buffer drained: send the rest of the outbox with this wake-up's replies.
+        if (ev.events & EPOLLOUT) {
+            if (auto it = reactor.clients.find(fd); it != reactor.clients.end()) {
+                QueueFlush(reactor, it->second);
+            }
+        }
+        // Drain readable clients; their frames are processed together below.
+        if (ev.events & (EPOLLIN | EPOLLRDHUP)) {
+            HandleRead(reactor, fd);
+        }
+    }
+    (this->*process_batch_)(reactor);
+    if (!threaded_) {
+        // Inline mode has no ticks: viewport changes go out after every batch.
+        (this->*update_viewports_)(*shards_[0]);
+    }
+    FlushSends(reactor);
+    if (recorder_) {
+        recorder_->flushIfDue();
+    }
+    reactor.monitor.endIteration();
+}
+
+void GameServer::Start(const ThreadingOptions& options) {
+    if (running_.load() || shards_[0]->thread.joinable()) {
+        throw std::logic_error("GameServer threads are already running");
+    }
+    if (!reactors_[0]->clients.empty()) {
+        throw std::logic_error("GameServer::Start must run before clients are served inline");
+    }
+    if (options.reactors == 0 || options.shards == 0 || options.shards >= kNoShard ||
+        options.tick <= std::chrono::microseconds::zero()) {
+        throw std::invalid_argument("GameServer needs at least one reactor and shard and a positive tick");
+    }
+    threading_ = options;
+    while (reactors_.size() < options.reactors) {
+        const auto id = static_cast<uint32_t>(reactors_.size());
+        reactors_.push_back(std::make_unique<Reactor>(id, "GameServer reactor " + std::to_string(id)));
+        reactors_.back()->monitor.setHandlerBudget(reactors_[0]->monitor.handlerBudget());
+    }
+    while (shards_.size() < options.shards) {
+        shards_.push_back(std::make_unique<Shard>(static_cast<uint32_t>(shards_.size())));
+        shards_.back()->monitor.setHandlerBudget(reactors_[0]->monitor.handlerBudget());
+    }
+    // One queue pair per reactor and shard, one mailbox per ordered pair of shards: every queue has a
+    // single producer thread and a single consumer thread.
+    for (auto& reactor : reactors_) {
+        reactor->links.resize(shards_.size());
+        for (ShardLink& link : reactor->links) {
+            link.inbound = std::make_unique<SpscQueue<InboundMessage>>(options.queue_capacity);
+            link.outbound = std::make_unique<SpscQueue<OutboundMessage>>(options.queue_capacity);
+        }
+        reactor->handoff = std::make_unique<SpscQueue<Handoff>>(options.queue_capacity);
+    }
+    for (auto& shard : shards_) {
+        shard->mailboxes.resize(shards_.size());
+        shard->mail_backlog.resize(shards_.size());
+        for (size_t from = 0; from < shards_.size(); ++from) {
+            if (from != shard->id) {
+                shard->mailboxes[from] = std::make_unique<SpscQueue<ShardMessage>>(options.queue_capacity);
+            }
+        }
+    }
+    const double budget = std::chrono::duration<double>(options.tick).count();
+    MetricsRegistry::Instance()->gaugeFunction("darkemu_game_tick_budget_seconds",
+                                               "Simulation tick period (the per-tick work budget).",
+                                               [budget] { return budget; });
+
+    threaded_ = true;
+    running_.store(true);
+    for (auto& shard : shards_) {
+        shard->thread = std::thread(&GameServer::ShardLoop, this, std::ref(*shard));
+    }
+    for (auto& reactor : reactors_) {
+        reactor->thread = std::thread(&GameServer::ReactorLoop, this, std::ref(*reactor));
+    }
+    Log::Info("GameServer listening on port " + std::to_string(port_) + " with " + std::to_string(reactors_.size()) +
+              " reactor(s), " + std::to_string(shards_.size()) + " shard(s) and a " +
+              std::to_string(options.tick.count()) + " us tick");
+}
+
+void GameServer::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    running_.notify_all();
+    for (auto& reactor : reactors_) {
+        Wake(*reactor);
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+    for (auto& reactor : reactors_) {
+        if (reactor->thread.joinable()) {
+            reactor->thread.join();
+        }
+    }
+}
+
+void GameServer::ReactorLoop(Reactor& reactor) {
+    Tracer::Instance()->setThreadName("GameServer reactor " + std::to_string(reactor.id));
+    while (running_.load(std::memory_order_acquire)) {
+        // Parked messages are retried every millisecond until the shards catch up.
+        const bool flushed = FlushInboundBacklog(reactor);
+        RunReactor(reactor, flushed ? 100 : 1);
+    }
+}
+
+void GameServer::ShardLoop(Shard& shard) {
+    Tracer::Instance()->setThreadName("GameServer shard " + std::to_string(shard.id));
+    if (threading_.pin_shards && !pinToCpu(shard.id)) {
+        Log::Info("GameServer: could not pin shard " + std::to_string(shard.id) + " to a CPU");
+    }
+    const auto period = std::chrono::duration_cast<Clock::duration>(threading_.tick);
+    Clock::time_point scheduled = Clock::now();
+    while (running_.load(std::memory_order_acquire)) {
+        // Handlers see the scheduled tick time, so rate windows do not drift with tick jitter.
+        const Clock::time_point started = Clock::now();
+        {
+            DARKEMU_TRACE_SPAN("tick", static_cast<int64_t>(shard.id));
+            (this->*run_tick_)(shard, scheduled);
+        }
+        const auto work = Clock::now() - started;
+        metrics_.ticks.inc();
+        metrics_.tick_time.observe(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(work).count()));
+        if (work > period) {
+            metrics_.tick_overruns.inc();
+        }
+        // Late ticks start immediately and the missed slots are dropped rather than run back to back.
+        scheduled = std::max(scheduled + period, Clock::now());
+        std::this_thread::sleep_until(scheduled);
+    }
+}
+
+template <typename ProtocolT>
+void GameServer::RunTick(Shard& shard, Clock::time_point now) {
+    using Framer = BasicPacketFramer<typename ProtocolT::Frames>;
+    DrainMail(shard);
+    uint64_t dispatched = 0;
+    uint64_t rejected = 0;
+    for (auto& reactor : reactors_) {
+        // Bounded per reactor: a burst on one reactor waits for the next tick instead of stretching this one.
+        SpscQueue<InboundMessage>& queue = *reactor->links[shard.id].inbound;
+        for (size_t taken = 0; taken < threading_.max_frames_per_tick; ++taken) {
+            InboundMessage* message = queue.front();
+            if (message == nullptr) {
+                break;
+            }
+            // A connection the reactor already routes here may still be on its way in the mailboxes:
+            // the move was mailed before the reactor heard of it.
+            if (message->kind != InboundMessage::Kind::Open && !shard.sessions.contains(message->connection)) {
+                DrainMail(shard);
+            }
+            switch (message->kind) {
+            case InboundMessage::Kind::Open:
+                OpenSession(shard, message->connection, reactor->id, message->index);
+                break;
+            case InboundMessage::Kind::Close: {
+                if (shard.sessions.contains(message->connection)) {
+                    CloseSession(shard, message->connection);
+                    break;
+                }
+                // The session left before the reactor learned of the move; follow it.
+                const uint32_t owner = player_shards_[message->index].load(std::memory_order_acquire);
+                if (owner != kNoShard && owner != shard.id) {
+                    ShardMessage close;
+                    close.kind = ShardMessage::Kind::Close;
+                    close.connection = message->connection;
+                    close.index = message->index;
+                    PostMail(shard, owner, std::move(close));
+                }
+                break;
+            }
+            case InboundMessage::Kind::Frame: {
+                auto it = shard.sessions.find(message->connection);
+                if (it == shard.sessions.end()) {
+                    // Sent to the old shard before a warp reached the reactor; the client waits for the
+                    // teleport before it talks to the new map.
+                    ++rejected;
+                    break;
+                }
+                Session& session = it->second;
+                const std::span<const uint8_t> frame(message->frame);
+                const uint8_t head = frame[Framer::headerSize(frame[0])];
+                {
+                    // Timed like an inline dispatch; the low half of the connection id is the client's fd.
+                    LoopMonitor::HandlerScope scope(shard.monitor, static_cast<int>(message->connection & 0xFFFFFFFF));
+                    shard.monitor.noteOpcode(head);
+                    DARKEMU_TRACE_SPAN("handler", head);
+                    const DispatchStatus status = Routes<ProtocolT>::Table::dispatch(
+                        *this, session, frame, session.state,
+                        [&](uint8_t rateClass) { return AllowRate(session, rateClass, now); });
+                    ++(status == DispatchStatus::Dispatched ? dispatched : rejected);
+                }
+                if (session.transfer != kNoShard) {
+                    MigrateSession(shard, message->connection);
+                }
+                break;
+            }
+            }
+            queue.pop();
+        }
+    }
+    if (dispatched != 0) {
+        metrics_.dispatched.inc(dispatched);
+    }
+    if (rejected != 0) {
+        metrics_.rejected.inc(rejected);
+    }
+    RunEntitySystems(shard);
+    UpdateViewports<ProtocolT>(shard);
+    FlushOutbound(shard);
+}
+
+template <typename ProtocolT>
+void GameServer::UpdateViewports(Shard& shard) {
+    using Packets = GamePackets<ProtocolT>;
+    for (ViewportTracker& viewports : shard.viewports) {
+        viewports.update([&](uint32_t recipient, std::span<const uint32_t> enters, std::span<const uint32_t> leaves) {
+            Session* session = FindPlayer(shard, static_cast<uint16_t>(recipient));
+            if (session == nullptr) {
+                return;
+            }
+            // Everything a player gained or lost this tick goes out as a few batched frames, not one per change.
+            for (size_t first = 0; first < enters.size(); first += Packets::kMaxViewportCreate) {
+                const size_t count = std::min(enters.size() - first, Packets::kMaxViewportCreate);
+                PacketWriter<512> writer;
+                writer.begin<typename Packets::ViewportCreate>().count = static_cast<uint8_t>(count);
+                for (const uint32_t index : enters.subspan(first, count)) {
+                    const Session* player = FindPlayer(shard, static_cast<uint16_t>(index));
+                    typename Packets::ViewportPlayer entry{};
+                    entry.index = static_cast<uint16_t>(index);
+                    if (player != nullptr) {
+                        entry.x = player->x;
+                        entry.y = player->y;
+                        std::memcpy(entry.name, player->character.data(),
+                                    std::min(player->character.size(), sizeof(entry.name)));
+                    }
+                    writer.writeStruct(entry);
+                }
+                Send(*session, writer.finish());
+            }
+            for (size_t first = 0; first < leaves.size(); first += Packets::kMaxViewportDestroy) {
+                const size_t count = std::min(leaves.size() - first, Packets::kMaxViewportDestroy);
+                PacketWriter<256> writer;
+                writer.begin<typename Packets::ViewportDestroy>().count = static_cast<uint8_t>(count);
+                for (const uint32_t index : leaves.subspan(first, count)) {
+                    writer.writeU16BE(static_cast<uint16_t>(index));
+                }
+                Send(*session, writer.finish());
             }
+        });
+    }
+}
+
+void GameServer::FlushOutbound(Shard& shard) {
+    for (auto& reactor : reactors_) {
+        ShardLink& link = reactor->links[shard.id];
+        // Parked replies go first so each connection keeps its reply order.
+        while (!link.outbound_backlog.empty()) {
+            OutboundMessage* slot = link.outbound->prepare();
+            if (slot == nullptr) {
+                break;
+            }
+            OutboundMessage& parked = link.outbound_backlog.front();
+            slot->kind = parked.kind;
+            slot->connection = parked.connection;
+            slot->shard = parked.shard;
+            slot->frame.swap(parked.frame);
+            slot->shared = std::move(parked.shared);
+            link.outbound->commit();
+            link.outbound_backlog.pop_front();
+        }
+        // One wake-up per reactor per tick, however many replies it got.
+        if (link.outbound_posted) {
+            link.outbound_posted = !link.outbound_backlog.empty();
+            Wake(*reactor);
+        }
+    }
+    // Shards poll their mailboxes every tick, so parked mail needs no wake-up.
+    for (size_t to = 0; to < shard.mail_backlog.size(); ++to) {
+        std::deque<ShardMessage>& backlog = shard.mail_backlog[to];
+        // Mail to the own shard is handled inline and never parked; that mailbox does not exist.
+        if (backlog.empty()) {
             continue;
         }
-        // Close clients on error or hang-up events.
-        if (ev.events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
-            CloseClient(fd);
+        SpscQueue<ShardMessage>& mailbox = *shards_[to]->mailboxes[shard.id];
+        while (!backlog.empty()) {
+            ShardMessage* slot = mailbox.prepare();
+            if (slot == nullptr) {
+                break;
+            }
+            *slot = std::move(backlog.front());
+            mailbox.commit();
+            backlog.pop_front();
+        }
+    }
+}
+
+void GameServer::Wake(const Reactor& reactor) {
+    const uint64_t one = 1;
+    // A full counter (EAGAIN) already guarantees a pending wake-up.
+    [[maybe_unused]] const ssize_t written = ::write(reactor.wake_fd, &one, sizeof(one));
+}
+
+void GameServer::DrainWake(Reactor& reactor) {
+    uint64_t count = 0;
+    [[maybe_unused]] const ssize_t read = ::read(reactor.wake_fd, &count, sizeof(count));
+    if (!reactor.handoff) {
+        return;
+    }
+    while (Handoff* handoff = reactor.handoff->front()) {
+        AddClient(reactor, std::move(handoff->socket), handoff->connection, handoff->index);
+        reactor.handoff->pop();
+    }
+    for (ShardLink& link : reactor.links) {
+        while (OutboundMessage* message = link.outbound->front()) {
+            // The fd may have been closed and reused since the shard replied; the full id tells them apart.
+            auto it = reactor.clients.find(static_cast<int>(message->connection & 0xFFFFFFFF));
+            if (it != reactor.clients.end() && it->second.connection == message->connection) {
+                if (message->kind == OutboundMessage::Kind::Moved) {
+                    it->second.shard = message->shard;
+                } else if (message->kind == OutboundMessage::Kind::Shared) {
+                    QueueShared(reactor, it->second, message->shared);
+                } else {
+                    QueueSend(reactor, it->second, message->frame);
+                }
+            }
+            // Slots are reused; a shared frame must not stay referenced until then.
+            message->shared.reset();
+            link.outbound->pop();
+        }
+    }
+}
+
+void GameServer::PostInbound(Reactor& reactor, uint32_t shard, InboundMessage::Kind kind, ConnectionId connection,
+                             uint16_t index, std::span<const uint8_t> frame) {
+    ShardLink& link = reactor.links[shard];
+    if (link.inbound_backlog.empty()) {
+        if (InboundMessage* slot = link.inbound->prepare()) {
+            slot->kind = kind;
+            slot->connection = connection;
+            slot->index = index;
+            slot->frame.assign(frame.begin(), frame.end());
+            link.inbound->commit();
+            return;
+        }
+    }
+    metrics_.queue_full.inc();
+    link.inbound_backlog.push_back(
+            InboundMessage{kind, connection, index, std::vector<uint8_t>(frame.begin(), frame.end())});
+}
+
+void GameServer::PostOutbound(uint32_t shard, uint32_t reactor, OutboundMessage::Kind kind, ConnectionId connection,
+                              uint32_t target, std::span<const uint8_t> frame, SharedFrame shared) {
+    ShardLink& link = reactors_[reactor]->links[shard];
+    link.outbound_posted = true;
+    if (link.outbound_backlog.empty()) {
+        if (OutboundMessage* slot = link.outbound->prepare()) {
+            slot->kind = kind;
+            slot->connection = connection;
+            slot->shard = target;
+            slot->frame.assign(frame.begin(), frame.end());
+            slot->shared = std::move(shared);
+            link.outbound->commit();
+            return;
+        }
+    }
+    metrics_.queue_full.inc();
+    link.outbound_backlog.push_back(OutboundMessage{
+            kind, connection, target, std::vector<uint8_t>(frame.begin(), frame.end()), std::move(shared)});
+}
+
+bool GameServer::FlushInboundBacklog(Reactor& reactor) {
+    bool flushed = true;
+    for (ShardLink& link : reactor.links) {
+        while (!link.inbound_backlog.empty()) {
+            InboundMessage* slot = link.inbound->prepare();
+            if (slot == nullptr) {
+                flushed = false;
+                break;
+            }
+            InboundMessage& parked = link.inbound_backlog.front();
+            slot->kind = parked.kind;
+            slot->connection = parked.connection;
+            slot->index = parked.index;
+            slot->frame.swap(parked.frame);
+            link.inbound->commit();
+            link.inbound_backlog.pop_front();
+        }
+    }
+    return flushed;
+}
+
+void GameServer::PostMail(Shard& from, uint32_t to, ShardMessage&& message) {
+    if (to == from.id) {
+        HandleMail(from, message);
+        return;
+    }
+    metrics_.mail.inc();
+    std::deque<ShardMessage>& backlog = from.mail_backlog[to];
+    SpscQueue<ShardMessage>& mailbox = *shards_[to]->mailboxes[from.id];
+    if (backlog.empty()) {
+        if (ShardMessage* slot = mailbox.prepare()) {
+            *slot = std::move(message);
+            mailbox.commit();
+            return;
+        }
+    }
+    metrics_.queue_full.inc();
+    backlog.push_back(std::move(message));
+}
+
+void GameServer::DrainMail(Shard& shard) {
+    for (auto& mailbox : shard.mailboxes) {
+        if (!mailbox) {
             continue;
         }
-        // Read available data from connected clients.
-        if (ev.events & EPOLLIN) {
-            HandleRead(fd);
+        while (ShardMessage* message = mailbox->front()) {
+            HandleMail(shard, *message);
+            mailbox->pop();
+        }
+    }
+}
+
+void GameServer::HandleMail(Shard& shard, ShardMessage& message) {
+    switch (message.kind) {
+    case ShardMessage::Kind::Enter: {
+        const ConnectionId connection = message.session.connection;
+        const uint16_t index = message.session.index;
+        Session& session = shard.sessions[connection] = std::move(message.session);
+        shard.players[index] = connection;
+        if (session.state == kStateInGame) {
+            EnterMap(session);
+        }
+        break;
+    }
+    case ShardMessage::Kind::Close: {
+        if (shard.sessions.contains(message.connection)) {
+            CloseSession(shard, message.connection);
+            break;
         }
+        const uint32_t owner = player_shards_[message.index].load(std::memory_order_acquire);
+        if (owner != kNoShard && owner != shard.id) {
+            PostMail(shard, owner, std::move(message));
+        }
+        break;
+    }
+    case ShardMessage::Kind::Register:
+        shard.directory[message.name] = message.index;
+        break;
+    case ShardMessage::Kind::Unregister: {
+        auto it = shard.directory.find(message.name);
+        if (it != shard.directory.end() && it->second == message.index) {
+            shard.directory.erase(it);
+        }
+        break;
+    }
+    case ShardMessage::Kind::Whisper: {
+        // This shard is the name's home: resolve it, then deliver to whoever holds the target (or the sender).
+        const uint16_t sender = message.index;
+        auto it = shard.directory.find(message.name);
+        const uint32_t owner =
+                it == shard.directory.end() ? kNoShard : player_shards_[it->second].load(std::memory_order_acquire);
+        message.kind = ShardMessage::Kind::Deliver;
+        if (owner != kNoShard) {
+            message.index = it->second;
+            PostMail(shard, owner, std::move(message));
+            break;
+        }
+        const uint32_t sender_owner = player_shards_[sender].load(std::memory_order_acquire);
+        if (sender_owner != kNoShard) {
+            message.index = sender;
+            message.frame.swap(message.reply);
+            PostMail(shard, sender_owner, std::move(message));
+        }
+        break;
+    }
+    case ShardMessage::Kind::Deliver: {
+        auto player = shard.players.find(message.index);
+        if (player != shard.players.end()) {
+            Send(shard.sessions.at(player->second), message.frame);
+            break;
+        }
+        // Moved away since the sender looked; deliveries racing a session that is still in flight are dropped.
+        const uint32_t owner = player_shards_[message.index].load(std::memory_order_acquire);
+        if (owner != kNoShard && owner != shard.id) {
+            PostMail(shard, owner, std::move(message));
+        }
+        break;
+    }
     }
 }
 
@@ -75,60 +738,798 @@ uint16_t GameServer::Port() const noexcept {
 }
 
 size_t GameServer::BytesReceived() const noexcept {
-    return total_bytes_received_;
+    return total_bytes_received_.load(std::memory_order_relaxed);
+}
+
+void GameServer::EnableStatusEndpoint(uint16_t port) {
+    // Bind the metrics port on the accepting reactor; rendering runs on its own thread.
+    status_ = std::make_unique<StatusServer>(reactors_[0]->epoll, port);
+    Log::Info("GameServer status endpoint on port " + std::to_string(status_->port()));
+}
+
+uint16_t GameServer::StatusPort() const noexcept {
+    return status_ ? status_->port() : 0;
+}
+
+void GameServer::SetHandlerBudget(std::chrono::microseconds budget) noexcept {
+    for (auto& reactor : reactors_) {
+        reactor->monitor.setHandlerBudget(budget);
+    }
+    for (auto& shard : shards_) {
+        shard->monitor.setHandlerBudget(budget);
+    }
+}
+
+const LoopMonitor& GameServer::GetLoopMonitor() const noexcept {
+    return reactors_[0]->monitor;
+}
+
+void GameServer::EnableCapture(const std::string& path) {
+    // Sessions accepted from now on are recorded; open ones are not back-filled.
+    recorder_ = std::make_unique<SessionRecorder>(path);
+    Log::Info("GameServer capturing sessions to " + path);
+}
+
+bool GameServer::LoadPacketKeys(const std::string& directory) {
+    if (!decoder_.loadDecryptionKey(directory + "/Dec2.dat")) {
+        Log::Info("GameServer: could not load " + directory + "/Dec2.dat, using built-in packet keys");
+        return false;
+    }
+    Log::Info("GameServer packet keys loaded from " + directory + " (" +
+              SimpleModulus::simdLevelName(decoder_.simdLevel()) + " kernel)");
+    return true;
+}
+
+void GameServer::SetRateLimit(RateClass rateClass, uint32_t perSecond) noexcept {
+    rate_limits_[static_cast<size_t>(rateClass)] = perSecond;
+}
+
+uint64_t GameServer::PacketsDispatched() const noexcept {
+    return metrics_.dispatched.value();
+}
+
+uint64_t GameServer::PacketsRejected() const noexcept {
+    return metrics_.rejected.value();
+}
+
+uint64_t GameServer::Ticks() const noexcept {
+    return metrics_.ticks.value();
+}
+
+void GameServer::SetPacketLogging(bool enabled) noexcept {
+    log_packets_ = enabled;
+}
+
+ProtocolVersion GameServer::Protocol() const noexcept {
+    return protocol_;
 }
 
-void GameServer::HandleAccept() {
+void GameServer::SetPlayerCapacity(uint16_t players) {
+    std::lock_guard lock(player_index_mutex_);
+    if (free_player_indices_.size() != player_capacity_) {
+        throw std::logic_error("GameServer::SetPlayerCapacity must run before clients connect");
+    }
+    player_capacity_ = std::min(players, kMaxPlayers);
+    free_player_indices_.clear();
+    for (uint16_t i = 0; i < player_capacity_; ++i) {
+        free_player_indices_.push_back(static_cast<uint16_t>(kFirstPlayerIndex + i));
+    }
+}
+
+bool GameServer::AcquirePlayerIndex(uint16_t& index) {
+    std::lock_guard lock(player_index_mutex_);
+    if (free_player_indices_.empty()) {
+        return false;
+    }
+    index = free_player_indices_.front();
+    free_player_indices_.pop_front();
+    return true;
+}
+
+void GameServer::ReleasePlayerIndex(uint16_t index) {
+    std::lock_guard lock(player_index_mutex_);
+    free_player_indices_.push_back(index);
+}
+
+void GameServer::HandleAccept(Reactor& acceptor) {
     // Drain all pending accept calls until the listen socket would block.
     while (true) {
         Socket client = listen_socket_.accept();
         if (!client.isValid()) {
             break;
         }
-        client.setNonBlocking(true);
-        int fd = client.fd();
-        // Register the new client for read and hang-up events.
-        epoll_.add(fd, EPOLLIN | EPOLLRDHUP);
-        clients_.emplace(fd, ClientState{std::move(client), {}});
+        // An index stays taken until its session closes, so it is never shared by two live players.
+        uint16_t index = 0;
+        if (!AcquirePlayerIndex(index)) {
+            Log::Info("GameServer: no free player index, refusing fd " + std::to_string(client.fd()));
+            metrics_.refused.inc();
+            continue;
+        }
+        const ConnectionId connection = (static_cast<uint64_t>(++next_connection_) << 32) |
+                                        static_cast<uint32_t>(client.fd());
+        // Threaded mode spreads connections round-robin; a full hand-off queue keeps the client here.
+        if (threaded_) {
+            Reactor& target = *reactors_[next_reactor_++ % reactors_.size()];
+            if (&target != &acceptor) {
+                if (Handoff* slot = target.handoff->prepare()) {
+                    slot->socket = std::move(client);
+                    slot->connection = connection;
+                    slot->index = index;
+                    target.handoff->commit();
+                    Wake(target);
+                    continue;
+                }
+                metrics_.queue_full.inc();
+            }
+        }
+        AddClient(acceptor, std::move(client), connection, index);
+    }
+}
+
+void GameServer::AddClient(Reactor& reactor, Socket socket, ConnectionId connection, uint16_t index) {
+    socket.setNonBlocking(true);
+    const int fd = socket.fd();
+    // Register the new client for read and hang-up events.
+    reactor.epoll.add(fd, kClientEvents);
+    ClientState& client = reactor.clients[fd];
+    client.socket = std::move(socket);
+    client.connection = connection;
+    client.index = index;
+    client.capture_id = recorder_ ? recorder_->open() : 0;
+    metrics_.accepted.inc();
+    metrics_.active.add(1);
+    (this->*send_welcome_)(reactor, client);
+    if (threaded_) {
+        // Sessions start on the spawn map's shard, so entering the world does not move them.
+        client.shard = ShardOfMap(static_cast<uint8_t>(WorldMap::Lorencia));
+        PostInbound(reactor, client.shard, InboundMessage::Kind::Open, connection, index, {});
+    } else {
+        Session& session = OpenSession(*shards_[0], connection, reactor.id, index);
+        session.client = &client;
+        client.session = &session;
+    }
+}
+
+GameServer::Session& GameServer::OpenSession(Shard& shard, ConnectionId connection, uint32_t reactor,
+                                             uint16_t index) {
+    Session& session = shard.sessions[connection];
+    session = Session{};
+    session.connection = connection;
+    session.reactor = reactor;
+    session.shard = shard.id;
+    session.index = index;
+    shard.players[index] = connection;
+    player_shards_[index].store(shard.id, std::memory_order_release);
+    return session;
+}
+
+void GameServer::CloseSession(Shard& shard, ConnectionId connection) {
+    auto it = shard.sessions.find(connection);
+    if (it == shard.sessions.end()) {
+        return;
+    }
+    Session& session = it->second;
+    if (session.state == kStateInGame) {
+        LeaveMap(session);
+    }
+    auto player = shard.players.find(session.index);
+    if (player != shard.players.end() && player->second == connection) {
+        shard.players.erase(player);
+        uint32_t owner = shard.id;
+        player_shards_[session.index].compare_exchange_strong(owner, kNoShard, std::memory_order_acq_rel);
+    }
+    if (!session.character.empty()) {
+        ShardMessage unregister;
+        unregister.kind = ShardMessage::Kind::Unregister;
+        unregister.index = session.index;
+        unregister.name = session.character;
+        PostMail(shard, HomeShard(session.character), std::move(unregister));
+    }
+    const uint16_t index = session.index;
+    shard.sessions.erase(it);
+    ReleasePlayerIndex(index);
+}
+
+void GameServer::MigrateSession(Shard& shard, ConnectionId connection) {
+    auto it = shard.sessions.find(connection);
+    Session& session = it->second;
+    const uint32_t target = session.transfer;
+    const uint32_t reactor = session.reactor;
+    session.transfer = kNoShard;
+    session.shard = target;
+    shard.players.erase(session.index);
+    // Ownership changes before the session is mailed, so anything that looks it up afterwards follows it.
+    player_shards_[session.index].store(target, std::memory_order_release);
+    ShardMessage enter;
+    enter.kind = ShardMessage::Kind::Enter;
+    enter.session = std::move(session);
+    shard.sessions.erase(it);
+    PostMail(shard, target, std::move(enter));
+    // The reactor switches after every reply already queued on this link; later frames go to the new shard.
+    PostOutbound(shard.id, reactor, OutboundMessage::Kind::Moved, connection, target, {});
+    metrics_.migrations.inc();
+}
+
+void GameServer::EnterMap(Session& session) {
+    Shard& shard = *shards_[session.shard];
+    shard.viewports[session.map].add(session.index, session.x, session.y);
+    EntitySpawn spawn;
+    spawn.kind = EntityKind::Player;
+    spawn.id = session.index;
+    spawn.map = session.map;
+    spawn.x = session.x;
+    spawn.y = session.y;
+    spawn.life = kPlayerLife;
+    spawn.mana = kPlayerMana;
+    session.entity = shard.entities.create(spawn);
+}
+
+void GameServer::LeaveMap(Session& session) {
+    Shard& shard = *shards_[session.shard];
+    shard.viewports[session.map].remove(session.index);
+    shard.entities.destroy(session.entity);
+    session.entity = {};
+}
+
+void GameServer::RunEntitySystems(Shard& shard) {
+    // Monsters pick their destinations first; then everyone steps toward theirs.
+    const bool monsters = std::any_of(shard.monsters.begin(), shard.monsters.end(),
+                                      [](const MonsterAi& ai) { return !ai.empty(); });
+    if (monsters) {
+        for (std::vector<EntityHandle>& players : shard.map_players) {
+            players.clear();
+        }
+        for (const auto& [connection, session] : shard.sessions) {
+            if (session.entity) {
+                shard.map_players[session.map].push_back(session.entity);
+            }
+        }
+        for (size_t map = 0; map < shard.monsters.size(); ++map) {
+            shard.monsters[map].update(shard.entities, shard.map_players[map]);
+        }
+    }
+    stepTowardDestinations(shard.entities);
+    clearStaleTargets(shard.entities);
+}
+
+ViewportTracker& GameServer::ViewportOf(const Session& session) noexcept {
+    return shards_[session.shard]->viewports[session.map];
+}
+
+GameServer::Session* GameServer::FindPlayer(Shard& shard, uint16_t index) noexcept {
+    auto player = shard.players.find(index);
+    if (player == shard.players.end()) {
+        return nullptr;
+    }
+    auto it = shard.sessions.find(player->second);
+    return it == shard.sessions.end() ? nullptr : &it->second;
+}
+
+uint32_t GameServer::ShardOfMap(uint8_t map) const noexcept {
+    return static_cast<uint32_t>(map % shards_.size());
+}
+
+uint32_t GameServer::HomeShard(const std::string& name) const noexcept {
+    return static_cast<uint32_t>(std::hash<std::string>{}(name) % shards_.size());
+}
+
+template <typename ProtocolT>
+void GameServer::SendWelcome(Reactor& reactor, ClientState& client) {
+    // Result 1, player index and the client version of this protocol.
+    auto packet = makePacket<typename GamePackets<ProtocolT>::JoinResult>();
+    packet.index = client.index;
+    QueueSend(reactor, client, packetBytes(packet));
+}
+
+void GameServer::QueueSend(Reactor& reactor, ClientState& client, std::span<const uint8_t> frame) {
+    // Everything a client gets during one wake-up (one tick of replies in threaded mode) leaves in one send().
+    if (OutboxOverflows(reactor, client, frame.size())) {
+        return;
+    }
+    client.outbox.append(frame);
+    if (!client.write_blocked) {
+        QueueFlush(reactor, client);
+    }
+    if (recorder_) {
+        recorder_->serverData(client.capture_id, frame);
+    }
+}
+
+void GameServer::QueueShared(Reactor& reactor, ClientState& client, const SharedFrame& frame) {
+    if (OutboxOverflows(reactor, client, frame.bytes().size())) {
+        return;
+    }
+    if (recorder_) {
+        recorder_->serverData(client.capture_id, frame.bytes());
+    }
+    client.outbox.append(frame);
+    if (!client.write_blocked) {
+        QueueFlush(reactor, client);
+    }
+}
+
+bool GameServer::OutboxOverflows(Reactor& reactor, ClientState& client, size_t bytes) {
+    if (!client.outbox_overflow && client.outbox.pending() + bytes <= kMaxOutboxBytes) {
+        return false;
+    }
+    // Frames already queued may point into the batch being dispatched, so the client is closed by the next flush
+    // rather than here; everything sent to it until then is dropped.
+    if (!client.outbox_overflow) {
+        client.outbox_overflow = true;
+        QueueFlush(reactor, client);
+    }
+    return true;
+}
+
+void GameServer::QueueFlush(Reactor& reactor, ClientState& client) {
+    if (!client.flush_queued) {
+        client.flush_queued = true;
+        reactor.flushing.push_back(client.socket.fd());
+    }
+}
+
+void GameServer::FlushSends(Reactor& reactor) {
+    // Listed by fd: a client closed since it was listed is simply not found (or is a newer, unlisted client).
+    for (size_t i = 0; i < reactor.flushing.size(); ++i) {
+        auto it = reactor.clients.find(reactor.flushing[i]);
+        if (it != reactor.clients.end() && it->second.flush_queued) {
+            it->second.flush_queued = false;
+            FlushClient(reactor, it->second);
+        }
+    }
+    reactor.flushing.clear();
+}
+
+void GameServer::FlushClient(Reactor& reactor, ClientState& client) {
+    const int fd = client.socket.fd();
+    if (client.outbox_overflow) {
+        Log::Info("GameServer: dropping a client that stopped reading");
+        CloseClient(reactor, fd);
+        return;
+    }
+    // Copied and shared frames go out together as one iovec array.
+    const Outbox::FlushResult result = client.outbox.flush(client.socket);
+    metrics_.send_calls.inc(result.calls);
+    metrics_.bytes_sent.inc(result.sent);
+    if (result.failed) {
+        // The peer is gone; the hang-up event closes the client.
+        client.outbox.clear();
+        return;
+    }
+    if (client.outbox.empty()) {
+        if (client.write_blocked) {
+            client.write_blocked = false;
+            reactor.epoll.modify(fd, kClientEvents);
+        }
+        return;
+    }
+    if (!client.write_blocked) {
+        client.write_blocked = true;
+        reactor.epoll.modify(fd, kBlockedClientEvents);
+    }
+}
+
+void GameServer::Send(Session& session, std::span<const uint8_t> frame) {
+    if (session.client != nullptr) {
+        QueueSend(*reactors_[session.reactor], *session.client, frame);
+        return;
+    }
+    // Shard thread: queue for the owning reactor, which is woken once at the end of the tick.
+    PostOutbound(session.shard, session.reactor, OutboundMessage::Kind::Frame, session.connection, 0, frame);
+}
+
+void GameServer::SendShared(Session& session, const SharedFrame& frame) {
+    if (session.client != nullptr) {
+        QueueShared(*reactors_[session.reactor], *session.client, frame);
+        return;
+    }
+    PostOutbound(session.shard, session.reactor, OutboundMessage::Kind::Shared, session.connection, 0, {}, frame);
+}
+
+void GameServer::Broadcast(Shard& shard, std::span<const uint32_t> players, std::span<const uint8_t> frame) {
+    // A reference costs an allocation, a reference count and an iovec; below the outbox's threshold copying is cheaper.
+    if (frame.size() < Outbox::kMinSharedBytes) {
+        for (const uint32_t player : players) {
+            if (Session* target = FindPlayer(shard, static_cast<uint16_t>(player))) {
+                Send(*target, frame);
+            }
+        }
+        return;
+    }
+    const SharedFrame shared = SharedFrame::copyOf(frame);
+    for (const uint32_t player : players) {
+        if (Session* target = FindPlayer(shard, static_cast<uint16_t>(player))) {
+            SendShared(*target, shared);
+        }
+    }
+}
+
+bool GameServer::AllowRate(Session& session, uint8_t rateClass, Clock::time_point now) {
+    const uint32_t limit = rate_limits_[rateClass];
+    if (limit == 0) {
+        return true;
+    }
+    // Fixed one-second windows shared by all classes of a client.
+    if (now - session.rate_window >= std::chrono::seconds(1)) {
+        session.rate_window = now;
+        session.rate_counts.fill(0);
     }
+    return ++session.rate_counts[rateClass] <= limit;
 }
 
-void GameServer::HandleRead(int fd) {
-    auto it = clients_.find(fd);
-    if (it == clients_.end()) {
+template <typename ProtocolT>
+void GameServer::HandleLogin(Session& session, std::span<const uint8_t> frame) {
+    using Packets = GamePackets<ProtocolT>;
+    const auto* request = viewPacket<typename Packets::LoginRequest>(frame);
+    // There is no account store yet: every account is accepted.
+    uint8_t account[sizeof(request->account)];
+    std::memcpy(account, request->account, sizeof(account));
+    buxConvert(account);
+    session.account = nameField(account);
+    session.state = kStateAuthenticated;
+    Log::Info("GameServer: account '" + session.account + "' logged in (index " + std::to_string(session.index) +
+              ")");
+    auto reply = makePacket<typename Packets::LoginResult>();
+    reply.result = 0x01;
+    Send(session, packetBytes(reply));
+}
+
+template <typename ProtocolT>
+void GameServer::HandleCharacterList(Session& session, std::span<const uint8_t>) {
+    // Characters are not stored yet, so the list is always empty.
+    Send(session, packetBytes(makePacket<typename GamePackets<ProtocolT>::CharacterListResponse>()));
+}
+
+template <typename ProtocolT>
+void GameServer::HandleSelectCharacter(Session& session, std::span<const uint8_t> frame) {
+    const auto* request = viewPacket<typename GamePackets<ProtocolT>::SelectCharacterRequest>(frame);
+    session.character = nameField(request->name);
+    session.state = kStateInGame;
+    // There is no character store yet: everyone enters at the Lorencia spawn.
+    session.map = static_cast<uint8_t>(WorldMap::Lorencia);
+    session.x = kWorldMaps[session.map].spawn_x;
+    session.y = kWorldMaps[session.map].spawn_y;
+    ShardMessage registration;
+    registration.kind = ShardMessage::Kind::Register;
+    registration.index = session.index;
+    registration.name = session.character;
+    PostMail(*shards_[session.shard], HomeShard(session.character), std::move(registration));
+    // A session on another map's shard joins that shard's viewports when it arrives there.
+    if (ShardOfMap(session.map) != session.shard) {
+        session.transfer = ShardOfMap(session.map);
+    } else {
+        EnterMap(session);
+    }
+    Log::Info("GameServer: '" + session.account + "' entered the world as '" + session.character + "'");
+}
+
+template <typename ProtocolT>
+void GameServer::HandleWalk(Session& session, std::span<const uint8_t> frame) {
+    using Packets = GamePackets<ProtocolT>;
+    const auto* request = viewPacket<typename Packets::WalkRequest>(frame);
+    session.x = request->x;
+    session.y = request->y;
+    shards_[session.shard]->entities.place(session.entity, session.x, session.y);
+    ViewportTracker& viewport = ViewportOf(session);
+    viewport.move(session.index, session.x, session.y);
+    const std::span<const uint32_t> watchers = viewport.visible(session.index);
+    if (watchers.empty()) {
+        return;
+    }
+    // Everyone watching gets the same bytes.
+    auto moved = makePacket<typename Packets::ObjectMoved>();
+    moved.index = session.index;
+    moved.x = session.x;
+    moved.y = session.y;
+    // The first path byte carries the facing direction in its high nibble.
+    moved.direction = frame.size() > sizeof(typename Packets::WalkRequest)
+                              ? static_cast<uint8_t>(frame[sizeof(typename Packets::WalkRequest)] & 0xF0)
+                              : 0;
+    Broadcast(*shards_[session.shard], watchers, packetBytes(moved));
+}
+
+template <typename ProtocolT>
+void GameServer::HandleWarp(Session& session, std::span<const uint8_t> frame) {
+    using Packets = GamePackets<ProtocolT>;
+    const auto* request = viewPacket<typename Packets::WarpRequest>(frame);
+    if (!isWorldMap(request->map)) {
+        return;
+    }
+    LeaveMap(session);
+    session.map = request->map;
+    session.x = kWorldMaps[session.map].spawn_x;
+    session.y = kWorldMaps[session.map].spawn_y;
+    auto reply = makePacket<typename Packets::Teleport>();
+    reply.map = session.map;
+    reply.x = session.x;
+    reply.y = session.y;
+    Send(session, packetBytes(reply));
+    // The dispatcher hands the session over once this handler returns.
+    if (ShardOfMap(session.map) != session.shard) {
+        session.transfer = ShardOfMap(session.map);
+    } else {
+        EnterMap(session);
+    }
+}
+
+template <typename ProtocolT>
+void GameServer::HandleWhisper(Session& session, std::span<const uint8_t> frame) {
+    using Packets = GamePackets<ProtocolT>;
+    const auto* request = viewPacket<typename Packets::Whisper>(frame);
+    ShardMessage whisper;
+    whisper.kind = ShardMessage::Kind::Whisper;
+    whisper.name = nameField(request->name);
+    whisper.index = session.index;
+    // The target receives the same frame with the sender's name in place of its own.
+    whisper.frame.assign(frame.begin(), frame.end());
+    auto* forwarded = reinterpret_cast<typename Packets::Whisper*>(whisper.frame.data());
+    std::memset(forwarded->name, 0, sizeof(forwarded->name));
+    std::memcpy(forwarded->name, session.character.data(), std::min(session.character.size(), sizeof(forwarded->name)));
+    const auto failed = makePacket<typename Packets::WhisperFailed>();
+    whisper.reply.assign(packetBytes(failed).begin(), packetBytes(failed).end());
+    PostMail(*shards_[session.shard], HomeShard(whisper.name), std::move(whisper));
+}
+
+template <typename ProtocolT>
+void GameServer::HandlePartyRequest(Session& session, std::span<const uint8_t> frame) {
+    using Packets = GamePackets<ProtocolT>;
+    const auto* request = viewPacket<typename Packets::PartyRequest>(frame);
+    const uint16_t target = request->index;
+    const uint32_t owner = player_shards_[target].load(std::memory_order_acquire);
+    if (target == session.index || owner == kNoShard) {
+        return;
+    }
+    auto invitation = makePacket<typename Packets::PartyRequest>();
+    invitation.index = session.index;
+    ShardMessage deliver;
+    deliver.kind = ShardMessage::Kind::Deliver;
+    deliver.index = target;
+    deliver.frame.assign(packetBytes(invitation).begin(), packetBytes(invitation).end());
+    PostMail(*shards_[session.shard], owner, std::move(deliver));
+}
+
+void GameServer::HandleRead(Reactor& reactor, int fd) {
+    auto it = reactor.clients.find(fd);
+    if (it == reactor.clients.end()) {
         return;
     }
 
     ClientState& client = it->second;
+    const size_t buffered = client.buffer.size();
     std::array<uint8_t, 1024> temp{};
-    // Read until the socket would block or closes.
-    while (true) {
-        ssize_t bytes = client.socket.recv(temp);
-        if (bytes > 0) {
-            // Append bytes to the client buffer and log the new data.
-            client.buffer.insert(client.buffer.end(), temp.begin(), temp.begin() + static_cast<size_t>(bytes));
-            total_bytes_received_ += static_cast<size_t>(bytes);
-            LogHexDump(temp.data(), static_cast<size_t>(bytes));
+    {
+        DARKEMU_TRACE_SPAN("recv", fd);
+        // Read until the socket would block or closes.
+        while (true) {
+            ssize_t bytes = client.socket.recv(temp);
+            if (bytes > 0) {
+                // Append bytes to the client buffer.
+                client.buffer.insert(client.buffer.end(), temp.begin(), temp.begin() + static_cast<size_t>(bytes));
+                total_bytes_received_.fetch_add(static_cast<size_t>(bytes), std::memory_order_relaxed);
+                metrics_.bytes_received.inc(static_cast<uint64_t>(bytes));
+                metrics_.recv_calls.inc();
+                continue;
+            }
+            if (bytes == 0) {
+                // Peer closed its side: dispatch what it sent last, then close with the batch.
+                if (client.buffer.size() == buffered) {
+                    CloseClient(reactor, fd);
+                    return;
+                }
+                client.batch_close = true;
+                break;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            Log::Info(std::string("recv error: ") + std::strerror(errno));
+            CloseClient(reactor, fd);
+            return;
+        }
+    }
+    if (client.buffer.size() > buffered) {
+        reactor.readable.push_back(&client);
+    }
+}
+
+template <typename ProtocolT>
+void GameServer::ProcessBatch(Reactor& reactor) {
+    if (reactor.readable.empty()) {
+        return;
+    }
+    const Clock::time_point now = Clock::now();
+    {
+        // Frame, decrypt and decode the whole batch stage by stage, one trace span per stage.
+        LoopMonitor::HandlerScope scope(reactor.monitor, -1);
+        {
+            DARKEMU_TRACE_SPAN("frame", static_cast<int64_t>(reactor.readable.size()));
+            GatherFrames<ProtocolT>(reactor);
+        }
+        {
+            DARKEMU_TRACE_SPAN("decrypt", static_cast<int64_t>(reactor.batch.size()));
+            DecryptFrames<ProtocolT>(reactor);
+        }
+        DARKEMU_TRACE_SPAN("decode", static_cast<int64_t>(reactor.batch.size()));
+        DecodeFrames<ProtocolT>(reactor);
+    }
+    if (threaded_) {
+        EnqueueFrames(reactor);
+    } else {
+        DispatchFrames<ProtocolT>(reactor, now);
+    }
+
+    // Drop the dispatched bytes; clients that sent something undecodable are closed only now,
+    // because their frames pointed into buffers the batch was still using.
+    for (ClientState* client : reactor.readable) {
+        if (client->batch_close) {
+            CloseClient(reactor, client->socket.fd());
             continue;
         }
-        if (bytes == 0) {
-            // Peer closed the connection.
-            CloseClient(fd);
-            return;
+        client->buffer.erase(client->buffer.begin(),
+                             client->buffer.begin() + static_cast<std::ptrdiff_t>(client->batch_consumed));
+        client->batch_frames = 0;
+        client->batch_valid = 0;
+        client->batch_consumed = 0;
+    }
+    reactor.readable.clear();
+    reactor.batch.clear();
+    reactor.dispatch_order.clear();
+}
+
+template <typename ProtocolT>
+void GameServer::GatherFrames(Reactor& reactor) {
+    using Framer = BasicPacketFramer<typename ProtocolT::Frames>;
+    std::vector<PendingFrame>& batch = reactor.batch;
+    for (ClientState* client : reactor.readable) {
+        const size_t first = batch.size();
+        bool invalid = false;
+        client->batch_consumed = Framer::forEachFrameInPlace(client->buffer, [&](std::span<uint8_t> frame) {
+            // Captures keep the wire bytes so a replay goes through decoding again.
+            if (recorder_) {
+                recorder_->clientData(client->capture_id, frame);
+            }
+            batch.push_back(PendingFrame{client, frame.data(), static_cast<uint32_t>(frame.size()),
+                                         static_cast<uint32_t>(batch.size() - first)});
+        }, invalid);
+        client->batch_frames = static_cast<uint32_t>(batch.size() - first);
+        client->batch_valid = client->batch_frames;
+        if (invalid) {
+            // Frames before the bad header are still dispatched.
+            Log::Info("GameServer: malformed packet header from fd " + std::to_string(client->socket.fd()));
+            client->batch_close = true;
         }
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            break;
+    }
+}
+
+template <typename ProtocolT>
+void GameServer::DecryptFrames(Reactor& reactor) {
+    using Framer = BasicPacketFramer<typename ProtocolT::Frames>;
+    // Plaintext never outgrows its ciphertext, so one arena sized to the C3/C4 bytes holds them all.
+    size_t needed = 0;
+    for (const PendingFrame& pending : reactor.batch) {
+        if (Framer::isEncrypted(pending.data[0])) {
+            needed += pending.size;
         }
-        Log::Info(std::string("recv error: ") + std::strerror(errno));
-        CloseClient(fd);
+    }
+    if (needed == 0) {
         return;
     }
+    if (reactor.plain_arena.size() < needed) {
+        reactor.plain_arena.resize(needed);
+    }
+
+    size_t offset = 0;
+    for (PendingFrame& pending : reactor.batch) {
+        ClientState& client = *pending.client;
+        if (!Framer::isEncrypted(pending.data[0]) || pending.wave >= client.batch_valid) {
+            continue;
+        }
+        const std::span<uint8_t> out(reactor.plain_arena.data() + offset, pending.size);
+        size_t size = 0;
+        uint8_t serial = 0;
+        if (!decoder_.decryptFrame({pending.data, pending.size}, out, size, serial)) {
+            // Keep the frames before this one; drop it and everything after.
+            Log::Info("GameServer: undecryptable packet from fd " + std::to_string(client.socket.fd()));
+            client.batch_valid = pending.wave;
+            client.batch_close = true;
+            continue;
+        }
+        pending.data = out.data();
+        pending.size = static_cast<uint32_t>(size);
+        offset += size;
+    }
 }
 
-void GameServer::CloseClient(int fd) {
+template <typename ProtocolT>
+void GameServer::DecodeFrames(Reactor& reactor) {
+    using Framer = BasicPacketFramer<typename ProtocolT::Frames>;
+    // Wave-major keys keep each client's frames in order while grouping equal opcodes within a wave;
+    // the low bits index the batch, so sorting moves 8-byte keys rather than frame records.
+    constexpr uint64_t kMaxWave = (uint64_t{1} << 20) - 1;
+    reactor.dispatch_order.clear();
+    for (size_t i = 0; i < reactor.batch.size(); ++i) {
+        PendingFrame& pending = reactor.batch[i];
+        if (pending.wave >= pending.client->batch_valid) {
+            continue;
+        }
+        // The client XORs every C1/C2 body, including the ones it then wraps in C3/C4.
+        const std::span<uint8_t> frame(pending.data, pending.size);
+        xor_.decodeFrame(frame);
+        const size_t header = Framer::headerSize(frame[0]);
+        const uint64_t head = frame[header];
+        const uint64_t sub = frame.size() > header + 1 ? frame[header + 1] : 0;
+        const uint64_t wave = std::min<uint64_t>(pending.wave, kMaxWave);
+        reactor.dispatch_order.push_back((wave << 44) | (head << 36) | (sub << 28) | i);
+        if (log_packets_) {
+            LogHexDump(frame.data(), frame.size());
+        }
+    }
+}
+
+template <typename ProtocolT>
+void GameServer::DispatchFrames(Reactor& reactor, Clock::time_point now) {
+    using Framer = BasicPacketFramer<typename ProtocolT::Frames>;
+    // With a single client the gather order already is the dispatch order.
+    if (reactor.readable.size() > 1) {
+        std::sort(reactor.dispatch_order.begin(), reactor.dispatch_order.end());
+    }
+
+    // Every dispatch is timed on its own against the handler budget; the counters are published once per batch.
+    uint64_t dispatched = 0;
+    uint64_t rejected = 0;
+    for (const uint64_t key : reactor.dispatch_order) {
+        const PendingFrame& pending = reactor.batch[key & kBatchIndexMask];
+        Session& session = *pending.client->session;
+        const std::span<const uint8_t> frame(pending.data, pending.size);
+        const uint8_t head = frame[Framer::headerSize(frame[0])];
+        LoopMonitor::HandlerScope scope(reactor.monitor, pending.client->socket.fd());
+        reactor.monitor.noteOpcode(head);
+        DARKEMU_TRACE_SPAN("handler", head);
+        const DispatchStatus status = Routes<ProtocolT>::Table::dispatch(
+            *this, session, frame, session.state,
+            [&](uint8_t rateClass) { return AllowRate(session, rateClass, now); });
+        ++(status == DispatchStatus::Dispatched ? dispatched : rejected);
+    }
+    if (dispatched != 0) {
+        metrics_.dispatched.inc(dispatched);
+    }
+    if (rejected != 0) {
+        metrics_.rejected.inc(rejected);
+    }
+}
+
+void GameServer::EnqueueFrames(Reactor& reactor) {
+    // Keys were appended in gather order, which already keeps each client's frames in sequence;
+    // grouping by opcode is the simulation's business now.
+    for (const uint64_t key : reactor.dispatch_order) {
+        const PendingFrame& pending = reactor.batch[key & kBatchIndexMask];
+        PostInbound(reactor, pending.client->shard, InboundMessage::Kind::Frame, pending.client->connection,
+                    pending.client->index, {pending.data, pending.size});
+    }
+}
+
+void GameServer::CloseClient(Reactor& reactor, int fd) {
     // Remove from epoll and erase from the connection map.
-    epoll_.remove(fd);
-    clients_.erase(fd);
+    reactor.epoll.remove(fd);
+    auto it = reactor.clients.find(fd);
+    if (it == reactor.clients.end()) {
+        return;
+    }
+    ClientState& client = it->second;
+    if (!client.outbox.empty()) {
+        // Best effort: replies to the frames before a bad one still reach the client.
+        metrics_.send_calls.inc(client.outbox.flush(client.socket).calls);
+    }
+    if (recorder_) {
+        recorder_->close(client.capture_id);
+    }
+    if (threaded_) {
+        PostInbound(reactor, client.shard, InboundMessage::Kind::Close, client.connection, client.index, {});
+    } else {
+        CloseSession(*shards_[0], client.connection);
+    }
+    reactor.clients.erase(it);
+    metrics_.active.add(-1);
 }
 
 void GameServer::LogHexDump(const uint8_t* data, size_t size) const {
@@ -0,0 +1,341 @@
+/**
+ * Copyright (c) DarkEmu
+ * Batched monster AI for one map: sleeping and waking, SIMD target search, idle/chase/attack/return.
+ */
+
+#include "GameServer/MonsterAi.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DARKEMU_MONSTERAI_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using SimdLevel = MonsterAi::SimdLevel;
+
+inline int32_t squaredDistance(int32_t ax, int32_t ay, int32_t bx, int32_t by) noexcept {
+    return (ax - bx) * (ax - bx) + (ay - by) * (ay - by);
+}
+
+// Candidates [first, count) one at a time; strictly closer only, so the earliest of equal distances wins.
+void nearestScalar(const int32_t* xs, const int32_t* ys, size_t first, size_t count, int32_t x, int32_t y,
+                   int32_t& best, uint32_t& found) noexcept {
+    for (size_t i = first; i < count; ++i) {
+        const int32_t d2 = squaredDistance(xs[i], ys[i], x, y);
+        if (d2 < best) {
+            best = d2;
+            found = static_cast<uint32_t>(i);
+        }
+    }
+}
+
+#ifdef DARKEMU_MONSTERAI_X86
+
+/*
+ * Vector kernels keep the best distance and its index per lane, then reduce
+ * the lanes: the smallest distance wins and, among equal ones, the smallest
+ * index, which is what the scalar scan would have picked. Lanes that never
+ * beat the starting best keep index -1. They return the first candidate left
+ * for the scalar loop.
+ */
+
+// Fold per-lane bests into best/found.
+void reduceLanes(const int32_t* lane_best, const int32_t* lane_index, size_t lanes, int32_t& best,
+                 uint32_t& found) noexcept {
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        if (lane_index[lane] < 0) {
+            continue;
+        }
+        const auto index = static_cast<uint32_t>(lane_index[lane]);
+        if (lane_best[lane] < best || (lane_best[lane] == best && index < found)) {
+            best = lane_best[lane];
+            found = index;
+        }
+    }
+}
+
+__attribute__((target("sse4.1"))) size_t nearestSse41(const int32_t* xs, const int32_t* ys, size_t count, int32_t x,
+                                                      int32_t y, int32_t& best, uint32_t& found) noexcept {
+    const __m128i px = _mm_set1_epi32(x);
+    const __m128i py = _mm_set1_epi32(y);
+    const __m128i step = _mm_set1_epi32(4);
+    __m128i best_d2 = _mm_set1_epi32(best);
+    __m128i best_index = _mm_set1_epi32(-1);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i dx = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i)), px);
+        const __m128i dy = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i)), py);
+        const __m128i d2 = _mm_add_epi32(_mm_mullo_epi32(dx, dx), _mm_mullo_epi32(dy, dy));
+        const __m128i closer = _mm_cmplt_epi32(d2, best_d2);
+        best_d2 = _mm_min_epi32(d2, best_d2);
+        best_index = _mm_blendv_epi8(best_index, index, closer);
+        index = _mm_add_epi32(index, step);
+    }
+    alignas(16) int32_t lane_best[4];
+    alignas(16) int32_t lane_index[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lane_best), best_d2);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lane_index), best_index);
+    reduceLanes(lane_best, lane_index, 4, best, found);
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t nearestAvx2(const int32_t* xs, const int32_t* ys, size_t count, int32_t x,
+                                                   int32_t y, int32_t& best, uint32_t& found) noexcept {
+    const __m256i px = _mm256_set1_epi32(x);
+    const __m256i py = _mm256_set1_epi32(y);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i best_d2 = _mm256_set1_epi32(best);
+    __m256i best_index = _mm256_set1_epi32(-1);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i dx = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i)), px);
+        const __m256i dy = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i)), py);
+        const __m256i d2 = _mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy));
+        const __m256i closer = _mm256_cmpgt_epi32(best_d2, d2);
+        best_d2 = _mm256_min_epi32(d2, best_d2);
+        best_index = _mm256_blendv_epi8(best_index, index, closer);
+        index = _mm256_add_epi32(index, step);
+    }
+    alignas(32) int32_t lane_best[8];
+    alignas(32) int32_t lane_index[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_best), best_d2);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_index), best_index);
+    reduceLanes(lane_best, lane_index, 8, best, found);
+    return i;
+}
+
+#endif // DARKEMU_MONSTERAI_X86
+
+} // namespace
+
+void MonsterAi::add(EntityStore& store, EntityHandle monster) {
+    const uint32_t index = store.indexOf(monster);
+    if (index == EntityStore::kNoIndex) {
+        return;
+    }
+    store.aiState()[index] = static_cast<uint8_t>(State::Idle);
+    store.target()[index] = {};
+    if (monster.slot >= sleeping_generation_.size()) {
+        sleeping_generation_.resize(monster.slot + 1);
+    }
+    sleeping_generation_[monster.slot] = monster.generation;
+    sleeping_.insert(monster.slot, store.x()[index], store.y()[index]);
+}
+
+void MonsterAi::remove(EntityHandle monster) {
+    if (sleeping_.contains(monster.slot) && sleeping_generation_[monster.slot] == monster.generation) {
+        sleeping_.remove(monster.slot);
+        return;
+    }
+    auto it = std::find(awake_.begin(), awake_.end(), monster);
+    if (it != awake_.end()) {
+        *it = awake_.back();
+        awake_.pop_back();
+    }
+}
+
+MonsterAi::TickStats MonsterAi::update(EntityStore& store, std::span<const EntityHandle> players) {
+    TickStats stats;
+    if (empty()) {
+        return stats;
+    }
+    sortPlayers(store, players);
+    stats.woken = wakeNearPlayers();
+
+    const std::span<uint8_t> xs = store.x();
+    const std::span<uint8_t> ys = store.y();
+    const std::span<uint8_t> dest_x = store.destX();
+    const std::span<uint8_t> dest_y = store.destY();
+    const std::span<uint8_t> states = store.aiState();
+    const std::span<EntityHandle> targets = store.target();
+    const std::span<const uint32_t> flags = std::as_const(store).flags();
+    const std::span<const uint8_t> maps = store.map();
+    const std::span<const uint8_t> home_x = store.homeX();
+    const std::span<const uint8_t> home_y = store.homeY();
+    const std::span<const uint8_t> view_range = store.viewRange();
+    const std::span<const uint8_t> attack_range = store.attackRange();
+
+    for (size_t i = 0; i < awake_.size();) {
+        const EntityHandle monster = awake_[i];
+        const uint32_t index = store.indexOf(monster);
+        // Destroyed without remove(), or dead: neither acts. A dead monster sleeps until it is revived.
+        const bool gone = index == EntityStore::kNoIndex;
+        bool sleep = !gone && (flags[index] & EntityStore::kFlagDead) != 0;
+        if (!gone && !sleep) {
+            auto state = static_cast<State>(states[index]);
+            if (state == State::Idle) {
+                bool has_candidates = false;
+                const uint32_t nearest = nearestPlayer(xs[index], ys[index], view_range[index], has_candidates);
+                if (nearest != kNone) {
+                    targets[index] = player_handles_[nearest];
+                    state = State::Chase;
+                } else {
+                    sleep = !has_candidates;
+                }
+            }
+            if (state == State::Chase || state == State::Attack) {
+                const uint32_t target = store.indexOf(targets[index]);
+                const bool lost = target == EntityStore::kNoIndex || (flags[target] & EntityStore::kFlagDead) != 0 ||
+                                  maps[target] != maps[index];
+                const bool strayed = squaredDistance(xs[index], ys[index], home_x[index], home_y[index]) >
+                                     kLeashRange * kLeashRange;
+                if (lost || strayed) {
+                    state = State::Return;
+                } else if (squaredDistance(xs[index], ys[index], xs[target], ys[target]) <=
+                           attack_range[index] * attack_range[index]) {
+                    state = State::Attack;
+                    dest_x[index] = xs[index];
+                    dest_y[index] = ys[index];
+                    ++stats.attacks;
+                } else {
+                    state = State::Chase;
+                    dest_x[index] = xs[target];
+                    dest_y[index] = ys[target];
+                }
+            }
+            if (state == State::Return) {
+                targets[index] = {};
+                dest_x[index] = home_x[index];
+                dest_y[index] = home_y[index];
+                if (xs[index] == home_x[index] && ys[index] == home_y[index]) {
+                    state = State::Idle;
+                }
+            }
+            states[index] = static_cast<uint8_t>(state);
+        }
+        if (gone || sleep) {
+            if (sleep) {
+                sleeping_generation_[monster.slot] = monster.generation;
+                sleeping_.insert(monster.slot, xs[index], ys[index]);
+                ++stats.slept;
+            }
+            awake_[i] = awake_.back();
+            awake_.pop_back();
+            continue;
+        }
+        ++i;
+    }
+    stats.awake = static_cast<uint32_t>(awake_.size());
+    return stats;
+}
+
+uint32_t MonsterAi::findNearest(SimdLevel level, std::span<const int32_t> xs, std::span<const int32_t> ys, int32_t x,
+                                int32_t y, int32_t& best) noexcept {
+    const size_t count = std::min(xs.size(), ys.size());
+    uint32_t found = kNone;
+    size_t first = 0;
+#ifdef DARKEMU_MONSTERAI_X86
+    level = std::min(level, SimpleModulus::supportedSimdLevel());
+    if (level == SimdLevel::Avx2) {
+        first = nearestAvx2(xs.data(), ys.data(), count, x, y, best, found);
+    } else if (level == SimdLevel::Sse41) {
+        first = nearestSse41(xs.data(), ys.data(), count, x, y, best, found);
+    }
+#else
+    (void) level;
+#endif
+    nearestScalar(xs.data(), ys.data(), first, count, x, y, best, found);
+    return found;
+}
+
+void MonsterAi::setSimdLevel(SimdLevel level) noexcept {
+    simd_level_ = std::min(level, SimpleModulus::supportedSimdLevel());
+}
+
+void MonsterAi::sortPlayers(const EntityStore& store, std::span<const EntityHandle> players) {
+    // Counting sort by cell: count into cell_start_[cell + 1], prefix-sum to starts, place, shift back.
+    cell_start_.fill(0);
+    player_cells_.clear();
+    const std::span<const uint8_t> xs = store.x();
+    const std::span<const uint8_t> ys = store.y();
+    const std::span<const uint32_t> flags = store.flags();
+    size_t count = 0;
+    for (const EntityHandle player : players) {
+        const uint32_t index = store.indexOf(player);
+        if (index == EntityStore::kNoIndex || (flags[index] & EntityStore::kFlagDead) != 0) {
+            continue;
+        }
+        ++cell_start_[SpatialGrid::cellOf(xs[index], ys[index]) + 1];
+        ++count;
+    }
+    for (size_t cell = 1; cell <= kCellCount; ++cell) {
+        cell_start_[cell] += cell_start_[cell - 1];
+    }
+    players_x_.resize(count);
+    players_y_.resize(count);
+    player_handles_.resize(count);
+    for (const EntityHandle player : players) {
+        const uint32_t index = store.indexOf(player);
+        if (index == EntityStore::kNoIndex || (flags[index] & EntityStore::kFlagDead) != 0) {
+            continue;
+        }
+        const uint16_t cell = SpatialGrid::cellOf(xs[index], ys[index]);
+        const uint32_t slot = cell_start_[cell]++;
+        players_x_[slot] = xs[index];
+        players_y_[slot] = ys[index];
+        player_handles_[slot] = player;
+        player_cells_.push_back(cell);
+    }
+    // Placing advanced every start to the next cell's start.
+    std::copy_backward(cell_start_.begin(), cell_start_.end() - 1, cell_start_.end());
+    cell_start_[0] = 0;
+    std::sort(player_cells_.begin(), player_cells_.end());
+    player_cells_.erase(std::unique(player_cells_.begin(), player_cells_.end()), player_cells_.end());
+}
+
+uint32_t MonsterAi::wakeNearPlayers() {
+    if (sleeping_.size() == 0) {
+        return 0;
+    }
+    waking_.clear();
+    for (const uint16_t cell : player_cells_) {
+        const auto x = static_cast<uint8_t>((cell % SpatialGrid::kCells) * SpatialGrid::kCellSize);
+        const auto y = static_cast<uint8_t>((cell / SpatialGrid::kCells) * SpatialGrid::kCellSize);
+        sleeping_.forEachInCellBlock(x, y, kWakeCells,
+                                     [this](const SpatialGrid::Slot& slot) { waking_.push_back(slot); });
+    }
+    uint32_t woken = 0;
+    for (const SpatialGrid::Slot& slot : waking_) {
+        // Blocks of neighbouring players overlap, so a sleeper can be listed twice.
+        if (!sleeping_.contains(slot.entity)) {
+            continue;
+        }
+        sleeping_.remove(slot.entity);
+        awake_.push_back(EntityHandle{slot.entity, sleeping_generation_[slot.entity]});
+        ++woken;
+    }
+    return woken;
+}
+
+uint32_t MonsterAi::nearestPlayer(uint8_t x, uint8_t y, uint8_t range, bool& has_candidates) const noexcept {
+    const uint32_t cx = x / SpatialGrid::kCellSize;
+    const uint32_t cy = y / SpatialGrid::kCellSize;
+    const uint32_t min_cx = cx > kWakeCells ? cx - kWakeCells : 0;
+    const uint32_t min_cy = cy > kWakeCells ? cy - kWakeCells : 0;
+    const uint32_t max_cx = std::min(cx + kWakeCells, SpatialGrid::kCells - 1);
+    const uint32_t max_cy = std::min(cy + kWakeCells, SpatialGrid::kCells - 1);
+    int32_t best = static_cast<int32_t>(range) * range + 1;
+    uint32_t found = kNone;
+    for (uint32_t row = min_cy; row <= max_cy; ++row) {
+        // The cells of one row of the block are adjacent, so their players are one contiguous run.
+        const uint32_t begin = cell_start_[row * SpatialGrid::kCells + min_cx];
+        const uint32_t end = cell_start_[row * SpatialGrid::kCells + max_cx + 1];
+        if (begin == end) {
+            continue;
+        }
+        has_candidates = true;
+        const uint32_t nearest =
+                findNearest(simd_level_, std::span<const int32_t>(players_x_).subspan(begin, end - begin),
+                            std::span<const int32_t>(players_y_).subspan(begin, end - begin), x, y, best);
+        if (nearest != kNone) {
+            found = begin + nearest;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) DarkEmu
+ * Uniform grid over a 256x256 map for "who is within N tiles" queries.
+ */
+
+#include "GameServer/SpatialGrid.h"
+
+void SpatialGrid::insert(uint32_t entity, uint8_t x, uint8_t y) {
+    if (entity >= locations_.size()) {
+        locations_.resize(entity + 1);
+    }
+    Location& location = locations_[entity];
+    if (location.cell != kAbsent) {
+        move(entity, x, y);
+        return;
+    }
+    std::vector<Slot>& cell = cells_[cellOf(x, y)];
+    location.cell = cellOf(x, y);
+    location.slot = static_cast<uint32_t>(cell.size());
+    cell.push_back(Slot{entity, x, y});
+    ++size_;
+}
+
+bool SpatialGrid::move(uint32_t entity, uint8_t x, uint8_t y) {
+    if (!contains(entity)) {
+        insert(entity, x, y);
+        return true;
+    }
+    Location& location = locations_[entity];
+    const uint16_t target = cellOf(x, y);
+    if (location.cell == target) {
+        // Most steps stay inside an 8x8 cell: just rewrite the slot.
+        Slot& slot = cells_[target][location.slot];
+        slot.x = x;
+        slot.y = y;
+        return false;
+    }
+    unlink(location);
+    std::vector<Slot>& cell = cells_[target];
+    location.cell = target;
+    location.slot = static_cast<uint32_t>(cell.size());
+    cell.push_back(Slot{entity, x, y});
+    return true;
+}
+
+void SpatialGrid::remove(uint32_t entity) {
+    if (!contains(entity)) {
+        return;
+    }
+    Location& location = locations_[entity];
+    unlink(location);
+    location.cell = kAbsent;
+    --size_;
+}
+
+size_t SpatialGrid::query(uint8_t x, uint8_t y, uint8_t radius, std::vector<uint32_t>& out) const {
+    const size_t before = out.size();
+    forEachInRange(x, y, radius, [&out](const Slot& slot) { out.push_back(slot.entity); });
+    return out.size() - before;
+}
+
+void SpatialGrid::unlink(const Location& location) {
+    std::vector<Slot>& cell = cells_[location.cell];
+    // Fill the hole with the cell's last slot and repoint that entity.
+    const Slot last = cell.back();
+    cell[location.slot] = last;
+    locations_[last.entity].slot = location.slot;
+    cell.pop_back();
+}
@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) DarkEmu
+ * Incremental viewports: who sees whom on one map, as enter/leave deltas.
+ */
+
+#include "GameServer/Viewport.h"
+
+#include <algorithm>
+
+namespace {
+
+bool containsSorted(const std::vector<uint32_t>& values, uint32_t value) {
+    return std::binary_search(values.begin(), values.end(), value);
+}
+
+void insertSorted(std::vector<uint32_t>& values, uint32_t value) {
+    auto it = std::lower_bound(values.begin(), values.end(), value);
+    if (it == values.end() || *it != value) {
+        values.insert(it, value);
+    }
+}
+
+bool eraseSorted(std::vector<uint32_t>& values, uint32_t value) {
+    auto it = std::lower_bound(values.begin(), values.end(), value);
+    if (it == values.end() || *it != value) {
+        return false;
+    }
+    values.erase(it);
+    return true;
+}
+
+/// Remove value from an unsorted list; false when it was not there.
+bool eraseUnordered(std::vector<uint32_t>& values, uint32_t value) {
+    auto it = std::find(values.begin(), values.end(), value);
+    if (it == values.end()) {
+        return false;
+    }
+    *it = values.back();
+    values.pop_back();
+    return true;
+}
+
+} // namespace
+
+void ViewportTracker::add(uint32_t entity, uint8_t x, uint8_t y) {
+    if (find(entity) != nullptr) {
+        move(entity, x, y);
+        return;
+    }
+    if (entity >= slots_.size()) {
+        slots_.resize(entity + 1, kNoViewer);
+    }
+    slots_[entity] = static_cast<uint32_t>(viewers_.size());
+    Viewer& viewer = viewers_.emplace_back();
+    viewer.entity = entity;
+    grid_.insert(entity, x, y);
+    markMoved(viewer);
+}
+
+void ViewportTracker::move(uint32_t entity, uint8_t x, uint8_t y) {
+    Viewer* viewer = find(entity);
+    if (viewer == nullptr) {
+        add(entity, x, y);
+        return;
+    }
+    if (grid_.move(entity, x, y)) {
+        markMoved(*viewer);
+    }
+}
+
+void ViewportTracker::remove(uint32_t entity) {
+    Viewer* viewer = find(entity);
+    if (viewer == nullptr) {
+        return;
+    }
+    for (uint32_t other : viewer->visible) {
+        if (Viewer* watcher = find(other); watcher != nullptr && eraseSorted(watcher->visible, entity)) {
+            queueLeave(*watcher, entity);
+        }
+    }
+    grid_.remove(entity);
+    // Swap-remove; stale ids left in moved_ and recipients_ are skipped because their flags are gone.
+    const uint32_t slot = slots_[entity];
+    slots_[entity] = kNoViewer;
+    if (slot + 1 != viewers_.size()) {
+        viewers_[slot] = std::move(viewers_.back());
+        slots_[viewers_[slot].entity] = slot;
+    }
+    viewers_.pop_back();
+}
+
+std::span<const uint32_t> ViewportTracker::visible(uint32_t entity) const noexcept {
+    if (entity >= slots_.size() || slots_[entity] == kNoViewer) {
+        return {};
+    }
+    return viewers_[slots_[entity]].visible;
+}
+
+ViewportTracker::Viewer* ViewportTracker::find(uint32_t entity) noexcept {
+    if (entity >= slots_.size() || slots_[entity] == kNoViewer) {
+        return nullptr;
+    }
+    return &viewers_[slots_[entity]];
+}
+
+void ViewportTracker::computeDeltas() {
+    for (uint32_t entity : moved_) {
+        Viewer* viewer = find(entity);
+        if (viewer == nullptr || !viewer->moved) {
+            continue;
+        }
+        viewer->moved = false;
+        const SpatialGrid::Slot* self = grid_.find(entity);
+        scratch_.clear();
+        grid_.forEachInCellBlock(self->x, self->y, kRadiusCells, [this, entity](const SpatialGrid::Slot& slot) {
+            if (slot.entity != entity) {
+                scratch_.push_back(slot.entity);
+            }
+        });
+        std::sort(scratch_.begin(), scratch_.end());
+
+        // Merge the old and new sorted sets; visibility is symmetric, so each change applies to both sides.
+        auto before = viewer->visible.begin();
+        auto after = scratch_.begin();
+        while (before != viewer->visible.end() || after != scratch_.end()) {
+            if (after == scratch_.end() || (before != viewer->visible.end() && *before < *after)) {
+                const uint32_t other = *before++;
+                queueLeave(*viewer, other);
+                if (Viewer* watcher = find(other); watcher != nullptr && eraseSorted(watcher->visible, entity)) {
+                    queueLeave(*watcher, entity);
+                }
+            } else if (before == viewer->visible.end() || *after < *before) {
+                const uint32_t other = *after++;
+                queueEnter(*viewer, other);
+                if (Viewer* watcher = find(other); watcher != nullptr && !containsSorted(watcher->visible, entity)) {
+                    insertSorted(watcher->visible, entity);
+                    queueEnter(*watcher, entity);
+                }
+            } else {
+                ++before;
+                ++after;
+            }
+        }
+        viewer->visible.swap(scratch_);
+    }
+    moved_.clear();
+}
+
+void ViewportTracker::queueEnter(Viewer& viewer, uint32_t entity) {
+    // Left and came back before the client heard about it: it never disappeared.
+    if (!eraseUnordered(viewer.leave, entity)) {
+        viewer.enter.push_back(entity);
+    }
+    if (!viewer.queued) {
+        viewer.queued = true;
+        recipients_.push_back(viewer.entity);
+    }
+}
+
+void ViewportTracker::queueLeave(Viewer& viewer, uint32_t entity) {
+    // Came and went before the client heard about it: nothing to destroy.
+    if (!eraseUnordered(viewer.enter, entity)) {
+        viewer.leave.push_back(entity);
+    }
+    if (!viewer.queued) {
+        viewer.queued = true;
+        recipients_.push_back(viewer.entity);
+    }
+}
+
+void ViewportTracker::markMoved(Viewer& viewer) {
+    if (!viewer.moved) {
+        viewer.moved = true;
+        moved_.push_back(viewer.entity);
+    }
+}
@@ -7,14 +7,62 @@
 
 #include "Common/Utils/Logger.h"
 
+#include <chrono>
+#include <cstdlib>
 #include <exception>
 #include <string>
 
 int main() {
     try {
+        // Client build to serve, e.g. DARKEMU_GS_PROTOCOL=season9 (default season6).
+        ProtocolVersion protocol = ProtocolVersion::Season6;
+        if (const char* name = std::getenv("DARKEMU_GS_PROTOCOL")) {
+            protocol = parseProtocolVersion(name);
+        }
         // Instantiate and run the GameServer until it is terminated.
-        GameServer server;
-        server.Run();
+        GameServer server(55901, protocol);
+        Log::Info(std::string("GameServer protocol: ") + std::string(protocolName(protocol)));
+        // Optional metrics endpoint, e.g. DARKEMU_GS_STATUS_PORT=9901.
+        if (const char* status_port = std::getenv("DARKEMU_GS_STATUS_PORT")) {
+            server.EnableStatusEndpoint(static_cast<uint16_t>(std::stoul(status_port)));
+        }
+        // Optional per-handler budget for the slow-handler log, e.g. DARKEMU_HANDLER_BUDGET_US=500.
+        if (const char* budget = std::getenv("DARKEMU_HANDLER_BUDGET_US")) {
+            server.SetHandlerBudget(std::chrono::microseconds(std::stoul(budget)));
+        }
+        // Optional session capture for replay, e.g. DARKEMU_GS_CAPTURE=/tmp/gs.demucap.
+        if (const char* capture = std::getenv("DARKEMU_GS_CAPTURE")) {
+            server.EnableCapture(capture);
+        }
+        // Optional hex dump of every decoded frame, e.g. DARKEMU_GS_LOG_PACKETS=1.
+        if (const char* log_packets = std::getenv("DARKEMU_GS_LOG_PACKETS")) {
+            server.SetPacketLogging(std::string(log_packets) != "0");
+        }
+        // Optional directory holding Dec2.dat, e.g. DARKEMU_GS_KEY_DIR=/etc/darkemu; built-in keys otherwise.
+        if (const char* key_dir = std::getenv("DARKEMU_GS_KEY_DIR")) {
+            server.LoadPacketKeys(key_dir);
+        }
+        // I/O reactors feeding a fixed-tick simulation thread, e.g. DARKEMU_GS_REACTORS=4 and
+        // DARKEMU_GS_TICK_MS=50 (the defaults are 1 and 50); DARKEMU_GS_REACTORS=0 keeps the single-threaded loop.
+        GameServer::ThreadingOptions threading;
+        if (const char* reactors = std::getenv("DARKEMU_GS_REACTORS")) {
+            threading.reactors = std::stoul(reactors);
+        }
+        if (const char* tick = std::getenv("DARKEMU_GS_TICK_MS")) {
+            threading.tick = std::chrono::milliseconds(std::stoul(tick));
+        }
+        // Map shards, one pinned simulation thread each, e.g. DARKEMU_GS_SHARDS=4; DARKEMU_GS_PIN=0 leaves them unpinned.
+        if (const char* shards = std::getenv("DARKEMU_GS_SHARDS")) {
+            threading.shards = std::stoul(shards);
+        }
+        if (const char* pin = std::getenv("DARKEMU_GS_PIN")) {
+            threading.pin_shards = std::string(pin) != "0";
+        }
+        if (threading.reactors == 0) {
+            server.Run();
+        } else {
+            server.Run(threading);
+        }
     } catch (const std::exception& ex) {
         // Report startup/runtime failures to stdout for now.
         Log::Info(std::string("GameServer failed: ") + ex.what());
@@ -0,0 +1,652 @@
+/*
+ * Copyright (c) DarkEmu
+ * SimpleModulus block cipher used by C3/C4 MU frames.
+ */
+
+#include "Common/Crypto/SimpleModulus.h"
+
+#include "Common/Network/PacketFramer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DARKEMU_SIMPLEMODULUS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Key file layout: int16 tag, 2 padding bytes, int32 total size, then three 16-byte key arrays.
+constexpr size_t kKeyFileHeaderSize = 8;
+constexpr size_t kKeyFileSize = kKeyFileHeaderSize + 3 * 16;
+
+// Obfuscation applied to every key word stored in a key file.
+constexpr std::array<uint32_t, 4> kSaveLoadXor{0x3F08A79B, 0xE25CC287, 0x93D27AB9, 0x20DEA7BF};
+
+using Keys = SimpleModulusKeys;
+
+// Spread a residue into its 18-bit wire field: low byte, high byte, then bits 16-17 (MSB first).
+inline uint32_t toField(uint32_t value) {
+    return ((value & 0xFF) << 10) | (((value >> 8) & 0xFF) << 2) | ((value >> 16) & 0x03);
+}
+
+// Inverse of toField.
+inline uint32_t fromField(uint32_t field) {
+    return ((field >> 10) & 0xFF) | (((field >> 2) & 0xFF) << 8) | ((field & 0x03) << 16);
+}
+
+// Load 8 bytes as a big-endian integer.
+inline uint64_t loadBe64(const uint8_t* in) {
+    uint64_t value = 0;
+    std::memcpy(&value, in, sizeof(value));
+    if constexpr (std::endian::native == std::endian::little) {
+        value = __builtin_bswap64(value);
+    }
+    return value;
+}
+
+// Store an integer as 8 big-endian bytes.
+inline void storeBe64(uint8_t* out, uint64_t value) {
+    if constexpr (std::endian::native == std::endian::little) {
+        value = __builtin_bswap64(value);
+    }
+    std::memcpy(out, &value, sizeof(value));
+}
+
+// Checksum byte over the 8 plaintext bytes of a block.
+inline uint8_t blockChecksum(const uint8_t* plain) {
+    uint64_t folded = 0;
+    std::memcpy(&folded, plain, sizeof(folded));
+    folded ^= folded >> 32;
+    folded ^= folded >> 16;
+    folded ^= folded >> 8;
+    return static_cast<uint8_t>(0xF8 ^ folded);
+}
+
+// Write four 18-bit wire fields (72 bits, MSB first) plus the size and checksum bytes as one 11-byte block.
+inline void packFields(const uint32_t (&fields)[4], uint8_t size, uint8_t checksum, uint8_t* dst) {
+    storeBe64(dst, (static_cast<uint64_t>(fields[0]) << 46) | (static_cast<uint64_t>(fields[1]) << 28) |
+                       (static_cast<uint64_t>(fields[2]) << 10) | (fields[3] >> 8));
+    dst[8] = static_cast<uint8_t>(fields[3]);
+    dst[9] = static_cast<uint8_t>(checksum ^ size ^ 0x3D);
+    dst[10] = checksum;
+}
+
+// Read the four 18-bit wire fields of an 11-byte block.
+inline void unpackFields(const uint8_t* src, uint32_t (&fields)[4]) {
+    const uint64_t head = loadBe64(src);
+    fields[0] = static_cast<uint32_t>(head >> 46);
+    fields[1] = static_cast<uint32_t>(head >> 28) & 0x3FFFF;
+    fields[2] = static_cast<uint32_t>(head >> 10) & 0x3FFFF;
+    fields[3] = (static_cast<uint32_t>(head & 0x3FF) << 8) | src[8];
+}
+
+// Undo the neighbour XOR applied after encryption (residue i was mixed with residue i + 1).
+inline void unchainResidues(const Keys& keys, uint32_t (&residues)[4]) {
+    for (int i = 2; i >= 0; --i) {
+        residues[i] ^= keys.xor_key[i] ^ (residues[i + 1] & 0xFFFF);
+    }
+}
+
+// Encrypt one 8-byte block (zero-padded by the caller when partial).
+void encryptBlockScalar(const Keys& keys, const uint8_t* src, uint8_t size, uint8_t* dst) {
+    uint32_t residues[4];
+    uint32_t previous = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        const uint32_t word = static_cast<uint32_t>(src[2 * i]) | (static_cast<uint32_t>(src[2 * i + 1]) << 8);
+        residues[i] = ((keys.xor_key[i] ^ word ^ previous) * keys.encryption[i]) % keys.modulus[i];
+        previous = residues[i] & 0xFFFF;
+    }
+    uint32_t fields[4];
+    for (size_t i = 0; i < 4; ++i) {
+        fields[i] = toField(i < 3 ? residues[i] ^ keys.xor_key[i] ^ (residues[i + 1] & 0xFFFF) : residues[i]);
+    }
+    packFields(fields, size, blockChecksum(src), dst);
+}
+
+// Decrypt the four words of one block; the size/checksum bytes are validated by the caller.
+void decryptWordsScalar(const Keys& keys, const uint8_t* src, uint8_t* dst) {
+    uint32_t residues[4];
+    unpackFields(src, residues);
+    for (uint32_t& residue : residues) {
+        residue = fromField(residue);
+    }
+    unchainResidues(keys, residues);
+    uint32_t previous = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        const uint32_t word = ((keys.decryption[i] * residues[i]) % keys.modulus[i]) ^ keys.xor_key[i] ^ previous;
+        previous = residues[i] & 0xFFFF;
+        dst[2 * i] = static_cast<uint8_t>(word);
+        dst[2 * i + 1] = static_cast<uint8_t>(word >> 8);
+    }
+}
+
+#ifdef DARKEMU_SIMPLEMODULUS_X86
+
+/*
+ * The kernels compute (a * b mod 2^32) % m exactly like the scalar path:
+ * the wrapped 32-bit product is converted to double (exact), divided by a
+ * reciprocal, floored, and the remainder corrected by one modulus either way.
+ * Every intermediate is an integer below 2^34, so no rounding leaks through.
+ * Kernels require every modulus below 2^31 (see usableSimdLevel).
+ */
+
+// Block output lane order after the encrypt transpose (8 blocks).
+constexpr std::array<size_t, 8> kAvxLaneBlock{0, 4, 1, 5, 2, 6, 3, 7};
+
+// Load 16 bytes starting at a block without reading past end.
+__attribute__((target("sse4.1"))) inline __m128i loadBlock(const uint8_t* p, const uint8_t* end) {
+    if (end - p >= 16) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    alignas(16) uint8_t padded[16]{};
+    std::memcpy(padded, p, SimpleModulus::kEncryptedBlockSize);
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(padded));
+}
+
+// Two uint32 lanes (0 and 1 of p) modulo per-lane moduli.
+__attribute__((target("sse4.1"))) inline __m128i mod2(__m128i p, __m128d mod, __m128d inv) {
+    const __m128i biased = _mm_xor_si128(p, _mm_set1_epi32(INT32_MIN));
+    const __m128d x = _mm_add_pd(_mm_cvtepi32_pd(biased), _mm_set1_pd(2147483648.0));
+    const __m128d q = _mm_floor_pd(_mm_mul_pd(x, inv));
+    __m128d r = _mm_sub_pd(x, _mm_mul_pd(q, mod));
+    r = _mm_add_pd(r, _mm_and_pd(_mm_cmplt_pd(r, _mm_setzero_pd()), mod));
+    r = _mm_sub_pd(r, _mm_and_pd(_mm_cmpge_pd(r, mod), mod));
+    return _mm_cvttpd_epi32(r);
+}
+
+// Four uint32 lanes modulo per-lane moduli (lo: lanes 0-1, hi: lanes 2-3).
+__attribute__((target("sse4.1"))) inline __m128i mod4(__m128i p, __m128d modLo, __m128d modHi, __m128d invLo,
+                                                      __m128d invHi) {
+    return _mm_unpacklo_epi64(mod2(p, modLo, invLo), mod2(_mm_srli_si128(p, 8), modHi, invHi));
+}
+
+// Four uint32 lanes modulo per-lane moduli.
+__attribute__((target("avx2"))) inline __m128i mod4(__m128i p, __m256d mod, __m256d inv) {
+    const __m128i biased = _mm_xor_si128(p, _mm_set1_epi32(INT32_MIN));
+    const __m256d x = _mm256_add_pd(_mm256_cvtepi32_pd(biased), _mm256_set1_pd(2147483648.0));
+    const __m256d q = _mm256_floor_pd(_mm256_mul_pd(x, inv));
+    __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(q, mod));
+    r = _mm256_add_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, _mm256_setzero_pd(), _CMP_LT_OQ), mod));
+    r = _mm256_sub_pd(r, _mm256_and_pd(_mm256_cmp_pd(r, mod, _CMP_GE_OQ), mod));
+    return _mm256_cvttpd_epi32(r);
+}
+
+// Eight uint32 lanes modulo per-lane moduli.
+__attribute__((target("avx2"))) inline __m256i mod8(__m256i p, __m256d modLo, __m256d modHi, __m256d invLo,
+                                                    __m256d invHi) {
+    const __m128i lo = mod4(_mm256_castsi256_si128(p), modLo, invLo);
+    const __m128i hi = mod4(_mm256_extracti128_si256(p, 1), modHi, invHi);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/*
+ * Decrypt kernels: one block per 128-bit lane group, one residue per 32-bit
+ * lane. Residue fields sit at bit offsets 0/18/36/54, i.e. 2*i bits into the
+ * big-endian word at byte 2*i, so a byte shuffle plus per-lane shifts extracts
+ * them. The post-encryption neighbour XOR is a suffix scan over the four lanes.
+ */
+
+// Decrypt words for blocks [0, blocks) one at a time; returns blocks processed.
+__attribute__((target("sse4.1"))) size_t decryptWordsSse41(const Keys& keys, const uint8_t* src, size_t blocks,
+                                                           const uint8_t* end, uint8_t* dst) {
+    const __m128i gather = _mm_setr_epi8(3, 2, 1, 0, 5, 4, 3, 2, 7, 6, 5, 4, 9, 8, 7, 6);
+    const __m128i align = _mm_setr_epi32(1, 4, 16, 64);
+    const __m128i pack = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i mask18 = _mm_set1_epi32(0x3FFFF);
+    const __m128i mask16 = _mm_set1_epi32(0xFFFF);
+    const __m128i mask8 = _mm_set1_epi32(0xFF);
+    const __m128i mask2 = _mm_set1_epi32(0x03);
+    const __m128i xor_all = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.xor_key.data()));
+    const __m128i xor_chain = _mm_setr_epi32(static_cast<int>(keys.xor_key[0]), static_cast<int>(keys.xor_key[1]),
+                                             static_cast<int>(keys.xor_key[2]), 0);
+    const __m128i dec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.decryption.data()));
+    const __m128d mod_lo = _mm_setr_pd(keys.modulus[0], keys.modulus[1]);
+    const __m128d mod_hi = _mm_setr_pd(keys.modulus[2], keys.modulus[3]);
+    const __m128d inv_lo = _mm_div_pd(_mm_set1_pd(1.0), mod_lo);
+    const __m128d inv_hi = _mm_div_pd(_mm_set1_pd(1.0), mod_hi);
+
+    for (size_t b = 0; b < blocks; ++b) {
+        const __m128i words = _mm_shuffle_epi8(loadBlock(src + b * SimpleModulus::kEncryptedBlockSize, end), gather);
+        const __m128i fields = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(words, align), 14), mask18);
+        const __m128i residues =
+            _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(fields, 10), mask8),
+                                      _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(fields, 2), mask8), 8)),
+                         _mm_slli_epi32(_mm_and_si128(fields, mask2), 16));
+        const __m128i mixed = _mm_xor_si128(residues, xor_chain);
+        __m128i scan = _mm_and_si128(mixed, mask16);
+        scan = _mm_xor_si128(scan, _mm_srli_si128(scan, 4));
+        scan = _mm_xor_si128(scan, _mm_srli_si128(scan, 8));
+        const __m128i plain = _mm_xor_si128(mixed, _mm_srli_si128(scan, 4));
+        const __m128i reduced = mod4(_mm_mullo_epi32(plain, dec), mod_lo, mod_hi, inv_lo, inv_hi);
+        const __m128i previous = _mm_and_si128(_mm_slli_si128(plain, 4), mask16);
+        const __m128i out = _mm_xor_si128(_mm_xor_si128(reduced, xor_all), previous);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + b * SimpleModulus::kBlockSize), _mm_shuffle_epi8(out, pack));
+    }
+    return blocks;
+}
+
+// Decrypt words for pairs of blocks; returns blocks processed (always even).
+__attribute__((target("avx2"))) size_t decryptWordsAvx2(const Keys& keys, const uint8_t* src, size_t blocks,
+                                                        const uint8_t* end, uint8_t* dst) {
+    const __m256i gather = _mm256_setr_epi8(3, 2, 1, 0, 5, 4, 3, 2, 7, 6, 5, 4, 9, 8, 7, 6,
+                                            3, 2, 1, 0, 5, 4, 3, 2, 7, 6, 5, 4, 9, 8, 7, 6);
+    const __m256i shifts = _mm256_setr_epi32(14, 12, 10, 8, 14, 12, 10, 8);
+    const __m256i pack = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+                                          0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i mask18 = _mm256_set1_epi32(0x3FFFF);
+    const __m256i mask16 = _mm256_set1_epi32(0xFFFF);
+    const __m256i mask8 = _mm256_set1_epi32(0xFF);
+    const __m256i mask2 = _mm256_set1_epi32(0x03);
+    const __m128i xor_all4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.xor_key.data()));
+    const __m256i xor_all = _mm256_broadcastsi128_si256(xor_all4);
+    const __m256i xor_chain = _mm256_broadcastsi128_si256(_mm_insert_epi32(xor_all4, 0, 3));
+    const __m256i dec =
+        _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys.decryption.data())));
+    const __m256d mod = _mm256_setr_pd(keys.modulus[0], keys.modulus[1], keys.modulus[2], keys.modulus[3]);
+    const __m256d inv = _mm256_div_pd(_mm256_set1_pd(1.0), mod);
+
+    size_t b = 0;
+    for (; b + 2 <= blocks; b += 2) {
+        const uint8_t* block = src + b * SimpleModulus::kEncryptedBlockSize;
+        const __m256i raw = _mm256_inserti128_si256(_mm256_castsi128_si256(loadBlock(block, end)),
+                                                    loadBlock(block + SimpleModulus::kEncryptedBlockSize, end), 1);
+        const __m256i fields = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(raw, gather), shifts), mask18);
+        const __m256i residues = _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(fields, 10), mask8),
+                            _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(fields, 2), mask8), 8)),
+            _mm256_slli_epi32(_mm256_and_si256(fields, mask2), 16));
+        const __m256i mixed = _mm256_xor_si256(residues, xor_chain);
+        __m256i scan = _mm256_and_si256(mixed, mask16);
+        scan = _mm256_xor_si256(scan, _mm256_srli_si256(scan, 4));
+        scan = _mm256_xor_si256(scan, _mm256_srli_si256(scan, 8));
+        const __m256i plain = _mm256_xor_si256(mixed, _mm256_srli_si256(scan, 4));
+        const __m256i reduced = mod8(_mm256_mullo_epi32(plain, dec), mod, mod, inv, inv);
+        const __m256i previous = _mm256_and_si256(_mm256_slli_si256(plain, 4), mask16);
+        const __m256i out = _mm256_shuffle_epi8(_mm256_xor_si256(_mm256_xor_si256(reduced, xor_all), previous), pack);
+        uint8_t* target = dst + b * SimpleModulus::kBlockSize;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(target), _mm256_castsi256_si128(out));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(target + SimpleModulus::kBlockSize),
+                         _mm256_extracti128_si256(out, 1));
+    }
+    return b;
+}
+
+/*
+ * Encrypt kernel: residue i of a block depends on residue i - 1, so the
+ * lanes run across blocks instead (one block per 32-bit lane) and the four
+ * residues are computed in sequence. Loading 64-bit lanes and merging two
+ * registers interleaves the block order (kAvxLaneBlock). There is no SSE4.1
+ * encrypt kernel: four lanes do not pay for the transpose over packFields.
+ */
+
+// Wire fields of eight residues (see toField).
+__attribute__((target("avx2"))) inline __m256i toFields(__m256i residues) {
+    const __m256i mask8 = _mm256_set1_epi32(0xFF);
+    return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(residues, mask8), 10),
+                                           _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(residues, 8), mask8), 2)),
+                           _mm256_and_si256(_mm256_srli_epi32(residues, 16), _mm256_set1_epi32(0x03)));
+}
+
+// Encrypt full blocks eight at a time; returns blocks processed.
+__attribute__((target("avx2"))) size_t encryptBlocksAvx2(const Keys& keys, const uint8_t* src, size_t blocks,
+                                                         uint8_t* dst) {
+    const __m256i mask16 = _mm256_set1_epi64x(0xFFFF);
+    const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+    __m256i xor_key[4];
+    __m256i enc_key[4];
+    __m256d mod[4];
+    __m256d inv[4];
+    for (int i = 0; i < 4; ++i) {
+        xor_key[i] = _mm256_set1_epi32(static_cast<int>(keys.xor_key[i]));
+        enc_key[i] = _mm256_set1_epi32(static_cast<int>(keys.encryption[i]));
+        mod[i] = _mm256_set1_pd(keys.modulus[i]);
+        inv[i] = _mm256_div_pd(_mm256_set1_pd(1.0), mod[i]);
+    }
+
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8) {
+        const uint8_t* block = src + b * SimpleModulus::kBlockSize;
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+        __m256i lanes[4];
+        __m256i previous = _mm256_setzero_si256();
+        for (int i = 0; i < 4; ++i) {
+            const __m128i count = _mm_cvtsi32_si128(16 * i);
+            const __m256i words =
+                _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi64(first, count), mask16),
+                                _mm256_slli_epi64(_mm256_and_si256(_mm256_srl_epi64(second, count), mask16), 32));
+            const __m256i mixed = _mm256_xor_si256(_mm256_xor_si256(words, xor_key[i]), previous);
+            lanes[i] = mod8(_mm256_mullo_epi32(mixed, enc_key[i]), mod[i], mod[i], inv[i], inv[i]);
+            previous = _mm256_and_si256(lanes[i], low16);
+        }
+        alignas(32) uint32_t fields[4][8];
+        for (int i = 0; i < 4; ++i) {
+            const __m256i chained =
+                i < 3 ? _mm256_xor_si256(lanes[i], _mm256_xor_si256(xor_key[i], _mm256_and_si256(lanes[i + 1], low16)))
+                      : lanes[i];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(fields[i]), toFields(chained));
+        }
+        for (size_t lane = 0; lane < 8; ++lane) {
+            const size_t index = b + kAvxLaneBlock[lane];
+            const uint32_t block_fields[4]{fields[0][lane], fields[1][lane], fields[2][lane], fields[3][lane]};
+            packFields(block_fields, SimpleModulus::kBlockSize, blockChecksum(src + index * SimpleModulus::kBlockSize),
+                       dst + index * SimpleModulus::kEncryptedBlockSize);
+        }
+    }
+    return b;
+}
+
+#endif // DARKEMU_SIMPLEMODULUS_X86
+
+// Load a little-endian uint32 from a key file buffer.
+uint32_t readLe32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) | (static_cast<uint32_t>(in[2]) << 16) |
+           (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Store a little-endian uint32 into a key file buffer.
+void writeLe32(uint8_t* out, uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+} // namespace
+
+SimpleModulusKeys SimpleModulusKeys::clientToServer() noexcept {
+    SimpleModulusKeys keys;
+    keys.modulus = {128079, 164742, 70235, 106898};
+    keys.encryption = {23489, 11911, 19816, 13647};
+    keys.decryption = {31544, 2047, 57011, 10183};
+    keys.xor_key = {48413, 46165, 15171, 37433};
+    return keys;
+}
+
+SimpleModulusKeys SimpleModulusKeys::serverToClient() noexcept {
+    SimpleModulusKeys keys;
+    keys.modulus = {73326, 109989, 98843, 171058};
+    keys.encryption = {13169, 19036, 35482, 29587};
+    keys.decryption = {18035, 30340, 24701, 11141};
+    keys.xor_key = {62004, 64409, 35374, 64599};
+    return keys;
+}
+
+SimpleModulus::SimpleModulus(const SimpleModulusKeys& keys) {
+    setKeys(keys);
+}
+
+void SimpleModulus::setKeys(const SimpleModulusKeys& keys) {
+    if (std::find(keys.modulus.begin(), keys.modulus.end(), 0u) != keys.modulus.end()) {
+        throw std::invalid_argument("SimpleModulus modulus must be non-zero");
+    }
+    keys_ = keys;
+    simd_level_ = std::min(requested_level_, usableSimdLevel());
+}
+
+bool SimpleModulus::loadEncryptionKey(const std::string& path) {
+    return loadKeyFile(path, true, false);
+}
+
+bool SimpleModulus::loadDecryptionKey(const std::string& path) {
+    return loadKeyFile(path, false, true);
+}
+
+bool SimpleModulus::saveEncryptionKey(const std::string& path) const {
+    return saveKeyFile(path, keys_.encryption);
+}
+
+bool SimpleModulus::saveDecryptionKey(const std::string& path) const {
+    return saveKeyFile(path, keys_.decryption);
+}
+
+bool SimpleModulus::loadKeyFile(const std::string& path, bool encryption, bool decryption) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::array<uint8_t, kKeyFileSize> data{};
+    in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (in.gcount() != static_cast<std::streamsize>(data.size())) {
+        return false;
+    }
+    const uint16_t tag = static_cast<uint16_t>(data[0] | (data[1] << 8));
+    if (tag != kKeyFileHeader || readLe32(data.data() + 4) != kKeyFileSize) {
+        return false;
+    }
+
+    // Key arrays follow the header in a fixed order: modulus, cipher key, XOR key.
+    auto readKey = [&](size_t index) {
+        std::array<uint32_t, 4> key{};
+        for (size_t i = 0; i < 4; ++i) {
+            key[i] = readLe32(data.data() + kKeyFileHeaderSize + index * 16 + i * 4) ^ kSaveLoadXor[i];
+        }
+        return key;
+    };
+    SimpleModulusKeys keys = keys_;
+    keys.modulus = readKey(0);
+    if (encryption) {
+        keys.encryption = readKey(1);
+    }
+    if (decryption) {
+        keys.decryption = readKey(1);
+    }
+    keys.xor_key = readKey(2);
+    if (std::find(keys.modulus.begin(), keys.modulus.end(), 0u) != keys.modulus.end()) {
+        return false;
+    }
+    setKeys(keys);
+    return true;
+}
+
+bool SimpleModulus::saveKeyFile(const std::string& path, const std::array<uint32_t, 4>& key) const {
+    std::array<uint8_t, kKeyFileSize> data{};
+    data[0] = static_cast<uint8_t>(kKeyFileHeader);
+    data[1] = static_cast<uint8_t>(kKeyFileHeader >> 8);
+    writeLe32(data.data() + 4, static_cast<uint32_t>(kKeyFileSize));
+    const std::array<const std::array<uint32_t, 4>*, 3> arrays{&keys_.modulus, &key, &keys_.xor_key};
+    for (size_t index = 0; index < arrays.size(); ++index) {
+        for (size_t i = 0; i < 4; ++i) {
+            writeLe32(data.data() + kKeyFileHeaderSize + index * 16 + i * 4, (*arrays[index])[i] ^ kSaveLoadXor[i]);
+        }
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+size_t SimpleModulus::encrypt(std::span<uint8_t> out, std::span<const uint8_t> in) const {
+    if (keys_.modulus[0] == 0) {
+        throw std::logic_error("SimpleModulus keys not loaded");
+    }
+    const size_t written = encryptedSize(in.size());
+    if (out.size() < written) {
+        throw std::length_error("SimpleModulus encrypt buffer too small");
+    }
+    const size_t full_blocks = in.size() / kBlockSize;
+    size_t done = 0;
+#ifdef DARKEMU_SIMPLEMODULUS_X86
+    if (simd_level_ == SimdLevel::Avx2) {
+        done = encryptBlocksAvx2(keys_, in.data(), full_blocks, out.data());
+    }
+#endif
+    for (size_t b = done; b < full_blocks; ++b) {
+        encryptBlockScalar(keys_, in.data() + b * kBlockSize, kBlockSize, out.data() + b * kEncryptedBlockSize);
+    }
+
+    // A partial final block is encrypted from a zero-padded copy and records its real length.
+    const size_t tail = in.size() % kBlockSize;
+    if (tail != 0) {
+        std::array<uint8_t, kBlockSize> padded{};
+        std::memcpy(padded.data(), in.data() + full_blocks * kBlockSize, tail);
+        encryptBlockScalar(keys_, padded.data(), static_cast<uint8_t>(tail),
+                           out.data() + full_blocks * kEncryptedBlockSize);
+    }
+    return written;
+}
+
+bool SimpleModulus::decrypt(std::span<uint8_t> out, std::span<const uint8_t> in, size_t& plainSize) const {
+    plainSize = 0;
+    if (keys_.modulus[0] == 0) {
+        throw std::logic_error("SimpleModulus keys not loaded");
+    }
+    if (in.empty() || in.size() % kEncryptedBlockSize != 0) {
+        return false;
+    }
+    const size_t blocks = in.size() / kEncryptedBlockSize;
+    if (out.size() < blocks * kBlockSize) {
+        throw std::length_error("SimpleModulus decrypt buffer too small");
+    }
+
+    size_t done = 0;
+#ifdef DARKEMU_SIMPLEMODULUS_X86
+    const uint8_t* end = in.data() + in.size();
+    if (simd_level_ == SimdLevel::Avx2) {
+        done = decryptWordsAvx2(keys_, in.data(), blocks, end, out.data());
+    }
+    if (simd_level_ >= SimdLevel::Sse41) {
+        done += decryptWordsSse41(keys_, in.data() + done * kEncryptedBlockSize, blocks - done, end,
+                                  out.data() + done * kBlockSize);
+    }
+#endif
+    for (size_t b = done; b < blocks; ++b) {
+        decryptWordsScalar(keys_, in.data() + b * kEncryptedBlockSize, out.data() + b * kBlockSize);
+    }
+
+    // Every block carries its plaintext length and a checksum; only the last block may be partial.
+    size_t total = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* block = in.data() + b * kEncryptedBlockSize;
+        const uint8_t checksum = block[10];
+        const size_t size = static_cast<uint8_t>(block[9] ^ checksum ^ 0x3D);
+        if (blockChecksum(out.data() + b * kBlockSize) != checksum || size == 0 || size > kBlockSize ||
+            (b + 1 < blocks && size != kBlockSize)) {
+            return false;
+        }
+        total += size;
+    }
+    plainSize = total;
+    return true;
+}
+
+bool SimpleModulus::encryptFrame(std::span<const uint8_t> frame, uint8_t serial, std::vector<uint8_t>& out) const {
+    if (frame.empty() || (frame[0] != 0xC1 && frame[0] != 0xC2)) {
+        return false;
+    }
+    const bool wide = PacketFramer::isWide(frame[0]);
+    const size_t header = PacketFramer::headerSize(frame[0]);
+    if (frame.size() <= header) {
+        return false;
+    }
+    const size_t plain_size = 1 + frame.size() - header;
+    const size_t frame_size = header + encryptedSize(plain_size);
+    if (frame_size > (wide ? 0xFFFFu : 0xFFu)) {
+        return false;
+    }
+
+    // Stage serial + body behind the ciphertext area so a reused vector never reallocates.
+    out.resize(frame_size + plain_size);
+    uint8_t* staged = out.data() + frame_size;
+    staged[0] = serial;
+    std::memcpy(staged + 1, frame.data() + header, frame.size() - header);
+    encrypt(std::span<uint8_t>(out.data() + header, frame_size - header), std::span<const uint8_t>(staged, plain_size));
+    out.resize(frame_size);
+
+    out[0] = wide ? 0xC4 : 0xC3;
+    if (wide) {
+        out[1] = static_cast<uint8_t>(frame_size >> 8);
+        out[2] = static_cast<uint8_t>(frame_size);
+    } else {
+        out[1] = static_cast<uint8_t>(frame_size);
+    }
+    return true;
+}
+
+bool SimpleModulus::decryptFrame(std::span<const uint8_t> frame, std::vector<uint8_t>& out, uint8_t& serial) const {
+    out.resize(frame.size());
+    size_t frame_size = 0;
+    if (!decryptFrame(frame, std::span<uint8_t>(out), frame_size, serial)) {
+        return false;
+    }
+    out.resize(frame_size);
+    return true;
+}
+
+bool SimpleModulus::decryptFrame(std::span<const uint8_t> frame, std::span<uint8_t> out, size_t& frameSize,
+                                 uint8_t& serial) const {
+    if (frame.empty() || !PacketFramer::isEncrypted(frame[0])) {
+        return false;
+    }
+    const bool wide = PacketFramer::isWide(frame[0]);
+    const size_t header = PacketFramer::headerSize(frame[0]);
+    const std::span<const uint8_t> cipher = frame.subspan(std::min(header, frame.size()));
+
+    // Decrypt so that the serial lands on the last size byte and the body right after the header.
+    // Plaintext is never longer than ciphertext, so frame.size() bytes always suffice.
+    const size_t capacity = header - 1 + decryptedCapacity(cipher.size());
+    if (out.size() < capacity) {
+        return false;
+    }
+    size_t plain_size = 0;
+    if (!decrypt(out.subspan(header - 1, capacity - (header - 1)), cipher, plain_size) || plain_size < 2) {
+        return false;
+    }
+    serial = out[header - 1];
+    frameSize = header - 1 + plain_size;
+    out[0] = wide ? 0xC2 : 0xC1;
+    if (wide) {
+        out[1] = static_cast<uint8_t>(frameSize >> 8);
+        out[2] = static_cast<uint8_t>(frameSize);
+    } else {
+        out[1] = static_cast<uint8_t>(frameSize);
+    }
+    return true;
+}
+
+SimpleModulus::SimdLevel SimpleModulus::supportedSimdLevel() noexcept {
+#ifdef DARKEMU_SIMPLEMODULUS_X86
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::Avx2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return SimdLevel::Sse41;
+        }
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+void SimpleModulus::setSimdLevel(SimdLevel level) noexcept {
+    requested_level_ = std::min(level, supportedSimdLevel());
+    simd_level_ = std::min(requested_level_, usableSimdLevel());
+}
+
+SimpleModulus::SimdLevel SimpleModulus::usableSimdLevel() const noexcept {
+    // The kernels convert residues through signed 32-bit lanes.
+    for (uint32_t modulus : keys_.modulus) {
+        if (modulus == 0 || modulus >= 0x80000000u) {
+            return SimdLevel::Scalar;
+        }
+    }
+    return supportedSimdLevel();
+}
+
+const char* SimpleModulus::simdLevelName(SimdLevel level) noexcept {
+    switch (level) {
+    case SimdLevel::Avx2:
+        return "avx2";
+    case SimdLevel::Sse41:
+        return "sse4.1";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) DarkEmu
+ * XOR32 body obfuscation used by client C1/C2 frames.
+ */
+
+#include "Common/Crypto/Xor32.h"
+
+#include "Common/Network/PacketFramer.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DARKEMU_XOR32_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kKeySize = Xor32::kKeySize;
+
+// Offset of the first obfuscated byte; the head code after the size field stays in clear.
+inline size_t bodyStart(uint8_t type) {
+    return PacketFramer::headerSize(type) + 1;
+}
+
+// Decode data[first, end) walking backwards so every byte still sees its ciphertext predecessor.
+void decodeScalar(uint8_t* data, size_t first, size_t end, const uint8_t* key) {
+    for (size_t i = end; i-- > first;) {
+        data[i] ^= data[i - 1] ^ key[i % kKeySize];
+    }
+}
+
+// Encode data[first, end) forwards; each byte chains on the encoded byte before it.
+void encodeScalar(uint8_t* data, size_t first, size_t end, const uint8_t* key) {
+    for (size_t i = first; i < end; ++i) {
+        data[i] ^= data[i - 1] ^ key[i % kKeySize];
+    }
+}
+
+#ifdef DARKEMU_XOR32_X86
+
+/*
+ * Decode kernels take whole vectors off the end of the body. A vector at i
+ * reads ciphertext [i - 1, i + width - 1) and only bytes at or above i have
+ * been written, so in-place decoding never sees its own output. They return
+ * the new end; the scalar loop finishes the short head of the body.
+ */
+
+__attribute__((target("sse2"))) size_t decodeSse2(uint8_t* data, size_t first, size_t end, const uint8_t* key) {
+    while (end >= first + 16) {
+        const size_t i = end - 16;
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i - 1));
+        const __m128i mix = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + i % kKeySize));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(_mm_xor_si128(current, previous), mix));
+        end = i;
+    }
+    return end;
+}
+
+__attribute__((target("avx2"))) size_t decodeAvx2(uint8_t* data, size_t first, size_t end, const uint8_t* key) {
+    while (end >= first + 32) {
+        const size_t i = end - 32;
+        const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i - 1));
+        const __m256i mix = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + i % kKeySize));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i),
+                            _mm256_xor_si256(_mm256_xor_si256(current, previous), mix));
+        end = i;
+    }
+    return end;
+}
+
+/*
+ * Encode kernel: e[i] = p[i] ^ k[i] ^ e[i - 1] is a prefix XOR of the
+ * key-mixed plaintext. Each vector mixes the key, resolves the chain with a
+ * log-step scan and folds in the last encoded byte. Returns the first byte
+ * left for the scalar loop.
+ */
+__attribute__((target("sse2"))) size_t encodeSse2(uint8_t* data, size_t first, size_t end, const uint8_t* key) {
+    size_t i = first;
+    for (; i + 16 <= end; i += 16) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + i % kKeySize)));
+        x = _mm_xor_si128(x, _mm_slli_si128(x, 1));
+        x = _mm_xor_si128(x, _mm_slli_si128(x, 2));
+        x = _mm_xor_si128(x, _mm_slli_si128(x, 4));
+        x = _mm_xor_si128(x, _mm_slli_si128(x, 8));
+        x = _mm_xor_si128(x, _mm_set1_epi8(static_cast<char>(data[i - 1])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), x);
+    }
+    return i;
+}
+
+#endif // DARKEMU_XOR32_X86
+
+} // namespace
+
+Xor32::Xor32() noexcept : Xor32(kDefaultKey) {}
+
+Xor32::Xor32(const Key& key) noexcept {
+    setKey(key);
+}
+
+void Xor32::setKey(const Key& key) noexcept {
+    std::copy(key.begin(), key.end(), key_.begin());
+    std::copy(key.begin(), key.end(), key_.begin() + kKeySize);
+}
+
+Xor32::Key Xor32::key() const noexcept {
+    Key key{};
+    std::copy(key_.begin(), key_.begin() + kKeySize, key.begin());
+    return key;
+}
+
+void Xor32::decodeFrame(std::span<uint8_t> frame) const noexcept {
+    if (frame.empty()) {
+        return;
+    }
+    const size_t first = bodyStart(frame[0]);
+    size_t end = frame.size();
+    if (end <= first) {
+        return;
+    }
+#ifdef DARKEMU_XOR32_X86
+    if (simd_level_ == SimdLevel::Avx2) {
+        end = decodeAvx2(frame.data(), first, end, key_.data());
+    }
+    if (simd_level_ >= SimdLevel::Sse41) {
+        end = decodeSse2(frame.data(), first, end, key_.data());
+    }
+#endif
+    decodeScalar(frame.data(), first, end, key_.data());
+}
+
+void Xor32::encodeFrame(std::span<uint8_t> frame) const noexcept {
+    if (frame.empty()) {
+        return;
+    }
+    size_t first = bodyStart(frame[0]);
+    const size_t end = frame.size();
+    if (end <= first) {
+        return;
+    }
+#ifdef DARKEMU_XOR32_X86
+    // The scan is serial per vector, so AVX2 gains nothing over 16-byte steps here.
+    if (simd_level_ >= SimdLevel::Sse41) {
+        first = encodeSse2(frame.data(), first, end, key_.data());
+    }
+#endif
+    encodeScalar(frame.data(), first, end, key_.data());
+}
+
+void Xor32::setSimdLevel(SimdLevel level) noexcept {
+    simd_level_ = std::min(level, SimpleModulus::supportedSimdLevel());
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) DarkEmu
+ * Coroutine loop over epoll: readiness, timers, cross-thread posts and socket operations.
+ */
+
+#include "Common/Network/AsyncIo.h"
+
+#include "Common/Network/PacketFramer.h"
+#include "Common/Utils/Logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// Epoll events fetched per wait.
+constexpr size_t kMaxEvents = 256;
+// Bytes requested per recv() while assembling frames.
+constexpr size_t kReadChunk = 4096;
+
+} // namespace
+
+void detail::TaskPromiseBase::finishDetached(TaskPromiseBase& promise) noexcept {
+    IoLoop& loop = *promise.loop;
+    if (promise.prev != nullptr) {
+        promise.prev->next = promise.next;
+    } else {
+        loop.live_ = promise.next;
+    }
+    if (promise.next != nullptr) {
+        promise.next->prev = promise.prev;
+    }
+    --loop.tasks_;
+    if (promise.exception) {
+        // Nobody awaits a spawned task, so an escaped exception can only be reported.
+        try {
+            std::rethrow_exception(promise.exception);
+        } catch (const std::exception& ex) {
+            Log::Info(std::string("IoLoop task failed: ") + ex.what());
+        } catch (...) {
+            Log::Info("IoLoop task failed with an unknown exception");
+        }
+    }
+}
+
+IoLoop::IoLoop() : events_(kMaxEvents) {
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ == -1) {
+        throw std::runtime_error(std::string("eventfd failed: ") + std::strerror(errno));
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr; // The wake eventfd is the only registration without an AsyncSocket.
+    if (::epoll_ctl(epoll_.fd(), EPOLL_CTL_ADD, wake_fd_, &event) == -1) {
+        ::close(wake_fd_);
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + std::strerror(errno));
+    }
+}
+
+IoLoop::~IoLoop() {
+    // Destroying a suspended task runs its destructors, which may deregister sockets from epoll_.
+    while (live_ != nullptr) {
+        detail::TaskPromiseBase* promise = live_;
+        live_ = promise->next;
+        promise->self.destroy();
+    }
+    ::close(wake_fd_);
+}
+
+void IoLoop::spawn(Task<void> task) {
+    auto handle = std::exchange(task.handle_, {});
+    detail::TaskPromiseBase& promise = handle.promise();
+    promise.loop = this;
+    promise.self = handle;
+    promise.next = live_;
+    if (live_ != nullptr) {
+        live_->prev = &promise;
+    }
+    live_ = &promise;
+    ++tasks_;
+    handle.resume();
+}
+
+int IoLoop::nextTimeout(int timeoutMs) const {
+    if (timers_.empty()) {
+        return timeoutMs;
+    }
+    const auto until = timers_.top().due - Clock::now();
+    if (until <= Clock::duration::zero()) {
+        return 0;
+    }
+    // Round up so a wake-up never lands just before the deadline.
+    const auto ms = std::chrono::ceil<std::chrono::milliseconds>(until).count();
+    if (timeoutMs >= 0 && ms > timeoutMs) {
+        return timeoutMs;
+    }
+    return static_cast<int>(ms);
+}
+
+void IoLoop::runOnce(int timeoutMs) {
+    const int count = epoll_.wait(events_, nextTimeout(timeoutMs));
+    // Finish every socket operation first and resume afterwards, so a coroutine that closes a
+    // socket cannot leave a dangling pointer in the rest of this batch.
+    ready_.clear();
+    for (int i = 0; i < count; ++i) {
+        const epoll_event& event = events_[static_cast<size_t>(i)];
+        if (event.data.ptr == nullptr) {
+            uint64_t value = 0;
+            [[maybe_unused]] const ssize_t drained = ::read(wake_fd_, &value, sizeof(value));
+            continue;
+        }
+        static_cast<AsyncSocket*>(event.data.ptr)->onEvent(event.events, ready_);
+    }
+    for (std::coroutine_handle<> handle : ready_) {
+        handle.resume();
+    }
+
+    const Clock::time_point now = Clock::now();
+    while (!timers_.empty() && timers_.top().due <= now) {
+        const std::coroutine_handle<> handle = timers_.top().handle;
+        timers_.pop();
+        handle.resume();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        resuming_.swap(posted_);
+    }
+    for (std::coroutine_handle<> handle : resuming_) {
+        handle.resume();
+    }
+    resuming_.clear();
+}
+
+void IoLoop::run() {
+    while (!stopping_.load(std::memory_order_acquire)) {
+        runOnce(-1);
+    }
+    stopping_.store(false, std::memory_order_release);
+}
+
+void IoLoop::stop() noexcept {
+    stopping_.store(true, std::memory_order_release);
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+}
+
+void IoLoop::post(std::coroutine_handle<> handle) {
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        first = posted_.empty();
+        posted_.push_back(handle);
+    }
+    // One wake-up per batch of posts: later posts find the list non-empty and the loop already signalled.
+    if (first) {
+        const uint64_t one = 1;
+        [[maybe_unused]] const ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+    }
+}
+
+AsyncSocket::AsyncSocket(IoLoop& loop, Socket socket) : loop_(loop), socket_(std::move(socket)) {
+    socket_.setNonBlocking(true);
+    epoll_event event{};
+    // Edge-triggered: operations run until EAGAIN before suspending, so one edge per arrival is enough.
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = this;
+    if (::epoll_ctl(loop_.epoll().fd(), EPOLL_CTL_ADD, socket_.fd(), &event) == -1) {
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + std::strerror(errno));
+    }
+}
+
+AsyncSocket::~AsyncSocket() {
+    if (socket_.isValid()) {
+        ::epoll_ctl(loop_.epoll().fd(), EPOLL_CTL_DEL, socket_.fd(), nullptr);
+    }
+}
+
+bool AsyncSocket::pollFrame() {
+    frame_ = {};
+    while (true) {
+        size_t size = 0;
+        const auto status = PacketFramer::peek(std::span<const uint8_t>(buffer_).subspan(head_), size);
+        if (status == PacketFramer::Status::Complete) {
+            frame_ = std::span<const uint8_t>(buffer_).subspan(head_, size);
+            head_ += size;
+            return true;
+        }
+        if (status == PacketFramer::Status::Invalid) {
+            failed_ = true;
+        }
+        if (failed_) {
+            return true;
+        }
+        // The frame handed out last is no longer needed: move the partial frame to the front.
+        if (head_ > 0) {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(head_));
+            head_ = 0;
+        }
+        const size_t used = buffer_.size();
+        buffer_.resize(used + kReadChunk);
+        const ssize_t received = socket_.recv(std::span<uint8_t>(buffer_).subspan(used));
+        buffer_.resize(used + (received > 0 ? static_cast<size_t>(received) : 0));
+        if (received > 0) {
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        failed_ = true;
+    }
+}
+
+bool AsyncSocket::pollSend() {
+    while (!pending_send_.empty()) {
+        const ssize_t sent = socket_.send(pending_send_, MSG_NOSIGNAL);
+        if (sent > 0) {
+            pending_send_ = pending_send_.subspan(static_cast<size_t>(sent));
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        pending_send_ = {};
+        send_ok_ = false;
+        return true;
+    }
+    send_ok_ = true;
+    return true;
+}
+
+bool AsyncSocket::pollAccept() {
+    try {
+        accepted_ = socket_.accept();
+    } catch (const std::exception&) {
+        accepted_ = Socket();
+        return true;
+    }
+    return accepted_.isValid();
+}
+
+void AsyncSocket::onEvent(uint32_t events, std::vector<std::coroutine_handle<>>& ready) {
+    if (reader_ && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0) {
+        const bool done = read_op_ == ReadOp::Frame ? pollFrame() : pollAccept();
+        if (done) {
+            ready.push_back(std::exchange(reader_, {}));
+        }
+    }
+    if (writer_ && (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0 && pollSend()) {
+        ready.push_back(std::exchange(writer_, {}));
+    }
+}
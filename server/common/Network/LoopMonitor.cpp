@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) DarkEmu
+ * Event-loop health instrumentation implementation.
+ */
+
+#include "Common/Network/LoopMonitor.h"
+
+#include "Common/Utils/Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Convert a steady-clock interval to whole microseconds.
+uint64_t toMicros(std::chrono::steady_clock::duration elapsed) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+} // namespace
+
+LoopMonitor::LoopMonitor(const std::string& prefix, std::string name) :
+    name_(std::move(name)),
+    wait_time_(MetricsRegistry::Instance()->histogram(prefix + "_wait_seconds",
+                                                      "Time the reactor spent blocked in epoll_wait.", 1e-6)),
+    handler_time_(MetricsRegistry::Instance()->histogram(prefix + "_handler_seconds",
+                                                         "Time per reactor iteration spent in handlers.", 1e-6)),
+    events_per_wakeup_(MetricsRegistry::Instance()->histogram(prefix + "_events_per_wakeup",
+                                                              "Ready events returned by each epoll_wait.")),
+    saturated_wakeups_(MetricsRegistry::Instance()->counter(prefix + "_saturated_wakeups_total",
+                                                            "Wakeups that filled the whole event array.")),
+    slow_handlers_(MetricsRegistry::Instance()->counter(prefix + "_slow_handlers_total",
+                                                        "Handlers that exceeded the configured time budget.")),
+    event_capacity_(MetricsRegistry::Instance()->gauge(prefix + "_event_capacity",
+                                                       "Current size of the reactor event array.")) {}
+
+void LoopMonitor::setHandlerBudget(std::chrono::microseconds budget) noexcept {
+    budget_ = budget;
+}
+
+std::chrono::microseconds LoopMonitor::handlerBudget() const noexcept {
+    return budget_;
+}
+
+int LoopMonitor::wait(EpollContext& epoll, std::vector<epoll_event>& events, int timeoutMs) {
+    // Grow the event array after repeated full batches (bounded by kMaxEvents).
+    if (saturated_streak_ >= kGrowAfter && events.size() < kMaxEvents) {
+        events.resize(std::min(events.size() * 2, kMaxEvents));
+        saturated_streak_ = 0;
+    }
+    event_capacity_.set(static_cast<int64_t>(events.size()));
+
+    const Clock::time_point before = Clock::now();
+    const int ready = epoll.wait(events, timeoutMs);
+    woke_at_ = Clock::now();
+    wait_time_.observe(toMicros(woke_at_ - before));
+
+    // Empty wakeups (timeouts, EINTR) say nothing about batch sizing.
+    if (ready > 0) {
+        events_per_wakeup_.observe(static_cast<uint64_t>(ready));
+        if (static_cast<size_t>(ready) == events.size()) {
+            saturated_wakeups_.inc();
+            ++saturated_streak_;
+        } else {
+            saturated_streak_ = 0;
+        }
+    }
+    return ready;
+}
+
+void LoopMonitor::endIteration() noexcept {
+    handler_time_.observe(toMicros(Clock::now() - woke_at_));
+}
+
+void LoopMonitor::beginHandler(int fd) noexcept {
+    handler_fd_ = fd;
+    handler_opcode_ = -1;
+    handler_started_ = Clock::now();
+}
+
+void LoopMonitor::noteOpcode(int opcode) noexcept {
+    handler_opcode_ = opcode;
+}
+
+void LoopMonitor::endHandler() noexcept {
+    const uint64_t elapsed = toMicros(Clock::now() - handler_started_);
+    if (elapsed <= static_cast<uint64_t>(budget_.count())) {
+        return;
+    }
+
+    // Slow path: keep the record and tell the operator.
+    SlowHandlerRecord record;
+    record.fd = handler_fd_;
+    record.opcode = handler_opcode_;
+    record.duration_us = elapsed;
+    record.wall_time_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    try {
+        recordSlow(record);
+    } catch (const std::exception&) {
+        // Logging must never take the reactor down.
+    }
+}
+
+std::vector<SlowHandlerRecord> LoopMonitor::slowHandlers() const {
+    std::lock_guard lock(slow_mutex_);
+    std::vector<SlowHandlerRecord> records;
+    const size_t stored = std::min(slow_count_, kSlowLogSize);
+    records.reserve(stored);
+    // The ring starts at the oldest entry once it has wrapped.
+    const size_t first = slow_count_ - stored;
+    for (size_t i = first; i < slow_count_; ++i) {
+        records.push_back(slow_log_[i % kSlowLogSize]);
+    }
+    return records;
+}
+
+void LoopMonitor::recordSlow(const SlowHandlerRecord& record) {
+    slow_handlers_.inc();
+    {
+        std::lock_guard lock(slow_mutex_);
+        slow_log_[slow_count_ % kSlowLogSize] = record;
+        ++slow_count_;
+    }
+
+    char opcode[16] = "?";
+    if (record.opcode >= 0) {
+        std::snprintf(opcode, sizeof(opcode), "0x%X", static_cast<unsigned>(record.opcode));
+    }
+    std::string line = name_ + " slow handler: fd=" + std::to_string(record.fd) + " opcode=" + opcode;
+    line += " took " + std::to_string(record.duration_us) + "us (budget " + std::to_string(budget_.count()) + "us)";
+    Log::Info(line);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) DarkEmu
+ * Per-connection outbound queue of copied and shared frames, written with scatter-gather sends.
+ */
+
+#include "Common/Network/Outbox.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <sys/uio.h>
+
+void Outbox::append(std::span<const uint8_t> frame) {
+    if (frame.empty()) {
+        return;
+    }
+    // Extend the last segment when it is a copy too: one iovec for any number of private frames in a row.
+    if (segments_.size() > head_ && !segments_.back().shared &&
+        segments_.back().offset + segments_.back().size == bytes_.size()) {
+        segments_.back().size += static_cast<uint32_t>(frame.size());
+    } else {
+        segments_.push_back(Segment{{}, static_cast<uint32_t>(bytes_.size()), static_cast<uint32_t>(frame.size())});
+    }
+    bytes_.insert(bytes_.end(), frame.begin(), frame.end());
+    pending_ += frame.size();
+}
+
+void Outbox::append(const SharedFrame& frame) {
+    const auto size = static_cast<uint32_t>(frame.bytes().size());
+    if (size < kMinSharedBytes) {
+        append(frame.bytes());
+        return;
+    }
+    segments_.push_back(Segment{frame, 0, size});
+    pending_ += size;
+}
+
+Outbox::FlushResult Outbox::flush(Socket& socket, int flags) {
+    FlushResult result;
+    while (pending_ != 0) {
+        std::array<iovec, kMaxIovecs> iov;
+        size_t count = 0;
+        size_t requested = 0;
+        for (size_t i = head_; i < segments_.size() && count < kMaxIovecs; ++i) {
+            const std::span<const uint8_t> bytes = bytesOf(segments_[i]).subspan(i == head_ ? head_sent_ : 0);
+            // sendmsg() only reads through the iovecs.
+            iov[count++] = iovec{const_cast<uint8_t*>(bytes.data()), bytes.size()};
+            requested += bytes.size();
+        }
+        const ssize_t sent = socket.sendv(std::span<const iovec>(iov.data(), count), flags);
+        ++result.calls;
+        if (sent < 0) {
+            result.failed = errno != EAGAIN && errno != EWOULDBLOCK;
+            break;
+        }
+        result.sent += static_cast<size_t>(sent);
+        consume(static_cast<size_t>(sent));
+        if (static_cast<size_t>(sent) < requested) {
+            break;
+        }
+    }
+    if (pending_ == 0) {
+        clear();
+    } else {
+        compact();
+    }
+    return result;
+}
+
+void Outbox::clear() noexcept {
+    segments_.clear();
+    bytes_.clear();
+    head_ = 0;
+    head_sent_ = 0;
+    pending_ = 0;
+}
+
+std::span<const uint8_t> Outbox::bytesOf(const Segment& segment) const noexcept {
+    if (segment.shared) {
+        return segment.shared.bytes();
+    }
+    return {bytes_.data() + segment.offset, segment.size};
+}
+
+void Outbox::consume(size_t sent) noexcept {
+    pending_ -= sent;
+    while (sent != 0) {
+        Segment& segment = segments_[head_];
+        const size_t left = segment.size - head_sent_;
+        if (sent < left) {
+            head_sent_ += sent;
+            return;
+        }
+        sent -= left;
+        // Release the shared frame as soon as this connection is done with it.
+        segment.shared.reset();
+        ++head_;
+        head_sent_ = 0;
+    }
+}
+
+void Outbox::compact() {
+    segments_.erase(segments_.begin(), segments_.begin() + static_cast<std::ptrdiff_t>(head_));
+    head_ = 0;
+    // Copied bytes before the first copied segment still queued are sent; shift the rest down.
+    auto first_copy = std::find_if(segments_.begin(), segments_.end(), [](const Segment& s) { return !s.shared; });
+    if (first_copy == segments_.end()) {
+        bytes_.clear();
+        return;
+    }
+    const uint32_t dropped = first_copy->offset;
+    if (dropped == 0) {
+        return;
+    }
+    bytes_.erase(bytes_.begin(), bytes_.begin() + dropped);
+    for (auto it = first_copy; it != segments_.end(); ++it) {
+        if (!it->shared) {
+            it->offset -= dropped;
+        }
+    }
+}
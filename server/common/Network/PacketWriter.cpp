@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) DarkEmu
+ * Response builders with inline storage and pooled spill buffers.
+ */
+
+#include "Common/Network/PacketWriter.h"
+
+#include <stdexcept>
+
+namespace {
+
+// Spill buffers kept per thread; more than a reactor needs for its in-flight replies.
+constexpr size_t kMaxPooledBuffers = 16;
+// Larger buffers are freed instead of pooled so one huge reply does not pin memory.
+constexpr size_t kMaxPooledCapacity = 64 * 1024;
+
+std::vector<std::vector<uint8_t>>& freeList() {
+    thread_local std::vector<std::vector<uint8_t>> buffers;
+    return buffers;
+}
+
+} // namespace
+
+std::vector<uint8_t> PacketBufferPool::acquire(size_t capacity) {
+    auto& buffers = freeList();
+    if (!buffers.empty()) {
+        std::vector<uint8_t> buffer = std::move(buffers.back());
+        buffers.pop_back();
+        buffer.reserve(capacity);
+        return buffer;
+    }
+    std::vector<uint8_t> buffer;
+    buffer.reserve(capacity);
+    return buffer;
+}
+
+void PacketBufferPool::release(std::vector<uint8_t>&& buffer) noexcept {
+    auto& buffers = freeList();
+    if (buffers.size() >= kMaxPooledBuffers || buffer.capacity() > kMaxPooledCapacity) {
+        return;
+    }
+    buffer.clear();
+    try {
+        buffers.push_back(std::move(buffer));
+    } catch (...) {
+        // Growing the free list failed; let the buffer go.
+    }
+}
+
+size_t PacketBufferPool::pooled() noexcept {
+    return freeList().size();
+}
+
+std::span<const uint8_t> PacketWriterBase::finish() {
+    if (size_ < 3) {
+        throw std::logic_error("PacketWriter: finish() without begin()");
+    }
+    if (data_[0] == 0xC2 || data_[0] == 0xC4) {
+        if (size_ > 0xFFFF) {
+            throw std::length_error("PacketWriter: C2 frame larger than 65535 bytes");
+        }
+        data_[1] = static_cast<uint8_t>(size_ >> 8);
+        data_[2] = static_cast<uint8_t>(size_);
+    } else {
+        if (size_ > 0xFF) {
+            throw std::length_error("PacketWriter: C1 frame larger than 255 bytes");
+        }
+        data_[1] = static_cast<uint8_t>(size_);
+    }
+    return {data_, size_};
+}
+
+PacketWriterBase::~PacketWriterBase() {
+    if (spilled()) {
+        PacketBufferPool::release(std::move(spill_));
+    }
+}
+
+void PacketWriterBase::spill(size_t needed) {
+    const size_t capacity = std::max(needed, capacity_ * 2);
+    if (!spilled()) {
+        spill_ = PacketBufferPool::acquire(capacity);
+    }
+    // A spill buffer keeps its prefix across resize(); inline bytes are copied over once.
+    const size_t written = size_;
+    spill_.resize(capacity);
+    if (!spilled()) {
+        std::memcpy(spill_.data(), inline_data_, written);
+    }
+    data_ = spill_.data();
+    capacity_ = capacity;
+}
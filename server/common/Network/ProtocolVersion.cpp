@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) DarkEmu
+ * Protocol version names.
+ */
+
+#include "Common/Network/ProtocolVersion.h"
+
+#include <stdexcept>
+#include <string>
+
+std::string_view protocolName(ProtocolVersion version) noexcept {
+    return withProtocol(version, [](auto protocol) { return decltype(protocol)::kName; });
+}
+
+ProtocolVersion parseProtocolVersion(std::string_view name) {
+    for (ProtocolVersion version : {ProtocolVersion::Season6, ProtocolVersion::Season9}) {
+        if (protocolName(version) == name) {
+            return version;
+        }
+    }
+    throw std::invalid_argument("unknown protocol version '" + std::string(name) + "' (expected season6 or season9)");
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) DarkEmu
+ * Capture of client sessions (timestamps plus raw frames) for replay.
+ */
+
+#include "Common/Network/SessionRecorder.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Fixed-size record header: type, session, timestamp, length.
+constexpr size_t kRecordHeaderSize = 1 + 4 + 8 + 4;
+
+// Store an unsigned integer little-endian.
+template <typename T>
+void putLe(uint8_t* out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// Load an unsigned integer stored little-endian.
+template <typename T>
+T getLe(const uint8_t* in) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<T>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+SessionRecorder::SessionRecorder(const std::string& path) :
+    out_(path, std::ios::binary | std::ios::trunc), start_(std::chrono::steady_clock::now()), last_flush_(start_) {
+    if (!out_.is_open()) {
+        throw std::runtime_error("unable to open capture file " + path + ": " + std::strerror(errno));
+    }
+    out_.write(kMagic.data(), static_cast<std::streamsize>(kMagic.size()));
+}
+
+SessionRecorder::~SessionRecorder() {
+    out_.flush();
+}
+
+uint32_t SessionRecorder::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t session = next_session_++;
+    write(CaptureRecordType::Open, session, {});
+    return session;
+}
+
+void SessionRecorder::clientData(uint32_t session, std::span<const uint8_t> frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write(CaptureRecordType::ClientData, session, frame);
+}
+
+void SessionRecorder::serverData(uint32_t session, std::span<const uint8_t> data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write(CaptureRecordType::ServerData, session, data);
+}
+
+void SessionRecorder::close(uint32_t session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write(CaptureRecordType::Close, session, {});
+}
+
+void SessionRecorder::flushIfDue() {
+    // A flush is a write() syscall; doing it per close would put one on the reactor for every disconnect.
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_ || now - last_flush_ < kFlushInterval) {
+        return;
+    }
+    out_.flush();
+    last_flush_ = now;
+    dirty_ = false;
+}
+
+void SessionRecorder::write(CaptureRecordType type, uint32_t session, std::span<const uint8_t> payload) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                               start_);
+    std::array<uint8_t, kRecordHeaderSize> header{};
+    header[0] = static_cast<uint8_t>(type);
+    putLe<uint32_t>(header.data() + 1, session);
+    putLe<uint64_t>(header.data() + 5, static_cast<uint64_t>(elapsed.count()));
+    putLe<uint32_t>(header.data() + 13, static_cast<uint32_t>(payload.size()));
+    out_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    if (!payload.empty()) {
+        out_.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    }
+    ++records_;
+    dirty_ = true;
+}
+
+bool SessionRecorder::Load(const std::string& path, std::vector<CaptureRecord>& records) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::array<char, 8> magic{};
+    if (!in.read(magic.data(), static_cast<std::streamsize>(magic.size())) || magic != kMagic) {
+        return false;
+    }
+
+    records.clear();
+    std::array<uint8_t, kRecordHeaderSize> header{};
+    while (in.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()))) {
+        CaptureRecord record;
+        record.type = static_cast<CaptureRecordType>(header[0]);
+        record.session = getLe<uint32_t>(header.data() + 1);
+        record.timestamp_us = getLe<uint64_t>(header.data() + 5);
+        const auto length = getLe<uint32_t>(header.data() + 13);
+        record.payload.resize(length);
+        if (length != 0 &&
+            !in.read(reinterpret_cast<char*>(record.payload.data()), static_cast<std::streamsize>(length))) {
+            // Truncated tail from a killed server: keep everything before it.
+            break;
+        }
+        records.push_back(std::move(record));
+    }
+    return true;
+}
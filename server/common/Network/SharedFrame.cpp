@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) DarkEmu
+ * Reference-counted immutable frames for packets fanned out to many connections.
+ */
+
+#include "Common/Network/SharedFrame.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+SharedFrame SharedFrame::copyOf(std::span<const uint8_t> frame) {
+    if (frame.empty() || (frame[0] != 0xC1 && frame[0] != 0xC2)) {
+        throw std::invalid_argument("SharedFrame: only plain C1/C2 frames can be shared");
+    }
+    // Header and bytes in one allocation; the bytes start right after the header.
+    void* memory = ::operator new(sizeof(Block) + frame.size());
+    auto* block = ::new (memory) Block{{1}, static_cast<uint32_t>(frame.size())};
+    std::memcpy(reinterpret_cast<uint8_t*>(block + 1), frame.data(), frame.size());
+    return SharedFrame(block);
+}
+
+SharedFrame::SharedFrame(const SharedFrame& other) noexcept : block_(other.block_) {
+    if (block_ != nullptr) {
+        // A new reference is only ever made from an existing one, so no ordering is needed.
+        block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SharedFrame& SharedFrame::operator=(const SharedFrame& other) noexcept {
+    if (this != &other) {
+        SharedFrame copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+SharedFrame& SharedFrame::operator=(SharedFrame&& other) noexcept {
+    if (this != &other) {
+        reset();
+        block_ = other.block_;
+        other.block_ = nullptr;
+    }
+    return *this;
+}
+
+SharedFrame::~SharedFrame() {
+    reset();
+}
+
+std::span<const uint8_t> SharedFrame::bytes() const noexcept {
+    if (block_ == nullptr) {
+        return {};
+    }
+    return {reinterpret_cast<const uint8_t*>(block_ + 1), block_->size};
+}
+
+uint32_t SharedFrame::useCount() const noexcept {
+    return block_ == nullptr ? 0 : block_->refs.load(std::memory_order_relaxed);
+}
+
+void SharedFrame::reset() noexcept {
+    if (block_ == nullptr) {
+        return;
+    }
+    // The last owner must see every other thread's use of the bytes before freeing them.
+    if (block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block_->~Block();
+        ::operator delete(block_);
+    }
+    block_ = nullptr;
+}
@@ -128,3 +128,11 @@ ssize_t Socket::send(std::span<const uint8_t> buffer, int flags) {
     // Forward to the POSIX send call.
     return ::send(fd_, buffer.data(), buffer.size(), flags);
 }
+
+ssize_t Socket::sendv(std::span<const iovec> buffers, int flags) {
+    // sendmsg() is writev() plus flags such as MSG_NOSIGNAL.
+    msghdr message{};
+    message.msg_iov = const_cast<iovec*>(buffers.data());
+    message.msg_iovlen = buffers.size();
+    return ::sendmsg(fd_, &message, flags);
+}
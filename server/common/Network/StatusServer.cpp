@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) DarkEmu
+ * HTTP/1.0 metrics endpoint implementation.
+ */
+
+#include "Common/Network/StatusServer.h"
+
+#include "Common/Utils/Metrics.h"
+#include "Common/Utils/Tracer.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <sstream>
+#include <span>
+#include <stdexcept>
+#include <sys/socket.h>
+
+namespace {
+
+// Requests larger than this are not a scrape; drop them.
+constexpr size_t kMaxRequestBytes = 4096;
+
+// Upper bound for a single tracing window requested over HTTP.
+constexpr unsigned long kMaxTraceSeconds = 60;
+
+// Build a complete status line and header block.
+std::string makeHeader(const char* status, size_t length,
+                       const char* contentType = "text/plain; version=0.0.4") {
+    std::string header = "HTTP/1.0 ";
+    header += status;
+    header += "\r\nContent-Type: ";
+    header += contentType;
+    header += "\r\nContent-Length: ";
+    header += std::to_string(length);
+    header += "\r\nConnection: close\r\n\r\n";
+    return header;
+}
+
+} // namespace
+
+StatusServer::StatusServer(EpollContext& epoll, uint16_t port, std::chrono::milliseconds interval) :
+    epoll_(epoll), port_(port), refresh_(interval) {
+    // Create and configure the listening socket.
+    listen_socket_ = Socket::createTcp();
+    listen_socket_.setNonBlocking(true);
+    listen_socket_.bind(port_);
+    listen_socket_.listen();
+
+    // Read back the bound port (supports ephemeral port 0 in tests).
+    sockaddr_in addr{};
+    socklen_t addr_len = sizeof(addr);
+    if (::getsockname(listen_socket_.fd(), reinterpret_cast<sockaddr*>(&addr), &addr_len) == -1) {
+        throw std::runtime_error(std::strerror(errno));
+    }
+    port_ = ntohs(addr.sin_port);
+
+    // Render once so the first scrape never sees an empty snapshot.
+    refresh();
+    epoll_.add(listen_socket_.fd(), EPOLLIN);
+    render_thread_ = std::thread([this] { renderLoop(); });
+}
+
+StatusServer::~StatusServer() {
+    {
+        std::lock_guard lock(stop_mutex_);
+        stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    if (render_thread_.joinable()) {
+        render_thread_.join();
+    }
+
+    // Unregister remaining descriptors; sockets close with the map.
+    try {
+        for (const auto& [fd, client] : clients_) {
+            epoll_.remove(fd);
+        }
+        if (listen_socket_.isValid() && epoll_.isValid()) {
+            epoll_.remove(listen_socket_.fd());
+        }
+    } catch (const std::exception&) {
+        // Closing the sockets below drops them from epoll anyway.
+    }
+    clients_.clear();
+}
+
+uint16_t StatusServer::port() const noexcept {
+    return port_;
+}
+
+bool StatusServer::owns(int fd) const noexcept {
+    // The empty() check keeps the common (no scrape in flight) path to two compares.
+    return fd == listen_socket_.fd() || (!clients_.empty() && clients_.contains(fd));
+}
+
+void StatusServer::handleEvent(int fd, uint32_t events) {
+    if (fd == listen_socket_.fd()) {
+        if (events & EPOLLIN) {
+            handleAccept();
+        }
+        return;
+    }
+    // Close clients on error or hang-up events.
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        closeClient(fd);
+        return;
+    }
+    if (events & EPOLLIN) {
+        handleRead(fd);
+    }
+    if ((events & EPOLLOUT) && clients_.contains(fd)) {
+        handleWrite(fd);
+    }
+}
+
+void StatusServer::refresh() {
+    // Render outside the lock; only the pointer swap is serialized.
+    auto rendered = std::make_shared<const std::string>(MetricsRegistry::Instance()->render());
+
+    // Close an expired tracing window and export it here, away from the reactor.
+    std::shared_ptr<const std::string> trace;
+    if (Tracer::Instance()->expired()) {
+        Tracer::Instance()->stop();
+        std::ostringstream json;
+        Tracer::Instance()->writeChromeJson(json);
+        trace = std::make_shared<const std::string>(json.str());
+    }
+
+    std::lock_guard lock(snapshot_mutex_);
+    snapshot_ = std::move(rendered);
+    if (trace) {
+        trace_snapshot_ = std::move(trace);
+    }
+}
+
+void StatusServer::handleAccept() {
+    // Drain all pending accept calls until the listen socket would block.
+    while (true) {
+        Socket client = listen_socket_.accept();
+        if (!client.isValid()) {
+            break;
+        }
+        client.setNonBlocking(true);
+        int fd = client.fd();
+        epoll_.add(fd, EPOLLIN);
+        clients_.emplace(fd, ClientState{std::move(client), {}, {}, {}, 0});
+    }
+}
+
+void StatusServer::handleRead(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+
+    ClientState& client = it->second;
+    char temp[512];
+    // Read until the socket would block or closes.
+    while (true) {
+        ssize_t bytes = ::recv(fd, temp, sizeof(temp), 0);
+        if (bytes > 0) {
+            client.request.append(temp, static_cast<size_t>(bytes));
+            if (client.request.size() > kMaxRequestBytes) {
+                closeClient(fd);
+                return;
+            }
+            continue;
+        }
+        if (bytes == 0) {
+            // Peer shut down its side: a complete request is still answered, and handleWrite closes after it.
+            if (client.request.find("\r\n\r\n") == std::string::npos) {
+                closeClient(fd);
+                return;
+            }
+            break;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        closeClient(fd);
+        return;
+    }
+
+    // Wait for the end of the request header.
+    if (client.request.find("\r\n\r\n") == std::string::npos || !client.header.empty()) {
+        return;
+    }
+
+    // Only the request line matters: "GET <path> HTTP/1.x".
+    const bool is_get = client.request.starts_with("GET ");
+    const size_t path_end = client.request.find(' ', 4);
+    const std::string path = is_get && path_end != std::string::npos ? client.request.substr(4, path_end - 4) : "";
+    if (path == "/metrics" || path == "/") {
+        std::lock_guard lock(snapshot_mutex_);
+        client.body = snapshot_;
+        client.header = makeHeader("200 OK", client.body->size());
+    } else if (path.starts_with("/trace/start")) {
+        // Open a tracing window; the render thread exports it once it expires.
+        unsigned long seconds = 5;
+        if (const size_t query = path.find("seconds="); query != std::string::npos) {
+            seconds = std::strtoul(path.c_str() + query + 8, nullptr, 10);
+        }
+        seconds = std::clamp<unsigned long>(seconds, 1, kMaxTraceSeconds);
+        Tracer::Instance()->start(std::chrono::seconds(seconds));
+        client.body = std::make_shared<const std::string>("tracing for " + std::to_string(seconds) + "s\n");
+        client.header = makeHeader("200 OK", client.body->size());
+    } else if (path == "/trace") {
+        // Serve the last completed trace as Chrome trace-event JSON.
+        std::lock_guard lock(snapshot_mutex_);
+        if (trace_snapshot_) {
+            client.body = trace_snapshot_;
+            client.header = makeHeader("200 OK", client.body->size(), "application/json");
+        } else {
+            client.body = std::make_shared<const std::string>("no trace captured; GET /trace/start?seconds=N\n");
+            client.header = makeHeader("404 Not Found", client.body->size());
+        }
+    } else {
+        static const auto not_found = std::make_shared<const std::string>("not found\n");
+        client.body = not_found;
+        client.header = makeHeader(is_get ? "404 Not Found" : "400 Bad Request", client.body->size());
+    }
+
+    // Switch the socket to write interest and try to flush immediately.
+    epoll_.modify(fd, EPOLLOUT);
+    handleWrite(fd);
+}
+
+void StatusServer::handleWrite(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+
+    ClientState& client = it->second;
+    const size_t total = client.header.size() + client.body->size();
+    while (client.sent < total) {
+        // Write the header first, then the shared snapshot body.
+        std::span<const uint8_t> chunk;
+        if (client.sent < client.header.size()) {
+            chunk = {reinterpret_cast<const uint8_t*>(client.header.data()) + client.sent,
+                     client.header.size() - client.sent};
+        } else {
+            const size_t offset = client.sent - client.header.size();
+            chunk = {reinterpret_cast<const uint8_t*>(client.body->data()) + offset, client.body->size() - offset};
+        }
+        ssize_t sent = client.socket.send(chunk, MSG_NOSIGNAL);
+        if (sent > 0) {
+            client.sent += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Wait for the next EPOLLOUT.
+            return;
+        }
+        break;
+    }
+    // HTTP/1.0 semantics: close after the response.
+    closeClient(fd);
+}
+
+void StatusServer::closeClient(int fd) {
+    // Remove from epoll and erase from the connection map.
+    epoll_.remove(fd);
+    clients_.erase(fd);
+}
+
+void StatusServer::renderLoop() {
+    // Re-render periodically until the destructor signals shutdown.
+    std::unique_lock lock(stop_mutex_);
+    while (!stop_cv_.wait_for(lock, refresh_, [this] { return stopping_; })) {
+        lock.unlock();
+        refresh();
+        lock.lock();
+    }
+}
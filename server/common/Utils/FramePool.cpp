@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) DarkEmu
+ * Thread-local free lists for coroutine frames.
+ */
+
+#include "Common/Utils/FramePool.h"
+
+#include <array>
+#include <new>
+
+namespace {
+
+constexpr size_t kClasses = FramePool::kMaxPooled / FramePool::kGranule;
+
+/// A cached block; the link lives in the block itself.
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+/// The calling thread's free lists, handed back to the heap when the thread exits.
+struct FrameCache {
+    std::array<FreeBlock*, kClasses> heads{};
+    std::array<size_t, kClasses> counts{};
+
+    ~FrameCache() {
+        for (FreeBlock* head : heads) {
+            while (head != nullptr) {
+                FreeBlock* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+};
+
+thread_local FrameCache tls_cache;
+
+constexpr size_t classOf(size_t size) noexcept {
+    return (size + FramePool::kGranule - 1) / FramePool::kGranule - 1;
+}
+
+} // namespace
+
+void* FramePool::allocate(size_t size) {
+    if (size == 0 || size > kMaxPooled) {
+        return ::operator new(size);
+    }
+    const size_t index = classOf(size);
+    if (FreeBlock* block = tls_cache.heads[index]) {
+        tls_cache.heads[index] = block->next;
+        --tls_cache.counts[index];
+        return block;
+    }
+    // Allocate the whole class size, so the block can serve any frame of the class later.
+    return ::operator new((index + 1) * kGranule);
+}
+
+void FramePool::deallocate(void* block, size_t size) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+    if (size == 0 || size > kMaxPooled) {
+        ::operator delete(block);
+        return;
+    }
+    const size_t index = classOf(size);
+    if (tls_cache.counts[index] >= kMaxCachedPerClass) {
+        ::operator delete(block);
+        return;
+    }
+    tls_cache.heads[index] = ::new (block) FreeBlock{tls_cache.heads[index]};
+    ++tls_cache.counts[index];
+}
+
+size_t FramePool::cachedBlocks() noexcept {
+    size_t total = 0;
+    for (size_t count : tls_cache.counts) {
+        total += count;
+    }
+    return total;
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) DarkEmu
+ * Work-stealing job system: Chase-Lev deques, worker threads and job pools.
+ */
+
+#include "Common/Utils/JobSystem.h"
+
+#include "Common/Utils/Tracer.h"
+
+#include <bit>
+#include <string>
+
+namespace {
+
+// Jobs per thread-local ring, and the deque capacity that bounds how many of them can be queued.
+constexpr size_t kPoolSize = 4096;
+constexpr size_t kQueueCapacity = 2048;
+// Failed searches for work before a worker parks on the wake epoch.
+constexpr int kIdleSpins = 64;
+
+// Calling thread's slot in the JobSystem it works for (slot 0 for any other thread).
+thread_local const JobSystem* tls_system = nullptr;
+thread_local size_t tls_index = 0;
+
+} // namespace
+
+WorkStealingQueue::WorkStealingQueue(size_t capacity) :
+    slots_(std::make_unique<std::atomic<Job*>[]>(std::bit_ceil(capacity < 2 ? size_t{2} : capacity))),
+    mask_(static_cast<int64_t>(std::bit_ceil(capacity < 2 ? size_t{2} : capacity)) - 1) {}
+
+bool WorkStealingQueue::push(Job* job) noexcept {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top > mask_) {
+        return false;
+    }
+    slots_[bottom & mask_].store(job, std::memory_order_relaxed);
+    // Release publishes the job's contents to thieves that read bottom_.
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+Job* WorkStealingQueue::pop() noexcept {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_release);
+    // Reserve the slot before looking at top_: a thief either sees the smaller bottom or loses the CAS below.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        bottom_.store(bottom + 1, std::memory_order_release);
+        return nullptr;
+    }
+    Job* job = slots_[bottom & mask_].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last job: race the thieves for it.
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+    return job;
+}
+
+Job* WorkStealingQueue::steal() noexcept {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+    Job* job = slots_[top & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::Worker::Worker(size_t capacity) : queue(capacity), pool(std::make_unique<Job[]>(kPoolSize)) {
+    // Pool slots start finished, so allocate() may hand them out.
+    for (size_t i = 0; i < kPoolSize; ++i) {
+        pool[i].unfinished.store(0, std::memory_order_relaxed);
+    }
+}
+
+JobSystem::JobSystem(size_t workers) {
+    for (size_t i = 0; i <= workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>(kQueueCapacity));
+        workers_.back()->victim_seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+    }
+    threads_.reserve(workers);
+    for (size_t i = 1; i <= workers; ++i) {
+        threads_.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    running_.store(false, std::memory_order_release);
+    wake_epoch_.fetch_add(1, std::memory_order_release);
+    wake_epoch_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t JobSystem::defaultWorkerCount() noexcept {
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 0;
+}
+
+size_t JobSystem::workerCount() const noexcept {
+    return threads_.size();
+}
+
+void JobSystem::run(Job* job) {
+    Worker& self = current();
+    if (!self.queue.push(job)) {
+        // Deque full: running it here bounds how many of this thread's pool slots can be in flight.
+        execute(job);
+        return;
+    }
+    // Pairs with the fence in workerLoop: either the parking worker sees this job or we see it parking.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) != 0) {
+        wake_epoch_.fetch_add(1, std::memory_order_release);
+        wake_epoch_.notify_all();
+    }
+}
+
+void JobSystem::wait(const Job* job) {
+    Worker& self = current();
+    const uint32_t generation = job->generation.load(std::memory_order_relaxed);
+    while (job->unfinished.load(std::memory_order_acquire) > 0 &&
+           job->generation.load(std::memory_order_relaxed) == generation) {
+        if (Job* next = findJob(self)) {
+            execute(next);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+JobSystem::Worker& JobSystem::current() noexcept {
+    return *workers_[tls_system == this ? tls_index : 0];
+}
+
+Job* JobSystem::allocate() {
+    Worker& self = current();
+    while (true) {
+        // Skip slots still queued or running; a full lap without a free slot means help out first.
+        for (size_t tries = 0; tries < kPoolSize; ++tries) {
+            Job* job = &self.pool[self.next++ & (kPoolSize - 1)];
+            if (job->unfinished.load(std::memory_order_acquire) == 0) {
+                return job;
+            }
+        }
+        if (Job* next = findJob(self)) {
+            execute(next);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+Job* JobSystem::findJob(Worker& self) {
+    if (Job* job = self.queue.pop()) {
+        return job;
+    }
+    // xorshift picks where to start, so thieves do not all hammer the same victim.
+    uint64_t& seed = self.victim_seed;
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    const size_t count = workers_.size();
+    const size_t start = static_cast<size_t>(seed % count);
+    for (size_t i = 0; i < count; ++i) {
+        Worker& victim = *workers_[(start + i) % count];
+        if (&victim == &self) {
+            continue;
+        }
+        if (Job* job = victim.queue.steal()) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(Job* job) {
+    job->function(*job);
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    // Read the parent first: once the count hits zero the slot may be reused at any moment.
+    Job* parent = job->parent;
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1 && parent != nullptr) {
+        finish(parent);
+    }
+}
+
+void JobSystem::workerLoop(size_t index) {
+    tls_system = this;
+    tls_index = index;
+    Tracer::Instance()->setThreadName("JobSystem worker " + std::to_string(index));
+    Worker& self = *workers_[index];
+    int idle = 0;
+    while (running_.load(std::memory_order_acquire)) {
+        if (Job* job = findJob(self)) {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < kIdleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+        // Park: announce it, look once more, then sleep until run() or the destructor bumps the epoch.
+        const uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Job* job = findJob(self);
+        if (job == nullptr && running_.load(std::memory_order_acquire)) {
+            wake_epoch_.wait(epoch, std::memory_order_acquire);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        if (job != nullptr) {
+            execute(job);
+        }
+        idle = 0;
+    }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) DarkEmu
+ * Metric registry and Prometheus text rendering.
+ */
+
+#include "Common/Utils/Metrics.h"
+
+#include <iomanip>
+#include <sstream>
+
+uint64_t Histogram::count() const noexcept {
+    // Sum every bucket including +Inf.
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Histogram::quantile(double q) const noexcept {
+    // Walk cumulative counts until the requested rank is covered.
+    const uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += bucket(i);
+        if (seen >= rank) {
+            return upperBound(i);
+        }
+    }
+    return upperBound(kBuckets - 1) + 1;
+}
+
+MetricsRegistry* MetricsRegistry::Instance() {
+    // Function-local static keeps initialization thread-safe since C++11.
+    static MetricsRegistry instance;
+    return &instance;
+}
+
+MetricsRegistry::Entry* MetricsRegistry::find(const std::string& name) {
+    for (auto& entry : entries_) {
+        if (entry->name == name) {
+            return entry.get();
+        }
+    }
+    return nullptr;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard lock(mutex_);
+    // Several engines in one process (tests) share the same series.
+    if (Entry* existing = find(name); existing != nullptr && existing->counter) {
+        return *existing->counter;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->kind = Kind::Counter;
+    entry->counter = std::make_unique<Counter>();
+    Counter& result = *entry->counter;
+    entries_.push_back(std::move(entry));
+    return result;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard lock(mutex_);
+    if (Entry* existing = find(name); existing != nullptr && existing->gauge) {
+        return *existing->gauge;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->kind = Kind::Gauge;
+    entry->gauge = std::make_unique<Gauge>();
+    Gauge& result = *entry->gauge;
+    entries_.push_back(std::move(entry));
+    return result;
+}
+
+void MetricsRegistry::gaugeFunction(const std::string& name, const std::string& help,
+                                    std::function<double()> sample) {
+    std::lock_guard lock(mutex_);
+    // Re-registration replaces the sampler (latest owner wins).
+    if (Entry* existing = find(name); existing != nullptr && existing->kind == Kind::GaugeFunction) {
+        existing->sample = std::move(sample);
+        return;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->kind = Kind::GaugeFunction;
+    entry->sample = std::move(sample);
+    entries_.push_back(std::move(entry));
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, double scale) {
+    std::lock_guard lock(mutex_);
+    if (Entry* existing = find(name); existing != nullptr && existing->histogram) {
+        return *existing->histogram;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->kind = Kind::Histogram;
+    entry->histogram = std::make_unique<Histogram>(scale);
+    Histogram& result = *entry->histogram;
+    entries_.push_back(std::move(entry));
+    return result;
+}
+
+std::string MetricsRegistry::render() const {
+    std::lock_guard lock(mutex_);
+    std::ostringstream out;
+    // Enough digits that integral bucket bounds never switch to exponent notation.
+    out << std::setprecision(15);
+    for (const auto& entry : entries_) {
+        out << "# HELP " << entry->name << ' ' << entry->help << '\n';
+        switch (entry->kind) {
+            case Kind::Counter:
+                out << "# TYPE " << entry->name << " counter\n";
+                out << entry->name << ' ' << entry->counter->value() << '\n';
+                break;
+            case Kind::Gauge:
+                out << "# TYPE " << entry->name << " gauge\n";
+                out << entry->name << ' ' << entry->gauge->value() << '\n';
+                break;
+            case Kind::GaugeFunction:
+                out << "# TYPE " << entry->name << " gauge\n";
+                out << entry->name << ' ' << (entry->sample ? entry->sample() : 0.0) << '\n';
+                break;
+            case Kind::Histogram: {
+                // Prometheus buckets are cumulative and end with +Inf.
+                const Histogram& histogram = *entry->histogram;
+                out << "# TYPE " << entry->name << " histogram\n";
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < Histogram::kBuckets; ++i) {
+                    cumulative += histogram.bucket(i);
+                    out << entry->name << "_bucket{le=\""
+                        << static_cast<double>(Histogram::upperBound(i)) * histogram.scale() << "\"} " << cumulative
+                        << '\n';
+                }
+                cumulative += histogram.bucket(Histogram::kBuckets);
+                out << entry->name << "_bucket{le=\"+Inf\"} " << cumulative << '\n';
+                out << entry->name << "_sum " << static_cast<double>(histogram.sum()) * histogram.scale() << '\n';
+                out << entry->name << "_count " << cumulative << '\n';
+                break;
+            }
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) DarkEmu
+ * Span tracer buffers and Chrome trace-event JSON export.
+ */
+
+#include "Common/Utils/Tracer.h"
+
+#include <iomanip>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Calling thread's buffer for the process-wide tracer (registered on first use).
+thread_local void* tls_buffer = nullptr;
+
+// Escape a thread or span name for a JSON string literal.
+void writeJsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+Tracer* Tracer::Instance() {
+    // Function-local static keeps initialization thread-safe since C++11.
+    static Tracer instance;
+    return &instance;
+}
+
+void Tracer::start(std::chrono::milliseconds duration) {
+    // Bump the generation first so writers reset their buffers lazily.
+    const int64_t now = nowNs();
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    window_start_ns_.store(now, std::memory_order_relaxed);
+    deadline_ns_.store(now + std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+                       std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void Tracer::stop() noexcept {
+    enabled_.store(false, std::memory_order_release);
+}
+
+bool Tracer::expired() const noexcept {
+    return enabled() && nowNs() >= deadline_ns_.load(std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(std::string name) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard lock(buffers_mutex_);
+    buffer.name = std::move(name);
+}
+
+Tracer::ThreadBuffer& Tracer::localBuffer() {
+    if (tls_buffer != nullptr) {
+        return *static_cast<ThreadBuffer*>(tls_buffer);
+    }
+    // First span on this thread: allocate its buffer once; it lives for the process.
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->tid = static_cast<int>(::syscall(SYS_gettid));
+    buffer->name = "thread-" + std::to_string(buffer->tid);
+    buffer->events.resize(kEventsPerThread);
+    buffer->generation.store(generation_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    ThreadBuffer* raw = buffer.get();
+    {
+        std::lock_guard lock(buffers_mutex_);
+        buffers_.push_back(std::move(buffer));
+    }
+    tls_buffer = raw;
+    return *raw;
+}
+
+void Tracer::record(const char* name, int64_t startNs, int64_t endNs, int64_t arg) noexcept {
+    ThreadBuffer* buffer;
+    try {
+        buffer = &localBuffer();
+    } catch (const std::exception&) {
+        return;
+    }
+
+    // Spans from an older window are discarded by the first write of a new one.
+    const uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        // Readers that see the new generation also see the reset counters.
+        buffer->generation.store(generation, std::memory_order_release);
+    }
+
+    const size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= buffer->events.size()) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[index] = Event{name, startNs, endNs, arg};
+    // Publish the slot before the count so the exporter never reads a partial event.
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+uint64_t Tracer::dropped() const noexcept {
+    std::lock_guard lock(buffers_mutex_);
+    const uint64_t generation = generation_.load(std::memory_order_acquire);
+    uint64_t total = 0;
+    for (const auto& buffer : buffers_) {
+        if (buffer->generation.load(std::memory_order_acquire) == generation) {
+            total += buffer->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+void Tracer::writeChromeJson(std::ostream& out) const {
+    std::lock_guard lock(buffers_mutex_);
+    const uint64_t generation = generation_.load(std::memory_order_acquire);
+    const int64_t origin = window_start_ns_.load(std::memory_order_relaxed);
+    const int pid = static_cast<int>(::getpid());
+
+    // Fixed notation keeps microsecond timestamps exact for long windows.
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& buffer : buffers_) {
+        if (buffer->generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+        // Thread-name metadata so Perfetto labels each track.
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+        writeJsonString(out, buffer->name);
+        out << "}}";
+        first = false;
+
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const Event& event = buffer->events[i];
+            // Trace-event timestamps are microseconds; keep sub-microsecond precision.
+            out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"darkemu\",\"ph\":\"X\",\"pid\":" << pid
+                << ",\"tid\":" << buffer->tid << ",\"ts\":" << static_cast<double>(event.start_ns - origin) / 1000.0
+                << ",\"dur\":" << static_cast<double>(event.end_ns - event.start_ns) / 1000.0;
+            if (event.arg >= 0) {
+                out << ",\"args\":{\"arg\":" << event.arg << '}';
+            }
+            out << '}';
+        }
+    }
+    out << "\n]}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
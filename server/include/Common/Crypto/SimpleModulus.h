@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) DarkEmu
+ * SimpleModulus block cipher used by C3/C4 MU frames.
+ */
+
+#ifndef DARKEMU_SIMPLEMODULUS_H
+#define DARKEMU_SIMPLEMODULUS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/// One direction's key set: four lanes, one per 16-bit word of a block.
+struct SimpleModulusKeys {
+    std::array<uint32_t, 4> modulus{};
+    std::array<uint32_t, 4> encryption{};
+    std::array<uint32_t, 4> decryption{};
+    std::array<uint32_t, 4> xor_key{};
+
+    /// Standard client-to-server keys (client Enc2.dat, server Dec2.dat).
+    static SimpleModulusKeys clientToServer() noexcept;
+    /// Standard server-to-client keys (server Enc1.dat, client Dec1.dat).
+    static SimpleModulusKeys serverToClient() noexcept;
+};
+
+/**
+ * SimpleModulus cipher: every 8 plaintext bytes become an 11-byte block of
+ * four 18-bit residues plus a size byte and a checksum byte.
+ *
+ * C3 frames carry an encrypted C1 body and C4 frames an encrypted C2 body,
+ * each prefixed with a one-byte serial. Bulk decryption runs through an AVX2
+ * or SSE4.1 kernel when the CPU supports it; results are bit-identical to the
+ * scalar path, which handles tails and other CPUs.
+ */
+class SimpleModulus {
+public:
+    /// Plaintext bytes per block.
+    static constexpr size_t kBlockSize = 8;
+    /// Ciphertext bytes per block.
+    static constexpr size_t kEncryptedBlockSize = 11;
+    /// Key file header tag.
+    static constexpr uint16_t kKeyFileHeader = 0x1112;
+
+    /// Block kernel implementations, in increasing width.
+    enum class SimdLevel : uint8_t { Scalar, Sse41, Avx2 };
+
+    /// Cipher with all-zero keys; load or assign keys before use.
+    SimpleModulus() = default;
+    /// Cipher using the given keys.
+    explicit SimpleModulus(const SimpleModulusKeys& keys);
+
+    /// Replace the keys; throws std::invalid_argument on a zero modulus.
+    void setKeys(const SimpleModulusKeys& keys);
+    const SimpleModulusKeys& keys() const noexcept {
+        return keys_;
+    }
+
+    /// Load modulus, encryption and XOR keys from an Enc*.dat file.
+    bool loadEncryptionKey(const std::string& path);
+    /// Load modulus, decryption and XOR keys from a Dec*.dat file.
+    bool loadDecryptionKey(const std::string& path);
+    /// Write modulus, encryption and XOR keys in the Enc*.dat format.
+    bool saveEncryptionKey(const std::string& path) const;
+    /// Write modulus, decryption and XOR keys in the Dec*.dat format.
+    bool saveDecryptionKey(const std::string& path) const;
+
+    /// Ciphertext length for a plaintext length.
+    static constexpr size_t encryptedSize(size_t plainSize) noexcept {
+        return (plainSize + kBlockSize - 1) / kBlockSize * kEncryptedBlockSize;
+    }
+    /// Largest plaintext length a ciphertext can decrypt to.
+    static constexpr size_t decryptedCapacity(size_t cipherSize) noexcept {
+        return cipherSize / kEncryptedBlockSize * kBlockSize;
+    }
+
+    /**
+     * Encrypt in into out (which must hold encryptedSize(in.size()) bytes).
+     * A partial final block is zero-padded.
+     * @return Bytes written.
+     */
+    size_t encrypt(std::span<uint8_t> out, std::span<const uint8_t> in) const;
+
+    /**
+     * Decrypt whole blocks from in into out (which must hold decryptedCapacity(in.size()) bytes).
+     * @param plainSize Set to the plaintext length carried by the size bytes.
+     * @return false when in is not a whole number of blocks or a block fails its checksum.
+     */
+    bool decrypt(std::span<uint8_t> out, std::span<const uint8_t> in, size_t& plainSize) const;
+
+    /**
+     * Encrypt a C1 or C2 frame into a C3 or C4 frame.
+     * @param serial Per-connection packet counter placed before the body.
+     * @return false for other frame types or when a C1 body no longer fits a C3 frame.
+     */
+    bool encryptFrame(std::span<const uint8_t> frame, uint8_t serial, std::vector<uint8_t>& out) const;
+
+    /**
+     * Decrypt a C3 or C4 frame back into the C1 or C2 frame it carries.
+     * out is resized rather than reallocated, so a reused vector stays allocation-free.
+     * @param serial Set to the packet counter sent with the frame.
+     * @return false for other frame types or when decryption fails.
+     */
+    bool decryptFrame(std::span<const uint8_t> frame, std::vector<uint8_t>& out, uint8_t& serial) const;
+
+    /**
+     * Decrypt a C3 or C4 frame into caller-owned storage of at least frame.size() bytes.
+     * @param frameSize Set to the size of the C1 or C2 frame written at the start of out.
+     */
+    bool decryptFrame(std::span<const uint8_t> frame, std::span<uint8_t> out, size_t& frameSize,
+                      uint8_t& serial) const;
+
+    /// Widest kernel this CPU supports.
+    static SimdLevel supportedSimdLevel() noexcept;
+    /// Kernel used by this instance.
+    SimdLevel simdLevel() const noexcept {
+        return simd_level_;
+    }
+    /// Select a kernel (clamped to what the CPU and keys support); used by tests and benchmarks.
+    void setSimdLevel(SimdLevel level) noexcept;
+    /// Short name for logs and benchmark labels ("scalar", "sse4.1", "avx2").
+    static const char* simdLevelName(SimdLevel level) noexcept;
+
+private:
+    /// Read a key file; each flag selects one 16-byte key array in file order.
+    bool loadKeyFile(const std::string& path, bool encryption, bool decryption);
+    /// Write a key file holding modulus, one cipher key and the XOR key.
+    bool saveKeyFile(const std::string& path, const std::array<uint32_t, 4>& key) const;
+    /// Widest kernel usable with the current keys.
+    SimdLevel usableSimdLevel() const noexcept;
+
+    SimpleModulusKeys keys_{};
+    SimdLevel requested_level_{supportedSimdLevel()};
+    SimdLevel simd_level_{SimdLevel::Scalar};
+};
+
+#endif // DARKEMU_SIMPLEMODULUS_H
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) DarkEmu
+ * XOR32 body obfuscation used by client C1/C2 frames.
+ */
+
+#ifndef DARKEMU_XOR32_H
+#define DARKEMU_XOR32_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "Common/Crypto/SimpleModulus.h"
+
+/**
+ * XOR32 frame coder: every body byte after the head code is XORed with the
+ * previous wire byte and a 32-byte key indexed by its offset in the frame.
+ *
+ * Decoding only reads ciphertext, so it runs in place 16 (SSE) or 32 (AVX2)
+ * bytes at a time. Encoding chains on its own output and is a prefix XOR;
+ * the key mix is vectorized and the chain resolved with an in-register scan.
+ */
+class Xor32 {
+public:
+    /// Key length; byte i of a frame uses key[i % kKeySize].
+    static constexpr size_t kKeySize = 32;
+    using Key = std::array<uint8_t, kKeySize>;
+    /// Kernel selection shared with SimpleModulus.
+    using SimdLevel = SimpleModulus::SimdLevel;
+
+    /// Season 5.2 client key.
+    static constexpr Key kDefaultKey{0xAB, 0x11, 0xCD, 0xFE, 0x18, 0x23, 0xC5, 0xA3, 0xCA, 0x33, 0xC1,
+                                     0xCC, 0x66, 0x67, 0x21, 0xF3, 0x32, 0x12, 0x15, 0x35, 0x29, 0xFF,
+                                     0xFE, 0x1D, 0x44, 0xEF, 0xCD, 0x41, 0x26, 0x3C, 0x4E, 0x4D};
+
+    /// Coder using kDefaultKey.
+    Xor32() noexcept;
+    /// Coder using a custom key.
+    explicit Xor32(const Key& key) noexcept;
+
+    void setKey(const Key& key) noexcept;
+    Key key() const noexcept;
+
+    /// Decode a C1/C2 frame in place; frames without body bytes are left untouched.
+    void decodeFrame(std::span<uint8_t> frame) const noexcept;
+    /// Encode a C1/C2 frame in place (client direction; used by tests and bots).
+    void encodeFrame(std::span<uint8_t> frame) const noexcept;
+
+    /// Kernel used by this instance.
+    SimdLevel simdLevel() const noexcept {
+        return simd_level_;
+    }
+    /// Select a kernel (clamped to what the CPU supports); used by tests and benchmarks.
+    void setSimdLevel(SimdLevel level) noexcept;
+
+private:
+    /// Key stored twice so the key for any 32-byte window is one unaligned load.
+    std::array<uint8_t, 2 * kKeySize> key_{};
+    SimdLevel simd_level_{SimpleModulus::supportedSimdLevel()};
+};
+
+#endif // DARKEMU_XOR32_H
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) DarkEmu
+ * Coroutine tasks and awaitable socket, timer and completion operations on an epoll loop.
+ */
+
+#ifndef DARKEMU_ASYNCIO_H
+#define DARKEMU_ASYNCIO_H
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "Common/Network/EpollContext.h"
+#include "Common/Network/Socket.h"
+#include "Common/Utils/FramePool.h"
+
+class IoLoop;
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+/// Promise state shared by every Task: continuation, error and the detached-task links.
+struct TaskPromiseBase {
+    /// Coroutine frames come from the thread's FramePool, so starting a flow costs no heap traffic.
+    static void* operator new(size_t size) {
+        return FramePool::allocate(size);
+    }
+    static void operator delete(void* frame, size_t size) noexcept {
+        FramePool::deallocate(frame, size);
+    }
+
+    /// Resumes the awaiting coroutine (symmetric transfer), or retires a detached task.
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase& promise = handle.promise();
+            if (promise.continuation) {
+                return promise.continuation;
+            }
+            if (promise.loop != nullptr) {
+                finishDetached(promise);
+                handle.destroy();
+            }
+            return std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+    void unhandled_exception() noexcept {
+        exception = std::current_exception();
+    }
+
+    /// Unlink a finished detached task from its loop and report an escaped exception.
+    static void finishDetached(TaskPromiseBase& promise) noexcept;
+
+    std::coroutine_handle<> continuation; ///< Coroutine awaiting this task.
+    std::exception_ptr exception;
+    // Detached tasks only: owning loop and its list of live tasks.
+    IoLoop* loop{nullptr};
+    std::coroutine_handle<> self;
+    TaskPromiseBase* prev{nullptr};
+    TaskPromiseBase* next{nullptr};
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& value) {
+        result.emplace(std::forward<U>(value));
+    }
+    T take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void take() const {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * Lazily started coroutine returning T. Awaiting a task starts it and
+ * resumes the awaiter when it returns, both by symmetric transfer (a tail
+ * jump, no stack growth); exceptions propagate to the awaiter. Top-level
+ * flows are handed to IoLoop::spawn().
+ */
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() noexcept = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() const noexcept {
+                return false;
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+                handle.promise().continuation = awaiter;
+                return handle;
+            }
+            T await_resume() {
+                return handle.promise().take();
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    friend class IoLoop;
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> detail::TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/**
+ * Single-threaded coroutine scheduler over an EpollContext. Coroutines
+ * suspend on socket readiness, timers or completions posted from other
+ * threads; runOnce() waits for events and resumes whatever they unblocked.
+ * Socket operations complete inside the loop before the coroutine is resumed,
+ * so a resumption is one indirect call into the frame.
+ *
+ * Everything except post() and stop() must be called on the loop's thread.
+ * No server runs on it yet; the GameServer login flow is the first planned user.
+ */
+class IoLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    IoLoop();
+    /// Destroy tasks that are still suspended, then close the loop.
+    ~IoLoop();
+
+    IoLoop(const IoLoop&) = delete;
+    IoLoop& operator=(const IoLoop&) = delete;
+
+    /// Start a top-level flow now; it runs until its first suspension and is owned by the loop.
+    void spawn(Task<void> task);
+    /// Wait up to timeoutMs (-1 blocks) for events, then resume every coroutine they unblocked.
+    void runOnce(int timeoutMs);
+    /// Run until stop() is called.
+    void run();
+    /// Make run() return after the current iteration; callable from any thread.
+    void stop() noexcept;
+    /// Any thread: resume a suspended coroutine on the loop thread at its next iteration.
+    void post(std::coroutine_handle<> handle);
+    /// Spawned tasks that have not finished yet.
+    size_t tasks() const noexcept {
+        return tasks_;
+    }
+    /// The epoll set sockets register with.
+    EpollContext& epoll() noexcept {
+        return epoll_;
+    }
+
+    /// co_await loop.sleep(d): resume after at least d (a zero delay yields to the loop).
+    auto sleep(Clock::duration delay) noexcept {
+        struct Awaiter {
+            IoLoop& loop;
+            Clock::time_point due;
+            bool await_ready() const noexcept {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle) {
+                loop.timers_.push(Timer{due, loop.next_timer_++, handle});
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, Clock::now() + delay};
+    }
+
+private:
+    friend struct detail::TaskPromiseBase;
+    friend class AsyncSocket;
+
+    struct Timer {
+        Clock::time_point due;
+        uint64_t sequence; ///< Keeps timers with the same deadline in arming order.
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& other) const noexcept {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+
+    /// Milliseconds until the next timer, capped by timeoutMs.
+    int nextTimeout(int timeoutMs) const;
+
+    EpollContext epoll_;
+    int wake_fd_{-1};                            ///< eventfd written by post() and stop().
+    std::vector<epoll_event> events_;
+    std::vector<std::coroutine_handle<>> ready_; ///< Coroutines unblocked by the current wait.
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t next_timer_{0};
+    std::mutex posted_mutex_;
+    std::vector<std::coroutine_handle<>> posted_; ///< Filled by post(), guarded by posted_mutex_.
+    std::vector<std::coroutine_handle<>> resuming_; ///< Posted handles taken by the current iteration.
+    std::atomic<bool> stopping_{false};
+    size_t tasks_{0};
+    detail::TaskPromiseBase* live_{nullptr};     ///< Spawned tasks that have not finished.
+};
+
+/**
+ * Non-blocking socket registered edge-triggered with an IoLoop, with
+ * awaitable frame reads, sends and accepts. At most one read (frame or
+ * accept) and one send may be pending at a time. Must outlive its pending
+ * operations and stays where it was constructed (the loop holds its address).
+ */
+class AsyncSocket {
+public:
+    /// Take ownership of socket, make it non-blocking and register it with loop.
+    AsyncSocket(IoLoop& loop, Socket socket);
+    /// Deregister and close the socket.
+    ~AsyncSocket();
+
+    AsyncSocket(const AsyncSocket&) = delete;
+    AsyncSocket& operator=(const AsyncSocket&) = delete;
+
+    /// The owned socket.
+    Socket& socket() noexcept {
+        return socket_;
+    }
+
+    /**
+     * co_await readFrame(): the next complete C1-C4 frame, or an empty span on
+     * EOF, a socket error or a malformed header. The frame stays valid until
+     * the next readFrame().
+     */
+    auto readFrame() noexcept {
+        struct Awaiter {
+            AsyncSocket& socket;
+            bool await_ready() {
+                return socket.pollFrame();
+            }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                socket.read_op_ = ReadOp::Frame;
+                socket.reader_ = handle;
+            }
+            std::span<const uint8_t> await_resume() const noexcept {
+                return socket.frame_;
+            }
+        };
+        return Awaiter{*this};
+    }
+
+    /// co_await send(data): write all of data; false when the connection failed. data must stay valid until then.
+    auto send(std::span<const uint8_t> data) noexcept {
+        struct Awaiter {
+            AsyncSocket& socket;
+            bool await_ready() {
+                return socket.pollSend();
+            }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                socket.writer_ = handle;
+            }
+            bool await_resume() const noexcept {
+                return socket.send_ok_;
+            }
+        };
+        pending_send_ = data;
+        return Awaiter{*this};
+    }
+
+    /// co_await accept() on a listening socket: the next connection, or an invalid Socket on error.
+    auto accept() noexcept {
+        struct Awaiter {
+            AsyncSocket& socket;
+            bool await_ready() {
+                return socket.pollAccept();
+            }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                socket.read_op_ = ReadOp::Accept;
+                socket.reader_ = handle;
+            }
+            Socket await_resume() noexcept {
+                return std::move(socket.accepted_);
+            }
+        };
+        return Awaiter{*this};
+    }
+
+private:
+    friend class IoLoop;
+
+    enum class ReadOp : uint8_t { Frame, Accept };
+
+    /// Try to complete a frame read; true when done (frame_ set, empty on failure).
+    bool pollFrame();
+    /// Try to finish the pending send; true when done (send_ok_ set).
+    bool pollSend();
+    /// Try to accept a connection; true when done (accepted_ set, invalid on failure).
+    bool pollAccept();
+    /// Finish whatever pending operations the readiness events allow and queue their coroutines.
+    void onEvent(uint32_t events, std::vector<std::coroutine_handle<>>& ready);
+
+    IoLoop& loop_;
+    Socket socket_;
+    std::vector<uint8_t> buffer_;    ///< Received bytes; [head_, size) are not consumed yet.
+    size_t head_{0};
+    std::span<const uint8_t> frame_; ///< Result of the last frame read.
+    bool failed_{false};             ///< EOF, error or malformed data: reads finish empty from now on.
+    std::span<const uint8_t> pending_send_;
+    bool send_ok_{true};
+    Socket accepted_;
+    ReadOp read_op_{ReadOp::Frame};
+    std::coroutine_handle<> reader_;
+    std::coroutine_handle<> writer_;
+};
+
+/**
+ * One-shot result handed to a coroutine from another thread (a database or
+ * file lookup running on a worker). The coroutine co_awaits the completion;
+ * the worker calls complete(), which resumes it on the loop thread. Either
+ * may happen first.
+ */
+template <typename T>
+class Completion {
+public:
+    explicit Completion(IoLoop& loop) noexcept : loop_(loop) {}
+
+    Completion(const Completion&) = delete;
+    Completion& operator=(const Completion&) = delete;
+
+    /// Any thread, once: store the result and resume the awaiting coroutine.
+    void complete(T value) {
+        value_.emplace(std::move(value));
+        // The awaiter may run and destroy this object as soon as the state flips; touch only locals after it.
+        IoLoop& loop = loop_;
+        const uintptr_t previous = state_.exchange(kCompleted, std::memory_order_acq_rel);
+        if (previous != kEmpty) {
+            loop.post(std::coroutine_handle<>::from_address(reinterpret_cast<void*>(previous)));
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return state_.load(std::memory_order_acquire) == kCompleted;
+    }
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+        uintptr_t expected = kEmpty;
+        // Fails when complete() got there first: then carry on without suspending.
+        return state_.compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(handle.address()),
+                                              std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+    T await_resume() {
+        return std::move(*value_);
+    }
+
+private:
+    static constexpr uintptr_t kEmpty = 0;
+    static constexpr uintptr_t kCompleted = 1;
+
+    IoLoop& loop_;
+    std::optional<T> value_;
+    std::atomic<uintptr_t> state_{kEmpty}; ///< kEmpty, kCompleted or the awaiting coroutine's address.
+};
+
+#endif // DARKEMU_ASYNCIO_H
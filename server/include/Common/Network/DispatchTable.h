@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) DarkEmu
+ * Compile-time opcode dispatch tables indexed by head code and sub-code.
+ */
+
+#ifndef DARKEMU_DISPATCHTABLE_H
+#define DARKEMU_DISPATCHTABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "Common/Network/PacketLayout.h"
+
+/// Outcome of routing one frame.
+enum class DispatchStatus : uint8_t {
+    Dispatched,    ///< Handler called.
+    UnknownOpcode, ///< No route for the head code / sub-code.
+    WrongType,     ///< Frame type byte (and so header width) differs from the route's packet.
+    TooShort,      ///< Frame shorter than the route's minimum length.
+    WrongState,    ///< Route not allowed in the session's current state.
+    RateLimited,   ///< The rate gate refused the route's rate class.
+};
+
+/// Route sub-code that matches every frame with the head code (packets without a sub-code).
+inline constexpr int kAnySubCode = -1;
+
+/**
+ * One handler registration.
+ * @tparam Type Frame type byte the route accepts; it fixes the header width the handler parses.
+ * @tparam Method Owner member function `void (Session&, std::span<const uint8_t>)`.
+ * @tparam MinLength Smallest accepted frame, header included.
+ * @tparam States Bit mask of session states in which the route is accepted.
+ * @tparam RateClass Caller-defined rate-limit bucket.
+ */
+template <uint8_t Type, uint8_t Head, int Sub, auto Method, uint16_t MinLength, uint8_t States,
+          uint8_t RateClass = 0>
+struct Route {
+    static_assert(Sub >= kAnySubCode && Sub <= 0xFF, "sub-code must be a byte or kAnySubCode");
+    static_assert(Sub == kAnySubCode || MinLength >= 4, "a sub-code route needs room for the sub-code");
+    static_assert(States != 0, "a route must be allowed in at least one state");
+
+    static constexpr uint8_t kType = Type;
+    static constexpr uint8_t kHead = Head;
+    static constexpr int kSub = Sub;
+    static constexpr auto kMethod = Method;
+    static constexpr uint16_t kMinLength = MinLength;
+    static constexpr uint8_t kStates = States;
+    static constexpr uint8_t kRateClass = RateClass;
+};
+
+namespace detail {
+
+template <WirePacket Packet>
+constexpr int routeSubCode() noexcept {
+    if constexpr (PacketTraits<Packet>::kHasSub) {
+        return Packet::Header::kSub;
+    } else {
+        return kAnySubCode;
+    }
+}
+
+} // namespace detail
+
+/// Route for the request struct a handler parses: type, head code, sub-code and minimum length come from Packet.
+template <WirePacket Packet, auto Method, uint8_t States, uint8_t RateClass = 0>
+using PacketRoute = Route<PacketTraits<Packet>::kType, PacketTraits<Packet>::kHead, detail::routeSubCode<Packet>(),
+                          Method, static_cast<uint16_t>(PacketTraits<Packet>::kSize), States, RateClass>;
+
+/**
+ * Two-level table built at compile time from Route registrations: 256
+ * head-code slots, and a 256-entry sub-code table for each head code that
+ * routes on sub-codes. Routing is two indexed loads and one validation
+ * branch whatever the number of routes; duplicate routes fail to compile.
+ * @tparam Framer BasicPacketFramer of the protocol's frame codes; it gives the header width before the head code.
+ */
+template <typename Owner, typename Session, typename Framer, typename... Routes>
+class DispatchTable {
+public:
+    using Handler = void (*)(Owner&, Session&, std::span<const uint8_t>);
+
+    /// Validation data and direct call target for one opcode.
+    struct Entry {
+        Handler handler{nullptr};
+        uint8_t type{0};
+        uint16_t min_length{0};
+        uint8_t states{0};
+        uint8_t rate_class{0};
+    };
+
+    /// Entry for a head code and sub-code (handler is null for unknown opcodes).
+    static constexpr const Entry& lookup(uint8_t head, uint8_t sub) noexcept {
+        const HeadSlot& slot = kTables.heads[head];
+        return slot.sub_table != 0 ? kTables.subs[slot.sub_table][sub] : slot.entry;
+    }
+
+    /**
+     * Validate a frame against its entry and call the handler.
+     * @param state Single-bit session state tested against the entry's mask.
+     * @param allow Rate gate called with the entry's rate class after the other checks pass.
+     */
+    template <typename RateGate>
+    static DispatchStatus dispatch(Owner& owner, Session& session, std::span<const uint8_t> frame, uint8_t state,
+                                   RateGate&& allow) {
+        const size_t header = Framer::headerSize(frame[0]);
+        const uint8_t sub = frame.size() > header + 1 ? frame[header + 1] : 0;
+        const Entry& entry = lookup(frame[header], sub);
+        if (entry.handler == nullptr) {
+            return DispatchStatus::UnknownOpcode;
+        }
+        // Handlers parse the header width of their packet, so a C2 frame never reaches a C1 route.
+        if (frame[0] != entry.type) {
+            return DispatchStatus::WrongType;
+        }
+        if (frame.size() < entry.min_length) {
+            return DispatchStatus::TooShort;
+        }
+        if ((entry.states & state) == 0) {
+            return DispatchStatus::WrongState;
+        }
+        if (!allow(entry.rate_class)) {
+            return DispatchStatus::RateLimited;
+        }
+        entry.handler(owner, session, frame);
+        return DispatchStatus::Dispatched;
+    }
+
+    /// Number of routes registered.
+    static constexpr size_t kRouteCount = sizeof...(Routes);
+
+private:
+    struct HeadSlot {
+        Entry entry;           ///< Route for heads without sub-codes.
+        uint8_t sub_table{0};  ///< Index into subs, 0 when the head has no sub-code routes.
+    };
+
+    /// Head codes that route on sub-codes; each gets its own sub table.
+    static constexpr size_t countSubTables() {
+        std::array<bool, 256> used{};
+        ((Routes::kSub != kAnySubCode ? used[Routes::kHead] = true : false), ...);
+        size_t count = 0;
+        for (bool flag : used) {
+            count += flag ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Sub table 0 is an all-empty sentinel so a valid index is never 0.
+    static constexpr size_t kSubTables = countSubTables() + 1;
+    static_assert(kSubTables <= 256, "at most 255 head codes can route on sub-codes");
+
+    struct Tables {
+        std::array<HeadSlot, 256> heads{};
+        std::array<std::array<Entry, 256>, kSubTables> subs{};
+    };
+
+    template <typename R>
+    static void call(Owner& owner, Session& session, std::span<const uint8_t> frame) {
+        (owner.*R::kMethod)(session, frame);
+    }
+
+    template <typename R>
+    static constexpr void add(Tables& tables, size_t& next_sub_table) {
+        const Entry entry{&call<R>, R::kType, R::kMinLength, R::kStates, R::kRateClass};
+        HeadSlot& slot = tables.heads[R::kHead];
+        if constexpr (R::kSub == kAnySubCode) {
+            if (slot.entry.handler != nullptr || slot.sub_table != 0) {
+                throw "DispatchTable: head code registered twice or mixed with sub-code routes";
+            }
+            slot.entry = entry;
+        } else {
+            if (slot.entry.handler != nullptr) {
+                throw "DispatchTable: sub-code route on a head code that has a catch-all route";
+            }
+            if (slot.sub_table == 0) {
+                slot.sub_table = static_cast<uint8_t>(next_sub_table++);
+            }
+            Entry& target = tables.subs[slot.sub_table][static_cast<size_t>(R::kSub)];
+            if (target.handler != nullptr) {
+                throw "DispatchTable: sub-code registered twice";
+            }
+            target = entry;
+        }
+    }
+
+    static constexpr Tables build() {
+        Tables tables{};
+        size_t next_sub_table = 1;
+        (add<Routes>(tables, next_sub_table), ...);
+        return tables;
+    }
+
+    static constexpr Tables kTables = build();
+};
+
+#endif // DARKEMU_DISPATCHTABLE_H
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) DarkEmu
+ * Event-loop health instrumentation for epoll reactors.
+ */
+
+#ifndef DARKEMU_LOOPMONITOR_H
+#define DARKEMU_LOOPMONITOR_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/Network/EpollContext.h"
+#include "Common/Utils/Metrics.h"
+
+/// One handler invocation that exceeded the configured budget.
+struct SlowHandlerRecord {
+    int fd{-1};               ///< Descriptor whose event was being handled.
+    int opcode{-1};           ///< Packet opcode noted by the handler (-1 if unknown).
+    uint64_t duration_us{0};  ///< Time spent in the handler.
+    uint64_t wall_time_ms{0}; ///< Wall-clock time the handler finished (ms since epoch).
+};
+
+/**
+ * Measures one reactor: time blocked in epoll_wait, time spent in handlers,
+ * events per wakeup and per-handler stalls. It also owns the sizing policy of
+ * the event array, growing it when wakeups keep returning a full batch.
+ */
+class LoopMonitor {
+public:
+    /// Maximum number of slow handler records kept in memory.
+    static constexpr size_t kSlowLogSize = 64;
+    /// Consecutive saturated wakeups before the event array grows.
+    static constexpr int kGrowAfter = 4;
+    /// Upper bound for the adaptive event array.
+    static constexpr size_t kMaxEvents = 4096;
+
+    /**
+     * Register the loop's metric series under the given prefix.
+     * @param prefix Metric name prefix, e.g. "darkemu_connect_loop".
+     * @param name Human-readable loop name used in slow-handler log lines.
+     */
+    LoopMonitor(const std::string& prefix, std::string name);
+
+    /// Set the per-handler time budget; longer handlers are logged as slow.
+    void setHandlerBudget(std::chrono::microseconds budget) noexcept;
+    /// Return the current per-handler time budget.
+    std::chrono::microseconds handlerBudget() const noexcept;
+
+    /**
+     * Wait for events, recording blocked time and batch size.
+     * Grows events when the previous wakeups kept filling it.
+     * @return Number of ready events (as EpollContext::wait).
+     */
+    int wait(EpollContext& epoll, std::vector<epoll_event>& events, int timeoutMs);
+    /// Close the iteration started by wait() and record total handler time.
+    void endIteration() noexcept;
+
+    /// Start timing the handler for fd.
+    void beginHandler(int fd) noexcept;
+    /// Attach the packet opcode currently being processed to the running handler.
+    void noteOpcode(int opcode) noexcept;
+    /// Stop timing the running handler and log it if it exceeded the budget.
+    void endHandler() noexcept;
+
+    /// Copy the most recent slow handler records, oldest first.
+    std::vector<SlowHandlerRecord> slowHandlers() const;
+
+    /// RAII helper that brackets one handler invocation.
+    class HandlerScope {
+    public:
+        HandlerScope(LoopMonitor& monitor, int fd) noexcept : monitor_(monitor) {
+            monitor_.beginHandler(fd);
+        }
+        ~HandlerScope() {
+            monitor_.endHandler();
+        }
+        HandlerScope(const HandlerScope&) = delete;
+        HandlerScope& operator=(const HandlerScope&) = delete;
+
+    private:
+        LoopMonitor& monitor_;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Store a slow handler record and emit a log line.
+    void recordSlow(const SlowHandlerRecord& record);
+
+    std::string name_;
+    std::chrono::microseconds budget_{2000};
+
+    Histogram& wait_time_;
+    Histogram& handler_time_;
+    Histogram& events_per_wakeup_;
+    Counter& saturated_wakeups_;
+    Counter& slow_handlers_;
+    Gauge& event_capacity_;
+
+    Clock::time_point woke_at_{};
+    Clock::time_point handler_started_{};
+    int handler_fd_{-1};
+    int handler_opcode_{-1};
+    int saturated_streak_{0};
+
+    mutable std::mutex slow_mutex_;
+    std::array<SlowHandlerRecord, kSlowLogSize> slow_log_{};
+    size_t slow_count_{0};
+};
+
+#endif // DARKEMU_LOOPMONITOR_H
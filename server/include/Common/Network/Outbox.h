@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) DarkEmu
+ * Per-connection outbound queue of copied and shared frames, written with scatter-gather sends.
+ */
+
+#ifndef DARKEMU_OUTBOX_H
+#define DARKEMU_OUTBOX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <sys/socket.h>
+#include <vector>
+
+#include "Common/Network/SharedFrame.h"
+#include "Common/Network/Socket.h"
+
+/**
+ * Frames waiting to be written to one connection, in send order.
+ *
+ * Frames meant for this connection only are copied into one contiguous
+ * buffer, and consecutive copies merge into a single segment. Shared frames
+ * (SharedFrame) of kMinSharedBytes or more are referenced instead of copied,
+ * so a packet fanned out to hundreds of connections exists once; smaller ones
+ * are copied too, because an iovec and a reference count cost more than
+ * copying a few bytes. flush() hands the segments to the socket as an iovec
+ * array, one sendmsg() per kMaxIovecs segments. What the socket does not take
+ * stays queued for the next flush().
+ */
+class Outbox {
+public:
+    /// Segments gathered into one sendmsg() call.
+    static constexpr size_t kMaxIovecs = 64;
+    /// Shared frames shorter than this are copied instead of referenced.
+    static constexpr size_t kMinSharedBytes = 256;
+
+    /// Outcome of one flush().
+    struct FlushResult {
+        size_t sent{0};      ///< Bytes the socket accepted.
+        uint32_t calls{0};   ///< sendmsg() calls made.
+        bool failed{false};  ///< A call failed with something other than EAGAIN (errno is kept).
+    };
+
+    /// Queue a copy of a frame.
+    void append(std::span<const uint8_t> frame);
+    /// Queue a shared frame, by reference unless it is shorter than kMinSharedBytes.
+    void append(const SharedFrame& frame);
+
+    /// Write as much as the socket takes, stopping at the first partial write or EAGAIN.
+    FlushResult flush(Socket& socket, int flags = MSG_NOSIGNAL);
+    /// Drop everything queued.
+    void clear() noexcept;
+
+    /// Bytes queued and not yet sent.
+    size_t pending() const noexcept {
+        return pending_;
+    }
+    bool empty() const noexcept {
+        return pending_ == 0;
+    }
+    /// Segments queued and not yet fully sent.
+    size_t segments() const noexcept {
+        return segments_.size() - head_;
+    }
+
+private:
+    /// A run of copied bytes in bytes_ (shared empty), or one shared frame.
+    struct Segment {
+        SharedFrame shared;
+        uint32_t offset{0};
+        uint32_t size{0};
+    };
+
+    std::span<const uint8_t> bytesOf(const Segment& segment) const noexcept;
+    /// Retire sent bytes from the front of the queue.
+    void consume(size_t sent) noexcept;
+    /// Drop retired segments and the copied bytes only they used.
+    void compact();
+
+    std::vector<uint8_t> bytes_;     ///< Copied frames.
+    std::vector<Segment> segments_;  ///< In send order; [0, head_) are already sent.
+    size_t head_{0};
+    size_t head_sent_{0};            ///< Bytes of segments_[head_] already sent.
+    size_t pending_{0};
+};
+
+#endif // DARKEMU_OUTBOX_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) DarkEmu
+ * Frame boundary detection for C1/C2/C3/C4 MU packets.
+ */
+
+#ifndef DARKEMU_PACKETFRAMER_H
+#define DARKEMU_PACKETFRAMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/// Frame type bytes used by every supported client build.
+struct StandardFrameCodes {
+    static constexpr uint8_t kC1 = 0xC1; ///< Plain frame, 1-byte size.
+    static constexpr uint8_t kC2 = 0xC2; ///< Plain frame, 2-byte size.
+    static constexpr uint8_t kC3 = 0xC3; ///< Encrypted frame, 1-byte size.
+    static constexpr uint8_t kC4 = 0xC4; ///< Encrypted frame, 2-byte size.
+};
+
+/**
+ * Stateless helpers that split a byte stream into MU protocol frames.
+ * C1/C3 frames carry a 1-byte size at offset 1; C2/C4 carry a big-endian
+ * 2-byte size at offset 1. The size always covers the whole frame.
+ * @tparam Codes Frame type bytes (a protocol policy's Frames type).
+ */
+template <typename Codes>
+class BasicPacketFramer {
+public:
+    /// Result of inspecting the front of a receive buffer.
+    enum class Status {
+        Complete,   ///< A whole frame is available.
+        Incomplete, ///< More bytes are needed.
+        Invalid,    ///< Unknown header byte or impossible size; drop the connection.
+    };
+
+    /// True for header bytes that use the 2-byte size field.
+    static constexpr bool isWide(uint8_t type) noexcept {
+        return type == Codes::kC2 || type == Codes::kC4;
+    }
+    /// True for header bytes whose body is SimpleModulus-encrypted.
+    static constexpr bool isEncrypted(uint8_t type) noexcept {
+        return type == Codes::kC3 || type == Codes::kC4;
+    }
+    /// Header length (type + size field) for a frame type.
+    static constexpr size_t headerSize(uint8_t type) noexcept {
+        return isWide(type) ? 3 : 2;
+    }
+
+    /**
+     * Inspect the start of data and report the next frame size.
+     * @param data Buffered bytes starting at a frame boundary.
+     * @param frameSize Set to the full frame length when Complete.
+     */
+    static constexpr Status peek(std::span<const uint8_t> data, size_t& frameSize) noexcept {
+        if (data.empty()) {
+            return Status::Incomplete;
+        }
+        const uint8_t type = data[0];
+        if (type != Codes::kC1 && type != Codes::kC2 && type != Codes::kC3 && type != Codes::kC4) {
+            return Status::Invalid;
+        }
+        const size_t header = headerSize(type);
+        if (data.size() < header) {
+            return Status::Incomplete;
+        }
+        const size_t size = isWide(type) ? (static_cast<size_t>(data[1]) << 8) | data[2] : data[1];
+        // A frame must at least hold its header and a head code.
+        if (size <= header) {
+            return Status::Invalid;
+        }
+        if (data.size() < size) {
+            return Status::Incomplete;
+        }
+        frameSize = size;
+        return Status::Complete;
+    }
+
+    /**
+     * Invoke fn(frame) for every complete frame at the front of data.
+     * @param invalid Set to true when a malformed header stops the scan.
+     * @return Number of bytes consumed by complete frames.
+     */
+    template <typename Fn>
+    static size_t forEachFrame(std::span<const uint8_t> data, Fn&& fn, bool& invalid) {
+        return scanFrames(data, fn, invalid);
+    }
+
+    /// Like forEachFrame, but hands out writable frames so they can be decoded in place.
+    template <typename Fn>
+    static size_t forEachFrameInPlace(std::span<uint8_t> data, Fn&& fn, bool& invalid) {
+        return scanFrames(data, fn, invalid);
+    }
+
+private:
+    template <typename Byte, typename Fn>
+    static size_t scanFrames(std::span<Byte> data, Fn& fn, bool& invalid) {
+        size_t offset = 0;
+        invalid = false;
+        while (offset < data.size()) {
+            size_t size = 0;
+            const Status status = peek(data.subspan(offset), size);
+            if (status == Status::Incomplete) {
+                break;
+            }
+            if (status == Status::Invalid) {
+                invalid = true;
+                break;
+            }
+            fn(data.subspan(offset, size));
+            offset += size;
+        }
+        return offset;
+    }
+};
+
+/// Framer for the standard C1-C4 type bytes.
+using PacketFramer = BasicPacketFramer<StandardFrameCodes>;
+
+#endif // DARKEMU_PACKETFRAMER_H
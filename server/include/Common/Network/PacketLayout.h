@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) DarkEmu
+ * Compile-time wire layouts for MU packets: endian fields, headers and views.
+ */
+
+#ifndef DARKEMU_PACKETLAYOUT_H
+#define DARKEMU_PACKETLAYOUT_H
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <type_traits>
+
+/**
+ * Unsigned integer stored as raw bytes in a fixed byte order.
+ * Alignment is 1, so it can sit at any offset of a packet struct.
+ */
+template <typename T, std::endian Order>
+class EndianValue {
+    static_assert(std::is_unsigned_v<T>, "EndianValue holds unsigned integers");
+
+public:
+    constexpr EndianValue() noexcept = default;
+    constexpr EndianValue(T value) noexcept {
+        set(value);
+    }
+
+    constexpr T get() const noexcept {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            value = static_cast<T>(value | static_cast<T>(static_cast<T>(bytes_[i]) << (8 * byteShift(i))));
+        }
+        return value;
+    }
+    constexpr void set(T value) noexcept {
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bytes_[i] = static_cast<uint8_t>(value >> (8 * byteShift(i)));
+        }
+    }
+    constexpr operator T() const noexcept {
+        return get();
+    }
+    constexpr EndianValue& operator=(T value) noexcept {
+        set(value);
+        return *this;
+    }
+
+private:
+    /// Significance (in bytes) of the byte stored at index i.
+    static constexpr size_t byteShift(size_t i) noexcept {
+        return Order == std::endian::big ? sizeof(T) - 1 - i : i;
+    }
+
+    uint8_t bytes_[sizeof(T)]{};
+};
+
+template <typename T>
+using BigEndian = EndianValue<T, std::endian::big>;
+template <typename T>
+using LittleEndian = EndianValue<T, std::endian::little>;
+
+static_assert(sizeof(BigEndian<uint16_t>) == 2 && alignof(BigEndian<uint32_t>) == 1);
+static_assert(BigEndian<uint16_t>(0x1234).get() == 0x1234 && LittleEndian<uint32_t>(0xA1B2C3D4).get() == 0xA1B2C3D4);
+
+/// C1 frame header without a subcode: C1 <size> <head>.
+template <uint8_t Head>
+struct C1Header {
+    static constexpr uint8_t kType = 0xC1;
+    static constexpr uint8_t kHead = Head;
+
+    uint8_t type{kType};
+    uint8_t size{0};
+    uint8_t head{kHead};
+
+    constexpr size_t frameSize() const noexcept {
+        return size;
+    }
+    constexpr void setFrameSize(size_t value) noexcept {
+        size = static_cast<uint8_t>(value);
+    }
+};
+
+/// C1 frame header with a subcode: C1 <size> <head> <sub>.
+template <uint8_t Head, uint8_t Sub>
+struct C1SubHeader {
+    static constexpr uint8_t kType = 0xC1;
+    static constexpr uint8_t kHead = Head;
+    static constexpr uint8_t kSub = Sub;
+
+    uint8_t type{kType};
+    uint8_t size{0};
+    uint8_t head{kHead};
+    uint8_t sub{kSub};
+
+    constexpr size_t frameSize() const noexcept {
+        return size;
+    }
+    constexpr void setFrameSize(size_t value) noexcept {
+        size = static_cast<uint8_t>(value);
+    }
+};
+
+/// C2 frame header: C2 <size hi> <size lo> <head>.
+template <uint8_t Head>
+struct C2Header {
+    static constexpr uint8_t kType = 0xC2;
+    static constexpr uint8_t kHead = Head;
+
+    uint8_t type{kType};
+    BigEndian<uint16_t> size{};
+    uint8_t head{kHead};
+
+    constexpr size_t frameSize() const noexcept {
+        return size;
+    }
+    constexpr void setFrameSize(size_t value) noexcept {
+        size = static_cast<uint16_t>(value);
+    }
+};
+
+/// C2 frame header with a subcode: C2 <size hi> <size lo> <head> <sub>.
+template <uint8_t Head, uint8_t Sub>
+struct C2SubHeader {
+    static constexpr uint8_t kType = 0xC2;
+    static constexpr uint8_t kHead = Head;
+    static constexpr uint8_t kSub = Sub;
+
+    uint8_t type{kType};
+    BigEndian<uint16_t> size{};
+    uint8_t head{kHead};
+    uint8_t sub{kSub};
+
+    constexpr size_t frameSize() const noexcept {
+        return size;
+    }
+    constexpr void setFrameSize(size_t value) noexcept {
+        size = static_cast<uint16_t>(value);
+    }
+};
+
+static_assert(sizeof(C1Header<0>) == 3 && sizeof(C1SubHeader<0, 0>) == 4 && sizeof(C2Header<0>) == 4 &&
+              sizeof(C2SubHeader<0, 0>) == 5);
+
+/**
+ * A packet struct: a `header` member of one of the header templates first,
+ * only byte-aligned fields, and trivially copyable so it can alias wire bytes.
+ */
+template <typename Packet>
+concept WirePacket = std::is_trivially_copyable_v<Packet> && std::is_standard_layout_v<Packet> &&
+                     alignof(Packet) == 1 && offsetof(Packet, header) == 0 && requires(const Packet& packet) {
+                         { packet.header.frameSize() } -> std::same_as<size_t>;
+                         Packet::Header::kType;
+                         Packet::Header::kHead;
+                     };
+
+/// Static traits of a packet struct.
+template <WirePacket Packet>
+struct PacketTraits {
+    static constexpr uint8_t kType = Packet::Header::kType;
+    static constexpr uint8_t kHead = Packet::Header::kHead;
+    /// True when the header carries a sub-code (Header::kSub).
+    static constexpr bool kHasSub = requires { Packet::Header::kSub; };
+    /// Size of the fixed part; variable-length packets append entries after it.
+    static constexpr size_t kSize = sizeof(Packet);
+};
+
+/**
+ * Typed zero-copy view of an incoming frame.
+ * @return nullptr when the frame is shorter than the packet or carries another type or opcode.
+ */
+template <WirePacket Packet>
+const Packet* viewPacket(std::span<const uint8_t> frame) noexcept {
+    using Traits = PacketTraits<Packet>;
+    if (frame.size() < Traits::kSize || frame[0] != Traits::kType) {
+        return nullptr;
+    }
+    const auto* packet = reinterpret_cast<const Packet*>(frame.data());
+    if (packet->header.head != Traits::kHead) {
+        return nullptr;
+    }
+    if constexpr (Traits::kHasSub) {
+        if (packet->header.sub != Packet::Header::kSub) {
+            return nullptr;
+        }
+    }
+    return packet;
+}
+
+/// Outgoing packet with its header filled in; frameSize defaults to the fixed size.
+template <WirePacket Packet>
+constexpr Packet makePacket(size_t frameSize = sizeof(Packet)) noexcept {
+    Packet packet{};
+    packet.header.setFrameSize(frameSize);
+    return packet;
+}
+
+/// Construct a packet in place at the start of out (which must hold sizeof(Packet) bytes).
+template <WirePacket Packet>
+Packet& emplacePacket(std::span<uint8_t> out, size_t frameSize = sizeof(Packet)) noexcept {
+    auto* packet = ::new (static_cast<void*>(out.data())) Packet{};
+    packet->header.setFrameSize(frameSize);
+    return *packet;
+}
+
+/// Wire bytes of a packet struct.
+template <typename Packet>
+    requires std::is_trivially_copyable_v<Packet> && (alignof(Packet) == 1)
+std::span<const uint8_t> packetBytes(const Packet& packet) noexcept {
+    return {reinterpret_cast<const uint8_t*>(&packet), sizeof(Packet)};
+}
+
+#endif // DARKEMU_PACKETLAYOUT_H
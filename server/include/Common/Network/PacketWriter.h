@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) DarkEmu
+ * Response builders with inline storage and pooled spill buffers.
+ */
+
+#ifndef DARKEMU_PACKETWRITER_H
+#define DARKEMU_PACKETWRITER_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Common/Network/PacketLayout.h"
+
+/**
+ * Per-thread free list of spill buffers for PacketWriter.
+ * Buffers keep their capacity, so a steady stream of large replies stops allocating.
+ */
+class PacketBufferPool {
+public:
+    /// Buffer with at least capacity bytes reserved (size 0).
+    static std::vector<uint8_t> acquire(size_t capacity);
+    /// Return a buffer to the calling thread's free list (dropped when the list is full).
+    static void release(std::vector<uint8_t>&& buffer) noexcept;
+    /// Buffers currently pooled on the calling thread.
+    static size_t pooled() noexcept;
+};
+
+/**
+ * Builds one C1/C2 frame. Storage comes from the derived PacketWriter<N>;
+ * writes past it move the frame into a pooled buffer. finish() patches the
+ * size field and returns the wire bytes.
+ */
+class PacketWriterBase {
+public:
+    PacketWriterBase(const PacketWriterBase&) = delete;
+    PacketWriterBase& operator=(const PacketWriterBase&) = delete;
+
+    /// Start a frame with a raw header: type (C1 or C2), size placeholder and head code.
+    void begin(uint8_t type, uint8_t head) {
+        size_ = 0;
+        writeU8(type);
+        if (type == 0xC2) {
+            writeU8(0);
+        }
+        writeU8(0);
+        writeU8(head);
+    }
+
+    /**
+     * Start a frame with a packet struct's fixed part, constructed in place.
+     * The reference is valid until the next write.
+     */
+    template <WirePacket Packet>
+    Packet& begin() {
+        size_ = 0;
+        return *::new (static_cast<void*>(grow(sizeof(Packet)))) Packet{};
+    }
+
+    void writeU8(uint8_t value) {
+        *grow(1) = value;
+    }
+    void writeU16LE(uint16_t value) {
+        writeStruct(LittleEndian<uint16_t>(value));
+    }
+    void writeU16BE(uint16_t value) {
+        writeStruct(BigEndian<uint16_t>(value));
+    }
+    void writeU32LE(uint32_t value) {
+        writeStruct(LittleEndian<uint32_t>(value));
+    }
+    void writeU32BE(uint32_t value) {
+        writeStruct(BigEndian<uint32_t>(value));
+    }
+    void writeBytes(std::span<const uint8_t> bytes) {
+        if (!bytes.empty()) {
+            std::memcpy(grow(bytes.size()), bytes.data(), bytes.size());
+        }
+    }
+    /// Write text truncated to width - 1 bytes and NUL-padded to width.
+    void writeString(std::string_view text, size_t width) {
+        uint8_t* out = grow(width);
+        const size_t copied = width == 0 ? 0 : std::min(text.size(), width - 1);
+        std::memcpy(out, text.data(), copied);
+        std::memset(out + copied, 0, width - copied);
+    }
+    /// Append the bytes of a byte-aligned trivially copyable struct (entries, endian fields).
+    template <typename T>
+        requires std::is_trivially_copyable_v<T> && (alignof(T) == 1)
+    void writeStruct(const T& value) {
+        std::memcpy(grow(sizeof(T)), &value, sizeof(T));
+    }
+
+    /**
+     * Patch the size field and return the frame.
+     * Throws std::length_error when the frame does not fit its size field.
+     */
+    std::span<const uint8_t> finish();
+
+    size_t size() const noexcept {
+        return size_;
+    }
+    /// True once the frame has outgrown the inline storage.
+    bool spilled() const noexcept {
+        return data_ != inline_data_;
+    }
+
+protected:
+    PacketWriterBase(uint8_t* storage, size_t capacity) noexcept :
+        data_(storage), inline_data_(storage), capacity_(capacity) {}
+    ~PacketWriterBase();
+
+private:
+    /// Reserve count bytes at the end of the frame and return where they start.
+    uint8_t* grow(size_t count) {
+        if (size_ + count > capacity_) {
+            spill(size_ + count);
+        }
+        uint8_t* out = data_ + size_;
+        size_ += count;
+        return out;
+    }
+    /// Move the frame into a pooled buffer with room for needed bytes.
+    void spill(size_t needed);
+
+    uint8_t* data_;
+    uint8_t* inline_data_;
+    size_t size_{0};
+    size_t capacity_;
+    std::vector<uint8_t> spill_;
+};
+
+/// PacketWriter with N bytes of inline (stack) storage.
+template <size_t N>
+class PacketWriter : public PacketWriterBase {
+public:
+    PacketWriter() noexcept : PacketWriterBase(storage_.data(), N) {}
+
+private:
+    std::array<uint8_t, N> storage_;
+};
+
+#endif // DARKEMU_PACKETWRITER_H
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) DarkEmu
+ * Protocol-version policies: opcodes, field widths and frame codes per client build.
+ */
+
+#ifndef DARKEMU_PROTOCOLVERSION_H
+#define DARKEMU_PROTOCOLVERSION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Common/Network/PacketFramer.h"
+
+/// Client builds a listener can serve; each listener picks one at startup.
+enum class ProtocolVersion : uint8_t {
+    Season6, ///< Season 6 Episode 3, client 1.04.04.
+    Season9, ///< Season 9, client 1.05.25.
+};
+
+/**
+ * Season 6 Episode 3 policy, the protocol the servers were written against.
+ * Policies only hold constants and types; packet layouts, framers and dispatch
+ * tables are templates instantiated once per policy.
+ */
+struct Season6Protocol {
+    static constexpr ProtocolVersion kVersion = ProtocolVersion::Season6;
+    static constexpr std::string_view kName = "season6";
+    using Frames = StandardFrameCodes;
+
+    // ConnectServer: F4 06 server list, F4 03 server address.
+    static constexpr uint8_t kConnectHead = 0xF4;
+    static constexpr uint8_t kServerListSub = 0x06;
+    static constexpr uint8_t kServerInfoSub = 0x03;
+
+    // GameServer: F1 00 join result, F1 01 login, F3 character screen, walk.
+    static constexpr uint8_t kAccountHead = 0xF1;
+    static constexpr uint8_t kCharacterHead = 0xF3;
+    static constexpr uint8_t kWalkHead = 0xD4;
+    // GameServer: 02 whisper, 0C whisper failed, 1C teleport, 40 party request, 8E 02 warp.
+    static constexpr uint8_t kWhisperHead = 0x02;
+    static constexpr uint8_t kWhisperFailedHead = 0x0C;
+    static constexpr uint8_t kTeleportHead = 0x1C;
+    static constexpr uint8_t kPartyHead = 0x40;
+    static constexpr uint8_t kWarpHead = 0x8E;
+    static constexpr uint8_t kWarpSub = 0x02;
+    // GameServer: 12 players entering the viewport, 14 objects leaving it.
+    static constexpr uint8_t kViewportCreateHead = 0x12;
+    static constexpr uint8_t kViewportDestroyHead = 0x14;
+    static constexpr size_t kAccountLength = 10;
+    static constexpr size_t kPasswordLength = 10;
+    /// Version bytes in the join result; the client refuses a build mismatch.
+    static constexpr std::array<uint8_t, 5> kClientVersion{'1', '0', '4', '0', '4'};
+};
+
+/// Season 9 policy: walk moves to D7 and the login password widens to 20 bytes.
+struct Season9Protocol : Season6Protocol {
+    static constexpr ProtocolVersion kVersion = ProtocolVersion::Season9;
+    static constexpr std::string_view kName = "season9";
+
+    static constexpr uint8_t kWalkHead = 0xD7;
+    static constexpr size_t kPasswordLength = 20;
+    static constexpr std::array<uint8_t, 5> kClientVersion{'1', '0', '5', '2', '5'};
+};
+
+/// Configuration name of a protocol version ("season6", "season9").
+std::string_view protocolName(ProtocolVersion version) noexcept;
+
+/// Parse a configured protocol name; throws std::invalid_argument for unknown names.
+ProtocolVersion parseProtocolVersion(std::string_view name);
+
+/**
+ * Call fn with a value of the policy type for version and return its result.
+ * Listeners call this once at startup to pick their template instantiations,
+ * so the packet path never branches on the protocol version.
+ */
+template <typename Fn>
+decltype(auto) withProtocol(ProtocolVersion version, Fn&& fn) {
+    switch (version) {
+    case ProtocolVersion::Season9:
+        return fn(Season9Protocol{});
+    case ProtocolVersion::Season6:
+    default:
+        return fn(Season6Protocol{});
+    }
+}
+
+#endif // DARKEMU_PROTOCOLVERSION_H
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) DarkEmu
+ * Capture of client sessions (timestamps plus raw frames) for replay.
+ */
+
+#ifndef DARKEMU_SESSIONRECORDER_H
+#define DARKEMU_SESSIONRECORDER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+/// Kind of a capture record.
+enum class CaptureRecordType : uint8_t {
+    Open = 1,       ///< Client connected.
+    ClientData = 2, ///< One complete frame received from the client.
+    ServerData = 3, ///< Bytes the server sent on its own (e.g. the join result).
+    Close = 4,      ///< Connection closed by either side.
+};
+
+/// One decoded capture record.
+struct CaptureRecord {
+    CaptureRecordType type{CaptureRecordType::Open};
+    uint32_t session{0};          ///< Capture-local session id (not the fd).
+    uint64_t timestamp_us{0};     ///< Microseconds since the capture started.
+    std::vector<uint8_t> payload; ///< Frame bytes for data records, empty otherwise.
+};
+
+/**
+ * Appends session events to a binary capture file from the reactor thread.
+ *
+ * Layout: the 8-byte magic "DEMUCAP1", then records of
+ * type (u8), session (u32), timestamp_us (u64), length (u32) and payload,
+ * all little-endian. Records are buffered: the owning loop calls
+ * flushIfDue() once per wake-up, which writes them out at most every
+ * kFlushInterval, and the destructor flushes the rest. A killed server loses
+ * about the last interval; readers ignore a truncated final record.
+ * Recording calls may come from several reactor threads; records are
+ * serialized by an internal mutex.
+ */
+class SessionRecorder {
+public:
+    /// File magic and format version.
+    static constexpr std::array<char, 8> kMagic{'D', 'E', 'M', 'U', 'C', 'A', 'P', '1'};
+    /// Longest time a record stays buffered while the owning loop keeps waking up.
+    static constexpr std::chrono::milliseconds kFlushInterval{1000};
+
+    /// Create (truncate) the capture file; throws std::runtime_error on failure.
+    explicit SessionRecorder(const std::string& path);
+    /// Flush buffered records.
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    /// Start a session and return its capture id.
+    uint32_t open();
+    /// Record one complete client frame.
+    void clientData(uint32_t session, std::span<const uint8_t> frame);
+    /// Record bytes sent by the server.
+    void serverData(uint32_t session, std::span<const uint8_t> data);
+    /// End a session.
+    void close(uint32_t session);
+    /// Flush buffered records when kFlushInterval has passed since the last flush.
+    void flushIfDue();
+
+    /// Records written so far.
+    uint64_t records() const noexcept {
+        return records_;
+    }
+
+    /**
+     * Read every complete record of a capture file.
+     * @return false when the file cannot be opened or has the wrong magic.
+     */
+    static bool Load(const std::string& path, std::vector<CaptureRecord>& records);
+
+private:
+    /// Append one record to the buffered stream (caller holds mutex_).
+    void write(CaptureRecordType type, uint32_t session, std::span<const uint8_t> payload);
+
+    std::mutex mutex_; ///< Guards the stream and counters below.
+    std::ofstream out_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_flush_;
+    bool dirty_{false}; ///< Records written since the last flush.
+    uint32_t next_session_{1};
+    uint64_t records_{0};
+};
+
+#endif // DARKEMU_SESSIONRECORDER_H
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) DarkEmu
+ * Reference-counted immutable frames for packets fanned out to many connections.
+ */
+
+#ifndef DARKEMU_SHAREDFRAME_H
+#define DARKEMU_SHAREDFRAME_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * One frame written once and referenced by any number of outbound queues.
+ *
+ * The bytes live in a single allocation next to an atomic reference count, so
+ * a handle is one pointer: copying it costs an increment, and the last handle
+ * to go frees the block on whichever thread drops it. The bytes never change
+ * after copyOf(), which is what lets reactors on different threads send them
+ * concurrently.
+ *
+ * Only plain C1/C2 frames can be shared. C3/C4 frames are encrypted with the
+ * serial of one connection, so they differ per recipient and must be sent per
+ * connection instead; copyOf() throws std::invalid_argument for them.
+ */
+class SharedFrame {
+public:
+    /// Empty handle.
+    SharedFrame() noexcept = default;
+    /// Copy a complete C1/C2 frame into a new shared block.
+    static SharedFrame copyOf(std::span<const uint8_t> frame);
+
+    SharedFrame(const SharedFrame& other) noexcept;
+    SharedFrame& operator=(const SharedFrame& other) noexcept;
+    SharedFrame(SharedFrame&& other) noexcept : block_(other.block_) {
+        other.block_ = nullptr;
+    }
+    SharedFrame& operator=(SharedFrame&& other) noexcept;
+    ~SharedFrame();
+
+    /// The frame bytes (empty for an empty handle).
+    std::span<const uint8_t> bytes() const noexcept;
+    /// Handles referencing the block (0 for an empty handle).
+    uint32_t useCount() const noexcept;
+    /// Drop the reference.
+    void reset() noexcept;
+    explicit operator bool() const noexcept {
+        return block_ != nullptr;
+    }
+
+private:
+    struct Block {
+        std::atomic<uint32_t> refs;
+        uint32_t size;
+    };
+
+    explicit SharedFrame(Block* block) noexcept : block_(block) {}
+
+    Block* block_{nullptr};
+};
+
+#endif // DARKEMU_SHAREDFRAME_H
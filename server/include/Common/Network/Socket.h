@@ -10,6 +10,7 @@
 #include <span>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 /**
  * Lightweight RAII wrapper for a TCP socket file descriptor.
@@ -62,6 +63,8 @@ public:
     ssize_t recv(std::span<uint8_t> buffer, int flags = 0);
     /// Send data from the provided buffer.
     ssize_t send(std::span<const uint8_t> buffer, int flags = 0);
+    /// Send several buffers in order with one call (writev semantics, but with send flags).
+    ssize_t sendv(std::span<const iovec> buffers, int flags = 0);
 
 private:
     /// Owned file descriptor, -1 means invalid.
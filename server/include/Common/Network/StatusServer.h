@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) DarkEmu
+ * Minimal HTTP/1.0 status endpoint served from a server's epoll loop.
+ */
+
+#ifndef DARKEMU_STATUSSERVER_H
+#define DARKEMU_STATUSSERVER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "Common/Network/EpollContext.h"
+#include "Common/Network/Socket.h"
+
+/**
+ * Plain-text metrics endpoint (GET /metrics) on a dedicated port.
+ * GET /trace/start?seconds=N opens a span tracing window and GET /trace
+ * returns the last completed window as Chrome trace-event JSON.
+ * Sockets are registered on the owning server's EpollContext, so no extra
+ * reactor thread is needed. A background thread renders the registry into a
+ * shared snapshot; the reactor only copies a pointer and writes bytes, which
+ * keeps scrapes off the packet critical path.
+ */
+class StatusServer {
+public:
+    /**
+     * Bind the status port and register it with the given epoll instance.
+     * @param epoll Reactor that will deliver events for the status sockets.
+     * @param port TCP port to listen on (0 selects an ephemeral port).
+     * @param interval Time between background snapshot renders.
+     */
+    StatusServer(EpollContext& epoll, uint16_t port,
+                 std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    /// Stop the render thread and unregister all sockets.
+    ~StatusServer();
+
+    StatusServer(const StatusServer&) = delete;
+    StatusServer& operator=(const StatusServer&) = delete;
+
+    /// Return the actual bound port.
+    uint16_t port() const noexcept;
+    /// Check whether the descriptor belongs to this endpoint.
+    bool owns(int fd) const noexcept;
+    /// Handle an epoll event for a descriptor owned by this endpoint.
+    void handleEvent(int fd, uint32_t events);
+    /// Render a fresh snapshot immediately (used by tests and on startup).
+    void refresh();
+
+private:
+    /// Per-connection HTTP state.
+    struct ClientState {
+        Socket socket;                                ///< Owned client socket.
+        std::string request;                          ///< Accumulated request bytes.
+        std::string header;                           ///< Response status line and headers.
+        std::shared_ptr<const std::string> body;      ///< Snapshot being served.
+        size_t sent{0};                               ///< Bytes of header+body already written.
+    };
+
+    /// Accept all pending status connections.
+    void handleAccept();
+    /// Read the request and start the response once the header is complete.
+    void handleRead(int fd);
+    /// Write pending response bytes; closes the client when done.
+    void handleWrite(int fd);
+    /// Remove a client from the epoll set and internal map.
+    void closeClient(int fd);
+    /// Background loop that re-renders the snapshot every refresh interval.
+    void renderLoop();
+
+    EpollContext& epoll_;
+    Socket listen_socket_;
+    std::unordered_map<int, ClientState> clients_;
+    uint16_t port_{0};
+
+    std::chrono::milliseconds refresh_;
+    std::mutex snapshot_mutex_;
+    std::shared_ptr<const std::string> snapshot_;
+    std::shared_ptr<const std::string> trace_snapshot_;
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stopping_{false};
+    std::thread render_thread_;
+};
+
+#endif // DARKEMU_STATUSSERVER_H
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) DarkEmu
+ * Thread-local free lists for coroutine frames.
+ */
+
+#ifndef DARKEMU_FRAMEPOOL_H
+#define DARKEMU_FRAMEPOOL_H
+
+#include <cstddef>
+
+/**
+ * Size-class allocator for coroutine frames. Each thread keeps one free list
+ * per 64-byte class up to kMaxPooled bytes, so once a flow has run, starting
+ * it again reuses the same blocks without touching the heap. Blocks may be
+ * freed on another thread than the one that allocated them; they simply join
+ * that thread's lists. Larger frames go straight to operator new.
+ */
+class FramePool {
+public:
+    /// Class granularity in bytes.
+    static constexpr size_t kGranule = 64;
+    /// Largest frame served from the free lists.
+    static constexpr size_t kMaxPooled = 2048;
+    /// Blocks kept per class and thread; extra frees go back to the heap.
+    static constexpr size_t kMaxCachedPerClass = 1024;
+
+    /// Allocate a block of at least size bytes.
+    static void* allocate(size_t size);
+    /// Return a block obtained from allocate(size).
+    static void deallocate(void* block, size_t size) noexcept;
+    /// Blocks cached on the calling thread (for tests).
+    static size_t cachedBlocks() noexcept;
+};
+
+#endif // DARKEMU_FRAMEPOOL_H
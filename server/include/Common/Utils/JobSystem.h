@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) DarkEmu
+ * Work-stealing job system for parallel per-tick workloads.
+ */
+
+#ifndef DARKEMU_JOBSYSTEM_H
+#define DARKEMU_JOBSYSTEM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * One unit of work: a function, an inline payload and a count of unfinished
+ * work (itself plus its children). A job is done when the count reaches zero;
+ * finishing a child counts down its parent, which is how fork/join works.
+ * Jobs are 64 bytes, one cache line, so neighbours in a pool never false-share.
+ */
+struct alignas(64) Job {
+    /// Bytes of inline payload (the captured state of a lambda).
+    static constexpr size_t kPayloadSize = 40;
+
+    void (*function)(Job&){nullptr};
+    Job* parent{nullptr};
+    std::atomic<int32_t> unfinished{1};
+    std::atomic<uint32_t> generation{0}; ///< Bumped when a pool slot is reused, so wait() notices.
+    alignas(8) unsigned char payload[kPayloadSize];
+};
+
+static_assert(sizeof(Job) == 64);
+
+/**
+ * Bounded Chase-Lev work-stealing deque of jobs. The owning thread pushes and
+ * pops at the bottom (LIFO, so it works depth-first on hot data); any other
+ * thread steals from the top, taking the oldest and usually largest piece.
+ */
+class WorkStealingQueue {
+public:
+    /// Create a deque with room for capacity jobs (rounded up to a power of two).
+    explicit WorkStealingQueue(size_t capacity);
+
+    /// Owner: add a job; false when the deque is full.
+    bool push(Job* job) noexcept;
+    /// Owner: take the newest job, or nullptr when empty (or a thief won the last one).
+    Job* pop() noexcept;
+    /// Any thread: take the oldest job, or nullptr when empty or another thread got there first.
+    Job* steal() noexcept;
+
+private:
+    std::unique_ptr<std::atomic<Job*>[]> slots_;
+    int64_t mask_;
+    alignas(64) std::atomic<int64_t> top_{0};    ///< Next job to steal.
+    alignas(64) std::atomic<int64_t> bottom_{0}; ///< Next free slot (owner only writes it).
+};
+
+/**
+ * Fork/join scheduler: a fixed set of worker threads, one work-stealing deque
+ * and one job pool per thread. The thread that submits work (typically a
+ * simulation tick) takes part while it waits, so waiting never idles a core.
+ *
+ * Jobs come from a per-thread ring of preallocated jobs: creating one is a
+ * bump of a thread-local index, with no allocation and no shared atomics.
+ * Job payloads must be trivially copyable (lambdas capturing pointers,
+ * references and integers), since jobs are never destroyed, only reused.
+ *
+ * Only one non-worker thread may submit work to a JobSystem at a time; give
+ * each shard its own instance.
+ */
+class JobSystem {
+public:
+    /// Start workers threads (0 runs everything on the submitting thread).
+    explicit JobSystem(size_t workers = defaultWorkerCount());
+    /// Stop and join the workers; pending jobs are not run.
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /// Worker threads to use by default: one per hardware thread, minus the submitting thread.
+    static size_t defaultWorkerCount() noexcept;
+
+    /// Number of worker threads (excluding the submitting thread).
+    size_t workerCount() const noexcept;
+
+    /// Create a job running fn() with no parent; submit it with run().
+    template <typename Fn>
+    Job* create(Fn&& fn) {
+        return emplace(nullptr, std::forward<Fn>(fn));
+    }
+    /// Create a job running fn() that parent waits for; create children before running the parent.
+    template <typename Fn>
+    Job* createChild(Job* parent, Fn&& fn) {
+        parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+        return emplace(parent, std::forward<Fn>(fn));
+    }
+    /// Queue a job on the calling thread's deque (or run it now when the deque is full).
+    void run(Job* job);
+    /// Run jobs (own first, then stolen ones) until job and all its children have finished.
+    void wait(const Job* job);
+
+    /**
+     * Call fn(first, last) over [begin, end) in pieces of at most grain items
+     * and return when all pieces are done. Ranges are split lazily: each job
+     * peels off its upper halves for thieves and keeps the lower part, so idle
+     * threads steal large chunks and the split cost only grows with contention.
+     */
+    template <typename Fn>
+    void parallelFor(size_t begin, size_t end, size_t grain, const Fn& fn);
+
+private:
+    /// Per-thread state: the deque others steal from and the ring jobs are created from.
+    struct alignas(64) Worker {
+        explicit Worker(size_t capacity);
+
+        WorkStealingQueue queue;
+        std::unique_ptr<Job[]> pool;
+        size_t next{0};          ///< Next pool slot to try.
+        uint64_t victim_seed{0}; ///< State of the victim picker.
+    };
+
+    /// parallelFor state shared by all pieces, on the caller's stack.
+    template <typename Fn>
+    struct RangeState {
+        JobSystem* system;
+        const Fn* fn;
+        size_t grain;
+        Job* root;
+    };
+    /// Payload of one parallelFor piece.
+    template <typename Fn>
+    struct RangePiece {
+        const RangeState<Fn>* state;
+        size_t begin;
+        size_t end;
+        void operator()() const;
+    };
+
+    template <typename Fn>
+    Job* emplace(Job* parent, Fn&& fn) {
+        using Callable = std::decay_t<Fn>;
+        static_assert(std::is_trivially_copyable_v<Callable> && sizeof(Callable) <= Job::kPayloadSize &&
+                              alignof(Callable) <= 8,
+                      "job payloads must be trivially copyable and fit in Job::kPayloadSize");
+        Job* job = allocate();
+        job->generation.fetch_add(1, std::memory_order_relaxed);
+        job->function = [](Job& self) {
+            (*std::launder(reinterpret_cast<Callable*>(self.payload)))();
+        };
+        job->parent = parent;
+        job->unfinished.store(1, std::memory_order_relaxed);
+        ::new (static_cast<void*>(job->payload)) Callable(std::forward<Fn>(fn));
+        return job;
+    }
+
+    /// Worker state of the calling thread (slot 0 for the submitting thread).
+    Worker& current() noexcept;
+    /// Next free job from the calling thread's ring.
+    Job* allocate();
+    /// Own newest job, else one stolen from another thread, else nullptr.
+    Job* findJob(Worker& self);
+    /// Run a job and count it (and possibly its ancestors) down.
+    static void execute(Job* job);
+    /// Count down a job; the last one out counts down the parent.
+    static void finish(Job* job);
+    /// Worker thread body.
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_; ///< Slot 0: the submitting thread; 1..n: worker threads.
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{true};
+    std::atomic<uint32_t> wake_epoch_{0}; ///< Bumped to wake sleeping workers.
+    std::atomic<uint32_t> sleepers_{0};   ///< Workers parked on wake_epoch_.
+};
+
+template <typename Fn>
+void JobSystem::RangePiece<Fn>::operator()() const {
+    JobSystem& system = *state->system;
+    size_t last = end;
+    // Hand the upper halves to the deque (where thieves find them) and keep the lower part.
+    while (last - begin > state->grain) {
+        const size_t mid = begin + (last - begin) / 2;
+        system.run(system.createChild(state->root, RangePiece{state, mid, last}));
+        last = mid;
+    }
+    (*state->fn)(begin, last);
+}
+
+template <typename Fn>
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grain, const Fn& fn) {
+    if (begin >= end) {
+        return;
+    }
+    // The root lives on this stack, so it outlives any amount of job-ring reuse during the wait.
+    Job root;
+    const RangeState<Fn> state{this, &fn, grain == 0 ? 1 : grain, &root};
+    RangePiece<Fn>{&state, begin, end}();
+    finish(&root);
+    wait(&root);
+}
+
+#endif // DARKEMU_JOBSYSTEM_H
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) DarkEmu
+ * Lock-free counters, gauges and histograms with Prometheus text rendering.
+ */
+
+#ifndef DARKEMU_METRICS_H
+#define DARKEMU_METRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Monotonic counter updated from the reactor thread.
+ * Increments are relaxed atomics so other threads can read without locks.
+ */
+class Counter {
+public:
+    /// Add n to the counter.
+    void inc(uint64_t n = 1) noexcept {
+        value_.fetch_add(n, std::memory_order_relaxed);
+    }
+    /// Read the current value.
+    uint64_t value() const noexcept {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * Gauge that can move up and down (connection counts, queue depths).
+ */
+class Gauge {
+public:
+    /// Overwrite the gauge value.
+    void set(int64_t value) noexcept {
+        value_.store(value, std::memory_order_relaxed);
+    }
+    /// Add a signed delta to the gauge.
+    void add(int64_t delta) noexcept {
+        value_.fetch_add(delta, std::memory_order_relaxed);
+    }
+    /// Read the current value.
+    int64_t value() const noexcept {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * Histogram with power-of-two bucket boundaries.
+ * Observations are raw integers (typically microseconds or counts); the bucket
+ * index is a single bit_width() so recording stays branch-free on the hot path.
+ */
+class Histogram {
+public:
+    /// Number of finite buckets; values >= 2^(kBuckets-1) land in +Inf.
+    static constexpr size_t kBuckets = 24;
+
+    /// Create a histogram whose rendered boundaries are multiplied by scale.
+    explicit Histogram(double scale = 1.0) noexcept : scale_(scale) {}
+
+    /// Record one observation.
+    void observe(uint64_t value) noexcept {
+        const size_t index = std::min<size_t>(static_cast<size_t>(std::bit_width(value)), kBuckets);
+        buckets_[index].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /// Upper bound (inclusive, unscaled) of the bucket at index.
+    static constexpr uint64_t upperBound(size_t index) noexcept {
+        return index == 0 ? 0 : (uint64_t{1} << index) - 1;
+    }
+
+    /// Observation count in a single (non-cumulative) bucket; index kBuckets is +Inf.
+    uint64_t bucket(size_t index) const noexcept {
+        return buckets_[index].load(std::memory_order_relaxed);
+    }
+    /// Total number of observations.
+    uint64_t count() const noexcept;
+    /// Sum of all observed values (unscaled).
+    uint64_t sum() const noexcept {
+        return sum_.load(std::memory_order_relaxed);
+    }
+    /// Approximate quantile (0..1) using bucket upper bounds (unscaled).
+    uint64_t quantile(double q) const noexcept;
+    /// Scale factor applied when rendering boundaries and sum.
+    double scale() const noexcept {
+        return scale_;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets + 1> buckets_{};
+    std::atomic<uint64_t> sum_{0};
+    double scale_{1.0};
+};
+
+/**
+ * Process-wide metric registry.
+ * Registration is mutex-protected and returns stable references; recording
+ * never touches the registry. Rendering is intended for a background thread.
+ */
+class MetricsRegistry {
+public:
+    /// Access the global registry instance.
+    static MetricsRegistry* Instance();
+
+    /// Register (or look up) a counter by name.
+    Counter& counter(const std::string& name, const std::string& help);
+    /// Register (or look up) a gauge by name.
+    Gauge& gauge(const std::string& name, const std::string& help);
+    /// Register a gauge whose value is sampled at render time.
+    void gaugeFunction(const std::string& name, const std::string& help, std::function<double()> sample);
+    /// Register (or look up) a histogram by name; scale converts raw units for output.
+    Histogram& histogram(const std::string& name, const std::string& help, double scale = 1.0);
+
+    /// Render every metric in the Prometheus text exposition format.
+    std::string render() const;
+
+private:
+    MetricsRegistry() = default;
+
+    enum class Kind { Counter, Gauge, GaugeFunction, Histogram };
+
+    /// Registered metric with owned storage.
+    struct Entry {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> sample;
+    };
+
+    /// Find an entry by name (caller holds mutex_).
+    Entry* find(const std::string& name);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+#endif // DARKEMU_METRICS_H
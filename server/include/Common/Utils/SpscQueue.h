@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) DarkEmu
+ * Bounded lock-free single-producer single-consumer ring buffer.
+ */
+
+#ifndef DARKEMU_SPSCQUEUE_H
+#define DARKEMU_SPSCQUEUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Fixed-capacity ring buffer for exactly one producer thread and one consumer
+ * thread. Slots are constructed once and reused: the producer fills the slot
+ * returned by prepare() in place and publishes it with commit(), so element
+ * types that own buffers (e.g. a std::vector payload) keep their capacity and
+ * a warm queue never allocates. Each side caches the other side's index and
+ * only reloads it when the queue looks full or empty.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /// Create a queue with room for at least capacity elements (rounded up to a power of two).
+    explicit SpscQueue(size_t capacity) :
+        slots_(std::bit_ceil(capacity < 2 ? size_t{2} : capacity)), mask_(slots_.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /// Producer: slot to fill for the next element, or nullptr when the queue is full.
+    T* prepare() noexcept {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) {
+                return nullptr;
+            }
+        }
+        return &slots_[tail & mask_];
+    }
+    /// Producer: publish the slot returned by the last successful prepare().
+    void commit() noexcept {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    /// Producer: move value into the queue; false (value untouched) when full.
+    bool tryPush(T&& value) {
+        T* slot = prepare();
+        if (slot == nullptr) {
+            return false;
+        }
+        *slot = std::move(value);
+        commit();
+        return true;
+    }
+
+    /// Consumer: oldest element, or nullptr when the queue is empty.
+    T* front() noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+    /// Consumer: release the element returned by front() back to the producer.
+    void pop() noexcept {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    /// Consumer: move the oldest element out; false when the queue is empty.
+    bool tryPop(T& out) {
+        T* slot = front();
+        if (slot == nullptr) {
+            return false;
+        }
+        out = std::move(*slot);
+        pop();
+        return true;
+    }
+
+    /// Elements currently queued; exact only when neither side is running.
+    size_t sizeApprox() const noexcept {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    /// Maximum number of queued elements.
+    size_t capacity() const noexcept {
+        return slots_.size();
+    }
+
+private:
+    // Producer and consumer indices live on separate cache lines so the two threads do not false-share.
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(kCacheLine) std::atomic<size_t> head_{0}; ///< Next slot to consume (written by the consumer).
+    size_t cached_tail_{0};                           ///< Consumer's last view of tail_.
+    alignas(kCacheLine) std::atomic<size_t> tail_{0}; ///< Next slot to fill (written by the producer).
+    size_t cached_head_{0};                           ///< Producer's last view of head_.
+};
+
+#endif // DARKEMU_SPSCQUEUE_H
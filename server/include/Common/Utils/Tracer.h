@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) DarkEmu
+ * Low-overhead span tracer with Chrome/Perfetto trace-event export.
+ */
+
+#ifndef DARKEMU_TRACER_H
+#define DARKEMU_TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Process-wide span tracer.
+ * Each thread appends complete spans to its own fixed-size buffer, so
+ * recording never takes a lock. Tracing is switched on for a bounded window
+ * (start(duration)); while it is off a span costs one relaxed load and a
+ * predictable branch. The collected spans are written as Chrome trace-event
+ * JSON, which chrome://tracing and ui.perfetto.dev open directly.
+ */
+class Tracer {
+public:
+    /// Spans kept per thread per tracing window; later spans are counted as dropped.
+    static constexpr size_t kEventsPerThread = 1 << 16;
+
+    /// Access the global tracer.
+    static Tracer* Instance();
+
+    /// Fast check used by TraceSpan; false unless a tracing window is open.
+    static bool enabled() noexcept {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /// Open a tracing window; spans from previous windows are discarded.
+    void start(std::chrono::milliseconds duration);
+    /// Close the tracing window early.
+    void stop() noexcept;
+    /// True once an open window has passed its deadline (checked off the hot path).
+    bool expired() const noexcept;
+    /// Name the calling thread in exported traces.
+    void setThreadName(std::string name);
+
+    /// Record one complete span on the calling thread's buffer.
+    void record(const char* name, int64_t startNs, int64_t endNs, int64_t arg) noexcept;
+
+    /// Write the current window's spans as Chrome trace-event JSON.
+    void writeChromeJson(std::ostream& out) const;
+    /// Spans that did not fit into a thread buffer during the current window.
+    uint64_t dropped() const noexcept;
+
+    /// Monotonic timestamp in nanoseconds used for span boundaries.
+    static int64_t nowNs() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    Tracer() = default;
+
+    /// One complete ("X") span.
+    struct Event {
+        const char* name;
+        int64_t start_ns;
+        int64_t end_ns;
+        int64_t arg;
+    };
+
+    /// Single-writer span buffer owned by one thread.
+    struct ThreadBuffer {
+        int tid{0};
+        std::string name;
+        std::atomic<uint64_t> generation{0}; ///< Window the buffer holds; published after count and dropped reset.
+        std::vector<Event> events;
+        std::atomic<size_t> count{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    /// Return (and lazily register) the calling thread's buffer.
+    ThreadBuffer& localBuffer();
+
+    static inline std::atomic<bool> enabled_{false};
+
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<int64_t> window_start_ns_{0};
+    std::atomic<int64_t> deadline_ns_{0};
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+/**
+ * RAII span: records [construction, destruction) when tracing is enabled.
+ */
+class TraceSpan {
+public:
+    /// Begin a span; name must point to a string literal.
+    explicit TraceSpan(const char* name, int64_t arg = -1) noexcept : name_(name), arg_(arg) {
+        if (Tracer::enabled()) [[unlikely]] {
+            start_ns_ = Tracer::nowNs();
+        }
+    }
+    ~TraceSpan() {
+        if (start_ns_ != 0) [[unlikely]] {
+            Tracer::Instance()->record(name_, start_ns_, Tracer::nowNs(), arg_);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    int64_t arg_;
+    int64_t start_ns_{0};
+};
+
+#define DARKEMU_TRACE_CONCAT_INNER(a, b) a##b
+#define DARKEMU_TRACE_CONCAT(a, b) DARKEMU_TRACE_CONCAT_INNER(a, b)
+/// Trace the rest of the enclosing scope under the given span name.
+#define DARKEMU_TRACE_SPAN(...) TraceSpan DARKEMU_TRACE_CONCAT(trace_span_, __LINE__)(__VA_ARGS__)
+
+#endif // DARKEMU_TRACER_H
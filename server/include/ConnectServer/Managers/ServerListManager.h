@@ -6,10 +6,14 @@
 #ifndef DARKEMU_SERVERLISTMANAGER_H
 #define DARKEMU_SERVERLISTMANAGER_H
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include "Common/Network/PacketWriter.h"
+#include "Common/Network/ProtocolVersion.h"
+
 // Runtime metadata for a single game server entry.
 struct GameServerInfo {
     uint16_t ServerCode;  ///< Internal server identifier used in the protocol.
@@ -38,8 +42,13 @@ public:
     void AddServer(uint16_t code, std::string name, std::string ip, uint16_t port, bool visible);
     /// Serialize the current server list into a packet buffer.
     void GetPacket(std::vector<uint8_t>& buffer) const;
+    /// Build the server list packet of a protocol in a writer (call finish() to get the frame).
+    template <typename Protocol = Season6Protocol>
+    void WritePacket(PacketWriterBase& writer) const;
     /// Find a server entry by its server code.
     const GameServerInfo* FindByCode(uint16_t serverCode) const;
+    /// Snapshot version, bumped every time the list contents change.
+    uint64_t Version() const noexcept;
 
 private:
     /// Prevent external construction; use Instance() instead.
@@ -47,6 +56,8 @@ private:
 
     /// In-memory list of servers that will be serialized.
     std::vector<GameServerInfo> servers_;
+    /// Incremented on every load or manual add (read by the metrics renderer).
+    std::atomic<uint64_t> version_{0};
 };
 
 #endif // DARKEMU_SERVERLISTMANAGER_H
@@ -9,29 +9,42 @@
 #include <cstdint>
 #include <span>
 
+#include "Common/Network/ProtocolVersion.h"
 #include "Common/Network/Socket.h"
+#include "Common/Utils/Metrics.h"
 
 /**
  * Central packet handler for ConnectServer protocol messages.
- * Dispatches based on type/subtype and writes responses to the client socket.
+ * Routes frames through a compile-time head/sub-code table and writes responses to the client socket.
  */
 class PacketHandler {
 public:
     /// Access the global PacketHandler instance.
     static PacketHandler* Instance();
 
-    /// Dispatch a raw packet to the appropriate handler.
+    /// Dispatch a raw packet to the appropriate handler of a protocol's table.
+    template <typename Protocol = Season6Protocol>
     void HandlePacket(Socket& client, std::span<const uint8_t> packet);
 
 private:
-    PacketHandler() = default;
+    /// Compile-time dispatch table over the handlers below for a protocol (defined in PacketHandler.cpp).
+    template <typename Protocol>
+    struct Routes;
+
+    PacketHandler();
 
     /// Handle the server list request (F4 06).
-    void HandleServerList(Socket& client);
+    template <typename Protocol>
+    void HandleServerList(Socket& client, std::span<const uint8_t> packet);
     /// Handle the server info request (F4 03).
+    template <typename Protocol>
     void HandleServerInfo(Socket& client, std::span<const uint8_t> packet);
     /// Send a complete response to the client, handling partial sends.
     void SendPacket(Socket& client, std::span<const uint8_t> payload);
+
+    Counter& packets_handled_;  ///< Packets routed to a handler.
+    Counter& packets_dropped_;  ///< Packets rejected by header checks or unknown subtype.
+    Counter& bytes_sent_;       ///< Response bytes written to clients.
 };
 
 #endif // DARKEMU_PACKETHANDLER_H
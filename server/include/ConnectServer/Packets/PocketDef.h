@@ -1,9 +1,72 @@
 /*
  * Copyright (c) DarkEmu
- * Packet definitions for ConnectServer (placeholder).
+ * Packet definitions for ConnectServer.
  */
 
 #ifndef DARKEMU_POCKETDEF_H
 #define DARKEMU_POCKETDEF_H
 
+#include <cstddef>
+#include <cstdint>
+
+#include "Common/Network/PacketLayout.h"
+#include "Common/Network/ProtocolVersion.h"
+
+/**
+ * ConnectServer packet layouts for one protocol policy (see ProtocolVersion.h).
+ * The opcodes come from the policy; every season currently shares the F4 layouts.
+ */
+template <typename Protocol>
+struct ConnectPackets {
+    /// Client request for the server list: C1 04 F4 06.
+    struct ServerListRequest {
+        using Header = C1SubHeader<Protocol::kConnectHead, Protocol::kServerListSub>;
+        Header header;
+    };
+
+    /// Server list response head: C2 <size> F4 06 <count:BE16>, followed by count ServerListEntry.
+    struct ServerListResponse {
+        using Header = C2SubHeader<Protocol::kConnectHead, Protocol::kServerListSub>;
+        Header header;
+        BigEndian<uint16_t> count;
+    };
+
+    /// One visible game server in the server list response.
+    struct ServerListEntry {
+        LittleEndian<uint16_t> server_code;
+        uint8_t user_total{0};
+        uint8_t list_type{0};
+    };
+
+    /// Client request for a game server address: C1 06 F4 03 <code:LE16>.
+    struct ServerInfoRequest {
+        using Header = C1SubHeader<Protocol::kConnectHead, Protocol::kServerInfoSub>;
+        Header header;
+        LittleEndian<uint16_t> server_code;
+    };
+
+    /// Game server address: C1 16 F4 03 <IP, NUL-padded to 16> <port:LE16>.
+    struct ServerInfoResponse {
+        using Header = C1SubHeader<Protocol::kConnectHead, Protocol::kServerInfoSub>;
+        Header header;
+        char ip[16]{};
+        LittleEndian<uint16_t> port;
+    };
+};
+
+/// Inline writer storage for server list replies; covers 62 visible servers before spilling.
+constexpr size_t kServerListInlineSize = 256;
+
+using Season6ConnectPackets = ConnectPackets<Season6Protocol>;
+static_assert(WirePacket<Season6ConnectPackets::ServerListRequest> &&
+              sizeof(Season6ConnectPackets::ServerListRequest) == 4);
+static_assert(WirePacket<Season6ConnectPackets::ServerListResponse> &&
+              sizeof(Season6ConnectPackets::ServerListResponse) == 7);
+static_assert(sizeof(Season6ConnectPackets::ServerListEntry) == 4 &&
+              alignof(Season6ConnectPackets::ServerListEntry) == 1);
+static_assert(WirePacket<Season6ConnectPackets::ServerInfoRequest> &&
+              sizeof(Season6ConnectPackets::ServerInfoRequest) == 6);
+static_assert(WirePacket<Season6ConnectPackets::ServerInfoResponse> &&
+              sizeof(Season6ConnectPackets::ServerInfoResponse) == 22);
+
 #endif // DARKEMU_POCKETDEF_H
@@ -6,12 +6,20 @@
 #ifndef DARKEMU_SERVERENGINE_H
 #define DARKEMU_SERVERENGINE_H
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "Common/Network/EpollContext.h"
+#include "Common/Network/LoopMonitor.h"
+#include "Common/Network/ProtocolVersion.h"
+#include "Common/Network/SessionRecorder.h"
 #include "Common/Network/Socket.h"
+#include "Common/Network/StatusServer.h"
+#include "Common/Utils/Metrics.h"
 
 /**
  * ConnectServer engine that accepts clients and responds to server list requests.
@@ -20,20 +28,41 @@
 
 class ServerEngine {
 public:
-    /// Create a server engine bound to the given port (0 selects an ephemeral port).
-    explicit ServerEngine(uint16_t port = 44405);
+    /// Create a server engine bound to the given port (0 selects an ephemeral port) for one client build.
+    explicit ServerEngine(uint16_t port = 44405, ProtocolVersion protocol = ProtocolVersion::Season6);
     /// Run the server event loop indefinitely.
     void run();
     /// Run a single epoll wait/dispatch cycle (used by tests).
     void runOnce(int timeoutMs);
     /// Return the actual port bound by the listening socket.
     uint16_t port() const noexcept;
+    /// Client build this engine speaks.
+    ProtocolVersion protocol() const noexcept;
+    /// Serve Prometheus metrics over HTTP on a second port (0 selects an ephemeral port).
+    void enableStatusEndpoint(uint16_t port);
+    /// Return the status endpoint port, or 0 when it is disabled.
+    uint16_t statusPort() const noexcept;
+    /// Set the handler time budget; slower handlers are logged with fd and opcode.
+    void setHandlerBudget(std::chrono::microseconds budget) noexcept;
+    /// Access event-loop health data (slow handler log, budget).
+    const LoopMonitor& loopMonitor() const noexcept;
+    /// Record every client session to a capture file for DarkEmu_Replay.
+    void enableCapture(const std::string& path);
 
 private:
     /// Tracks per-client state for buffered reads.
     struct ClientState {
         Socket socket;                ///< Owned client socket.
         std::vector<uint8_t> buffer;  ///< Accumulated inbound data.
+        uint32_t capture_id{0};       ///< Session id in the capture file (0 when not capturing).
+    };
+
+    /// Metric series updated from the event loop.
+    struct EngineMetrics {
+        Counter& accepted;       ///< Connections accepted since startup.
+        Gauge& active;           ///< Currently open client connections.
+        Counter& bytes_received; ///< Raw bytes read from clients.
+        Histogram& request_time; ///< Read-to-response time in microseconds.
     };
 
     /// Accept all pending connections from the listen socket.
@@ -42,6 +71,9 @@ private:
     void handleClientEvent(int fd, uint32_t events);
     /// Read and process data for a connected client.
     void handleRead(int fd);
+    /// Frame and dispatch the buffered request of a client, then close it.
+    template <typename Protocol>
+    void handleFrame(int fd, ClientState& client, std::chrono::steady_clock::time_point started);
     /// Remove a client from the epoll set and internal map.
     void closeClient(int fd);
 
@@ -50,6 +82,13 @@ private:
     std::unordered_map<int, ClientState> clients_;
     std::vector<epoll_event> events_;
     uint16_t port_{0};
+    EngineMetrics metrics_;
+    LoopMonitor monitor_;
+    std::unique_ptr<StatusServer> status_;
+    std::unique_ptr<SessionRecorder> recorder_;
+    ProtocolVersion protocol_;
+    /// handleFrame instantiation for protocol_, picked by the constructor.
+    void (ServerEngine::*handle_frame_)(int, ClientState&, std::chrono::steady_clock::time_point){nullptr};
 };
 
 #endif // DARKEMU_SERVERENGINE_H
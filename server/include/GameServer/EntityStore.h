@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) DarkEmu
+ * Structure-of-arrays storage for players, monsters and NPCs, with per-tick systems.
+ */
+
+#ifndef DARKEMU_ENTITYSTORE_H
+#define DARKEMU_ENTITYSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// What an entity is.
+enum class EntityKind : uint8_t {
+    Player = 0,
+    Monster = 1,
+    Npc = 2,
+};
+
+/**
+ * Stable reference to an entity. The slot never moves while the entity lives;
+ * the generation changes every time the slot is reused, so a handle kept past
+ * the entity's death (a stale target, say) stops resolving instead of
+ * silently pointing at whatever took the slot.
+ */
+struct EntityHandle {
+    uint32_t slot{0};
+    uint32_t generation{0}; ///< 0 never names a live entity.
+
+    bool operator==(const EntityHandle&) const = default;
+    explicit operator bool() const noexcept {
+        return generation != 0;
+    }
+};
+
+/// Everything needed to create an entity.
+struct EntitySpawn {
+    EntityKind kind{EntityKind::Monster};
+    uint16_t id{0};       ///< Player index, or monster/NPC class.
+    uint8_t map{0};
+    uint8_t x{0};
+    uint8_t y{0};
+    uint32_t life{0};     ///< Also the maximum.
+    uint32_t mana{0};     ///< Also the maximum.
+    uint8_t view_range{0};   ///< Monsters: tiles within which they notice players.
+    uint8_t attack_range{0}; ///< Monsters: tiles within which they attack.
+};
+
+/**
+ * The entities of one shard, one contiguous array per field.
+ *
+ * Live entities occupy indices [0, size()) of every column with no holes:
+ * destroy() moves the last entity into the freed index. A system that needs
+ * two fields walks two arrays front to back, touching nothing else, which is
+ * what lets the compiler vectorize it. Indices therefore change on destroy();
+ * anything kept across calls holds an EntityHandle, resolved through a slot
+ * table to the current index.
+ *
+ * There are no per-entity objects and no virtual calls: behavior lives in
+ * the systems below and in MonsterAi, which run over whole columns once per
+ * tick. Columns only some kinds use (ranges, AI state) are zero for the rest.
+ */
+class EntityStore {
+public:
+    /// Index returned for handles that do not resolve.
+    static constexpr uint32_t kNoIndex = 0xFFFFFFFF;
+
+    // State flags.
+    static constexpr uint32_t kFlagDead = 1u << 0;   ///< Life reached zero; skipped by regeneration.
+    static constexpr uint32_t kFlagMoving = 1u << 1; ///< Stepped toward its destination on the last step.
+
+    /// Add an entity; it stands on its spawn tile with full life and mana.
+    EntityHandle create(const EntitySpawn& spawn);
+    /// Remove an entity; false when the handle is stale. The last entity takes its index.
+    bool destroy(EntityHandle handle);
+    /// True while the handle names a live entity.
+    bool alive(EntityHandle handle) const noexcept {
+        return indexOf(handle) != kNoIndex;
+    }
+    /// Current column index of an entity, or kNoIndex.
+    uint32_t indexOf(EntityHandle handle) const noexcept {
+        if (handle.slot >= slots_.size() || slots_[handle.slot].generation != handle.generation) {
+            return kNoIndex;
+        }
+        return slots_[handle.slot].index;
+    }
+    /// Handle of the entity at a column index.
+    EntityHandle handleAt(uint32_t index) const noexcept {
+        return {owners_[index], slots_[owners_[index]].generation};
+    }
+    /// Place an entity on a tile of its map and stop it there; false when the handle is stale.
+    bool place(EntityHandle handle, uint8_t x, uint8_t y) noexcept;
+
+    /// Live entities.
+    size_t size() const noexcept {
+        return kind_.size();
+    }
+    bool empty() const noexcept {
+        return kind_.empty();
+    }
+
+    // Columns, indexed [0, size()). Spans are invalidated by create() and destroy().
+    std::span<const EntityKind> kind() const noexcept { return kind_; }
+    std::span<const uint16_t> id() const noexcept { return id_; }
+    std::span<const uint8_t> map() const noexcept { return map_; }
+    std::span<uint8_t> x() noexcept { return x_; }
+    std::span<const uint8_t> x() const noexcept { return x_; }
+    std::span<uint8_t> y() noexcept { return y_; }
+    std::span<const uint8_t> y() const noexcept { return y_; }
+    std::span<uint8_t> destX() noexcept { return dest_x_; }
+    std::span<const uint8_t> destX() const noexcept { return dest_x_; }
+    std::span<uint8_t> destY() noexcept { return dest_y_; }
+    std::span<const uint8_t> destY() const noexcept { return dest_y_; }
+    std::span<uint32_t> life() noexcept { return life_; }
+    std::span<const uint32_t> life() const noexcept { return life_; }
+    std::span<const uint32_t> maxLife() const noexcept { return max_life_; }
+    std::span<uint32_t> mana() noexcept { return mana_; }
+    std::span<const uint32_t> mana() const noexcept { return mana_; }
+    std::span<const uint32_t> maxMana() const noexcept { return max_mana_; }
+    std::span<uint32_t> flags() noexcept { return flags_; }
+    std::span<const uint32_t> flags() const noexcept { return flags_; }
+    std::span<EntityHandle> target() noexcept { return target_; }
+    std::span<const EntityHandle> target() const noexcept { return target_; }
+    std::span<const uint8_t> homeX() const noexcept { return home_x_; }
+    std::span<const uint8_t> homeY() const noexcept { return home_y_; }
+    std::span<const uint8_t> viewRange() const noexcept { return view_range_; }
+    std::span<const uint8_t> attackRange() const noexcept { return attack_range_; }
+    std::span<uint8_t> aiState() noexcept { return ai_state_; }
+    std::span<const uint8_t> aiState() const noexcept { return ai_state_; }
+
+private:
+    /// Where a handle's entity lives now.
+    struct Slot {
+        uint32_t index{kNoIndex};
+        uint32_t generation{0};
+    };
+
+    std::vector<EntityKind> kind_;
+    std::vector<uint16_t> id_;
+    std::vector<uint8_t> map_;
+    std::vector<uint8_t> x_;
+    std::vector<uint8_t> y_;
+    std::vector<uint8_t> dest_x_;
+    std::vector<uint8_t> dest_y_;
+    std::vector<uint32_t> life_;
+    std::vector<uint32_t> max_life_;
+    std::vector<uint32_t> mana_;
+    std::vector<uint32_t> max_mana_;
+    std::vector<uint32_t> flags_;
+    std::vector<EntityHandle> target_;
+    std::vector<uint8_t> home_x_;      ///< Spawn tile.
+    std::vector<uint8_t> home_y_;
+    std::vector<uint8_t> view_range_;
+    std::vector<uint8_t> attack_range_;
+    std::vector<uint8_t> ai_state_;    ///< MonsterAi::State of monsters.
+    std::vector<uint32_t> owners_;     ///< Slot of the entity at each index.
+    std::vector<Slot> slots_;          ///< Indexed by EntityHandle::slot.
+    std::vector<uint32_t> free_slots_; ///< Slots of destroyed entities, reused last-in first-out.
+};
+
+/**
+ * Add life and mana to every entity that is not dead, up to its maximum.
+ * Pools are expected to stay below 2^31 so the sum cannot wrap.
+ */
+void regenerate(EntityStore& store, uint32_t life, uint32_t mana) noexcept;
+
+/// Step every entity one tile toward its destination, diagonals included, and set kFlagMoving on those that moved.
+/// Returns how many moved.
+size_t stepTowardDestinations(EntityStore& store) noexcept;
+
+/// Forget targets that died or were destroyed; returns how many were cleared.
+size_t clearStaleTargets(EntityStore& store) noexcept;
+
+#endif // DARKEMU_ENTITYSTORE_H
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) DarkEmu
+ * Packet definitions for the GameServer handshake, login and character-select flow.
+ */
+
+#ifndef DARKEMU_GAMEPACKETS_H
+#define DARKEMU_GAMEPACKETS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "Common/Network/PacketLayout.h"
+#include "Common/Network/ProtocolVersion.h"
+
+/// Key the client XORs over account and password bytes (BuxConvert).
+inline constexpr std::array<uint8_t, 3> kBuxKey{0xFC, 0xCF, 0xAB};
+
+/// Apply or undo BuxConvert over a whole field, NUL padding included.
+inline void buxConvert(std::span<uint8_t> field) noexcept {
+    for (size_t i = 0; i < field.size(); ++i) {
+        field[i] ^= kBuxKey[i % kBuxKey.size()];
+    }
+}
+
+/**
+ * GameServer packet layouts for one protocol policy (see ProtocolVersion.h).
+ * Opcodes and field widths come from the policy, so every season gets its own
+ * set of types and nothing about the layout is decided at run time.
+ */
+template <typename Protocol>
+struct GamePackets {
+    /// Join result (F1 00), sent by the server right after accept.
+    struct JoinResult {
+        using Header = C1SubHeader<Protocol::kAccountHead, 0x00>;
+        Header header;
+        uint8_t result{0x01};
+        BigEndian<uint16_t> index; ///< Player index.
+        std::array<uint8_t, 5> version{Protocol::kClientVersion};
+    };
+
+    /// Account login (F1 01); the client sends it C3-encrypted.
+    struct LoginRequest {
+        using Header = C1SubHeader<Protocol::kAccountHead, 0x01>;
+        Header header;
+        uint8_t account[Protocol::kAccountLength]{};   ///< BuxConvert-obfuscated, NUL-padded.
+        uint8_t password[Protocol::kPasswordLength]{}; ///< BuxConvert-obfuscated, NUL-padded.
+        LittleEndian<uint32_t> tick_count;             ///< Client GetTickCount() at send time.
+        uint8_t version[5]{};
+        uint8_t serial[16]{};
+    };
+
+    /// Login result (F1 01): 0x01 accepted.
+    struct LoginResult {
+        using Header = C1SubHeader<Protocol::kAccountHead, 0x01>;
+        Header header;
+        uint8_t result{0};
+    };
+
+    /// Character list request (F3 00).
+    struct CharacterListRequest {
+        using Header = C1SubHeader<Protocol::kCharacterHead, 0x00>;
+        Header header;
+    };
+
+    /// Character list head (F3 00); count character entries follow.
+    struct CharacterListResponse {
+        using Header = C1SubHeader<Protocol::kCharacterHead, 0x00>;
+        Header header;
+        uint8_t max_class{0};  ///< Highest class the account may create.
+        uint8_t move_count{0}; ///< Server-move tickets left.
+        uint8_t count{0};
+    };
+
+    /// Select a character and enter the world (F3 03).
+    struct SelectCharacterRequest {
+        using Header = C1SubHeader<Protocol::kCharacterHead, 0x03>;
+        Header header;
+        char name[10]{};
+    };
+
+    /// Walk: target tile, then a packed path the server does not replay yet.
+    struct WalkRequest {
+        using Header = C1Header<Protocol::kWalkHead>;
+        Header header;
+        uint8_t x{0};
+        uint8_t y{0};
+    };
+
+    /// Another player walked (same head as the walk request): index, target tile and direction (high nibble).
+    struct ObjectMoved {
+        using Header = C1Header<Protocol::kWalkHead>;
+        Header header;
+        BigEndian<uint16_t> index;
+        uint8_t x{0};
+        uint8_t y{0};
+        uint8_t direction{0};
+    };
+
+    /// Whisper (02): target name, then the message text up to the frame end.
+    /// The server forwards the same layout to the target with the sender's name.
+    struct Whisper {
+        using Header = C1Header<Protocol::kWhisperHead>;
+        Header header;
+        char name[10]{};
+    };
+
+    /// Whisper target is not online (0C).
+    struct WhisperFailed {
+        using Header = C1Header<Protocol::kWhisperFailedHead>;
+        Header header;
+        uint8_t result{0};
+    };
+
+    /// Warp to another map (8E 02).
+    struct WarpRequest {
+        using Header = C1SubHeader<Protocol::kWarpHead, Protocol::kWarpSub>;
+        Header header;
+        LittleEndian<uint32_t> key; ///< Client anti-hack key; not checked.
+        uint8_t map{0};
+    };
+
+    /// Teleport (1C): the character now stands on map at (x, y).
+    struct Teleport {
+        using Header = C1Header<Protocol::kTeleportHead>;
+        Header header;
+        uint8_t flag{0};
+        uint8_t map{0};
+        uint8_t x{0};
+        uint8_t y{0};
+        uint8_t direction{0};
+    };
+
+    /// Party invitation (40): the request carries the target's index, the forwarded copy the sender's.
+    struct PartyRequest {
+        using Header = C1Header<Protocol::kPartyHead>;
+        Header header;
+        BigEndian<uint16_t> index;
+    };
+
+    /// Players entering the viewport (C2 12): count ViewportPlayer entries follow.
+    struct ViewportCreate {
+        using Header = C2Header<Protocol::kViewportCreateHead>;
+        Header header;
+        uint8_t count{0};
+    };
+
+    /// One player in ViewportCreate. Equipment and effects are not tracked yet, so only position and name go out.
+    struct ViewportPlayer {
+        BigEndian<uint16_t> index;
+        uint8_t x{0};
+        uint8_t y{0};
+        char name[10]{};
+    };
+
+    /// Objects leaving the viewport (14): count big-endian object indices follow.
+    struct ViewportDestroy {
+        using Header = C1Header<Protocol::kViewportDestroyHead>;
+        Header header;
+        uint8_t count{0};
+    };
+
+    /// Entries per frame: a C2 count is one byte, a C1 frame at most 255 bytes.
+    static constexpr size_t kMaxViewportCreate = 255;
+    static constexpr size_t kMaxViewportDestroy = (255 - sizeof(ViewportDestroy)) / sizeof(BigEndian<uint16_t>);
+};
+
+static_assert(WirePacket<GamePackets<Season6Protocol>::JoinResult> &&
+              sizeof(GamePackets<Season6Protocol>::JoinResult) == 12);
+static_assert(WirePacket<GamePackets<Season6Protocol>::LoginRequest> &&
+              sizeof(GamePackets<Season6Protocol>::LoginRequest) == 49);
+static_assert(WirePacket<GamePackets<Season9Protocol>::LoginRequest> &&
+              sizeof(GamePackets<Season9Protocol>::LoginRequest) == 59);
+static_assert(WirePacket<GamePackets<Season6Protocol>::LoginResult> &&
+              sizeof(GamePackets<Season6Protocol>::LoginResult) == 5);
+static_assert(WirePacket<GamePackets<Season6Protocol>::CharacterListRequest> &&
+              sizeof(GamePackets<Season6Protocol>::CharacterListRequest) == 4);
+static_assert(WirePacket<GamePackets<Season6Protocol>::CharacterListResponse> &&
+              sizeof(GamePackets<Season6Protocol>::CharacterListResponse) == 7);
+static_assert(WirePacket<GamePackets<Season6Protocol>::SelectCharacterRequest> &&
+              sizeof(GamePackets<Season6Protocol>::SelectCharacterRequest) == 14);
+static_assert(WirePacket<GamePackets<Season9Protocol>::WalkRequest> &&
+              sizeof(GamePackets<Season9Protocol>::WalkRequest) == 5);
+static_assert(WirePacket<GamePackets<Season6Protocol>::ObjectMoved> &&
+              sizeof(GamePackets<Season6Protocol>::ObjectMoved) == 8);
+static_assert(WirePacket<GamePackets<Season6Protocol>::Whisper> && sizeof(GamePackets<Season6Protocol>::Whisper) == 13);
+static_assert(WirePacket<GamePackets<Season6Protocol>::WarpRequest> &&
+              sizeof(GamePackets<Season6Protocol>::WarpRequest) == 9);
+static_assert(WirePacket<GamePackets<Season6Protocol>::Teleport> && sizeof(GamePackets<Season6Protocol>::Teleport) == 8);
+static_assert(WirePacket<GamePackets<Season6Protocol>::PartyRequest> &&
+              sizeof(GamePackets<Season6Protocol>::PartyRequest) == 5);
+static_assert(WirePacket<GamePackets<Season6Protocol>::ViewportCreate> &&
+              sizeof(GamePackets<Season6Protocol>::ViewportCreate) == 5);
+static_assert(sizeof(GamePackets<Season6Protocol>::ViewportPlayer) == 14 &&
+              alignof(GamePackets<Season6Protocol>::ViewportPlayer) == 1);
+static_assert(WirePacket<GamePackets<Season6Protocol>::ViewportDestroy> &&
+              sizeof(GamePackets<Season6Protocol>::ViewportDestroy) == 4);
+
+#endif // DARKEMU_GAMEPACKETS_H
@@ -6,52 +6,474 @@
 #ifndef DARKEMU_GAMESERVER_H
 #define DARKEMU_GAMESERVER_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "Common/Crypto/SimpleModulus.h"
+#include "Common/Crypto/Xor32.h"
 #include "Common/Network/EpollContext.h"
+#include "Common/Network/LoopMonitor.h"
+#include "Common/Network/Outbox.h"
+#include "Common/Network/ProtocolVersion.h"
+#include "Common/Network/SessionRecorder.h"
 #include "Common/Network/Socket.h"
+#include "Common/Network/StatusServer.h"
+#include "Common/Utils/Metrics.h"
+#include "Common/Utils/SpscQueue.h"
+#include "GameServer/EntityStore.h"
+#include "GameServer/MonsterAi.h"
+#include "GameServer/Viewport.h"
+#include "GameServer/WorldMap.h"
 
 /**
- * TCP game server that accepts clients and logs incoming packets.
+ * TCP game server that accepts clients, decodes their packets and routes
+ * them through a compile-time dispatch table. Login accepts any account
+ * (there is no account store yet) and leads to character selection.
+ *
+ * Each reactor wake-up is processed as one batch: every readable client is
+ * drained first, then all complete frames are decrypted together and
+ * dispatched grouped by opcode (keeping each client's own frames in order).
+ *
+ * RunOnce()/Run() drive one reactor that also runs the handlers inline.
+ * Run(ThreadingOptions) splits the work instead: I/O reactor threads frame
+ * and decode, then hand frames to fixed-tick simulation shards through one
+ * SPSC queue per reactor and shard; replies flow back through a second queue
+ * per pair. A burst of reads then cannot stretch a tick, and a slow tick
+ * cannot stall reads.
+ *
+ * Shards partition the world by map. Each shard thread (pinned to a core)
+ * owns the sessions on its maps; a warp hands the session to the shard of the
+ * target map, and whispers and party requests cross shards through
+ * per-pair SPSC mailboxes. No lock is shared between shards.
+ *
+ * The packet path is templated on a protocol policy; the constructor picks
+ * the instantiation for the configured client build once.
  */
 class GameServer {
 public:
-    /// Create the GameServer bound to the given port.
-    explicit GameServer(uint16_t port = 55901);
-    /// Run the main event loop indefinitely.
+    /// Rate-limit buckets referenced by dispatch routes.
+    enum class RateClass : uint8_t {
+        Unlimited, ///< Never limited.
+        Login,     ///< Login and character selection.
+        Movement,  ///< Walk and position updates.
+        Chat,      ///< Whispers and party requests.
+        Count,
+    };
+
+    /// Thread layout for the split reactor/simulation mode.
+    struct ThreadingOptions {
+        size_t reactors{1};                                        ///< I/O reactor threads; reactor 0 also accepts.
+        size_t shards{1};                                          ///< Simulation threads; map m runs on shard m % shards.
+        bool pin_shards{true};                                     ///< Pin shard i to CPU i (modulo the CPU count).
+        std::chrono::microseconds tick{std::chrono::milliseconds(50)}; ///< Simulation tick period.
+        size_t queue_capacity{8192};                               ///< Slots per queue and mailbox, in each direction.
+        size_t max_frames_per_tick{4096};                          ///< Inbound messages a shard takes per reactor per tick.
+    };
+
+    /// Create the GameServer bound to the given port, serving one client build.
+    explicit GameServer(uint16_t port = 55901, ProtocolVersion protocol = ProtocolVersion::Season6);
+    /// Stop the reactor and shard threads, if running.
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    /// Run the single-threaded event loop indefinitely.
     void Run();
-    /// Run a single event loop iteration (useful for tests).
+    /// Run the split reactor/shard threads until Stop() is called.
+    void Run(const ThreadingOptions& options);
+    /// Run a single event loop iteration with inline handlers (useful for tests).
     void RunOnce(int timeoutMs);
+    /**
+     * Start the reactor and shard threads and return.
+     * Throws std::logic_error when threads already run or clients were accepted inline.
+     */
+    void Start(const ThreadingOptions& options);
+    /// Stop and join the threads started by Start(); safe to call more than once.
+    void Stop();
     /// Return the bound port for diagnostics or tests.
     uint16_t Port() const noexcept;
     /// Return total bytes received since startup (for testing).
     size_t BytesReceived() const noexcept;
+    /// Serve Prometheus metrics over HTTP on a second port (0 selects an ephemeral port).
+    void EnableStatusEndpoint(uint16_t port);
+    /// Return the status endpoint port, or 0 when it is disabled.
+    uint16_t StatusPort() const noexcept;
+    /// Set the handler time budget of the reactors and shards; slower handlers are logged with fd and opcode.
+    void SetHandlerBudget(std::chrono::microseconds budget) noexcept;
+    /// Access event-loop health data (slow handler log, budget) of the accepting reactor.
+    const LoopMonitor& GetLoopMonitor() const noexcept;
+    /// Record every client session to a capture file for DarkEmu_Replay.
+    void EnableCapture(const std::string& path);
+    /// Load client-to-server packet keys (Dec2.dat) from a directory; the built-in keys stay on failure.
+    bool LoadPacketKeys(const std::string& directory);
+    /// Set a per-client packets-per-second limit for a rate class (0 disables it).
+    void SetRateLimit(RateClass rateClass, uint32_t perSecond) noexcept;
+    /// Frames routed to a handler since startup (for testing).
+    uint64_t PacketsDispatched() const noexcept;
+    /// Frames dropped by dispatch validation since startup (for testing).
+    uint64_t PacketsRejected() const noexcept;
+    /// Simulation ticks run since startup, summed over shards (0 in single-threaded mode).
+    uint64_t Ticks() const noexcept;
+    /**
+     * Limit concurrent players (at most 50000, the default); connections beyond it are refused.
+     * Throws std::logic_error once a client was accepted.
+     */
+    void SetPlayerCapacity(uint16_t players);
+    /// Log a hex dump of every decoded frame (off by default; costs allocations per frame).
+    void SetPacketLogging(bool enabled) noexcept;
+    /// Client build this server speaks.
+    ProtocolVersion Protocol() const noexcept;
 
 private:
-    /// Tracks per-client state for buffered reads.
+    /// Compile-time dispatch table over the packet handlers for a protocol (defined in GameServer.cpp).
+    template <typename ProtocolT>
+    struct Routes;
+
+    /// Session progress; dispatch routes list the states they accept as a bit mask.
+    enum SessionState : uint8_t {
+        kStateConnected = 0x01,     ///< Join result sent, waiting for login.
+        kStateAuthenticated = 0x02, ///< Logged in, choosing a character.
+        kStateInGame = 0x04,        ///< Character selected and in the world.
+    };
+
+    using Clock = std::chrono::steady_clock;
+    /// Connection identity across threads: accept sequence number in the high half, fd in the low half.
+    using ConnectionId = uint64_t;
+    /// Shard id meaning "none": a free player index or no pending transfer.
+    static constexpr uint32_t kNoShard = 0xFFFF;
+
+    struct ClientState;
+
+    /// Game-side state of a connection; the handlers and the dispatch table work on it.
+    struct Session {
+        ConnectionId connection{0};
+        uint32_t reactor{0};          ///< Reactor that owns the socket.
+        uint32_t shard{0};            ///< Shard holding the session.
+        uint32_t transfer{kNoShard};  ///< Shard to hand the session to once the current handler returns.
+        ClientState* client{nullptr}; ///< Socket owner when handlers run inline, null in threaded mode.
+        uint16_t index{0};            ///< Player index announced in the join result.
+        uint8_t state{kStateConnected};
+        std::string account;          ///< Account name from the login packet.
+        std::string character;        ///< Selected character name.
+        uint8_t map{0};               ///< Current map (WorldMap).
+        uint8_t x{0};                 ///< Last walk target.
+        uint8_t y{0};
+        EntityHandle entity;          ///< Player entity in the holding shard's store while on a map.
+        Clock::time_point rate_window{};  ///< Start of the current one-second rate window.
+        std::array<uint32_t, static_cast<size_t>(RateClass::Count)> rate_counts{};
+    };
+
+    /// Reactor-side state of a connection: the socket and its buffered reads.
     struct ClientState {
         Socket socket;                ///< Owned client socket.
         std::vector<uint8_t> buffer;  ///< Accumulated inbound data.
+        ConnectionId connection{0};
+        uint16_t index{0};            ///< Player index announced in the join result.
+        uint32_t shard{0};            ///< Shard its frames go to; follows the session on warps.
+        uint32_t capture_id{0};       ///< Session id in the capture file (0 when not capturing).
+        Session* session{nullptr};    ///< Inline mode only: the session its frames dispatch to.
+        Outbox outbox{};              ///< Outbound frames not yet handed to the socket.
+        bool flush_queued{false};     ///< Listed in Reactor::flushing.
+        bool write_blocked{false};    ///< The socket buffer filled up; EPOLLOUT is armed.
+        bool outbox_overflow{false};  ///< The outbox hit its size cap; closed by the next flush.
+        // Per-batch bookkeeping, reset after every wake-up.
+        uint32_t batch_frames{0};     ///< Frames gathered from this client in the current batch.
+        uint32_t batch_valid{0};      ///< Leading frames that may be dispatched (the rest failed to decode).
+        size_t batch_consumed{0};     ///< Buffer bytes covered by the gathered frames.
+        bool batch_close{false};      ///< Close once the batch is dispatched.
+    };
+
+    /// One complete frame gathered during a wake-up.
+    struct PendingFrame {
+        ClientState* client;
+        uint8_t* data;        ///< Frame bytes, in the client buffer or the decryption arena.
+        uint32_t size;
+        uint32_t wave;        ///< Position among the client's frames in this batch.
+    };
+
+    /// Reactor to shard message; slots are reused, so frame keeps its capacity.
+    struct InboundMessage {
+        enum class Kind : uint8_t { Open, Frame, Close };
+        Kind kind{Kind::Frame};
+        ConnectionId connection{0};
+        uint16_t index{0};            ///< Open, Close: player index.
+        std::vector<uint8_t> frame;   ///< Frame: decoded C1/C2 frame.
+    };
+
+    /// Shard to reactor message: a reply frame, or the new shard of a warped connection.
+    struct OutboundMessage {
+        enum class Kind : uint8_t { Frame, Shared, Moved };
+        Kind kind{Kind::Frame};
+        ConnectionId connection{0};
+        uint32_t shard{0};            ///< Moved: shard that now holds the session.
+        std::vector<uint8_t> frame;   ///< Frame: a copy for this connection.
+        SharedFrame shared;           ///< Shared: a reference to a fan-out frame.
+    };
+
+    /// Shard to shard mailbox message.
+    struct ShardMessage {
+        enum class Kind : uint8_t { Enter, Close, Register, Unregister, Whisper, Deliver };
+        Kind kind{Kind::Deliver};
+        Session session;              ///< Enter: the session moving in.
+        ConnectionId connection{0};   ///< Close: connection that went away after its session moved.
+        uint16_t index{0};            ///< Register, Unregister, Deliver: target index; Whisper: sender index.
+        std::string name;             ///< Register, Unregister, Whisper: character name.
+        std::vector<uint8_t> frame;   ///< Whisper, Deliver: frame for the target.
+        std::vector<uint8_t> reply;   ///< Whisper: frame for the sender when the target is offline.
+    };
+
+    /// Connection accepted by reactor 0 and handed to another reactor.
+    struct Handoff {
+        Socket socket;
+        ConnectionId connection{0};
+        uint16_t index{0};
+    };
+
+    /// Queues between one reactor and one shard.
+    struct ShardLink {
+        std::unique_ptr<SpscQueue<InboundMessage>> inbound;   ///< Decoded frames for the shard.
+        std::unique_ptr<SpscQueue<OutboundMessage>> outbound; ///< Replies from the shard.
+        std::deque<InboundMessage> inbound_backlog;   ///< Reactor side: messages waiting for queue space.
+        std::deque<OutboundMessage> outbound_backlog; ///< Shard side: replies waiting for queue space.
+        bool outbound_posted{false};                  ///< Shard queued replies this tick.
+    };
+
+    /// One I/O reactor: an epoll set with its connections and batch scratch space.
+    struct Reactor {
+        Reactor(uint32_t id, const std::string& name);
+        ~Reactor();
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+
+        uint32_t id;
+        EpollContext epoll;
+        std::vector<epoll_event> events;
+        LoopMonitor monitor;
+        int wake_fd{-1};                       ///< eventfd the shards and reactor 0 signal.
+        std::unordered_map<int, ClientState> clients;
+        std::vector<ClientState*> readable;    ///< Clients with new data in the current wake-up.
+        std::vector<PendingFrame> batch;       ///< Frames gathered in the current wake-up.
+        std::vector<uint64_t> dispatch_order;  ///< Dispatch keys: client wave, head, sub-code, batch index.
+        std::vector<uint8_t> plain_arena;      ///< Decrypted C3/C4 frames of the current batch.
+        std::vector<int> flushing;             ///< Clients with outbound frames this wake-up, by fd.
+        // Threaded mode only; created by Start().
+        std::vector<ShardLink> links;                ///< Indexed by shard.
+        std::unique_ptr<SpscQueue<Handoff>> handoff; ///< Connections from reactor 0.
+        std::thread thread;
+    };
+
+    /// One simulation shard: the sessions on its maps and its share of the name directory.
+    struct Shard {
+        explicit Shard(uint32_t id) : id(id), monitor("darkemu_game_loop", "GameServer shard " + std::to_string(id)) {}
+
+        uint32_t id;
+        LoopMonitor monitor;  ///< Times the handlers run on the shard thread; only its slow-handler log is used.
+        std::unordered_map<ConnectionId, Session> sessions;
+        std::unordered_map<uint16_t, ConnectionId> players;  ///< Player index of each session held here.
+        std::unordered_map<std::string, uint16_t> directory; ///< Character names homed here, to player index.
+        /// In-game players and who sees whom, per map (only maps run here).
+        std::array<ViewportTracker, kWorldMaps.size()> viewports;
+        /// Entities on its maps, one array per field, for the per-tick systems.
+        EntityStore entities;
+        /// Monster AI per map (only maps run here).
+        std::array<MonsterAi, kWorldMaps.size()> monsters;
+        /// Scratch: in-game player entities per map, gathered each tick for the monster AI.
+        std::array<std::vector<EntityHandle>, kWorldMaps.size()> map_players;
+        // Threaded mode only; created by Start().
+        std::vector<std::unique_ptr<SpscQueue<ShardMessage>>> mailboxes; ///< Incoming, indexed by sender shard.
+        std::vector<std::deque<ShardMessage>> mail_backlog; ///< Outgoing mail waiting for space, by target shard.
+        std::thread thread;
+    };
+
+    /// Metric series updated from the event loop.
+    struct ServerMetrics {
+        Counter& accepted;       ///< Connections accepted since startup.
+        Counter& refused;        ///< Connections closed at accept because every player index was in use.
+        Gauge& active;           ///< Currently open client connections.
+        Counter& bytes_received; ///< Raw bytes read from clients.
+        Counter& recv_calls;     ///< recv() calls that returned data.
+        Counter& bytes_sent;     ///< Raw bytes written to clients.
+        Counter& send_calls;     ///< send() calls on client sockets.
+        Counter& dispatched;     ///< Frames routed to a handler.
+        Counter& rejected;       ///< Frames dropped by dispatch validation or rate limits.
+        Counter& ticks;          ///< Simulation ticks run.
+        Histogram& tick_time;    ///< Work time per tick in microseconds.
+        Counter& tick_overruns;  ///< Ticks whose work exceeded the tick period.
+        Counter& queue_full;     ///< Messages parked because a queue or mailbox was full.
+        Counter& migrations;     ///< Sessions handed to another shard.
+        Counter& mail;           ///< Messages sent through shard mailboxes.
     };
 
     /// Accept all pending connections from the listen socket.
-    void HandleAccept();
-    /// Read from a connected client and log the payload.
-    void HandleRead(int fd);
-    /// Remove a client from the epoll set and internal map.
-    void CloseClient(int fd);
+    void HandleAccept(Reactor& reactor);
+    /// Take a free player index; false when every index is in use.
+    bool AcquirePlayerIndex(uint16_t& index);
+    /// Return the index of a closed session to the free list.
+    void ReleasePlayerIndex(uint16_t index);
+    /// Register an accepted socket with a reactor, greet it and open its session.
+    void AddClient(Reactor& reactor, Socket socket, ConnectionId connection, uint16_t index);
+    /// Send the F1 00 join result that starts the client handshake.
+    template <typename ProtocolT>
+    void SendWelcome(Reactor& reactor, ClientState& client);
+    /// Append a complete frame to the client's outbox and record it in the capture; FlushSends writes it.
+    void QueueSend(Reactor& reactor, ClientState& client, std::span<const uint8_t> frame);
+    /// Queue a shared frame in the client's outbox by reference and record it in the capture.
+    void QueueShared(Reactor& reactor, ClientState& client, const SharedFrame& frame);
+    /// True when another `bytes` would take the outbox past its cap; the client is then closed by the next flush.
+    static bool OutboxOverflows(Reactor& reactor, ClientState& client, size_t bytes);
+    /// Schedule a client's outbox for the flush at the end of the wake-up.
+    static void QueueFlush(Reactor& reactor, ClientState& client);
+    /// Write every scheduled outbox with one send() per client.
+    void FlushSends(Reactor& reactor);
+    /// Send as much of a client's outbox as the socket takes; the rest waits for EPOLLOUT.
+    void FlushClient(Reactor& reactor, ClientState& client);
+    /// Send a frame to a session: into its outbox inline, through its reactor link in threaded mode.
+    void Send(Session& session, std::span<const uint8_t> frame);
+    /// Send a fan-out frame to a session without copying its bytes.
+    void SendShared(Session& session, const SharedFrame& frame);
+    /// Send one frame to players held by a shard: written once and shared when large, copied per player when small.
+    void Broadcast(Shard& shard, std::span<const uint32_t> players, std::span<const uint8_t> frame);
+    /// Count a frame against its rate class; false once the class is over its limit.
+    bool AllowRate(Session& session, uint8_t rateClass, Clock::time_point now);
+    /// F1 01: accept the account and move to character selection.
+    template <typename ProtocolT>
+    void HandleLogin(Session& session, std::span<const uint8_t> frame);
+    /// F3 00: reply with the (empty) character list.
+    template <typename ProtocolT>
+    void HandleCharacterList(Session& session, std::span<const uint8_t> frame);
+    /// F3 03: enter the world with the named character.
+    template <typename ProtocolT>
+    void HandleSelectCharacter(Session& session, std::span<const uint8_t> frame);
+    /// Walk: record the target tile.
+    template <typename ProtocolT>
+    void HandleWalk(Session& session, std::span<const uint8_t> frame);
+    /// 8E 02: move to another map, handing the session to that map's shard.
+    template <typename ProtocolT>
+    void HandleWarp(Session& session, std::span<const uint8_t> frame);
+    /// 02: forward a whisper through the home shard of the target name.
+    template <typename ProtocolT>
+    void HandleWhisper(Session& session, std::span<const uint8_t> frame);
+    /// 40: forward a party invitation to the shard holding the target index.
+    template <typename ProtocolT>
+    void HandlePartyRequest(Session& session, std::span<const uint8_t> frame);
+    /// One epoll wait and the batch it produced.
+    void RunReactor(Reactor& reactor, int timeoutMs);
+    /// Drain a readable client into its buffer and queue it for the batch; closes it on EOF or error.
+    void HandleRead(Reactor& reactor, int fd);
+    /// Frame, decrypt, decode and dispatch (or enqueue) everything read during this wake-up.
+    template <typename ProtocolT>
+    void ProcessBatch(Reactor& reactor);
+    /// Split each readable client's buffer into complete frames.
+    template <typename ProtocolT>
+    void GatherFrames(Reactor& reactor);
+    /// Decrypt every C3/C4 frame of the batch into the reactor's arena.
+    template <typename ProtocolT>
+    void DecryptFrames(Reactor& reactor);
+    /// Undo XOR32 on every dispatchable frame and queue its dispatch key.
+    template <typename ProtocolT>
+    void DecodeFrames(Reactor& reactor);
+    /// Run handlers in dispatch-key order.
+    template <typename ProtocolT>
+    void DispatchFrames(Reactor& reactor, Clock::time_point now);
+    /// Threaded mode: hand the decoded frames of the batch to their shards in arrival order.
+    void EnqueueFrames(Reactor& reactor);
+    /// Queue a message for a shard, parking it when the queue is full so order is kept.
+    void PostInbound(Reactor& reactor, uint32_t shard, InboundMessage::Kind kind, ConnectionId connection,
+                     uint16_t index, std::span<const uint8_t> frame);
+    /// Queue a message from a shard to a reactor, parking it when the queue is full so order is kept.
+    void PostOutbound(uint32_t shard, uint32_t reactor, OutboundMessage::Kind kind, ConnectionId connection,
+                      uint32_t target, std::span<const uint8_t> frame, SharedFrame shared = {});
+    /// Move parked inbound messages into the queues while they have room; false while some remain.
+    bool FlushInboundBacklog(Reactor& reactor);
+    /// Take handed-off connections, apply shard moves and send the shards' replies.
+    void DrainWake(Reactor& reactor);
+    /// Reactor thread body.
+    void ReactorLoop(Reactor& reactor);
+    /// Shard thread body: fixed-period ticks.
+    void ShardLoop(Shard& shard);
+    /// One shard tick: read the mailboxes, apply every reactor's queued messages, then flush replies and mail.
+    template <typename ProtocolT>
+    void RunTick(Shard& shard, Clock::time_point now);
+    /// Send every player on the shard the players that entered and left its viewport since the last call.
+    template <typename ProtocolT>
+    void UpdateViewports(Shard& shard);
+    /// Wake reactors that received replies during the tick and move parked mail into the mailboxes.
+    void FlushOutbound(Shard& shard);
+    /// Signal a reactor's eventfd.
+    static void Wake(const Reactor& reactor);
+    /// Create the game-side state of a connection on a shard.
+    Session& OpenSession(Shard& shard, ConnectionId connection, uint32_t reactor, uint16_t index);
+    /// End a session held by a shard, releasing its index and directory entry.
+    void CloseSession(Shard& shard, ConnectionId connection);
+    /// Hand a session to the shard in its transfer field.
+    void MigrateSession(Shard& shard, ConnectionId connection);
+    /// Send mail to a shard; mail to the sending shard itself is handled at once.
+    void PostMail(Shard& from, uint32_t to, ShardMessage&& message);
+    /// Handle every message waiting in a shard's mailboxes.
+    void DrainMail(Shard& shard);
+    /// Handle one mailbox message.
+    void HandleMail(Shard& shard, ShardMessage& message);
+    /// Put an in-game session on its map: into the viewports and the entity store of the shard holding it.
+    void EnterMap(Session& session);
+    /// Take a session off its map again.
+    void LeaveMap(Session& session);
+    /// Run the entity systems over a shard's store.
+    static void RunEntitySystems(Shard& shard);
+    /// Viewports of the session's current map on the shard holding the session.
+    ViewportTracker& ViewportOf(const Session& session) noexcept;
+    /// Session of a player index held by a shard, or nullptr.
+    static Session* FindPlayer(Shard& shard, uint16_t index) noexcept;
+    /// Shard of a map.
+    uint32_t ShardOfMap(uint8_t map) const noexcept;
+    /// Shard holding the directory entry of a character name.
+    uint32_t HomeShard(const std::string& name) const noexcept;
+    /// Remove a client from its reactor and end its session.
+    void CloseClient(Reactor& reactor, int fd);
     /// Convert raw bytes to a hex string and log it.
     void LogHexDump(const uint8_t* data, size_t size) const;
 
-    EpollContext epoll_;
     Socket listen_socket_;
-    std::unordered_map<int, ClientState> clients_;
-    std::vector<epoll_event> events_;
     uint16_t port_{0};
-    size_t total_bytes_received_{0};
+    std::atomic<size_t> total_bytes_received_{0};
+    // Taken by the accepting reactor, returned by whichever shard closes the session.
+    std::mutex player_index_mutex_;
+    std::deque<uint16_t> free_player_indices_; ///< Oldest-freed first, so a closed index rests as long as possible.
+    uint16_t player_capacity_{0};
+    uint32_t next_connection_{0};
+    ServerMetrics metrics_;
+    std::unique_ptr<StatusServer> status_;
+    std::unique_ptr<SessionRecorder> recorder_;
+    SimpleModulus decoder_{SimpleModulusKeys::clientToServer()};
+    Xor32 xor_;
+    std::array<uint32_t, static_cast<size_t>(RateClass::Count)> rate_limits_{};
+    bool log_packets_{false};
+    ProtocolVersion protocol_;
+    // Protocol instantiations picked by the constructor.
+    void (GameServer::*send_welcome_)(Reactor&, ClientState&){nullptr};
+    void (GameServer::*process_batch_)(Reactor&){nullptr};
+    void (GameServer::*run_tick_)(Shard&, Clock::time_point){nullptr};
+    void (GameServer::*update_viewports_)(Shard&){nullptr};
+    std::vector<std::unique_ptr<Reactor>> reactors_; ///< Reactor 0 owns the listener and status endpoint.
+    std::vector<std::unique_ptr<Shard>> shards_;     ///< Shard 0 also runs inline mode.
+    /// Player index to the shard holding its session (kNoShard when free); written by the holding shard.
+    std::unique_ptr<std::atomic<uint32_t>[]> player_shards_;
+    // Threaded mode.
+    bool threaded_{false};
+    std::atomic<bool> running_{false};
+    ThreadingOptions threading_{};
+    size_t next_reactor_{0};                 ///< Round-robin target for accepted connections.
 };
 
 #endif // DARKEMU_GAMESERVER_H
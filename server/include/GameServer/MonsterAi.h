@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) DarkEmu
+ * Batched monster AI for one map: sleeping and waking, SIMD target search, idle/chase/attack/return.
+ */
+
+#ifndef DARKEMU_MONSTERAI_H
+#define DARKEMU_MONSTERAI_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Common/Crypto/SimpleModulus.h"
+#include "GameServer/EntityStore.h"
+#include "GameServer/SpatialGrid.h"
+
+/**
+ * AI of the monsters on one map, run once per tick over the shard's
+ * EntityStore.
+ *
+ * Monsters with no player within kWakeCells grid cells sleep: they sit in a
+ * SpatialGrid and cost nothing per tick. Each update() buckets the map's
+ * players by cell, wakes the sleepers in the cells around them, and then only
+ * walks the awake monsters, so the cost follows the monsters near players
+ * rather than the monsters on the map.
+ *
+ * Players are counting-sorted by cell into x and y arrays, which makes the
+ * candidates of a monster (the players in the cells around its own) one
+ * contiguous range per cell row. findNearest() runs over those ranges with
+ * SSE4.1 or AVX2, computing squared distances for 4 or 8 players at a time.
+ *
+ * The state machine then runs per monster:
+ *  - Idle: target the nearest player within view range and chase it; with no
+ *    player left in the cells around it, go to sleep.
+ *  - Chase: head for the target; attack once within attack range.
+ *  - Attack: strike every tick while the target stays in attack range.
+ *  - Return: drop the target and walk home, then idle. Chasing and attacking
+ *    monsters return when the target is gone or they strayed more than
+ *    kLeashRange tiles from home.
+ * Movement itself is stepTowardDestinations(): the AI only sets destinations.
+ */
+class MonsterAi {
+public:
+    /// Kernel selection shared with SimpleModulus.
+    using SimdLevel = SimpleModulus::SimdLevel;
+
+    /// AI states, kept in EntityStore::aiState().
+    enum class State : uint8_t { Idle = 0, Chase = 1, Attack = 2, Return = 3 };
+
+    /// Cells around a monster's own cell whose players wake it and are its candidate targets. Candidates cover at
+    /// least kWakeCells * SpatialGrid::kCellSize tiles in every direction, so view ranges up to 16 see everyone.
+    static constexpr uint32_t kWakeCells = 2;
+    /// Tiles (straight-line) a monster may stray from home before it gives up and returns.
+    static constexpr int32_t kLeashRange = 15;
+    /// Returned by findNearest() when no candidate beats the limit.
+    static constexpr uint32_t kNone = 0xFFFFFFFF;
+
+    /// What one update() did.
+    struct TickStats {
+        uint32_t awake{0};   ///< Awake monsters after the update.
+        uint32_t woken{0};   ///< Sleepers woken by nearby players.
+        uint32_t slept{0};   ///< Idle monsters that went to sleep.
+        uint32_t attacks{0}; ///< Attacks made.
+    };
+
+    /// Start running a monster of this map; it sleeps until a player comes near.
+    void add(EntityStore& store, EntityHandle monster);
+    /// Stop running a monster; call before destroying it.
+    void remove(EntityHandle monster);
+    /// Monsters run here.
+    size_t size() const noexcept {
+        return sleeping_.size() + awake_.size();
+    }
+    bool empty() const noexcept {
+        return sleeping_.size() == 0 && awake_.empty();
+    }
+    /// Monsters awake after the last update().
+    size_t awake() const noexcept {
+        return awake_.size();
+    }
+
+    /// Run one tick: players are the entities of the players on this map.
+    TickStats update(EntityStore& store, std::span<const EntityHandle> players);
+
+    /**
+     * Index of the first candidate with the smallest squared distance to
+     * (x, y) that is below best, or kNone; best is lowered to that distance.
+     * Chaining calls over several ranges keeps the earliest of equal matches.
+     */
+    static uint32_t findNearest(SimdLevel level, std::span<const int32_t> xs, std::span<const int32_t> ys, int32_t x,
+                                int32_t y, int32_t& best) noexcept;
+
+    /// Kernel used by this instance.
+    SimdLevel simdLevel() const noexcept {
+        return simd_level_;
+    }
+    /// Select a kernel (clamped to what the CPU supports); used by tests and benchmarks.
+    void setSimdLevel(SimdLevel level) noexcept;
+
+private:
+    static constexpr size_t kCellCount = SpatialGrid::kCells * SpatialGrid::kCells;
+
+    /// Bucket the players by cell into players_x_, players_y_ and player_handles_.
+    void sortPlayers(const EntityStore& store, std::span<const EntityHandle> players);
+    /// Move the sleepers in the cells around the players' cells to awake_.
+    uint32_t wakeNearPlayers();
+    /// Nearest player in the cells around (x, y) within range tiles, or kNone.
+    /// has_candidates is set when any player is in those cells at all.
+    uint32_t nearestPlayer(uint8_t x, uint8_t y, uint8_t range, bool& has_candidates) const noexcept;
+
+    SpatialGrid sleeping_;                      ///< Sleeping monsters by handle slot.
+    std::vector<uint32_t> sleeping_generation_; ///< Handle generation of each sleeping slot.
+    std::vector<EntityHandle> awake_;
+    // Players of the current update, sorted by cell.
+    std::array<uint32_t, kCellCount + 1> cell_start_{}; ///< Players of cell c are [cell_start_[c], cell_start_[c + 1]).
+    std::vector<int32_t> players_x_;
+    std::vector<int32_t> players_y_;
+    std::vector<EntityHandle> player_handles_;
+    std::vector<uint16_t> player_cells_;      ///< Scratch: cell of each player, then the occupied cells.
+    std::vector<SpatialGrid::Slot> waking_;   ///< Scratch: sleepers being woken.
+    SimdLevel simd_level_{SimpleModulus::supportedSimdLevel()};
+};
+
+#endif // DARKEMU_MONSTERAI_H
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) DarkEmu
+ * Uniform grid over a 256x256 map for "who is within N tiles" queries.
+ */
+
+#ifndef DARKEMU_SPATIALGRID_H
+#define DARKEMU_SPATIALGRID_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Entities of one map bucketed into 8x8-tile cells. Each cell is a packed
+ * array of (entity, x, y) slots, so a range query walks a handful of small
+ * contiguous arrays without touching any other entity data. Entities are
+ * small integer ids (player indices, later monster ids) and map to their slot
+ * through a flat table, which makes insert, move and remove O(1).
+ *
+ * Range means Chebyshev distance, the tile distance the client uses for its
+ * viewport and skill ranges: |dx| <= radius and |dy| <= radius.
+ */
+class SpatialGrid {
+public:
+    /// Tiles per map side.
+    static constexpr uint32_t kMapSize = 256;
+    /// Tiles per cell side.
+    static constexpr uint32_t kCellSize = 8;
+    /// Cells per map side.
+    static constexpr uint32_t kCells = kMapSize / kCellSize;
+
+    /// One occupant of a cell.
+    struct Slot {
+        uint32_t entity;
+        uint8_t x;
+        uint8_t y;
+    };
+
+    /// Add an entity at a tile; an entity already present is moved instead.
+    void insert(uint32_t entity, uint8_t x, uint8_t y);
+    /// Move an entity to a tile; an absent entity is inserted. Returns true when it changed cells.
+    bool move(uint32_t entity, uint8_t x, uint8_t y);
+    /// Remove an entity; absent entities are ignored.
+    void remove(uint32_t entity);
+    /// True when the entity is on this grid.
+    bool contains(uint32_t entity) const noexcept {
+        return entity < locations_.size() && locations_[entity].cell != kAbsent;
+    }
+    /// Entities on the grid.
+    size_t size() const noexcept {
+        return size_;
+    }
+    /// The entity's slot (its tile), or nullptr when it is not on the grid.
+    const Slot* find(uint32_t entity) const noexcept {
+        return contains(entity) ? &cells_[locations_[entity].cell][locations_[entity].slot] : nullptr;
+    }
+    /// Cell index (row-major) holding a tile.
+    static constexpr uint16_t cellOf(uint8_t x, uint8_t y) noexcept {
+        return static_cast<uint16_t>((y / kCellSize) * kCells + x / kCellSize);
+    }
+
+    /// Call fn(slot) for every entity in the cells within cells of the cell holding (x, y).
+    template <typename Fn>
+    void forEachInCellBlock(uint8_t x, uint8_t y, uint32_t cells, Fn&& fn) const {
+        const uint32_t cx = x / kCellSize;
+        const uint32_t cy = y / kCellSize;
+        const uint32_t min_cx = cx > cells ? cx - cells : 0;
+        const uint32_t min_cy = cy > cells ? cy - cells : 0;
+        const uint32_t max_cx = cx + cells < kCells ? cx + cells : kCells - 1;
+        const uint32_t max_cy = cy + cells < kCells ? cy + cells : kCells - 1;
+        for (uint32_t row = min_cy; row <= max_cy; ++row) {
+            for (uint32_t column = min_cx; column <= max_cx; ++column) {
+                for (const Slot& slot : cells_[row * kCells + column]) {
+                    fn(slot);
+                }
+            }
+        }
+    }
+
+    /// Call fn(slot) for every entity within radius tiles of (x, y), the centre's own occupants included.
+    template <typename Fn>
+    void forEachInRange(uint8_t x, uint8_t y, uint8_t radius, Fn&& fn) const {
+        const uint32_t min_x = x > radius ? x - radius : 0;
+        const uint32_t min_y = y > radius ? y - radius : 0;
+        const uint32_t max_x = x + radius < kMapSize ? x + radius : kMapSize - 1;
+        const uint32_t max_y = y + radius < kMapSize ? y + radius : kMapSize - 1;
+        for (uint32_t cy = min_y / kCellSize; cy <= max_y / kCellSize; ++cy) {
+            for (uint32_t cx = min_x / kCellSize; cx <= max_x / kCellSize; ++cx) {
+                const std::vector<Slot>& cell = cells_[cy * kCells + cx];
+                // Cells fully inside the range skip the per-entity test.
+                const bool inside = cx * kCellSize >= min_x && (cx + 1) * kCellSize - 1 <= max_x &&
+                                    cy * kCellSize >= min_y && (cy + 1) * kCellSize - 1 <= max_y;
+                for (const Slot& slot : cell) {
+                    if (inside || (slot.x >= min_x && slot.x <= max_x && slot.y >= min_y && slot.y <= max_y)) {
+                        fn(slot);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Append the entities within radius tiles of (x, y) to out; returns how many were added.
+    size_t query(uint8_t x, uint8_t y, uint8_t radius, std::vector<uint32_t>& out) const;
+
+private:
+    static constexpr uint16_t kAbsent = 0xFFFF;
+
+    /// Where an entity's slot lives.
+    struct Location {
+        uint16_t cell{kAbsent};
+        uint32_t slot{0};
+    };
+
+    /// Swap-remove the slot of a present entity from its cell.
+    void unlink(const Location& location);
+
+    std::array<std::vector<Slot>, kCells * kCells> cells_{};
+    std::vector<Location> locations_; ///< Indexed by entity id; grows to the largest id seen.
+    size_t size_{0};
+};
+
+#endif // DARKEMU_SPATIALGRID_H
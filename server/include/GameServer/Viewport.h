@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) DarkEmu
+ * Incremental viewports: who sees whom on one map, as enter/leave deltas.
+ */
+
+#ifndef DARKEMU_VIEWPORT_H
+#define DARKEMU_VIEWPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "GameServer/SpatialGrid.h"
+
+/**
+ * Viewports of the players on one map, kept up to date from movement instead
+ * of being recomputed every tick.
+ *
+ * Visibility is decided per grid cell: a player sees everyone in the cells
+ * within kRadiusCells of its own cell (5x5 cells, 40x40 tiles), which is
+ * symmetric and only changes when somebody crosses a cell boundary. Steps
+ * inside a cell therefore cost one slot update; only entities that crossed a
+ * cell (or entered the map) since the last update() get their visible set
+ * recomputed and diffed against the previous one. Each resulting enter or
+ * leave is applied to both sides, so the other players never rescan.
+ *
+ * update() hands every player with changes its enters and leaves at once, so
+ * the caller sends one batch of create and destroy packets per recipient.
+ */
+class ViewportTracker {
+public:
+    /// Cells around a player's own cell that it sees, in each direction.
+    static constexpr uint32_t kRadiusCells = 2;
+
+    /// Place an entity on the map; its viewport is filled at the next update().
+    void add(uint32_t entity, uint8_t x, uint8_t y);
+    /// Move an entity; crossing a cell schedules its viewport for the next update().
+    void move(uint32_t entity, uint8_t x, uint8_t y);
+    /// Take an entity off the map: it leaves every viewport it was in, and its own pending changes are dropped.
+    void remove(uint32_t entity);
+
+    /**
+     * Recompute the viewports that cell crossings invalidated, then call
+     * sink(recipient, enters, leaves) once per entity whose viewport changed.
+     * The spans stay valid during the call only.
+     */
+    template <typename Sink>
+    void update(Sink&& sink) {
+        computeDeltas();
+        for (uint32_t entity : recipients_) {
+            Viewer* viewer = find(entity);
+            if (viewer == nullptr || !viewer->queued) {
+                continue;
+            }
+            viewer->queued = false;
+            sink(entity, std::span<const uint32_t>(viewer->enter), std::span<const uint32_t>(viewer->leave));
+            viewer->enter.clear();
+            viewer->leave.clear();
+        }
+        recipients_.clear();
+    }
+
+    /// Entities currently in an entity's viewport, sorted (empty when it is not on the map).
+    std::span<const uint32_t> visible(uint32_t entity) const noexcept;
+    /// Positions of the entities on the map, for range queries (combat, AI).
+    const SpatialGrid& grid() const noexcept {
+        return grid_;
+    }
+
+private:
+    static constexpr uint32_t kNoViewer = 0xFFFFFFFF;
+
+    /// Viewport state of one entity on the map.
+    struct Viewer {
+        uint32_t entity{0};
+        std::vector<uint32_t> visible; ///< Sorted.
+        std::vector<uint32_t> enter;   ///< Entered since the last update() (not yet sent).
+        std::vector<uint32_t> leave;   ///< Left since the last update() (not yet sent).
+        bool moved{false};             ///< Listed in moved_.
+        bool queued{false};            ///< Listed in recipients_.
+    };
+
+    Viewer* find(uint32_t entity) noexcept;
+    /// Recompute the viewport of every entity in moved_ and queue the differences on both sides.
+    void computeDeltas();
+    /// Queue "entity entered" for viewer, cancelling a pending leave of the same entity.
+    void queueEnter(Viewer& viewer, uint32_t entity);
+    /// Queue "entity left" for viewer, cancelling a pending enter of the same entity.
+    void queueLeave(Viewer& viewer, uint32_t entity);
+    /// Schedule a viewer's viewport for recomputation.
+    void markMoved(Viewer& viewer);
+
+    SpatialGrid grid_;
+    std::vector<Viewer> viewers_;       ///< Dense; swap-removed.
+    std::vector<uint32_t> slots_;       ///< Entity id to viewers_ index (kNoViewer when absent).
+    std::vector<uint32_t> moved_;       ///< Entities that crossed a cell since the last update().
+    std::vector<uint32_t> recipients_;  ///< Entities with queued enters or leaves.
+    std::vector<uint32_t> scratch_;     ///< New visible set while diffing.
+};
+
+#endif // DARKEMU_VIEWPORT_H
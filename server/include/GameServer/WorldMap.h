@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) DarkEmu
+ * World maps: ids, names and spawn tiles.
+ */
+
+#ifndef DARKEMU_WORLDMAP_H
+#define DARKEMU_WORLDMAP_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/// Map ids as the client numbers them.
+enum class WorldMap : uint8_t {
+    Lorencia = 0,
+    Dungeon = 1,
+    Devias = 2,
+    Noria = 3,
+    LostTower = 4,
+};
+
+/// Static data of one map.
+struct WorldMapInfo {
+    std::string_view name;
+    uint8_t spawn_x; ///< Tile a warp lands on.
+    uint8_t spawn_y;
+};
+
+/// Maps the server knows, indexed by map id.
+inline constexpr std::array<WorldMapInfo, 5> kWorldMaps{{
+    {"Lorencia", 135, 128},
+    {"Dungeon", 108, 247},
+    {"Devias", 215, 45},
+    {"Noria", 175, 112},
+    {"Lost Tower", 208, 75},
+}};
+
+/// True when map is a valid map id.
+constexpr bool isWorldMap(uint8_t map) noexcept {
+    return map < kWorldMaps.size();
+}
+
+#endif // DARKEMU_WORLDMAP_H
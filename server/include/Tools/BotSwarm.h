@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) DarkEmu
+ * Simulated-player bot swarm for GameServer capacity testing.
+ */
+
+#ifndef DARKEMU_BOTSWARM_H
+#define DARKEMU_BOTSWARM_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/Crypto/SimpleModulus.h"
+#include "Common/Crypto/Xor32.h"
+#include "Common/Network/EpollContext.h"
+#include "Common/Network/Socket.h"
+#include "Tools/ClientEngine.h"
+#include "Tools/LatencyHistogram.h"
+
+/// In-game actions a bot sends once it has joined.
+enum class BotAction : uint8_t {
+    Walk,   ///< C1 D4 move request.
+    Attack, ///< C1 11 melee attack on a target index.
+    Chat,   ///< C1 00 public chat message.
+    Item,   ///< C1 22 item pick-up request.
+    Count,
+};
+
+/// Per-bot send rates in packets per second (Poisson arrivals per action).
+struct BotMix {
+    std::array<double, static_cast<size_t>(BotAction::Count)> rate_hz{4.0, 1.0, 0.1, 0.2};
+};
+
+/// Swarm-wide configuration.
+struct SwarmProfile {
+    uint32_t address{0x7F000001};             ///< GameServer IPv4 address in host byte order.
+    uint16_t port{55901};                     ///< GameServer TCP port.
+    double connect_rate{1000.0};              ///< New bots per second while growing the swarm.
+    BotMix mix;                               ///< Traffic generated by every joined bot.
+    std::chrono::milliseconds timeout{2000};  ///< Connect and join-result timeout.
+    std::chrono::milliseconds probe_interval{20}; ///< Gap between latency probe connections.
+    bool reset_on_close{false};               ///< Close with RST to avoid TIME_WAIT buildup.
+    uint32_t seed{1};                         ///< PRNG seed for reproducible traffic.
+};
+
+/// Results of one measurement window.
+struct SwarmStepStats {
+    size_t bots{0};             ///< Bots joined at the end of the window.
+    uint64_t joined{0};         ///< Bots that received the join result during the window.
+    uint64_t frames_sent{0};    ///< In-game frames written.
+    uint64_t frames_skipped{0}; ///< Frames not sent because the bot's send queue was full.
+    uint64_t bytes_sent{0};
+    std::array<uint64_t, static_cast<size_t>(BotAction::Count)> frames_by_action{};
+    std::array<uint64_t, static_cast<size_t>(LoadError::Count)> errors{};
+    LatencyHistogram join_us;   ///< Connect start to join result for bots added in this window.
+    LatencyHistogram probe_us;  ///< Connect start to join result for probe connections.
+    uint64_t send_backlog_us{0}; ///< Worst lag between a scheduled send and the actual write.
+    std::chrono::nanoseconds elapsed{0};
+
+    /// Sum of all error classes.
+    uint64_t totalErrors() const noexcept;
+    /// Offered in-game load in bytes per second.
+    double offeredBytesPerSec() const noexcept;
+};
+
+/**
+ * Single-threaded epoll engine holding thousands of long-lived bot connections.
+ * Bots connect, wait for the GameServer join result, log in (C3), select a
+ * character, then send a walk/attack/chat/item mix on a timer heap. The
+ * GameServer does not answer in-game packets yet, so server response latency
+ * is sampled with probe connections: a probe's time to join result is the
+ * reactor's queueing delay under the current load.
+ */
+class BotSwarm {
+public:
+    explicit BotSwarm(SwarmProfile profile);
+
+    /**
+     * Grow the swarm to bots joined players, then generate traffic for window.
+     * Bots are never removed, so successive calls form a ramp.
+     */
+    SwarmStepStats runStep(size_t bots, std::chrono::milliseconds window);
+
+    /// Bots currently joined and playing.
+    size_t playing() const noexcept {
+        return playing_;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase : uint8_t { Connecting, Joining, Playing };
+
+    struct Bot {
+        uint64_t id{0};              ///< Unique id; timers of a closed bot never fire on a reused fd.
+        Socket socket;
+        Phase phase{Phase::Connecting};
+        bool probe{false};           ///< Latency probe: closed right after the join result.
+        Clock::time_point started;   ///< Connect start (latency origin).
+        uint16_t index{0};           ///< Player index from the join result.
+        std::vector<uint8_t> inbound;
+        std::vector<uint8_t> outbound; ///< Frames not yet accepted by the kernel.
+    };
+
+    /// One scheduled send.
+    struct Timer {
+        Clock::time_point due;
+        uint64_t id;
+        int fd;
+        BotAction action;
+        bool operator>(const Timer& other) const noexcept {
+            return due > other.due;
+        }
+    };
+
+    /// Start a connection; probes close after their join result.
+    void connect(bool probe);
+    /// Dispatch one epoll event.
+    void handleEvent(const epoll_event& event);
+    /// Read the join result and discard anything else the server sends.
+    void handleReadable(int fd, Bot& bot);
+    /// Write a frame (queueing on EAGAIN); false when the bot was dropped.
+    bool write(int fd, Bot& bot, const std::vector<uint8_t>& frame);
+    /// Send login, character list and character select back to back; false when the bot was dropped.
+    bool enterWorld(int fd, Bot& bot);
+    /// Build the frame for an action.
+    std::vector<uint8_t> buildFrame(BotAction action, const Bot& bot);
+    /// Queue the next send of an action after an exponential gap.
+    void schedule(int fd, const Bot& bot, BotAction action, Clock::time_point from);
+    /// Fire every timer that is due; with send false the timers are only rescheduled.
+    void fireTimers(Clock::time_point now, bool send);
+    /// Drop bots stuck before the join result.
+    void sweep(Clock::time_point now);
+    /// Close a bot and record an error class (LoadError::Count for none).
+    void drop(int fd, LoadError error);
+
+    SwarmProfile profile_;
+    EpollContext epoll_;
+    std::vector<epoll_event> events_;
+    std::unordered_map<int, Bot> bots_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    std::mt19937 rng_;
+    Xor32 xor_;
+    SimpleModulus encryptor_{SimpleModulusKeys::clientToServer()};
+    uint64_t next_id_{1};
+    size_t playing_{0};
+    size_t pending_{0};  ///< Non-probe bots connecting or joining.
+    SwarmStepStats* step_{nullptr};
+};
+
+#endif // DARKEMU_BOTSWARM_H
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) DarkEmu
+ * Epoll-driven open-loop client engine for load generation.
+ */
+
+#ifndef DARKEMU_CLIENTENGINE_H
+#define DARKEMU_CLIENTENGINE_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/Network/EpollContext.h"
+#include "Common/Network/Socket.h"
+#include "Tools/LatencyHistogram.h"
+
+/// Failure classes reported by the load generator.
+enum class LoadError : uint8_t {
+    ConnectRefused,  ///< Connection refused by the target (backlog full or server down).
+    ConnectTimeout,  ///< Handshake did not complete within the timeout.
+    ConnectFailed,   ///< Any other connect error.
+    SocketLimit,     ///< Arrival dropped: descriptor limit or max-concurrent cap reached.
+    Reset,           ///< Connection reset by the peer.
+    PeerClosed,      ///< Peer closed before the session finished.
+    ResponseTimeout, ///< No complete reply within the timeout.
+    BadFrame,        ///< Reply did not start with a valid C1-C4 header.
+    UnexpectedReply, ///< Reply differed from the expected bytes.
+    Count,
+};
+
+/// Stable snake_case name for a LoadError.
+const char* loadErrorName(LoadError error) noexcept;
+
+/**
+ * What every simulated client does once connected.
+ * A session connects, sends request requests_per_session times (waiting for
+ * one reply frame per request when expect_reply is set), keeps the
+ * connection open for hold, then closes.
+ */
+struct LoadProfile {
+    uint32_t address{0x7F000001};           ///< Target IPv4 address in host byte order.
+    uint16_t port{44405};                   ///< Target TCP port.
+    double rate{100.0};                     ///< New sessions per second (open loop).
+    std::chrono::milliseconds duration{1000}; ///< Arrival window; in-flight sessions then drain.
+    std::vector<uint8_t> request;           ///< Bytes sent per request (may hold several frames).
+    bool expect_reply{true};                ///< Wait for one reply frame per request.
+    std::vector<uint8_t> expected_reply;    ///< Exact reply to verify; empty accepts any valid frame.
+    int requests_per_session{1};            ///< Requests sent on each connection.
+    std::chrono::milliseconds hold{0};      ///< Idle time before closing a finished session.
+    std::chrono::milliseconds timeout{2000}; ///< Connect and per-reply timeout.
+    size_t max_concurrent{100000};          ///< Open sessions cap; further arrivals count as SocketLimit.
+    bool reset_on_close{false};             ///< Close with RST to avoid TIME_WAIT at high connect rates.
+};
+
+/// Aggregated results of one or more engine runs.
+struct LoadStats {
+    uint64_t started{0};        ///< Sessions launched.
+    uint64_t connected{0};      ///< Successful TCP handshakes.
+    uint64_t completed{0};      ///< Sessions that finished every request without error.
+    uint64_t requests{0};       ///< Requests written.
+    uint64_t responses{0};      ///< Reply frames received.
+    uint64_t bytes_sent{0};
+    uint64_t bytes_received{0};
+    size_t peak_concurrent{0};  ///< Largest number of simultaneously open sessions.
+    std::chrono::nanoseconds elapsed{0};
+    std::array<uint64_t, static_cast<size_t>(LoadError::Count)> errors{};
+    LatencyHistogram connect_us;  ///< Scheduled arrival to established, in microseconds.
+    LatencyHistogram response_us; ///< Request write to complete reply, in microseconds.
+
+    /// Combine results from another engine (per-thread merge).
+    void merge(const LoadStats& other);
+    /// Sum of all error classes.
+    uint64_t totalErrors() const noexcept;
+    /// Human-readable summary.
+    void print(std::ostream& out) const;
+    /// Machine-readable summary with a fixed key order.
+    void writeJson(std::ostream& out) const;
+};
+
+/**
+ * Single-threaded epoll client engine.
+ * Arrivals follow the configured rate regardless of how many sessions are
+ * still in flight (open loop), and connect latency is measured from the
+ * scheduled arrival time, so a stalling server shows up as latency instead
+ * of silently lowering the offered load. Run one engine per thread.
+ */
+class ClientEngine {
+public:
+    explicit ClientEngine(LoadProfile profile);
+
+    /// Run the arrival window, drain in-flight sessions and return the results.
+    LoadStats run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Per-connection progress.
+    enum class Phase : uint8_t { Connecting, Awaiting, Holding };
+
+    struct Session {
+        Socket socket;
+        Phase phase{Phase::Connecting};
+        Clock::time_point scheduled;   ///< Arrival time the session was due.
+        Clock::time_point sent_at;     ///< When the outstanding request was written.
+        Clock::time_point deadline;    ///< Timeout (or end of hold).
+        int remaining{0};              ///< Requests still to send.
+        std::vector<uint8_t> inbound;  ///< Partial reply bytes.
+        std::vector<uint8_t> outbound; ///< Unsent request bytes after EAGAIN.
+        size_t out_offset{0};
+    };
+
+    /// Open a non-blocking connection for an arrival due at scheduled.
+    void launch(Clock::time_point scheduled);
+    /// Dispatch one epoll event.
+    void handleEvent(const epoll_event& event);
+    /// Finish the handshake once the socket becomes writable.
+    void handleConnected(int fd, Session& session);
+    /// Read replies and advance the session.
+    void handleReadable(int fd, Session& session);
+    /// Write the next request, or move to the hold phase when none remain.
+    void sendNext(int fd, Session& session);
+    /// Flush queued request bytes; false on a fatal write error.
+    bool flush(int fd, Session& session);
+    /// Close sessions whose deadline passed.
+    void sweep(Clock::time_point now);
+    /// Close a session, recording an error unless it finished cleanly.
+    void finish(int fd, bool ok, LoadError error = LoadError::Count);
+
+    LoadProfile profile_;
+    EpollContext epoll_;
+    std::vector<epoll_event> events_;
+    std::unordered_map<int, Session> sessions_;
+    LoadStats stats_;
+};
+
+#endif // DARKEMU_CLIENTENGINE_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) DarkEmu
+ * Log-linear latency histogram for load-generation tools.
+ */
+
+#ifndef DARKEMU_LATENCYHISTOGRAM_H
+#define DARKEMU_LATENCYHISTOGRAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Microseconds between two time points, clamped at zero; the unit the tools record latencies in.
+inline uint64_t microsBetween(std::chrono::steady_clock::time_point from,
+                              std::chrono::steady_clock::time_point to) noexcept {
+    if (to <= from) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+/**
+ * Single-threaded histogram with ~3% relative bucket width at every scale.
+ * Values below 64 are exact; above that each power of two is split into 32
+ * sub-buckets, which keeps p999 meaningful where power-of-two buckets
+ * (see Common/Utils/Metrics.h) would be off by up to 2x. One instance per
+ * client thread, merged at the end of a run.
+ */
+class LatencyHistogram {
+public:
+    /// Sub-bucket resolution: 2^kSubBits buckets per power of two.
+    static constexpr unsigned kSubBits = 5;
+    /// Total bucket count covering the full uint64_t range.
+    static constexpr size_t kBuckets = (64 - kSubBits - 1) * (size_t{1} << kSubBits) + (size_t{2} << kSubBits);
+
+    LatencyHistogram();
+
+    /// Record one value (typically microseconds).
+    void record(uint64_t value) noexcept;
+    /// Add all observations from another histogram.
+    void merge(const LatencyHistogram& other) noexcept;
+
+    /// Number of recorded values.
+    uint64_t count() const noexcept {
+        return count_;
+    }
+    /// Largest recorded value.
+    uint64_t max() const noexcept {
+        return max_;
+    }
+    /// Arithmetic mean of recorded values (0 when empty).
+    double mean() const noexcept;
+    /**
+     * Value at quantile q in [0, 1].
+     * Reports the upper edge of the containing bucket, clamped to max().
+     */
+    uint64_t percentile(double q) const noexcept;
+
+private:
+    /// Bucket index for a value.
+    static size_t indexOf(uint64_t value) noexcept;
+    /// Largest value that maps to a bucket.
+    static uint64_t upperBound(size_t index) noexcept;
+
+    std::vector<uint64_t> buckets_;
+    uint64_t count_{0};
+    uint64_t max_{0};
+    long double sum_{0};
+};
+
+#endif // DARKEMU_LATENCYHISTOGRAM_H
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) DarkEmu
+ * Replays captured client sessions against a test server.
+ */
+
+#ifndef DARKEMU_REPLAYENGINE_H
+#define DARKEMU_REPLAYENGINE_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/Network/EpollContext.h"
+#include "Common/Network/SessionRecorder.h"
+#include "Common/Network/Socket.h"
+#include "Tools/ClientEngine.h"
+#include "Tools/LatencyHistogram.h"
+
+/// One captured client frame, timed relative to its session's connect.
+struct ReplayFrame {
+    uint64_t offset_us{0};
+    std::vector<uint8_t> bytes;
+};
+
+/// A captured session, ready to replay.
+struct ReplaySession {
+    uint32_t id{0};                  ///< Capture session id.
+    uint64_t open_us{0};             ///< Connect time relative to the first captured session.
+    uint64_t close_offset_us{0};     ///< Close time relative to connect.
+    bool server_first{false};        ///< The server spoke before the client (wait for it on replay).
+    std::vector<ReplayFrame> frames; ///< Client frames in capture order.
+};
+
+/**
+ * Group capture records into sessions ordered by connect time.
+ * Sessions without a Close record end at their last frame.
+ */
+std::vector<ReplaySession> buildReplaySessions(const std::vector<CaptureRecord>& records);
+
+/// Replay configuration.
+struct ReplayProfile {
+    uint32_t address{0x7F000001};            ///< Target IPv4 address in host byte order.
+    uint16_t port{0};                        ///< Target TCP port.
+    double speed{1.0};                       ///< Time scale (2 = twice as fast); 0 replays at max speed.
+    size_t copies{1};                        ///< Parallel copies of every captured session.
+    size_t max_concurrent{1000};             ///< Open-connection cap in max-speed mode.
+    std::chrono::milliseconds timeout{2000}; ///< Connect and server-first timeout.
+    std::chrono::milliseconds linger{20};    ///< Wait after the last frame in max-speed mode.
+    bool reset_on_close{false};              ///< Close with RST to avoid TIME_WAIT buildup.
+};
+
+/// Results of a replay run.
+struct ReplayStats {
+    uint64_t sessions{0};        ///< Session copies started.
+    uint64_t completed{0};       ///< Copies that sent every frame without error.
+    uint64_t frames_sent{0};
+    uint64_t bytes_sent{0};
+    uint64_t bytes_received{0};
+    std::chrono::nanoseconds elapsed{0};
+    std::array<uint64_t, static_cast<size_t>(LoadError::Count)> errors{};
+    LatencyHistogram connect_us;  ///< Scheduled start to established.
+    LatencyHistogram response_us; ///< Frame written to the next server bytes (when the server answered).
+    LatencyHistogram lag_us;      ///< How late frames left relative to their scaled capture time.
+
+    /// Combine results from another worker thread.
+    void merge(const ReplayStats& other);
+    /// Sum of all error classes.
+    uint64_t totalErrors() const noexcept;
+    /// Human-readable summary.
+    void print(std::ostream& out) const;
+    /// Machine-readable summary with a fixed key order (input for --baseline).
+    void writeJson(std::ostream& out) const;
+};
+
+/**
+ * Single-threaded epoll replayer.
+ * Worker w of n replays every session copy whose index is w modulo n, so
+ * several engines on separate threads split one capture without overlap.
+ */
+class ReplayEngine {
+public:
+    ReplayEngine(ReplayProfile profile, const std::vector<ReplaySession>& sessions, size_t worker = 0,
+                 size_t workers = 1);
+
+    /// Replay every assigned session copy and return the results.
+    ReplayStats run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase : uint8_t { Connecting, WaitingServer, Sending, Lingering };
+
+    /// One live session copy.
+    struct Conn {
+        uint64_t id{0};
+        const ReplaySession* session{nullptr};
+        Socket socket;
+        Phase phase{Phase::Connecting};
+        Clock::time_point base;       ///< Scheduled connect time; frame times are relative to it.
+        Clock::time_point deadline;   ///< Connect/server-first timeout or end of linger.
+        Clock::time_point sent_at;    ///< Last frame write, for response latency.
+        bool awaiting{false};         ///< A frame was written and no server bytes arrived since.
+        size_t next_frame{0};
+        std::vector<uint8_t> outbound;
+    };
+
+    /// Frame or close deadline for a connection.
+    struct Timer {
+        Clock::time_point due;
+        uint64_t id;
+        int fd;
+        bool operator>(const Timer& other) const noexcept {
+            return due > other.due;
+        }
+    };
+
+    /// Start a session copy scheduled at base.
+    void startSession(const ReplaySession& session, Clock::time_point base);
+    /// Dispatch one epoll event.
+    void handleEvent(const epoll_event& event);
+    /// Begin sending once connected (and greeted, for server-first sessions).
+    void beginSending(int fd, Conn& conn);
+    /// Send every frame that is due; schedules the next one or the close.
+    void pump(int fd, Conn& conn, Clock::time_point now);
+    /// Write bytes, queueing on EAGAIN; false when the connection was dropped.
+    bool write(int fd, Conn& conn, const std::vector<uint8_t>& bytes);
+    /// Scaled due time of a frame offset.
+    Clock::time_point dueAt(const Conn& conn, uint64_t offset_us) const;
+    /// Fire due timers and expire stuck connections.
+    void fireTimers(Clock::time_point now);
+    void sweep(Clock::time_point now);
+    /// Close a connection; LoadError::Count marks a clean finish.
+    void finish(int fd, LoadError error);
+
+    ReplayProfile profile_;
+    std::vector<std::pair<const ReplaySession*, size_t>> assigned_; ///< (session, copy) in start order.
+    EpollContext epoll_;
+    std::vector<epoll_event> events_;
+    std::unordered_map<int, Conn> conns_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t next_id_{1};
+    ReplayStats stats_;
+};
+
+#endif // DARKEMU_REPLAYENGINE_H
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) DarkEmu
+ * Global allocation counter for benchmarks and allocation regression tests.
+ */
+
+#ifndef DARKEMU_ALLOCATIONCOUNTER_H
+#define DARKEMU_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+/**
+ * Counts every call to the replaceable global operator new in this process.
+ * Linking AllocationCounter.cpp into an executable installs the hook; the
+ * counter is process-wide, so measure on a quiet thread.
+ */
+namespace AllocationCounter {
+    /// Number of global operator new calls since process start.
+    uint64_t allocations() noexcept;
+    /// Total bytes requested from global operator new since process start.
+    uint64_t bytes() noexcept;
+}
+
+#endif // DARKEMU_ALLOCATIONCOUNTER_H
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) DarkEmu
+ * Minimal in-tree microbenchmark harness with stable JSON output.
+ */
+
+#ifndef DARKEMU_BENCHHARNESS_H
+#define DARKEMU_BENCHHARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "AllocationCounter.h"
+
+/// Keep a value observable so the optimizer cannot delete the benchmarked work.
+template <typename T>
+inline void doNotOptimize(T& value) {
+    asm volatile("" : "+m"(value) : : "memory");
+}
+
+/// Result of one benchmark case.
+struct BenchResult {
+    std::string name;          ///< Stable case identifier, e.g. "serverlist.get_packet".
+    uint64_t iterations{0};    ///< Operations in the best timed round.
+    double ns_per_op{0.0};     ///< Best (minimum) nanoseconds per operation over all rounds.
+    double allocs_per_op{0.0}; ///< Global operator new calls per operation.
+    double ops_per_sec{0.0};   ///< Throughput derived from ns_per_op.
+    double bytes_per_sec{0.0}; ///< Payload throughput when the case declares bytes per op.
+};
+
+/**
+ * Runs benchmark cases for a minimum wall time each.
+ * A case is a callable taking an iteration count and performing that many
+ * operations; the harness calibrates the count, runs three timed rounds and
+ * keeps the fastest, which is the most repeatable figure on a shared box.
+ */
+class BenchRunner {
+public:
+    /// Timed rounds per case; the minimum is reported.
+    static constexpr int kRounds = 3;
+
+    BenchRunner(std::chrono::milliseconds minTime, std::string filter) :
+        min_time_(minTime), filter_(std::move(filter)) {}
+
+    /**
+     * Run one case unless it is filtered out.
+     * @param name Stable identifier used in JSON output and comparisons.
+     * @param fn Callable invoked as fn(iterations).
+     * @param bytesPerOp Payload bytes processed per operation (0 to omit).
+     */
+    template <typename Fn>
+    void run(const std::string& name, Fn&& fn, uint64_t bytesPerOp = 0) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+            return;
+        }
+
+        // Warm caches and lazy allocations, then calibrate to ~1/8 of the budget.
+        fn(uint64_t{16});
+        uint64_t iterations = 1;
+        double elapsed_ns = 0.0;
+        while (true) {
+            elapsed_ns = timeRound(fn, iterations);
+            if (elapsed_ns * 8.0 >= static_cast<double>(toNs(min_time_)) || iterations >= (uint64_t{1} << 40)) {
+                break;
+            }
+            iterations *= 2;
+        }
+        const double per_round_ns = static_cast<double>(toNs(min_time_)) / kRounds;
+        const auto round_iterations = std::max<uint64_t>(
+                1, static_cast<uint64_t>(static_cast<double>(iterations) * per_round_ns / std::max(elapsed_ns, 1.0)));
+
+        BenchResult result;
+        result.name = name;
+        result.iterations = round_iterations;
+        result.ns_per_op = 1e300;
+        for (int round = 0; round < kRounds; ++round) {
+            const uint64_t allocs_before = AllocationCounter::allocations();
+            const double round_ns = timeRound(fn, round_iterations);
+            const uint64_t allocs = AllocationCounter::allocations() - allocs_before;
+            result.ns_per_op = std::min(result.ns_per_op, round_ns / static_cast<double>(round_iterations));
+            if (round == 0) {
+                result.allocs_per_op = static_cast<double>(allocs) / static_cast<double>(round_iterations);
+            }
+        }
+        result.ops_per_sec = result.ns_per_op > 0.0 ? 1e9 / result.ns_per_op : 0.0;
+        result.bytes_per_sec = static_cast<double>(bytesPerOp) * result.ops_per_sec;
+        results_.push_back(std::move(result));
+    }
+
+    /// Results in execution order.
+    const std::vector<BenchResult>& results() const noexcept {
+        return results_;
+    }
+
+    /// Write results as JSON with a fixed key order and precision.
+    void writeJson(std::ostream& out) const {
+        out << std::fixed;
+        out << "{\n  \"schema\": 1,\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const BenchResult& r = results_[i];
+            out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"ns_per_op\": " << std::setprecision(2) << r.ns_per_op
+                << ", \"allocs_per_op\": " << std::setprecision(3) << r.allocs_per_op
+                << ", \"ops_per_sec\": " << std::setprecision(0) << r.ops_per_sec
+                << ", \"bytes_per_sec\": " << std::setprecision(0) << r.bytes_per_sec << '}'
+                << (i + 1 < results_.size() ? "," : "") << '\n';
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    template <typename Rep, typename Period>
+    static int64_t toNs(std::chrono::duration<Rep, Period> d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+    /// Time fn(iterations) in nanoseconds.
+    template <typename Fn>
+    static double timeRound(Fn& fn, uint64_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        fn(iterations);
+        return static_cast<double>(toNs(std::chrono::steady_clock::now() - start));
+    }
+
+    std::chrono::milliseconds min_time_;
+    std::string filter_;
+    std::vector<BenchResult> results_;
+};
+
+#endif // DARKEMU_BENCHHARNESS_H
@@ -0,0 +1,1189 @@
+/*
+ * Copyright (c) DarkEmu
+ * Microbenchmarks for protocol, server-list and GameServer hot paths.
+ */
+
+#include "BenchHarness.h"
+
+#include "Common/Crypto/SimpleModulus.h"
+#include "Common/Crypto/Xor32.h"
+#include "Common/Network/AsyncIo.h"
+#include "Common/Network/EpollContext.h"
+#include "Common/Network/Outbox.h"
+#include "Common/Network/PacketFramer.h"
+#include "Common/Network/Socket.h"
+#include "Common/Utils/JobSystem.h"
+#include "ConnectServer/Managers/ServerListManager.h"
+#include "ConnectServer/Packets/PacketHandler.h"
+#include "GameServer/EntityStore.h"
+#include "GameServer/GamePackets.h"
+#include "GameServer/GameServer.h"
+#include "GameServer/MonsterAi.h"
+#include "GameServer/SpatialGrid.h"
+#include "GameServer/Viewport.h"
+
+#include "common/Utils/json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// GameServer packets of the Season 6 client.
+using Packets = GamePackets<Season6Protocol>;
+
+// Command-line options.
+struct Options {
+    std::chrono::milliseconds min_time{300};
+    std::string filter;
+    std::string out_path;
+    std::string compare_path;
+};
+
+// Parse --min-time-ms, --filter, --out and --compare.
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--min-time-ms") {
+            options.min_time = std::chrono::milliseconds(std::stoul(next()));
+        } else if (arg == "--filter") {
+            options.filter = next();
+        } else if (arg == "--out") {
+            options.out_path = next();
+        } else if (arg == "--compare") {
+            options.compare_path = next();
+        } else {
+            throw std::runtime_error("unknown option " + arg +
+                                     " (usage: DarkEmu_Bench [--min-time-ms N] [--filter S] [--out F] [--compare F])");
+        }
+    }
+    return options;
+}
+
+// Read exactly size bytes from a blocking descriptor.
+void readExact(int fd, uint8_t* data, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        ssize_t received = ::recv(fd, data + offset, size - offset, 0);
+        if (received <= 0) {
+            throw std::runtime_error("socketpair read failed");
+        }
+        offset += static_cast<size_t>(received);
+    }
+}
+
+// Server list request and lookup cases.
+void benchServerList(BenchRunner& runner) {
+    ServerListManager* manager = ServerListManager::Instance();
+
+    // Reused buffer: steady-state serialization cost.
+    std::vector<uint8_t> buffer;
+    runner.run("serverlist.get_packet", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            manager->GetPacket(buffer);
+            doNotOptimize(buffer);
+        }
+    });
+
+    // Fresh buffer per call, as a naive response builder would do.
+    runner.run("serverlist.get_packet_fresh_buffer", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            std::vector<uint8_t> fresh;
+            manager->GetPacket(fresh);
+            doNotOptimize(fresh);
+        }
+    });
+
+    // Alternate hits and a miss across the seeded codes.
+    constexpr std::array<uint16_t, 4> codes{0, 20, 7, 21};
+    runner.run("serverlist.find_by_code", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            const GameServerInfo* info = manager->FindByCode(codes[i & 3]);
+            doNotOptimize(info);
+        }
+    });
+}
+
+// Full request handling against a connected socketpair.
+void benchPacketHandler(BenchRunner& runner) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+        throw std::runtime_error("socketpair failed");
+    }
+    Socket server(fds[0]);
+    const int client_fd = fds[1];
+
+    std::vector<uint8_t> expected;
+    ServerListManager::Instance()->GetPacket(expected);
+    std::vector<uint8_t> reply(expected.size());
+    const std::array<uint8_t, 4> list_request{0xC1, 0x04, 0xF4, 0x06};
+    runner.run("packet_handler.server_list", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            PacketHandler::Instance()->HandlePacket(server, list_request);
+            readExact(client_fd, reply.data(), reply.size());
+        }
+    });
+
+    const std::array<uint8_t, 6> info_request{0xC1, 0x06, 0xF4, 0x03, 0x14, 0x00};
+    std::array<uint8_t, 22> info_reply{};
+    runner.run("packet_handler.server_info", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            PacketHandler::Instance()->HandlePacket(server, info_request);
+            readExact(client_fd, info_reply.data(), info_reply.size());
+        }
+    });
+
+    ::close(client_fd);
+}
+
+// Frame splitting over a realistic mix of small C1 and larger C2/C3 frames.
+void benchFraming(BenchRunner& runner) {
+    std::vector<uint8_t> stream;
+    while (stream.size() < 4096) {
+        // C1 walk-sized frame.
+        const std::array<uint8_t, 8> walk{0xC1, 0x08, 0xD4, 0x80, 0x80, 0x01, 0x23, 0x00};
+        stream.insert(stream.end(), walk.begin(), walk.end());
+        // C3 encrypted frame (body contents are irrelevant for framing).
+        stream.push_back(0xC3);
+        stream.push_back(0x0D);
+        stream.insert(stream.end(), 11, 0x5A);
+        // C2 frame with a 40-byte body.
+        stream.push_back(0xC2);
+        stream.push_back(0x00);
+        stream.push_back(0x2B);
+        stream.insert(stream.end(), 40, 0x11);
+    }
+
+    runner.run("framer.for_each_frame_4k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            size_t frames = 0;
+            bool invalid = false;
+            const size_t consumed = PacketFramer::forEachFrame(stream, [&](std::span<const uint8_t>) {
+                ++frames;
+            }, invalid);
+            doNotOptimize(frames);
+            if (invalid || consumed != stream.size()) {
+                throw std::runtime_error("framer rejected benchmark stream");
+            }
+        }
+    }, stream.size());
+}
+
+// EpollContext wait/dispatch round-trip on an eventfd.
+void benchEpoll(BenchRunner& runner) {
+    EpollContext epoll;
+    int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd == -1) {
+        throw std::runtime_error("eventfd failed");
+    }
+    epoll.add(efd, EPOLLIN);
+    std::array<epoll_event, 8> events{};
+
+    runner.run("epoll.eventfd_round_trip", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            uint64_t one = 1;
+            if (::write(efd, &one, sizeof(one)) != sizeof(one)) {
+                throw std::runtime_error("eventfd write failed");
+            }
+            if (epoll.wait(events, 0) != 1) {
+                throw std::runtime_error("eventfd not ready");
+            }
+            uint64_t value = 0;
+            if (::read(efd, &value, sizeof(value)) != sizeof(value)) {
+                throw std::runtime_error("eventfd read failed");
+            }
+        }
+    });
+
+    // Empty poll: the fixed cost of one epoll_wait syscall.
+    runner.run("epoll.wait_empty", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            int ready = epoll.wait(events, 0);
+            doNotOptimize(ready);
+        }
+    });
+
+    ::close(efd);
+}
+
+// SimpleModulus bulk encrypt/decrypt of 4 KiB per kernel the CPU supports.
+void benchSimpleModulus(BenchRunner& runner) {
+    std::vector<uint8_t> plain(4096);
+    for (size_t i = 0; i < plain.size(); ++i) {
+        plain[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    std::vector<uint8_t> cipher(SimpleModulus::encryptedSize(plain.size()));
+    std::vector<uint8_t> decrypted(SimpleModulus::decryptedCapacity(cipher.size()));
+
+    for (auto level : {SimpleModulus::SimdLevel::Scalar, SimpleModulus::SimdLevel::Sse41,
+                       SimpleModulus::SimdLevel::Avx2}) {
+        if (level > SimpleModulus::supportedSimdLevel()) {
+            continue;
+        }
+        SimpleModulus codec(SimpleModulusKeys::clientToServer());
+        codec.setSimdLevel(level);
+        const std::string suffix = SimpleModulus::simdLevelName(level);
+        runner.run("simplemodulus.encrypt_4k." + suffix, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                codec.encrypt(cipher, plain);
+                doNotOptimize(cipher);
+            }
+        }, plain.size());
+        runner.run("simplemodulus.decrypt_4k." + suffix, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                size_t size = 0;
+                if (!codec.decrypt(decrypted, cipher, size)) {
+                    throw std::runtime_error("decrypt rejected benchmark data");
+                }
+                doNotOptimize(decrypted);
+            }
+        }, plain.size());
+    }
+}
+
+// XOR32 decode/encode in place over a receive buffer of client-sized C1/C2 frames, per kernel.
+void benchXor32(BenchRunner& runner) {
+    std::vector<uint8_t> stream;
+    for (uint8_t seed = 0; stream.size() < 4096; ++seed) {
+        // Walk, a 40-byte C2 body and a 100-byte C1 (inventory/chat sized).
+        const std::array<uint8_t, 8> walk{0xC1, 0x08, 0xD4, 0x80, 0x80, 0x01, 0x23, seed};
+        stream.insert(stream.end(), walk.begin(), walk.end());
+        stream.insert(stream.end(), {0xC2, 0x00, 0x2B, 0xF3});
+        stream.insert(stream.end(), 39, seed);
+        stream.insert(stream.end(), {0xC1, 0x64, 0x00});
+        stream.insert(stream.end(), 97, static_cast<uint8_t>(seed ^ 0x5A));
+    }
+
+    for (auto level : {Xor32::SimdLevel::Scalar, Xor32::SimdLevel::Sse41, Xor32::SimdLevel::Avx2}) {
+        if (level > SimpleModulus::supportedSimdLevel()) {
+            continue;
+        }
+        Xor32 coder;
+        coder.setSimdLevel(level);
+        const std::string suffix = SimpleModulus::simdLevelName(level);
+        for (const bool decode : {true, false}) {
+            runner.run(std::string("xor32.") + (decode ? "decode" : "encode") + "_stream_4k." + suffix,
+                       [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) {
+                    bool invalid = false;
+                    PacketFramer::forEachFrameInPlace(stream, [&](std::span<uint8_t> frame) {
+                        if (decode) {
+                            coder.decodeFrame(frame);
+                        } else {
+                            coder.encodeFrame(frame);
+                        }
+                    }, invalid);
+                    doNotOptimize(stream);
+                }
+            }, stream.size());
+        }
+    }
+}
+
+// Write every byte to a blocking descriptor.
+void writeAll(int fd, const uint8_t* data, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        const ssize_t sent = ::send(fd, data + offset, size - offset, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            throw std::runtime_error("client send failed");
+        }
+        offset += static_cast<size_t>(sent);
+    }
+}
+
+/**
+ * GameServer wake-ups over loopback: 64 in-game clients each send four rounds of
+ * a C1 walk, an unrouted C1 attack, a C3 walk and a C3 attack, then RunOnce
+ * drains them. One op is one wake-up of 1024 packets, so packets/sec per core
+ * is 1024e9 / ns_per_op (client sends included).
+ */
+void benchGameServer(BenchRunner& runner) {
+    constexpr size_t kClients = 64;
+    GameServer server(0);
+    server.SetHandlerBudget(std::chrono::seconds(10));
+    server.SetRateLimit(GameServer::RateClass::Movement, 0);
+
+    const Xor32 xor32;
+    const SimpleModulus encoder(SimpleModulusKeys::clientToServer());
+    auto encode = [&](std::vector<uint8_t> frame, bool encrypt) {
+        xor32.encodeFrame(frame);
+        if (!encrypt) {
+            return frame;
+        }
+        std::vector<uint8_t> encrypted;
+        encoder.encryptFrame(frame, 0, encrypted);
+        return encrypted;
+    };
+
+    // Every client logs in and enters the world before the timed rounds.
+    Packets::LoginRequest login = makePacket<Packets::LoginRequest>();
+    std::memcpy(login.account, "bench", 5);
+    buxConvert(login.account);
+    Packets::SelectCharacterRequest select = makePacket<Packets::SelectCharacterRequest>();
+    std::memcpy(select.name, "bench", 5);
+    std::vector<uint8_t> setup = encode({packetBytes(login).begin(), packetBytes(login).end()}, false);
+    const std::vector<uint8_t> enter = encode({packetBytes(select).begin(), packetBytes(select).end()}, false);
+    setup.insert(setup.end(), enter.begin(), enter.end());
+
+    std::vector<int> clients;
+    for (size_t i = 0; i < kClients; ++i) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server.Port());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        const int nodelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        if (fd == -1 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            throw std::runtime_error("GameServer connect failed");
+        }
+        clients.push_back(fd);
+        server.RunOnce(0);
+        writeAll(fd, setup.data(), setup.size());
+    }
+    for (int spins = 0; server.PacketsDispatched() < 2 * kClients; ++spins) {
+        if (spins > 100000) {
+            throw std::runtime_error("GameServer did not log the bench clients in");
+        }
+        server.RunOnce(0);
+    }
+    std::array<uint8_t, 256> replies{};
+    for (int fd : clients) {
+        while (::recv(fd, replies.data(), replies.size(), MSG_DONTWAIT) > 0) {
+        }
+    }
+
+    std::vector<uint8_t> burst;
+    const std::vector<uint8_t> walk{0xC1, 0x08, 0xD4, 0x80, 0x80, 0x01, 0x23, 0x00};
+    const std::vector<uint8_t> attack{0xC1, 0x07, 0x11, 0x00, 0x2A, 0x78, 0x03};
+    for (int repeat = 0; repeat < 4; ++repeat) {
+        for (const auto& frame : {encode(walk, false), encode(attack, false), encode(walk, true),
+                                  encode(attack, true)}) {
+            burst.insert(burst.end(), frame.begin(), frame.end());
+        }
+    }
+    // Every client stands at the spawn, so each walk also fans out to the other 63; the clients read those moves
+    // so their sockets never fill.
+    std::array<uint8_t, 4096> moves{};
+    runner.run("gameserver.wakeup_64_clients_x16", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            const size_t target = server.BytesReceived() + kClients * burst.size();
+            for (int fd : clients) {
+                writeAll(fd, burst.data(), burst.size());
+            }
+            while (server.BytesReceived() < target) {
+                server.RunOnce(0);
+            }
+            for (int fd : clients) {
+                while (::recv(fd, moves.data(), moves.size(), MSG_DONTWAIT) > 0) {
+                }
+            }
+        }
+    }, kClients * burst.size());
+
+    for (int fd : clients) {
+        ::close(fd);
+    }
+}
+
+void benchGameServerReplies(BenchRunner& runner) {
+    // 64 logged-in clients each send 16 character-list requests per op and read the 16 replies.
+    constexpr size_t kClients = 64;
+    constexpr size_t kRequests = 16;
+    GameServer server(0);
+    server.SetHandlerBudget(std::chrono::seconds(10));
+    server.SetRateLimit(GameServer::RateClass::Login, 0);
+
+    const Xor32 xor32;
+    Packets::LoginRequest login = makePacket<Packets::LoginRequest>();
+    std::memcpy(login.account, "bench", 5);
+    buxConvert(login.account);
+    std::vector<uint8_t> setup(packetBytes(login).begin(), packetBytes(login).end());
+    xor32.encodeFrame(setup);
+    std::vector<int> clients;
+    for (size_t i = 0; i < kClients; ++i) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server.Port());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd == -1 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            throw std::runtime_error("GameServer connect failed");
+        }
+        clients.push_back(fd);
+        server.RunOnce(0);
+        writeAll(fd, setup.data(), setup.size());
+    }
+    for (int spins = 0; server.PacketsDispatched() < kClients; ++spins) {
+        if (spins > 100000) {
+            throw std::runtime_error("GameServer did not log the bench clients in");
+        }
+        server.RunOnce(0);
+    }
+    std::array<uint8_t, 256> replies{};
+    for (int fd : clients) {
+        while (::recv(fd, replies.data(), replies.size(), MSG_DONTWAIT) > 0) {
+        }
+    }
+
+    std::vector<uint8_t> list{0xC1, 0x04, 0xF3, 0x00};
+    xor32.encodeFrame(list);
+    std::vector<uint8_t> burst;
+    for (size_t i = 0; i < kRequests; ++i) {
+        burst.insert(burst.end(), list.begin(), list.end());
+    }
+    const size_t reply_bytes = kRequests * sizeof(Packets::CharacterListResponse);
+    runner.run("gameserver.replies_64_clients_x16", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            const uint64_t target = server.PacketsDispatched() + kClients * kRequests;
+            for (int fd : clients) {
+                writeAll(fd, burst.data(), burst.size());
+            }
+            while (server.PacketsDispatched() < target) {
+                server.RunOnce(0);
+            }
+            for (int fd : clients) {
+                ::recv(fd, replies.data(), reply_bytes, MSG_WAITALL);
+            }
+        }
+    }, kClients * reply_bytes);
+
+    for (int fd : clients) {
+        ::close(fd);
+    }
+}
+
+void benchFanOut(BenchRunner& runner) {
+    // One 512-byte frame (a long chat line, an effect list) queued for 200 nearby connections.
+    constexpr size_t kRecipients = 200;
+    std::vector<uint8_t> frame(512, 0x5A);
+    frame[0] = 0xC1;
+    frame[1] = 0x00;
+    std::vector<Outbox> outboxes(kRecipients);
+    runner.run("fanout.copy_512b_x200", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            for (Outbox& outbox : outboxes) {
+                outbox.append(std::span<const uint8_t>(frame));
+            }
+            for (Outbox& outbox : outboxes) {
+                outbox.clear();
+            }
+        }
+        doNotOptimize(outboxes);
+    });
+    runner.run("fanout.shared_512b_x200", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            const SharedFrame shared = SharedFrame::copyOf(frame);
+            for (Outbox& outbox : outboxes) {
+                outbox.append(shared);
+            }
+            for (Outbox& outbox : outboxes) {
+                outbox.clear();
+            }
+        }
+        doNotOptimize(outboxes);
+    });
+}
+
+/// Baseline for benchJobs: a mutex-guarded std::function queue drained by plain std::threads.
+class NaiveThreadPool {
+public:
+    explicit NaiveThreadPool(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this] { workerLoop(); });
+        }
+    }
+    ~NaiveThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(job));
+            ++pending_;
+        }
+        work_ready_.notify_one();
+    }
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+private:
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            std::function<void()> job = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+            if (--pending_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable idle_;
+    std::deque<std::function<void()>> queue_;
+    size_t pending_{0};
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+};
+
+/**
+ * One simulated tick of 100k small entity updates (position += velocity),
+ * submitted as 100k separate jobs to the naive pool and to the JobSystem, and
+ * as a parallelFor. Both schedulers get the same worker threads (at least one).
+ */
+void benchJobs(BenchRunner& runner) {
+    constexpr size_t kEntities = 100000;
+    const size_t workers = std::max<size_t>(JobSystem::defaultWorkerCount(), 1);
+    std::vector<float> positions(kEntities, 0.0f);
+    std::vector<float> velocities(kEntities, 0.5f);
+    float* position = positions.data();
+    const float* velocity = velocities.data();
+
+    {
+        NaiveThreadPool pool(workers);
+        runner.run("jobs.naive_pool_100k", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                for (size_t e = 0; e < kEntities; ++e) {
+                    pool.submit([position, velocity, e] { position[e] += velocity[e]; });
+                }
+                pool.waitIdle();
+            }
+            doNotOptimize(positions);
+        });
+    }
+
+    JobSystem jobs(workers);
+    runner.run("jobs.children_100k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            Job* tick = jobs.create([] {});
+            for (size_t e = 0; e < kEntities; ++e) {
+                jobs.run(jobs.createChild(tick, [position, velocity, e] { position[e] += velocity[e]; }));
+            }
+            jobs.run(tick);
+            jobs.wait(tick);
+        }
+        doNotOptimize(positions);
+    });
+    runner.run("jobs.parallel_for_100k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            jobs.parallelFor(0, kEntities, 256, [position, velocity](size_t first, size_t last) {
+                for (size_t e = first; e < last; ++e) {
+                    position[e] += velocity[e];
+                }
+            });
+        }
+        doNotOptimize(positions);
+    });
+}
+
+/**
+ * Spatial grid with 5000 entities spread over one map: a walk step for every
+ * entity, and one radius-15 query (about the client's viewport) next to a
+ * linear scan over the same positions.
+ */
+void benchSpatialGrid(BenchRunner& runner) {
+    constexpr uint32_t kEntities = 5000;
+    constexpr uint8_t kRadius = 15;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> tile(0, 255);
+    struct Position {
+        uint8_t x;
+        uint8_t y;
+    };
+    std::vector<Position> positions(kEntities);
+    SpatialGrid grid;
+    for (uint32_t entity = 0; entity < kEntities; ++entity) {
+        positions[entity] = {static_cast<uint8_t>(tile(rng)), static_cast<uint8_t>(tile(rng))};
+        grid.insert(entity, positions[entity].x, positions[entity].y);
+    }
+    std::vector<Position> centres(1024);
+    for (Position& centre : centres) {
+        centre = {static_cast<uint8_t>(tile(rng)), static_cast<uint8_t>(tile(rng))};
+    }
+
+    uint64_t round = 0;
+    runner.run("grid.move_5k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i, ++round) {
+            // Alternate one tile right/down and back, so positions stay bounded and some steps cross cells.
+            const int step = (round & 1) == 0 ? 1 : -1;
+            for (uint32_t entity = 0; entity < kEntities; ++entity) {
+                Position& position = positions[entity];
+                position.x = static_cast<uint8_t>(std::clamp(position.x + step, 0, 255));
+                position.y = static_cast<uint8_t>(std::clamp(position.y + step, 0, 255));
+                grid.move(entity, position.x, position.y);
+            }
+        }
+        doNotOptimize(grid);
+    });
+
+    size_t found = 0;
+    runner.run("grid.query_r15_5k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            const Position& centre = centres[i & 1023];
+            grid.forEachInRange(centre.x, centre.y, kRadius, [&found](const SpatialGrid::Slot&) { ++found; });
+        }
+        doNotOptimize(found);
+    });
+    runner.run("grid.brute_force_r15_5k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            const Position& centre = centres[i & 1023];
+            for (const Position& position : positions) {
+                if (std::abs(position.x - centre.x) <= kRadius && std::abs(position.y - centre.y) <= kRadius) {
+                    ++found;
+                }
+            }
+        }
+        doNotOptimize(found);
+    });
+}
+
+// Wire bytes of the create and destroy frames for one recipient's changes.
+size_t viewportBytes(size_t enters, size_t leaves) {
+    using Packets = GamePackets<Season6Protocol>;
+    const size_t creates = (enters + Packets::kMaxViewportCreate - 1) / Packets::kMaxViewportCreate;
+    const size_t destroys = (leaves + Packets::kMaxViewportDestroy - 1) / Packets::kMaxViewportDestroy;
+    return creates * sizeof(Packets::ViewportCreate) + enters * sizeof(Packets::ViewportPlayer) +
+           destroys * sizeof(Packets::ViewportDestroy) + leaves * sizeof(uint16_t);
+}
+
+void benchViewport(BenchRunner& runner) {
+    // A crowded town: 1000 players inside 64x64 tiles, each taking a random one-tile step every tick.
+    constexpr uint32_t kPlayers = 1000;
+    constexpr int kTownMin = 96;
+    constexpr int kTownMax = kTownMin + 63;
+    constexpr size_t kStepTicks = 64;
+    constexpr uint32_t kRadius = ViewportTracker::kRadiusCells;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> tile(kTownMin, kTownMax);
+    std::uniform_int_distribution<int> step(-1, 1);
+    struct Position {
+        uint8_t x;
+        uint8_t y;
+    };
+    std::vector<Position> start(kPlayers);
+    for (Position& position : start) {
+        position = {static_cast<uint8_t>(tile(rng)), static_cast<uint8_t>(tile(rng))};
+    }
+    // Steps are drawn up front so the timed loop does no random number generation.
+    std::vector<int8_t> steps(kStepTicks * kPlayers * 2);
+    for (int8_t& value : steps) {
+        value = static_cast<int8_t>(step(rng));
+    }
+    auto walk = [&](std::vector<Position>& positions, uint64_t tick, auto&& place) {
+        const int8_t* row = &steps[(tick % kStepTicks) * kPlayers * 2];
+        for (uint32_t player = 0; player < kPlayers; ++player) {
+            Position& position = positions[player];
+            position.x = static_cast<uint8_t>(std::clamp(position.x + row[player * 2], kTownMin, kTownMax));
+            position.y = static_cast<uint8_t>(std::clamp(position.y + row[player * 2 + 1], kTownMin, kTownMax));
+            place(player, position);
+        }
+    };
+
+    // Incremental: only cell crossings are rediffed; recipients get their enters and leaves.
+    std::vector<Position> delta_positions = start;
+    ViewportTracker tracker;
+    for (uint32_t player = 0; player < kPlayers; ++player) {
+        tracker.add(player, start[player].x, start[player].y);
+    }
+    size_t delta_bytes = 0;
+    auto sink = [&delta_bytes](uint32_t, std::span<const uint32_t> enters, std::span<const uint32_t> leaves) {
+        delta_bytes += viewportBytes(enters.size(), leaves.size());
+    };
+    tracker.update(sink);
+    uint64_t delta_tick = 0;
+    auto deltaTick = [&] {
+        walk(delta_positions, delta_tick++,
+             [&tracker](uint32_t player, const Position& position) { tracker.move(player, position.x, position.y); });
+        tracker.update(sink);
+    };
+
+    // Stateless: every player's viewport is recomputed and sent whole every tick.
+    std::vector<Position> full_positions = start;
+    SpatialGrid grid;
+    for (uint32_t player = 0; player < kPlayers; ++player) {
+        grid.insert(player, start[player].x, start[player].y);
+    }
+    std::vector<std::vector<uint32_t>> visible(kPlayers);
+    size_t full_bytes = 0;
+    uint64_t full_tick = 0;
+    auto fullTick = [&] {
+        walk(full_positions, full_tick++,
+             [&grid](uint32_t player, const Position& position) { grid.move(player, position.x, position.y); });
+        for (uint32_t player = 0; player < kPlayers; ++player) {
+            std::vector<uint32_t>& seen = visible[player];
+            seen.clear();
+            const Position& position = full_positions[player];
+            grid.forEachInCellBlock(position.x, position.y, kRadius, [&seen, player](const SpatialGrid::Slot& slot) {
+                if (slot.entity != player) {
+                    seen.push_back(slot.entity);
+                }
+            });
+            std::sort(seen.begin(), seen.end());
+            full_bytes += viewportBytes(seen.size(), 0);
+        }
+    };
+
+    // Outbound bytes per tick, measured over one pass of the step table, become the cases' bytes per op.
+    delta_bytes = 0;
+    full_bytes = 0;
+    for (size_t i = 0; i < kStepTicks; ++i) {
+        deltaTick();
+        fullTick();
+    }
+    const uint64_t delta_bytes_per_tick = delta_bytes / kStepTicks;
+    const uint64_t full_bytes_per_tick = full_bytes / kStepTicks;
+
+    runner.run(
+            "viewport.delta_tick_1k",
+            [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) {
+                    deltaTick();
+                }
+                doNotOptimize(delta_bytes);
+            },
+            delta_bytes_per_tick);
+    runner.run(
+            "viewport.full_tick_1k",
+            [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) {
+                    fullTick();
+                }
+                doNotOptimize(full_bytes);
+            },
+            full_bytes_per_tick);
+}
+
+/// Bare coroutine that counts and suspends forever: isolates the cost of handle.resume().
+struct CountingCoroutine {
+    struct promise_type {
+        CountingCoroutine get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+CountingCoroutine countForever(uint64_t& counter) {
+    while (true) {
+        ++counter;
+        co_await std::suspend_always{};
+    }
+}
+
+Task<uint64_t> addOne(uint64_t value) {
+    co_return value + 1;
+}
+
+Task<> awaitTwice(uint64_t& counter) {
+    counter = co_await addOne(counter);
+    counter = co_await addOne(counter);
+}
+
+/**
+ * Coroutine costs: resuming a suspended coroutine next to an indirect call,
+ * and spawning a flow that awaits two child tasks (three pooled frames, so
+ * allocs_per_op should read 0).
+ */
+void benchCoroutines(BenchRunner& runner) {
+    uint64_t counter = 0;
+    void (*volatile step)(uint64_t&) = [](uint64_t& value) { ++value; };
+    runner.run("coro.function_call", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            step(counter);
+        }
+        doNotOptimize(counter);
+    });
+
+    CountingCoroutine coroutine = countForever(counter);
+    runner.run("coro.resume", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            coroutine.handle.resume();
+        }
+        doNotOptimize(counter);
+    });
+    coroutine.handle.destroy();
+
+    IoLoop loop;
+    runner.run("coro.spawn_task_awaiting_two", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            loop.spawn(awaitTwice(counter));
+        }
+        doNotOptimize(counter);
+    });
+}
+
+/// The same fields as EntityStore, one struct per entity (array of structures).
+struct AosEntity {
+    EntityKind kind;
+    uint16_t id;
+    uint8_t map;
+    uint8_t x;
+    uint8_t y;
+    uint8_t dest_x;
+    uint8_t dest_y;
+    uint32_t life;
+    uint32_t max_life;
+    uint32_t mana;
+    uint32_t max_mana;
+    uint32_t flags;
+    EntityHandle target;
+    uint8_t home_x;
+    uint8_t home_y;
+    uint8_t view_range;
+    uint8_t attack_range;
+    uint8_t ai_state;
+};
+
+/// The layout EntityStore replaces: heap objects updated through a virtual call.
+class VirtualEntity {
+public:
+    explicit VirtualEntity(const AosEntity& state) : state_(state) {}
+    virtual ~VirtualEntity() = default;
+    virtual void update(uint32_t life, uint32_t mana) = 0;
+    void setDestination(uint8_t x, uint8_t y) {
+        state_.dest_x = x;
+        state_.dest_y = y;
+    }
+
+protected:
+    AosEntity state_;
+};
+
+class VirtualMonster final : public VirtualEntity {
+public:
+    using VirtualEntity::VirtualEntity;
+    void update(uint32_t life, uint32_t mana) override {
+        if ((state_.flags & EntityStore::kFlagDead) == 0) {
+            state_.life = std::min(state_.life + life, state_.max_life);
+            state_.mana = std::min(state_.mana + mana, state_.max_mana);
+        }
+        state_.x = static_cast<uint8_t>(state_.x + (state_.dest_x > state_.x) - (state_.dest_x < state_.x));
+        state_.y = static_cast<uint8_t>(state_.y + (state_.dest_y > state_.y) - (state_.dest_y < state_.y));
+    }
+};
+
+/**
+ * One tick of entity systems (regeneration, then a step toward the
+ * destination) over 50k entities: EntityStore columns, the same fields as an
+ * array of structs, and heap objects with a virtual update. Destinations keep
+ * moving so every op has the same amount of walking to do.
+ */
+void benchEntities(BenchRunner& runner) {
+    constexpr uint32_t kEntities = 50000;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> tile(0, 255);
+    EntityStore store;
+    std::vector<AosEntity> aos;
+    std::vector<std::unique_ptr<VirtualEntity>> objects;
+    aos.reserve(kEntities);
+    objects.reserve(kEntities);
+    for (uint32_t i = 0; i < kEntities; ++i) {
+        EntitySpawn spawn;
+        spawn.id = static_cast<uint16_t>(i);
+        spawn.x = static_cast<uint8_t>(tile(rng));
+        spawn.y = static_cast<uint8_t>(tile(rng));
+        spawn.life = 1000;
+        spawn.mana = 500;
+        store.create(spawn);
+        const AosEntity entity{spawn.kind, spawn.id, 0, spawn.x, spawn.y, 0, 0, 1000, 1000, 500, 500, 0, {},
+                               spawn.x, spawn.y, 0, 0, 0};
+        aos.push_back(entity);
+        objects.push_back(std::make_unique<VirtualMonster>(entity));
+    }
+    // Retarget every entity now and then; between retargets they walk, then stand.
+    auto retarget = [&](uint64_t round) {
+        if (round % 64 != 0) {
+            return;
+        }
+        for (uint32_t i = 0; i < kEntities; ++i) {
+            const auto x = static_cast<uint8_t>((i * 7 + round) & 0xFF);
+            const auto y = static_cast<uint8_t>((i * 13 + round) & 0xFF);
+            store.destX()[i] = x;
+            store.destY()[i] = y;
+            aos[i].dest_x = x;
+            aos[i].dest_y = y;
+            objects[i]->setDestination(x, y);
+        }
+    };
+
+    uint64_t round = 0;
+    size_t moved = 0;
+    runner.run("entities.soa_tick_50k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i, ++round) {
+            retarget(round);
+            regenerate(store, 3, 1);
+            moved += stepTowardDestinations(store);
+        }
+        doNotOptimize(moved);
+    });
+    round = 0;
+    runner.run("entities.aos_tick_50k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i, ++round) {
+            retarget(round);
+            // One pass per entity, as an object layout would run it.
+            for (AosEntity& entity : aos) {
+                const uint32_t alive = (entity.flags & EntityStore::kFlagDead) == 0;
+                entity.life = std::min(entity.life + 3 * alive, entity.max_life);
+                entity.mana = std::min(entity.mana + alive, entity.max_mana);
+                const int step_x = (entity.dest_x > entity.x) - (entity.dest_x < entity.x);
+                const int step_y = (entity.dest_y > entity.y) - (entity.dest_y < entity.y);
+                entity.x = static_cast<uint8_t>(entity.x + step_x);
+                entity.y = static_cast<uint8_t>(entity.y + step_y);
+                const uint32_t moving = (step_x | step_y) != 0 ? EntityStore::kFlagMoving : 0;
+                entity.flags = (entity.flags & ~EntityStore::kFlagMoving) | moving;
+                moved += moving != 0;
+            }
+        }
+        doNotOptimize(aos);
+        doNotOptimize(moved);
+    });
+    round = 0;
+    runner.run("entities.virtual_tick_50k", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i, ++round) {
+            retarget(round);
+            for (const std::unique_ptr<VirtualEntity>& object : objects) {
+                object->update(3, 1);
+            }
+        }
+        doNotOptimize(objects);
+    });
+}
+
+/**
+ * Monster AI: the nearest-player kernel over 256 candidates per SIMD level,
+ * and one AI update for 2000 monsters around 100 players wandering a
+ * 64x64-tile town, without and with 50000 more monsters asleep elsewhere on
+ * the map. The naive case is what it replaces: every monster scanning every
+ * player every tick.
+ */
+void benchMonsters(BenchRunner& runner) {
+    constexpr uint32_t kCandidates = 256;
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int32_t> tile(0, 255);
+    std::vector<int32_t> xs(kCandidates);
+    std::vector<int32_t> ys(kCandidates);
+    for (uint32_t i = 0; i < kCandidates; ++i) {
+        xs[i] = tile(rng);
+        ys[i] = tile(rng);
+    }
+    uint32_t found = 0;
+    for (auto level : {MonsterAi::SimdLevel::Scalar, MonsterAi::SimdLevel::Sse41, MonsterAi::SimdLevel::Avx2}) {
+        if (level > SimpleModulus::supportedSimdLevel()) {
+            continue;
+        }
+        runner.run(std::string("monsters.nearest_256.") + SimpleModulus::simdLevelName(level), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                int32_t best = 15 * 15 + 1;
+                found += MonsterAi::findNearest(level, xs, ys, static_cast<int32_t>(i & 0xFF),
+                                                static_cast<int32_t>((i * 7) & 0xFF), best);
+            }
+            doNotOptimize(found);
+        });
+    }
+
+    constexpr uint32_t kPlayers = 100;
+    constexpr uint32_t kNear = 2000;
+    constexpr uint32_t kFar = 50000;
+    constexpr int kTownMin = 96;
+    constexpr int kTownSize = 64;
+    std::uniform_int_distribution<int> town(kTownMin, kTownMin + kTownSize - 1);
+    // Far monsters keep more than MonsterAi::kWakeCells cells away from the town.
+    std::uniform_int_distribution<int> far_x(0, 47);
+    std::uniform_int_distribution<int> step(-1, 1);
+    for (const uint32_t far : {uint32_t{0}, kFar}) {
+        EntityStore store;
+        MonsterAi ai;
+        std::vector<EntityHandle> players;
+        for (uint32_t i = 0; i < kPlayers; ++i) {
+            EntitySpawn spawn;
+            spawn.kind = EntityKind::Player;
+            spawn.x = static_cast<uint8_t>(town(rng));
+            spawn.y = static_cast<uint8_t>(town(rng));
+            spawn.life = 110;
+            players.push_back(store.create(spawn));
+        }
+        for (uint32_t i = 0; i < kNear + far; ++i) {
+            EntitySpawn spawn;
+            spawn.kind = EntityKind::Monster;
+            spawn.x = static_cast<uint8_t>(i < kNear ? town(rng) : far_x(rng));
+            spawn.y = static_cast<uint8_t>(i < kNear ? town(rng) : tile(rng));
+            spawn.life = 100;
+            spawn.view_range = 6;
+            spawn.attack_range = 1;
+            ai.add(store, store.create(spawn));
+        }
+        uint32_t attacks = 0;
+        runner.run("monsters.ai_tick_2k_near_" + std::to_string(far / 1000) + "k_far", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                // Players wander a tile at a time, so targets come and go.
+                for (const EntityHandle player : players) {
+                    const uint32_t index = store.indexOf(player);
+                    store.place(player,
+                                static_cast<uint8_t>(std::clamp(store.x()[index] + step(rng), kTownMin,
+                                                                kTownMin + kTownSize - 1)),
+                                static_cast<uint8_t>(std::clamp(store.y()[index] + step(rng), kTownMin,
+                                                                kTownMin + kTownSize - 1)));
+                }
+                attacks += ai.update(store, players).attacks;
+            }
+            doNotOptimize(attacks);
+        });
+        if (far == 0) {
+            continue;
+        }
+        // Baseline on the same store: every monster scans every player, scalar.
+        std::vector<int32_t> player_x(kPlayers);
+        std::vector<int32_t> player_y(kPlayers);
+        runner.run("monsters.naive_tick_52k", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                for (uint32_t p = 0; p < kPlayers; ++p) {
+                    const uint32_t index = store.indexOf(players[p]);
+                    player_x[p] = store.x()[index];
+                    player_y[p] = store.y()[index];
+                }
+                const std::span<const EntityKind> kinds = store.kind();
+                for (uint32_t m = 0; m < store.size(); ++m) {
+                    if (kinds[m] != EntityKind::Monster) {
+                        continue;
+                    }
+                    int32_t best = 6 * 6 + 1;
+                    found += MonsterAi::findNearest(MonsterAi::SimdLevel::Scalar, player_x, player_y,
+                                                    store.x()[m], store.y()[m], best);
+                }
+            }
+            doNotOptimize(found);
+        });
+    }
+}
+
+// Print per-case deltas against a previous JSON result file.
+void printComparison(const BenchRunner& runner, const std::string& path) {
+    std::ifstream input(path);
+    if (!input.is_open()) {
+        throw std::runtime_error("unable to open comparison file " + path);
+    }
+    nlohmann::json previous;
+    input >> previous;
+    std::map<std::string, nlohmann::json> by_name;
+    for (const auto& entry : previous.at("benchmarks")) {
+        by_name[entry.at("name").get<std::string>()] = entry;
+    }
+
+    std::fprintf(stderr, "%-40s %12s %12s %9s %10s\n", "benchmark", "old ns/op", "new ns/op", "delta", "allocs");
+    for (const BenchResult& result : runner.results()) {
+        auto it = by_name.find(result.name);
+        if (it == by_name.end()) {
+            std::fprintf(stderr, "%-40s %12s %12.2f %9s %10.3f\n", result.name.c_str(), "-", result.ns_per_op, "new",
+                         result.allocs_per_op);
+            continue;
+        }
+        const double old_ns = it->second.at("ns_per_op").get<double>();
+        const double delta = old_ns > 0.0 ? (result.ns_per_op - old_ns) / old_ns * 100.0 : 0.0;
+        std::fprintf(stderr, "%-40s %12.2f %12.2f %+8.1f%% %10.3f\n", result.name.c_str(), old_ns, result.ns_per_op,
+                     delta, result.allocs_per_op);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+
+        // Seed the server list to avoid external config dependencies.
+        ServerListManager::Instance()->AddServer(0, "Bench PVP", "127.0.0.1", 55901, true);
+        ServerListManager::Instance()->AddServer(20, "Bench VIP", "192.168.1.50", 55919, true);
+        ServerListManager::Instance()->AddServer(21, "Bench Hidden", "192.168.1.51", 55920, false);
+
+        BenchRunner runner(options.min_time, options.filter);
+        benchServerList(runner);
+        benchPacketHandler(runner);
+        benchFraming(runner);
+        benchEpoll(runner);
+        benchSimpleModulus(runner);
+        benchXor32(runner);
+        benchGameServer(runner);
+        benchGameServerReplies(runner);
+        benchFanOut(runner);
+        benchSpatialGrid(runner);
+        benchViewport(runner);
+        benchEntities(runner);
+        benchMonsters(runner);
+        benchJobs(runner);
+        benchCoroutines(runner);
+
+        // JSON goes to stdout (or --out) so runs can be diffed between commits.
+        if (options.out_path.empty()) {
+            runner.writeJson(std::cout);
+        } else {
+            std::ofstream out(options.out_path);
+            runner.writeJson(out);
+        }
+        if (!options.compare_path.empty()) {
+            printComparison(runner, options.compare_path);
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Benchmark failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
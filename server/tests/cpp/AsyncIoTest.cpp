@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) DarkEmu
+ * Coroutine I/O tests: task composition, a login flow over a socketpair, accept, timers and completions.
+ */
+
+#include "Common/Network/AsyncIo.h"
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// Run the loop until every spawned task has finished, giving up after a few seconds.
+bool drain(IoLoop& loop) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (loop.tasks() != 0) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        loop.runOnce(10);
+    }
+    return true;
+}
+
+std::array<Socket, 2> makePair() {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+        throw std::runtime_error("socketpair failed");
+    }
+    return {Socket(fds[0]), Socket(fds[1])};
+}
+
+Task<int> add(int a, int b) {
+    co_return a + b;
+}
+
+Task<int> sum(int depth) {
+    if (depth == 0) {
+        co_return 0;
+    }
+    const int rest = co_await sum(depth - 1);
+    co_return co_await add(rest, depth);
+}
+
+Task<> storeSum(int& result) {
+    result = co_await sum(100);
+}
+
+Task<int> throwing() {
+    throw std::runtime_error("lookup failed");
+    co_return 0;
+}
+
+// Nested tasks return values through symmetric transfer; exceptions reach the awaiter; frames are pooled.
+bool checkTasks() {
+    IoLoop loop;
+    int result = 0;
+    std::string error;
+    loop.spawn([](int& result, std::string& error) -> Task<> {
+        result = co_await sum(100);
+        try {
+            co_await throwing();
+        } catch (const std::runtime_error& ex) {
+            error = ex.what();
+        }
+    }(result, error));
+    if (loop.tasks() != 0 || result != 5050 || error != "lookup failed") {
+        return fail("Task composition returned " + std::to_string(result) + " / '" + error + "'");
+    }
+    // Frames go back to this thread's free lists, so running a flow again takes no new blocks.
+    loop.spawn(storeSum(result));
+    const size_t cached = FramePool::cachedBlocks();
+    loop.spawn(storeSum(result));
+    return FramePool::cachedBlocks() == cached || fail("Second run did not reuse the pooled frames");
+}
+
+// Server side of a handshake -> login -> character select flow with a lookup on another thread.
+Task<> serveClient(IoLoop& loop, Socket socket, std::vector<std::string>& log) {
+    AsyncSocket client(loop, std::move(socket));
+    const std::array<uint8_t, 4> welcome{0xC1, 0x04, 0xF1, 0x00};
+    if (!co_await client.send(welcome)) {
+        co_return;
+    }
+    std::span<const uint8_t> frame = co_await client.readFrame();
+    if (frame.size() < 4 || frame[2] != 0xF1 || frame[3] != 0x01) {
+        log.push_back("bad login");
+        co_return;
+    }
+    // The "database" answers from a worker thread; the flow resumes here on the loop thread.
+    const std::string account(frame.begin() + 4, frame.end());
+    Completion<int> lookup(loop);
+    std::thread worker([&lookup, account] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        lookup.complete(account == "darkemu" ? 1 : 0);
+    });
+    const int found = co_await lookup;
+    worker.join();
+    log.push_back("login " + account + (found == 1 ? " ok" : " unknown"));
+    const std::array<uint8_t, 5> accepted{0xC1, 0x05, 0xF1, 0x01, static_cast<uint8_t>(found)};
+    co_await client.send(accepted);
+
+    frame = co_await client.readFrame();
+    if (frame.size() >= 4 && frame[2] == 0xF3 && frame[3] == 0x03) {
+        log.push_back("select");
+    }
+    co_await loop.sleep(std::chrono::milliseconds(2));
+    frame = co_await client.readFrame();
+    log.push_back(frame.empty() ? "eof" : "unexpected frame");
+}
+
+// Client side: sends the select frame in two pieces so the server sees a partial frame first.
+Task<> runClient(IoLoop& loop, Socket socket, std::vector<std::string>& log) {
+    AsyncSocket server(loop, std::move(socket));
+    std::span<const uint8_t> frame = co_await server.readFrame();
+    if (frame.size() != 4 || frame[2] != 0xF1) {
+        log.push_back("bad welcome");
+        co_return;
+    }
+    const std::array<uint8_t, 11> login{0xC1, 0x0B, 0xF1, 0x01, 'd', 'a', 'r', 'k', 'e', 'm', 'u'};
+    co_await server.send(login);
+    frame = co_await server.readFrame();
+    log.push_back(frame.size() == 5 && frame[4] == 1 ? "accepted" : "rejected");
+    const std::array<uint8_t, 3> head{0xC1, 0x06, 0xF3};
+    const std::array<uint8_t, 3> tail{0x03, 'h', 'i'};
+    co_await server.send(head);
+    co_await loop.sleep(std::chrono::milliseconds(3));
+    co_await server.send(tail);
+}
+
+bool checkLoginFlow() {
+    IoLoop loop;
+    std::vector<std::string> server_log;
+    std::vector<std::string> client_log;
+    auto pair = makePair();
+    loop.spawn(serveClient(loop, std::move(pair[0]), server_log));
+    loop.spawn(runClient(loop, std::move(pair[1]), client_log));
+    if (!drain(loop)) {
+        return fail("Login flow did not finish");
+    }
+    const std::vector<std::string> expected_server{"login darkemu ok", "select", "eof"};
+    const std::vector<std::string> expected_client{"accepted"};
+    return (server_log == expected_server && client_log == expected_client) || fail("Login flow took the wrong path");
+}
+
+// A malformed header ends the read with an empty frame.
+bool checkMalformed() {
+    IoLoop loop;
+    auto pair = makePair();
+    const std::array<uint8_t, 3> garbage{0x17, 0x03, 0x00};
+    pair[1].send(garbage);
+    bool empty = false;
+    loop.spawn([](IoLoop& loop, Socket socket, bool& empty) -> Task<> {
+        AsyncSocket client(loop, std::move(socket));
+        empty = (co_await client.readFrame()).empty();
+    }(loop, std::move(pair[0]), empty));
+    return (drain(loop) && empty) || fail("Malformed header did not end the read");
+}
+
+// Accept over loopback, then a completion that finishes before it is awaited.
+bool checkAcceptAndEarlyCompletion() {
+    IoLoop loop;
+    Socket listener = Socket::createTcp();
+    listener.bind(0, INADDR_LOOPBACK);
+    listener.listen();
+    sockaddr_in addr{};
+    socklen_t length = sizeof(addr);
+    ::getsockname(listener.fd(), reinterpret_cast<sockaddr*>(&addr), &length);
+    int accepted = 0;
+    loop.spawn([](IoLoop& loop, Socket socket, int& accepted) -> Task<> {
+        AsyncSocket listening(loop, std::move(socket));
+        for (int i = 0; i < 2; ++i) {
+            Socket client = co_await listening.accept();
+            accepted += client.isValid() ? 1 : 0;
+        }
+        Completion<int> ready(loop);
+        ready.complete(7);
+        accepted += co_await ready;
+    }(loop, std::move(listener), accepted));
+    std::vector<Socket> clients;
+    for (int i = 0; i < 2; ++i) {
+        clients.push_back(Socket::createTcp());
+        if (::connect(clients.back().fd(), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+            return fail("Loopback connect failed");
+        }
+    }
+    return (drain(loop) && accepted == 9) || fail("Accept or early completion went wrong");
+}
+
+// Timers fire in deadline order; stop() from another thread ends run().
+bool checkTimersAndStop() {
+    IoLoop loop;
+    std::vector<int> order;
+    for (int delay : {6, 2, 4}) {
+        loop.spawn([](IoLoop& loop, int delay, std::vector<int>& order) -> Task<> {
+            co_await loop.sleep(std::chrono::milliseconds(delay));
+            order.push_back(delay);
+        }(loop, delay, order));
+    }
+    if (!drain(loop) || order != std::vector<int>{2, 4, 6}) {
+        return fail("Timers fired out of order");
+    }
+    std::thread stopper([&loop] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        loop.stop();
+    });
+    loop.run();
+    stopper.join();
+    // A loop destroyed with suspended tasks releases them.
+    loop.spawn([](IoLoop& loop) -> Task<> { co_await loop.sleep(std::chrono::hours(1)); }(loop));
+    return loop.tasks() == 1 || fail("Sleeping task was not counted");
+}
+
+} // namespace
+
+int main() {
+    try {
+        return checkTasks() && checkLoginFlow() && checkMalformed() && checkAcceptAndEarlyCompletion() &&
+                       checkTimersAndStop()
+                   ? 0
+                   : 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "AsyncIo test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
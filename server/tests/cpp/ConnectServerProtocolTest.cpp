@@ -1,11 +1,13 @@
 /*
  * Copyright (c) DarkEmu
- * Protocol test for the ConnectServer server list response.
+ * Protocol test for the ConnectServer server list and server info responses.
  */
 
 #include "ConnectServer/Managers/ServerListManager.h"
+#include "ConnectServer/Packets/PocketDef.h"
 #include "ConnectServer/ServerEngine.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cerrno>
@@ -21,6 +23,9 @@
 
 namespace {
 
+// ConnectServer packets of the Season 6 client.
+using Packets = Season6ConnectPackets;
+
 // Configure a socket receive timeout in milliseconds.
 bool setRecvTimeout(int fd, int timeoutMs) {
     timeval tv{};
@@ -66,6 +71,23 @@ bool recvExact(int fd, uint8_t* data, size_t size) {
     return true;
 }
 
+// Open a loopback connection with a receive timeout; -1 on failure.
+int connectClient(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (!setRecvTimeout(fd, 1000) || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
 } // namespace
 
 int main() {
@@ -153,6 +175,33 @@ int main() {
             return 1;
         }
 
+        // The server closes after each reply, so request the address of server 20 (F4 03) on a new connection.
+        ::close(fd);
+        fd = connectClient(port);
+        auto info_request = makePacket<Packets::ServerInfoRequest>();
+        info_request.server_code = 20;
+        const std::array<uint8_t, 6> info_wire{0xC1, 0x06, 0xF4, 0x03, 0x14, 0x00};
+        std::array<uint8_t, sizeof(Packets::ServerInfoResponse)> info_reply{};
+        if (fd == -1 || !std::equal(info_wire.begin(), info_wire.end(), packetBytes(info_request).begin()) ||
+            !sendAll(fd, info_wire.data(), info_wire.size()) ||
+            !recvExact(fd, info_reply.data(), info_reply.size())) {
+            std::cerr << "Server info exchange failed\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+        const Packets::ServerInfoResponse* info = viewPacket<Packets::ServerInfoResponse>(info_reply);
+        if (info == nullptr || info->header.size != 22 || std::strcmp(info->ip, "127.0.0.1") != 0 ||
+            info->port != 55919 || info_reply[20] != 0x6F || info_reply[21] != 0xDA ||
+            viewPacket<Packets::ServerListResponse>(info_reply) != nullptr) {
+            std::cerr << "Unexpected server info payload\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+
         // Cleanup resources and stop the server thread.
         ::close(fd);
         stop.store(true);
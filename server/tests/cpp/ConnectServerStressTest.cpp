@@ -1,123 +1,16 @@
 /**
  * Copyright (c) DarkEmu
- * Stress test for concurrent ConnectServer server list requests.
+ * Stress test for concurrent ConnectServer server list requests using the epoll client engine.
  */
 
 #include "ConnectServer/Managers/ServerListManager.h"
 #include "ConnectServer/ServerEngine.h"
+#include "Tools/ClientEngine.h"
 
-#include <array>
 #include <atomic>
-#include <cerrno>
-#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <thread>
-#include <vector>
-
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#include <sys/socket.h>
-#include <sys/time.h>
-#include <unistd.h>
-
-namespace {
-
-// Configure send/receive timeouts in milliseconds.
-bool setTimeouts(int fd, int timeoutMs) {
-    timeval tv{};
-    tv.tv_sec = timeoutMs / 1000;
-    tv.tv_usec = (timeoutMs % 1000) * 1000;
-    if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0) {
-        return false;
-    }
-    return ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == 0;
-}
-
-// Send all bytes, retrying on EINTR.
-bool sendAll(int fd, const uint8_t* data, size_t size) {
-    size_t offset = 0;
-    while (offset < size) {
-        ssize_t sent = ::send(fd, data + offset, size - offset, 0);
-        if (sent > 0) {
-            offset += static_cast<size_t>(sent);
-            continue;
-        }
-        if (sent == -1 && errno == EINTR) {
-            continue;
-        }
-        return false;
-    }
-    return true;
-}
-
-// Receive an exact number of bytes, retrying on EINTR.
-bool recvExact(int fd, uint8_t* data, size_t size) {
-    size_t offset = 0;
-    while (offset < size) {
-        ssize_t received = ::recv(fd, data + offset, size - offset, 0);
-        if (received > 0) {
-            offset += static_cast<size_t>(received);
-            continue;
-        }
-        if (received == 0) {
-            return false;
-        }
-        if (errno == EINTR) {
-            continue;
-        }
-        return false;
-    }
-    return true;
-}
-
-// Execute one complete request/response cycle.
-bool runClient(uint16_t port) {
-    // Open a client socket to the ConnectServer.
-    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (fd == -1) {
-        return false;
-    }
-
-    // Apply short timeouts to avoid long stalls.
-    setTimeouts(fd, 1000);
-
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-
-    // Connect to the server.
-    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
-        ::close(fd);
-        return false;
-    }
-
-    // Send the server list request.
-    std::array<uint8_t, 4> request{0xC1, 0x04, 0xF4, 0x06};
-    if (!sendAll(fd, request.data(), request.size())) {
-        ::close(fd);
-        return false;
-    }
-
-    // Receive the full server list response.
-    std::array<uint8_t, 15> response{};
-    if (!recvExact(fd, response.data(), response.size())) {
-        ::close(fd);
-        return false;
-    }
-
-    std::array<uint8_t, 15> expected{
-        0xC2, 0x00, 0x0F, 0xF4, 0x06, 0x00, 0x02,
-        0x00, 0x00, 0x00, 0xCC,
-        0x14, 0x00, 0x00, 0xCC
-    };
-    // Compare the response to the expected payload.
-    bool ok = response == expected;
-    ::close(fd);
-    return ok;
-}
-
-} // namespace
 
 int main() {
     try {
@@ -143,36 +36,31 @@ int main() {
             return 1;
         }
 
-        // Launch multiple clients in parallel.
-        constexpr int kThreads = 8;
-        constexpr int kIterations = 8;
-        std::atomic_int failures{0};
-        std::vector<std::thread> clients;
-        clients.reserve(kThreads);
-
-        for (int i = 0; i < kThreads; ++i) {
-            clients.emplace_back([&] {
-                for (int j = 0; j < kIterations; ++j) {
-                    if (!runClient(port)) {
-                        failures.fetch_add(1);
-                        return;
-                    }
-                }
-            });
-        }
-
-        // Wait for all clients to finish.
-        for (auto& t : clients) {
-            t.join();
-        }
+        // Open-loop arrivals from a single epoll client engine: new sessions start on
+        // schedule whether or not earlier ones have been answered.
+        LoadProfile profile;
+        profile.port = port;
+        profile.rate = 4000.0;
+        profile.duration = std::chrono::milliseconds(250);
+        profile.request = {0xC1, 0x04, 0xF4, 0x06};
+        profile.expected_reply = {
+            0xC2, 0x00, 0x0F, 0xF4, 0x06, 0x00, 0x02,
+            0x00, 0x00, 0x00, 0xCC,
+            0x14, 0x00, 0x00, 0xCC
+        };
+        ClientEngine engine(profile);
+        const LoadStats stats = engine.run();
 
         // Shut down the server loop.
         stop.store(true);
         server_thread.join();
 
-        // Report any failures detected by the client threads.
-        if (failures.load() != 0) {
-            std::cerr << "Stress test failed for " << failures.load() << " client(s)\n";
+        // Every session must connect, receive the exact list and finish cleanly.
+        if (stats.totalErrors() != 0 || stats.started == 0 || stats.completed != stats.started ||
+            stats.responses != stats.started) {
+            std::ostringstream report;
+            stats.print(report);
+            std::cerr << "Stress test failed:\n" << report.str();
             return 1;
         }
         return 0;
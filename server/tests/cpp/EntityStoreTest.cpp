@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) DarkEmu
+ * Entity store tests: handle generations, dense columns after removal, and the per-tick systems.
+ */
+
+#include "GameServer/EntityStore.h"
+
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+EntitySpawn monster(uint16_t id, uint8_t x, uint8_t y, uint32_t life = 100) {
+    EntitySpawn spawn;
+    spawn.kind = EntityKind::Monster;
+    spawn.id = id;
+    spawn.x = x;
+    spawn.y = y;
+    spawn.life = life;
+    spawn.mana = life / 2;
+    return spawn;
+}
+
+// Destroyed handles stop resolving, even once their slot is reused; the empty handle never resolves.
+bool checkHandles() {
+    EntityStore store;
+    const EntityHandle first = store.create(monster(1, 10, 10));
+    const EntityHandle second = store.create(monster(2, 20, 20));
+    if (!first || !second || first == second || store.size() != 2 || !store.alive(first) ||
+        store.alive(EntityHandle{})) {
+        return fail("Fresh handles do not resolve");
+    }
+    if (!store.destroy(first) || store.destroy(first) || store.alive(first) || store.size() != 1) {
+        return fail("A destroyed handle still resolves");
+    }
+    const EntityHandle reused = store.create(monster(3, 30, 30));
+    if (reused.slot != first.slot || reused == first || store.alive(first) || !store.alive(reused)) {
+        return fail("A reused slot revived the old handle");
+    }
+    const uint32_t index = store.indexOf(reused);
+    if (store.handleAt(index) != reused || store.id()[index] != 3 || store.x()[index] != 30) {
+        return fail("Index and handle disagree");
+    }
+    return true;
+}
+
+// Random creates and destroys keep every column dense and every live handle on its own row.
+bool checkDenseColumns() {
+    EntityStore store;
+    std::map<uint16_t, EntityHandle> live; // by id
+    std::mt19937 rng(7);
+    uint16_t next = 0;
+    for (int round = 0; round < 5000; ++round) {
+        if (live.empty() || rng() % 3 != 0) {
+            const uint16_t id = next++;
+            live[id] = store.create(monster(id, static_cast<uint8_t>(id), static_cast<uint8_t>(id >> 8)));
+        } else {
+            auto victim = live.begin();
+            std::advance(victim, rng() % live.size());
+            store.destroy(victim->second);
+            live.erase(victim);
+        }
+    }
+    if (store.size() != live.size() || store.x().size() != live.size() || store.target().size() != live.size()) {
+        return fail("Columns are not dense");
+    }
+    for (const auto& [id, handle] : live) {
+        const uint32_t index = store.indexOf(handle);
+        if (index == EntityStore::kNoIndex || store.handleAt(index) != handle || store.id()[index] != id ||
+            store.x()[index] != static_cast<uint8_t>(id) || store.y()[index] != static_cast<uint8_t>(id >> 8) ||
+            store.homeX()[index] != static_cast<uint8_t>(id) || store.homeY()[index] != static_cast<uint8_t>(id >> 8)) {
+            return fail("Entity " + std::to_string(id) + " lost its row");
+        }
+    }
+    return true;
+}
+
+// Regeneration caps at the maximum and skips the dead; steps go one tile per tick, diagonals included.
+bool checkSystems() {
+    EntityStore store;
+    const EntityHandle hurt = store.create(monster(1, 10, 10, 100));
+    const EntityHandle dead = store.create(monster(2, 50, 50, 100));
+    const EntityHandle walker = store.create(monster(3, 100, 100));
+    store.life()[store.indexOf(hurt)] = 40;
+    store.mana()[store.indexOf(hurt)] = 0;
+    store.life()[store.indexOf(dead)] = 0;
+    store.flags()[store.indexOf(dead)] |= EntityStore::kFlagDead;
+    regenerate(store, 25, 30);
+    regenerate(store, 25, 30);
+    regenerate(store, 25, 30);
+    if (store.life()[store.indexOf(hurt)] != 100 || store.mana()[store.indexOf(hurt)] != 50 ||
+        store.life()[store.indexOf(dead)] != 0) {
+        return fail("Regeneration overshot the maximum or revived the dead");
+    }
+
+    const uint32_t index = store.indexOf(walker);
+    store.destX()[index] = 103;
+    store.destY()[index] = 98;
+    std::vector<size_t> moved;
+    for (int tick = 0; tick < 4; ++tick) {
+        moved.push_back(stepTowardDestinations(store));
+    }
+    if (moved != std::vector<size_t>{1, 1, 1, 0} || store.x()[index] != 103 || store.y()[index] != 98 ||
+        (store.flags()[index] & EntityStore::kFlagMoving) != 0) {
+        return fail("Steps toward the destination are wrong");
+    }
+    store.destX()[index] = 0;
+    stepTowardDestinations(store);
+    if ((store.flags()[index] & EntityStore::kFlagMoving) == 0 || !store.place(walker, 5, 6) ||
+        store.x()[index] != 5 || stepTowardDestinations(store) != 0) {
+        return fail("Placing an entity did not stop it");
+    }
+
+    // Targets on a destroyed or dead entity are dropped; live ones stay.
+    store.target()[store.indexOf(hurt)] = walker;
+    store.target()[store.indexOf(walker)] = dead;
+    const EntityHandle gone = store.create(monster(4, 1, 1));
+    store.target()[store.indexOf(dead)] = gone;
+    store.destroy(gone);
+    if (clearStaleTargets(store) != 2 || store.target()[store.indexOf(hurt)] != walker ||
+        store.target()[store.indexOf(walker)] || store.target()[store.indexOf(dead)]) {
+        return fail("Stale targets were not cleared");
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    return checkHandles() && checkDenseColumns() && checkSystems() ? 0 : 1;
+}
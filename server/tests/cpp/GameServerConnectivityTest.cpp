@@ -1,8 +1,13 @@
 /**
  * Copyright (c) DarkEmu
- * Basic connectivity test for the GameServer.
+ * Basic connectivity test for the GameServer: one send() per batch of replies, frames of the wrong type, half-closes.
  */
 #include "GameServer/GameServer.h"
+#include "GameServer/GamePackets.h"
+
+#include "Common/Crypto/SimpleModulus.h"
+#include "Common/Crypto/Xor32.h"
+#include "Common/Utils/Metrics.h"
 
 #include <array>
 #include <atomic>
@@ -11,14 +16,19 @@
 #include <cstring>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 namespace {
 
+// GameServer packets of the Season 6 client.
+using Packets = GamePackets<Season6Protocol>;
+
 // Send all bytes, retrying on EINTR.
 bool sendAll(int fd, const uint8_t* data, size_t size) {
     size_t offset = 0;
@@ -43,8 +53,13 @@ int main() {
         // Start the server in the background with a short polling loop.
         GameServer server(0);
         std::atomic_bool stop{false};
+        std::atomic_bool paused{false};
         std::thread server_thread([&] {
             while (!stop.load()) {
+                if (paused.load()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
                 server.RunOnce(50);
             }
         });
@@ -78,6 +93,20 @@ int main() {
             return 1;
         }
 
+        // The server greets every connection with the F1 00 join result.
+        std::array<uint8_t, 12> welcome{};
+        timeval tv{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (::recv(fd, welcome.data(), welcome.size(), MSG_WAITALL) != static_cast<ssize_t>(welcome.size()) ||
+            welcome[0] != 0xC1 || welcome[1] != 0x0C || welcome[2] != 0xF1 || welcome[3] != 0x00 ||
+            welcome[4] != 0x01) {
+            std::cerr << "Missing or malformed join result\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+
         // Send a small payload to verify the server receives data.
         std::array<uint8_t, 4> payload{0xC1, 0x04, 0xF1, 0x01};
         if (!sendAll(fd, payload.data(), payload.size())) {
@@ -88,8 +117,155 @@ int main() {
             return 1;
         }
 
-        // Allow the server loop to read and record the data.
+        // Character list before login is refused by the dispatch table without a reply.
+        const Xor32 xor32;
+        std::array<uint8_t, 4> list{0xC1, 0x04, 0xF3, 0x00};
+        xor32.encodeFrame(list);
+        if (!sendAll(fd, list.data(), list.size())) {
+            std::cerr << "Failed to send character list request\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint8_t probe = 0;
+        if (::recv(fd, &probe, 1, MSG_DONTWAIT) != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            std::cerr << "Server answered or dropped a request sent before login\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+
+        // A login-sized F1 01 in a C2 frame matches the C1 login route's opcode but not its type: it is refused
+        // without a reply and the server keeps serving the connection.
+        std::vector<uint8_t> wide(sizeof(Packets::LoginRequest) + 1, 0);
+        wide[0] = 0xC2;
+        wide[1] = 0x00;
+        wide[2] = static_cast<uint8_t>(wide.size());
+        wide[3] = 0xF1;
+        wide[4] = 0x01;
+        xor32.encodeFrame(wide);
+        if (!sendAll(fd, wide.data(), wide.size())) {
+            std::cerr << "Failed to send C2 login frame\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (::recv(fd, &probe, 1, MSG_DONTWAIT) != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            std::cerr << "Server answered or dropped a C2 frame on a C1 route\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+
+        // A C3 login built like the client's (BuxConvert account, XOR32 body, then SimpleModulus) is accepted.
+        const SimpleModulus encoder(SimpleModulusKeys::clientToServer());
+        Packets::LoginRequest request = makePacket<Packets::LoginRequest>();
+        std::memcpy(request.account, "dark", 4);
+        buxConvert(request.account);
+        std::vector<uint8_t> login(packetBytes(request).begin(), packetBytes(request).end());
+        xor32.encodeFrame(login);
+        std::vector<uint8_t> encrypted;
+        if (!encoder.encryptFrame(login, 0, encrypted) || !sendAll(fd, encrypted.data(), encrypted.size())) {
+            std::cerr << "Failed to send encrypted frame\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+        std::array<uint8_t, 5> result{};
+        if (::recv(fd, result.data(), result.size(), MSG_WAITALL) != static_cast<ssize_t>(result.size()) ||
+            result != std::array<uint8_t, 5>{0xC1, 0x05, 0xF1, 0x01, 0x01}) {
+            std::cerr << "Missing or malformed login result\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+
+        // After login the same character list request is answered.
+        std::array<uint8_t, 7> characters{};
+        if (!sendAll(fd, list.data(), list.size()) ||
+            ::recv(fd, characters.data(), characters.size(), MSG_WAITALL) !=
+                static_cast<ssize_t>(characters.size()) ||
+            characters[0] != 0xC1 || characters[1] != 0x07 || characters[2] != 0xF3 || characters[3] != 0x00) {
+            std::cerr << "Missing or malformed character list\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+
+        // Replies to frames that arrive together leave in one send() call.
+        Counter& send_calls = MetricsRegistry::Instance()->counter("darkemu_game_send_calls_total", "");
+        std::vector<uint8_t> lists;
+        for (int i = 0; i < 3; ++i) {
+            lists.insert(lists.end(), list.begin(), list.end());
+        }
+        // The counter moves after send() returns, so let the previous reply's count land first.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const uint64_t sends_before = send_calls.value();
+        std::array<uint8_t, 3 * 7> three{};
+        if (!sendAll(fd, lists.data(), lists.size()) ||
+            ::recv(fd, three.data(), three.size(), MSG_WAITALL) != static_cast<ssize_t>(three.size()) ||
+            three[7] != 0xC1 || three[14] != 0xC1 || three[16] != 0xF3) {
+            std::cerr << "Missing or malformed batched character lists\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (send_calls.value() - sends_before != 1) {
+            std::cerr << "Three replies took " << send_calls.value() - sends_before << " send() calls\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+
+        // A C3 frame with a damaged checksum closes the connection.
+        encrypted.back() ^= 0xFF;
+        if (!sendAll(fd, encrypted.data(), encrypted.size()) || ::recv(fd, &probe, 1, 0) != 0) {
+            std::cerr << "Server kept a connection that sent an undecryptable frame\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
+        ::close(fd);
+
+        // A client that sends its last frames and shuts down its side still gets them handled and answered.
+        // The loop is paused meanwhile so the frames and the half-close arrive in the same wake-up.
+        encrypted.back() ^= 0xFF;
+        std::vector<uint8_t> last(encrypted);
+        last.insert(last.end(), list.begin(), list.end());
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        std::array<uint8_t, 5 + 7> answers{};
+        bool half_closed =
+                fd != -1 && ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0 &&
+                ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                ::recv(fd, welcome.data(), welcome.size(), MSG_WAITALL) == static_cast<ssize_t>(welcome.size());
+        paused.store(true);
+        // Outlast the RunOnce(50) that may still be waiting.
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        half_closed = half_closed && sendAll(fd, last.data(), last.size()) && ::shutdown(fd, SHUT_WR) == 0;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        paused.store(false);
+        if (!half_closed ||
+            ::recv(fd, answers.data(), answers.size(), MSG_WAITALL) != static_cast<ssize_t>(answers.size()) ||
+            answers[2] != 0xF1 || answers[5 + 2] != 0xF3 || ::recv(fd, &probe, 1, 0) != 0) {
+            std::cerr << "Frames sent before a half-close were dropped\n";
+            ::close(fd);
+            stop.store(true);
+            server_thread.join();
+            return 1;
+        }
         ::close(fd);
 
         stop.store(true);
@@ -99,6 +275,13 @@ int main() {
             std::cerr << "Server did not receive any bytes\n";
             return 1;
         }
+        // Dispatched: two logins and five list requests. Rejected: the short F1 01, the early list request and the
+        // C2 login.
+        if (server.PacketsDispatched() != 7 || server.PacketsRejected() != 3) {
+            std::cerr << "Unexpected dispatch counts: " << server.PacketsDispatched() << " dispatched, "
+                      << server.PacketsRejected() << " rejected\n";
+            return 1;
+        }
 
         return 0;
     } catch (const std::exception& ex) {
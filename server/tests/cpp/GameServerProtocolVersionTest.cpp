@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) DarkEmu
+ * GameServer protocol-version test: a Season 9 listener uses the Season 9 layouts and opcodes.
+ */
+#include "GameServer/GameServer.h"
+#include "GameServer/GamePackets.h"
+
+#include "Common/Crypto/SimpleModulus.h"
+#include "Common/Crypto/Xor32.h"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// Send all bytes, retrying on EINTR.
+bool sendAll(int fd, std::span<const uint8_t> data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t sent = ::send(fd, data.data() + offset, data.size() - offset, 0);
+        if (sent > 0) {
+            offset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent == -1 && errno == EINTR) {
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+// True when nothing arrives within a short grace period.
+bool silent(int fd) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint8_t probe = 0;
+    return ::recv(fd, &probe, 1, MSG_DONTWAIT) == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+// Login the way the client builds it: BuxConvert account, XOR32 body, then C3 SimpleModulus.
+template <typename Protocol>
+std::vector<uint8_t> encryptedLogin(const char* account, uint8_t serial) {
+    static const SimpleModulus encoder(SimpleModulusKeys::clientToServer());
+    auto request = makePacket<typename GamePackets<Protocol>::LoginRequest>();
+    std::memcpy(request.account, account, std::strlen(account));
+    buxConvert(request.account);
+    const std::span<const uint8_t> bytes = packetBytes(request);
+    std::vector<uint8_t> login(bytes.begin(), bytes.end());
+    Xor32().encodeFrame(login);
+    std::vector<uint8_t> encrypted;
+    if (!encoder.encryptFrame(login, serial, encrypted)) {
+        throw std::runtime_error("login encryption failed");
+    }
+    return encrypted;
+}
+
+// Version names round-trip and unknown names are refused.
+bool checkNames() {
+    if (parseProtocolVersion("season9") != ProtocolVersion::Season9 ||
+        protocolName(ProtocolVersion::Season6) != "season6") {
+        return fail("Protocol names do not round-trip");
+    }
+    try {
+        parseProtocolVersion("season42");
+        return fail("Unknown protocol name was accepted");
+    } catch (const std::invalid_argument&) {
+    }
+    return true;
+}
+
+// Drive a Season 9 session: version bytes, login width and the D7 walk opcode.
+bool checkSeason9Session(int fd) {
+    using Packets = GamePackets<Season9Protocol>;
+    const Xor32 xor32;
+
+    std::array<uint8_t, sizeof(Packets::JoinResult)> welcome{};
+    if (::recv(fd, welcome.data(), welcome.size(), MSG_WAITALL) != static_cast<ssize_t>(welcome.size())) {
+        return fail("Missing join result");
+    }
+    const auto* join = viewPacket<Packets::JoinResult>(welcome);
+    if (join == nullptr || join->version != Season9Protocol::kClientVersion) {
+        return fail("Join result does not carry the Season 9 client version");
+    }
+
+    // A Season 6 login is ten bytes short of the Season 9 layout.
+    if (!sendAll(fd, encryptedLogin<Season6Protocol>("dark", 0)) || !silent(fd)) {
+        return fail("Season 6 login was answered by a Season 9 listener");
+    }
+    std::array<uint8_t, sizeof(Packets::LoginResult)> result{};
+    if (!sendAll(fd, encryptedLogin<Season9Protocol>("dark", 1)) ||
+        ::recv(fd, result.data(), result.size(), MSG_WAITALL) != static_cast<ssize_t>(result.size()) ||
+        viewPacket<Packets::LoginResult>(result) == nullptr || result[4] != 0x01) {
+        return fail("Season 9 login was not accepted");
+    }
+
+    // Enter the world, then walk with the Season 6 (ignored) and Season 9 opcodes.
+    auto select = makePacket<Packets::SelectCharacterRequest>();
+    std::memcpy(select.name, "Hero", 4);
+    std::vector<uint8_t> frames(packetBytes(select).begin(), packetBytes(select).end());
+    xor32.encodeFrame(frames);
+    for (const uint8_t head : {uint8_t{0xD4}, Season9Protocol::kWalkHead}) {
+        std::array<uint8_t, 8> walk{0xC1, 0x08, head, 0x80, 0x80, 0x01, 0x23, 0x00};
+        xor32.encodeFrame(walk);
+        frames.insert(frames.end(), walk.begin(), walk.end());
+    }
+    if (!sendAll(fd, frames) || !silent(fd)) {
+        return fail("Select or walk frames were answered");
+    }
+    return true;
+}
+
+// Dispatched: login, select and the D7 walk. Rejected: the short login and the D4 walk.
+bool checkCounts(const GameServer& server) {
+    if (server.PacketsDispatched() != 3 || server.PacketsRejected() != 2) {
+        return fail("Unexpected dispatch counts: " + std::to_string(server.PacketsDispatched()) + " dispatched, " +
+                    std::to_string(server.PacketsRejected()) + " rejected");
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    try {
+        if (!checkNames()) {
+            return 1;
+        }
+
+        GameServer server(0, ProtocolVersion::Season9);
+        if (server.Protocol() != ProtocolVersion::Season9) {
+            std::cerr << "Listener did not keep its protocol version\n";
+            return 1;
+        }
+        std::atomic_bool stop{false};
+        std::thread server_thread([&] {
+            while (!stop.load()) {
+                server.RunOnce(50);
+            }
+        });
+
+        bool ok = false;
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(server.Port());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        timeval tv{1, 0};
+        if (fd != -1 && ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0 &&
+            ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            ok = checkSeason9Session(fd);
+        } else {
+            std::cerr << "Connect failed: " << std::strerror(errno) << '\n';
+        }
+        if (fd != -1) {
+            ::close(fd);
+        }
+
+        stop.store(true);
+        server_thread.join();
+        return ok && checkCounts(server) ? 0 : 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
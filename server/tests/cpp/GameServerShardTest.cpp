@@ -0,0 +1,307 @@
+/**
+ * Copyright (c) DarkEmu
+ * GameServer shard test: warps hand sessions between map shards; whispers and party requests cross shards;
+ * viewports report players entering and leaving, and walks reach the players watching; a full server refuses players.
+ */
+#include "GameServer/GameServer.h"
+#include "GameServer/GamePackets.h"
+#include "GameServer/WorldMap.h"
+
+#include "Common/Crypto/SimpleModulus.h"
+#include "Common/Crypto/Xor32.h"
+#include "Common/Utils/Metrics.h"
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+using Packets = GamePackets<Season6Protocol>;
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// Send all bytes, retrying on EINTR.
+bool sendAll(int fd, std::span<const uint8_t> data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t sent = ::send(fd, data.data() + offset, data.size() - offset, 0);
+        if (sent > 0) {
+            offset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent == -1 && errno == EINTR) {
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+// Receive exactly out.size() bytes (the socket has a receive timeout).
+bool recvAll(int fd, std::span<uint8_t> out) {
+    return ::recv(fd, out.data(), out.size(), MSG_WAITALL) == static_cast<ssize_t>(out.size());
+}
+
+// Receive one C1 or C2 frame.
+bool recvFrame(int fd, std::vector<uint8_t>& frame) {
+    frame.assign(3, 0);
+    if (!recvAll(fd, frame)) {
+        return false;
+    }
+    const size_t size = frame[0] == 0xC2 ? (size_t{frame[1]} << 8 | frame[2]) : frame[1];
+    if (size <= 3) {
+        return size == 3;
+    }
+    frame.resize(size);
+    return recvAll(fd, std::span<uint8_t>(frame).subspan(3));
+}
+
+// XOR32-encode a plain C1 frame and send it.
+bool sendPlain(int fd, std::span<const uint8_t> frame) {
+    std::vector<uint8_t> encoded(frame.begin(), frame.end());
+    Xor32().encodeFrame(encoded);
+    return sendAll(fd, encoded);
+}
+
+// A logged-in client standing in the world; index is its player index from the join result.
+struct Player {
+    int fd{-1};
+    uint16_t index{0};
+};
+
+// Connect and read the join result; false when the server closes the connection instead.
+bool join(uint16_t port, Player& player) {
+    player.fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval tv{1, 0};
+    std::array<uint8_t, sizeof(Packets::JoinResult)> welcome{};
+    if (player.fd == -1 || ::setsockopt(player.fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0 ||
+        ::connect(player.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || !recvAll(player.fd, welcome)) {
+        return false;
+    }
+    player.index = viewPacket<Packets::JoinResult>(welcome)->index;
+    return true;
+}
+
+// Connect, log in and select a character; false when any step goes unanswered.
+bool enterWorld(uint16_t port, const char* name, Player& player) {
+    if (!join(port, player)) {
+        return fail(std::string(name) + ": no join result");
+    }
+
+    static const SimpleModulus encoder(SimpleModulusKeys::clientToServer());
+    auto request = makePacket<Packets::LoginRequest>();
+    std::memcpy(request.account, name, std::strlen(name));
+    buxConvert(request.account);
+    std::vector<uint8_t> login(packetBytes(request).begin(), packetBytes(request).end());
+    Xor32().encodeFrame(login);
+    std::vector<uint8_t> encrypted;
+    std::array<uint8_t, sizeof(Packets::LoginResult)> result{};
+    if (!encoder.encryptFrame(login, 0, encrypted) || !sendAll(player.fd, encrypted) || !recvAll(player.fd, result)) {
+        return fail(std::string(name) + ": login unanswered");
+    }
+    auto select = makePacket<Packets::SelectCharacterRequest>();
+    std::memcpy(select.name, name, std::strlen(name));
+    return sendPlain(player.fd, packetBytes(select)) || fail(std::string(name) + ": select failed");
+}
+
+// Warp and expect the teleport to the map's spawn tile.
+bool warp(const Player& player, WorldMap map) {
+    auto request = makePacket<Packets::WarpRequest>();
+    request.map = static_cast<uint8_t>(map);
+    std::array<uint8_t, sizeof(Packets::Teleport)> reply{};
+    if (!sendPlain(player.fd, packetBytes(request)) || !recvAll(player.fd, reply)) {
+        return fail("Warp unanswered");
+    }
+    const auto* teleport = viewPacket<Packets::Teleport>(reply);
+    const WorldMapInfo& info = kWorldMaps[static_cast<size_t>(map)];
+    return (teleport != nullptr && teleport->map == static_cast<uint8_t>(map) && teleport->x == info.spawn_x &&
+            teleport->y == info.spawn_y) ||
+           fail("Teleport does not match the warp target");
+}
+
+// Expect a viewport create listing exactly the other player.
+bool expectCreate(const Player& viewer, const Player& other) {
+    std::vector<uint8_t> frame;
+    const auto* create = recvFrame(viewer.fd, frame) ? viewPacket<Packets::ViewportCreate>(frame) : nullptr;
+    if (create == nullptr || create->count != 1 ||
+        frame.size() != sizeof(Packets::ViewportCreate) + sizeof(Packets::ViewportPlayer)) {
+        return fail("No viewport create");
+    }
+    Packets::ViewportPlayer entry;
+    std::memcpy(&entry, frame.data() + sizeof(Packets::ViewportCreate), sizeof(entry));
+    const WorldMapInfo& lorencia = kWorldMaps[static_cast<size_t>(WorldMap::Lorencia)];
+    return (entry.index == other.index && entry.x == lorencia.spawn_x && entry.y == lorencia.spawn_y) ||
+           fail("Viewport create does not list the other player");
+}
+
+// Expect a viewport destroy listing exactly the other player.
+bool expectDestroy(const Player& viewer, const Player& other) {
+    std::vector<uint8_t> frame;
+    const auto* destroy = recvFrame(viewer.fd, frame) ? viewPacket<Packets::ViewportDestroy>(frame) : nullptr;
+    return (destroy != nullptr && destroy->count == 1 && frame.size() == sizeof(Packets::ViewportDestroy) + 2 &&
+            (uint16_t{frame[4]} << 8 | frame[5]) == other.index) ||
+           fail("Viewport destroy does not list the other player");
+}
+
+// Walk one tile east of the Lorencia spawn and expect the watcher to see the move.
+bool expectWalkSeen(const Player& walker, const Player& watcher) {
+    const WorldMapInfo& lorencia = kWorldMaps[static_cast<size_t>(WorldMap::Lorencia)];
+    auto walk = makePacket<Packets::WalkRequest>();
+    walk.x = static_cast<uint8_t>(lorencia.spawn_x + 1);
+    walk.y = lorencia.spawn_y;
+    std::vector<uint8_t> frame;
+    if (!sendPlain(walker.fd, packetBytes(walk)) || !recvFrame(watcher.fd, frame)) {
+        return fail("Walk was not broadcast");
+    }
+    const auto* moved = viewPacket<Packets::ObjectMoved>(frame);
+    return (moved != nullptr && moved->index == walker.index && moved->x == walk.x && moved->y == walk.y) ||
+           fail("Broadcast move does not match the walk");
+}
+
+// Whisper frame to a name with a short message.
+std::vector<uint8_t> whisper(const char* target, const std::string& text) {
+    auto head = makePacket<Packets::Whisper>(sizeof(Packets::Whisper) + text.size());
+    std::memcpy(head.name, target, std::strlen(target));
+    std::vector<uint8_t> frame(packetBytes(head).begin(), packetBytes(head).end());
+    frame.insert(frame.end(), text.begin(), text.end());
+    return frame;
+}
+
+bool checkCrossShard(uint16_t port) {
+    Player alice;
+    Player bob;
+    bool ok = enterWorld(port, "Alice", alice) && enterWorld(port, "Bob", bob);
+    // Both stand on the Lorencia spawn, so each sees the other; Bob's warp takes Bob out of Alice's view.
+    ok = ok && expectCreate(alice, bob) && expectCreate(bob, alice) && expectWalkSeen(bob, alice);
+    // Noria and Devias run on different shards of two.
+    ok = ok && warp(bob, WorldMap::Noria) && expectDestroy(alice, bob) && warp(alice, WorldMap::Devias);
+    // Let the name directory pick up both characters before whispering.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Whisper: Bob sees Alice's name and the text.
+    const std::vector<uint8_t> hello = whisper("Bob", "hi");
+    std::vector<uint8_t> received(hello.size());
+    if (ok && (!sendPlain(alice.fd, hello) || !recvAll(bob.fd, received) ||
+               std::memcmp(viewPacket<Packets::Whisper>(received)->name, "Alice", 6) != 0 ||
+               std::memcmp(received.data() + sizeof(Packets::Whisper), "hi", 2) != 0)) {
+        ok = fail("Whisper did not cross shards");
+    }
+    // Whisper to nobody: the sender is told.
+    std::array<uint8_t, sizeof(Packets::WhisperFailed)> failed{};
+    if (ok && (!sendPlain(alice.fd, whisper("Nobody", "hi")) || !recvAll(alice.fd, failed) ||
+               viewPacket<Packets::WhisperFailed>(failed) == nullptr)) {
+        ok = fail("Whisper to an offline name was not refused");
+    }
+    // Party request: Alice receives Bob's index.
+    auto invite = makePacket<Packets::PartyRequest>();
+    invite.index = alice.index;
+    std::array<uint8_t, sizeof(Packets::PartyRequest)> party{};
+    if (ok && (!sendPlain(bob.fd, packetBytes(invite)) || !recvAll(alice.fd, party) ||
+               viewPacket<Packets::PartyRequest>(party)->index != bob.index)) {
+        ok = fail("Party request did not cross shards");
+    }
+    for (int fd : {alice.fd, bob.fd}) {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+    return ok;
+}
+
+// A full server refuses connections; the index of a closed session goes to the next client, not to two at once.
+bool checkPlayerCapacity() {
+    GameServer server(0, ProtocolVersion::Season6);
+    server.SetPlayerCapacity(2);
+    GameServer::ThreadingOptions options;
+    options.reactors = 2;
+    options.shards = 2;
+    options.tick = std::chrono::milliseconds(5);
+    server.Start(options);
+    Counter& refused = MetricsRegistry::Instance()->counter("darkemu_game_connections_refused_total", "");
+    const uint64_t refused_before = refused.value();
+    Player first;
+    Player second;
+    Player extra;
+    bool ok = (join(server.Port(), first) && join(server.Port(), second) && first.index != second.index) ||
+              fail("Two players did not get two indices");
+    if (ok && join(server.Port(), extra)) {
+        ok = fail("A third player joined a server for two");
+    }
+    ::close(extra.fd);
+    // The shard returns the index after the reactor reports the close, so retry for a moment.
+    ::close(first.fd);
+    Player next;
+    bool joined = false;
+    for (int attempt = 0; ok && !joined && attempt < 50; ++attempt) {
+        joined = join(server.Port(), next);
+        if (!joined) {
+            ::close(next.fd);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    if (ok && (!joined || next.index != first.index)) {
+        ok = fail("The closed player's index was not handed out again");
+    }
+    if (ok && refused.value() == refused_before) {
+        ok = fail("Refused connections were not counted");
+    }
+    for (int fd : {second.fd, next.fd}) {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+    server.Stop();
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    try {
+        GameServer server(0, ProtocolVersion::Season6);
+        GameServer::ThreadingOptions options;
+        options.reactors = 2;
+        options.shards = 2;
+        options.tick = std::chrono::milliseconds(5);
+        options.queue_capacity = 16;
+        server.Start(options);
+        bool ok = checkCrossShard(server.Port());
+        server.Stop();
+
+        // Both start in Lorencia (shard 0); only Bob's warp to Noria changes shard.
+        const uint64_t migrations =
+                MetricsRegistry::Instance()->counter("darkemu_game_shard_migrations_total", "").value();
+        if (ok && migrations != 1) {
+            ok = fail("Expected 1 shard migration, saw " + std::to_string(migrations));
+        }
+        // Login, select and warp for both, Bob's walk, two whispers and the party request.
+        if (ok && (server.PacketsDispatched() != 10 || server.PacketsRejected() != 0)) {
+            ok = fail("Unexpected dispatch counts: " + std::to_string(server.PacketsDispatched()) + " dispatched, " +
+                      std::to_string(server.PacketsRejected()) + " rejected");
+        }
+        return ok && checkPlayerCapacity() ? 0 : 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
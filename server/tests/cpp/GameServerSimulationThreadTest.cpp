@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) DarkEmu
+ * GameServer threaded-mode test: clients spread over two reactors are served by the simulation thread.
+ */
+#include "GameServer/GameServer.h"
+#include "GameServer/GamePackets.h"
+
+#include "Common/Crypto/SimpleModulus.h"
+#include "Common/Crypto/Xor32.h"
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+using Packets = GamePackets<Season6Protocol>;
+
+constexpr size_t kClients = 6;
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// Send all bytes, retrying on EINTR.
+bool sendAll(int fd, std::span<const uint8_t> data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t sent = ::send(fd, data.data() + offset, data.size() - offset, 0);
+        if (sent > 0) {
+            offset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent == -1 && errno == EINTR) {
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+// Receive exactly out.size() bytes (the socket has a receive timeout).
+bool recvAll(int fd, std::span<uint8_t> out) {
+    return ::recv(fd, out.data(), out.size(), MSG_WAITALL) == static_cast<ssize_t>(out.size());
+}
+
+// Connected loopback client with a one-second receive timeout, or -1.
+int connectClient(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval tv{1, 0};
+    if (fd != -1 && (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0 ||
+                     ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Login and character-list request sent as one burst; the C3 login is XOR32-encoded first.
+std::vector<uint8_t> loginBurst(const std::string& account) {
+    static const SimpleModulus encoder(SimpleModulusKeys::clientToServer());
+    const Xor32 xor32;
+    auto request = makePacket<Packets::LoginRequest>();
+    std::memcpy(request.account, account.data(), account.size());
+    buxConvert(request.account);
+    std::vector<uint8_t> login(packetBytes(request).begin(), packetBytes(request).end());
+    xor32.encodeFrame(login);
+    std::vector<uint8_t> burst;
+    if (!encoder.encryptFrame(login, 0, burst)) {
+        throw std::runtime_error("login encryption failed");
+    }
+    const auto list = makePacket<Packets::CharacterListRequest>();
+    std::vector<uint8_t> plain(packetBytes(list).begin(), packetBytes(list).end());
+    xor32.encodeFrame(plain);
+    burst.insert(burst.end(), plain.begin(), plain.end());
+    return burst;
+}
+
+// Every client gets its welcome, then a login result and an empty character list in order.
+bool checkClients(uint16_t port) {
+    std::array<int, kClients> fds{};
+    fds.fill(-1);
+    bool ok = true;
+    for (size_t i = 0; i < kClients && ok; ++i) {
+        fds[i] = connectClient(port);
+        std::array<uint8_t, sizeof(Packets::JoinResult)> welcome{};
+        ok = (fds[i] != -1 && recvAll(fds[i], welcome) && viewPacket<Packets::JoinResult>(welcome) != nullptr) ||
+             fail("Client " + std::to_string(i) + " got no join result");
+    }
+    for (size_t i = 0; i < kClients && ok; ++i) {
+        ok = sendAll(fds[i], loginBurst("user" + std::to_string(i))) || fail("Login send failed");
+    }
+    for (size_t i = 0; i < kClients && ok; ++i) {
+        std::array<uint8_t, sizeof(Packets::LoginResult) + sizeof(Packets::CharacterListResponse)> replies{};
+        const std::span<const uint8_t> bytes(replies);
+        ok = (recvAll(fds[i], replies) && viewPacket<Packets::LoginResult>(bytes) != nullptr && replies[4] == 0x01 &&
+              viewPacket<Packets::CharacterListResponse>(bytes.subspan(sizeof(Packets::LoginResult))) != nullptr) ||
+             fail("Client " + std::to_string(i) + " did not get its login replies in order");
+    }
+    for (int fd : fds) {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    try {
+        GameServer server(0, ProtocolVersion::Season6);
+        GameServer::ThreadingOptions options;
+        options.reactors = 2;
+        options.tick = std::chrono::milliseconds(10);
+        options.queue_capacity = 16;
+        server.Start(options);
+
+        bool ok = true;
+        try {
+            server.Start(options);
+            ok = fail("Second Start() was accepted");
+        } catch (const std::logic_error&) {
+        }
+        ok = ok && checkClients(server.Port());
+        server.Stop();
+
+        // Two frames per client, all dispatched on the simulation thread.
+        if (ok && (server.PacketsDispatched() != 2 * kClients || server.PacketsRejected() != 0)) {
+            ok = fail("Unexpected dispatch counts: " + std::to_string(server.PacketsDispatched()) + " dispatched, " +
+                      std::to_string(server.PacketsRejected()) + " rejected");
+        }
+        if (ok && server.Ticks() == 0) {
+            ok = fail("Simulation thread never ticked");
+        }
+        return ok ? 0 : 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
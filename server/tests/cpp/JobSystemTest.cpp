@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) DarkEmu
+ * Job system tests: deque edges, parallelFor coverage, fork/join chains, pool reuse and stealing.
+ */
+
+#include "Common/Utils/JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// The owner pops newest-first, thieves steal oldest-first, and a full deque refuses pushes.
+bool checkQueueEdges() {
+    WorkStealingQueue queue(4);
+    Job jobs[5];
+    if (queue.pop() != nullptr || queue.steal() != nullptr) {
+        return fail("New deque is not empty");
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (!queue.push(&jobs[i])) {
+            return fail("Push failed before the deque was full");
+        }
+    }
+    if (queue.push(&jobs[4])) {
+        return fail("Full deque accepted another job");
+    }
+    if (queue.steal() != &jobs[0] || queue.pop() != &jobs[3] || queue.steal() != &jobs[1] ||
+        queue.pop() != &jobs[2]) {
+        return fail("Deque handed out jobs in the wrong order");
+    }
+    return (queue.pop() == nullptr && queue.steal() == nullptr) || fail("Drained deque is not empty");
+}
+
+// Owner and thief race for the deque's only job: exactly one of them gets it, every round.
+bool checkLastJobRace() {
+    WorkStealingQueue queue(2);
+    Job job;
+    constexpr int kRounds = 20000;
+    std::atomic<int> started{0};
+    std::atomic<int> done{0};
+    std::atomic<int> stolen{0};
+    std::thread thief([&] {
+        for (int round = 1; round <= kRounds; ++round) {
+            while (started.load(std::memory_order_acquire) < round) {
+                std::this_thread::yield();
+            }
+            if (queue.steal() != nullptr) {
+                stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+            done.store(round, std::memory_order_release);
+        }
+    });
+    int popped = 0;
+    for (int round = 1; round <= kRounds; ++round) {
+        queue.push(&job);
+        started.store(round, std::memory_order_release);
+        if (queue.pop() != nullptr) {
+            ++popped;
+        }
+        while (done.load(std::memory_order_acquire) < round) {
+            std::this_thread::yield();
+        }
+    }
+    thief.join();
+    return popped + stolen.load() == kRounds || fail("The last job was lost or taken twice");
+}
+
+// Every index of the range is visited exactly once, for any worker count and grain.
+bool checkParallelFor() {
+    for (size_t workers : {size_t{0}, size_t{1}, size_t{3}}) {
+        JobSystem jobs(workers);
+        if (jobs.workerCount() != workers) {
+            return fail("Worker count does not match the constructor");
+        }
+        for (size_t grain : {size_t{0}, size_t{1}, size_t{7}, size_t{1000}}) {
+            constexpr size_t kCount = 10000;
+            auto visits = std::make_unique<std::atomic<uint8_t>[]>(kCount);
+            jobs.parallelFor(3, kCount, grain, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    visits[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            for (size_t i = 0; i < kCount; ++i) {
+                if (visits[i].load() != (i < 3 ? 0 : 1)) {
+                    return fail("parallelFor visited index " + std::to_string(i) + " " +
+                                std::to_string(visits[i].load()) + " times");
+                }
+            }
+        }
+        bool called = false;
+        jobs.parallelFor(5, 5, 1, [&](size_t, size_t) { called = true; });
+        if (called) {
+            return fail("parallelFor ran an empty range");
+        }
+    }
+    return true;
+}
+
+// A parent finishes only after all its children, and each phase of a tick sees the previous one complete.
+bool checkForkJoin() {
+    JobSystem jobs(2);
+    constexpr int kChildren = 100;
+    std::vector<int> values(kChildren, 0);
+    int* data = values.data();
+    for (int phase = 1; phase <= 3; ++phase) {
+        Job* root = jobs.create([] {});
+        for (int i = 0; i < kChildren; ++i) {
+            jobs.run(jobs.createChild(root, [data, i, phase] {
+                if (data[i] != phase - 1) {
+                    data[i] = -1000;
+                }
+                data[i] = phase;
+            }));
+        }
+        jobs.run(root);
+        jobs.wait(root);
+        for (int i = 0; i < kChildren; ++i) {
+            if (values[i] != phase) {
+                return fail("Phase " + std::to_string(phase) + " saw an unfinished child of the previous phase");
+            }
+        }
+    }
+    return true;
+}
+
+// Children may fork grandchildren; waiting on the root covers the whole tree.
+bool checkNestedChildren() {
+    JobSystem jobs(2);
+    std::atomic<int> leaves{0};
+    Job* root = jobs.create([] {});
+    struct Spawn {
+        JobSystem* jobs;
+        Job* root;
+        std::atomic<int>* leaves;
+        void operator()() const {
+            for (int i = 0; i < 10; ++i) {
+                std::atomic<int>* counter = leaves;
+                jobs->run(jobs->createChild(root, [counter] { counter->fetch_add(1, std::memory_order_relaxed); }));
+            }
+        }
+    };
+    for (int i = 0; i < 50; ++i) {
+        jobs.run(jobs.createChild(root, Spawn{&jobs, root, &leaves}));
+    }
+    jobs.run(root);
+    jobs.wait(root);
+    return leaves.load() == 500 || fail("Waiting on the root missed grandchildren");
+}
+
+// Far more jobs than one pool holds: slots are reused once finished and nothing is lost.
+bool checkPoolReuse() {
+    JobSystem jobs(1);
+    std::atomic<int> ran{0};
+    constexpr int kJobs = 50000;
+    Job* root = jobs.create([] {});
+    for (int i = 0; i < kJobs; ++i) {
+        jobs.run(jobs.createChild(root, [&ran] { ran.fetch_add(1, std::memory_order_relaxed); }));
+    }
+    jobs.run(root);
+    jobs.wait(root);
+    return ran.load() == kJobs || fail("Pool reuse lost jobs: " + std::to_string(ran.load()));
+}
+
+// Slow jobs queued on the submitting thread are picked up by the workers.
+bool checkStealing() {
+    JobSystem jobs(3);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    struct Record {
+        std::mutex* mutex;
+        std::set<std::thread::id>* threads;
+        void operator()() const {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            std::lock_guard<std::mutex> lock(*mutex);
+            threads->insert(std::this_thread::get_id());
+        }
+    };
+    Job* root = jobs.create([] {});
+    for (int i = 0; i < 64; ++i) {
+        jobs.run(jobs.createChild(root, Record{&mutex, &threads}));
+    }
+    jobs.run(root);
+    jobs.wait(root);
+    return threads.size() > 1 || fail("No job was stolen by a worker");
+}
+
+} // namespace
+
+int main() {
+    return checkQueueEdges() && checkLastJobRace() && checkParallelFor() && checkForkJoin() &&
+                   checkNestedChildren() && checkPoolReuse() && checkStealing()
+               ? 0
+               : 1;
+}
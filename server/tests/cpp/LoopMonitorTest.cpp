@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) DarkEmu
+ * Tests for event-loop health instrumentation (adaptive batch size, slow handler log).
+ */
+
+#include "Common/Network/EpollContext.h"
+#include "Common/Network/LoopMonitor.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+int main() {
+    try {
+        // Keep more descriptors permanently readable than the initial event array holds.
+        EpollContext epoll;
+        std::vector<int> fds;
+        for (int i = 0; i < 12; ++i) {
+            int fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (fd == -1) {
+                std::cerr << "eventfd failed\n";
+                return 1;
+            }
+            epoll.add(fd, EPOLLIN);
+            fds.push_back(fd);
+        }
+
+        LoopMonitor monitor("darkemu_test_loop", "TestLoop");
+        std::vector<epoll_event> events(2);
+
+        // Every wakeup fills the array, so it must grow (2 -> 4 -> 8 -> 16) until all 12 fit.
+        for (int i = 0; i < 4 * LoopMonitor::kGrowAfter; ++i) {
+            monitor.wait(epoll, events, 0);
+            monitor.endIteration();
+        }
+        if (events.size() < fds.size()) {
+            std::cerr << "Event array did not grow: " << events.size() << '\n';
+            return 1;
+        }
+        const size_t grown = events.size();
+        for (int i = 0; i < 2 * LoopMonitor::kGrowAfter; ++i) {
+            monitor.wait(epoll, events, 0);
+        }
+        if (events.size() != grown) {
+            std::cerr << "Event array kept growing without saturation\n";
+            return 1;
+        }
+
+        // A handler above budget is logged with its fd and opcode.
+        monitor.setHandlerBudget(std::chrono::microseconds(100));
+        {
+            LoopMonitor::HandlerScope scope(monitor, fds[3]);
+            monitor.noteOpcode(0xF406);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        {
+            // Fast handlers stay out of the log.
+            LoopMonitor::HandlerScope scope(monitor, fds[4]);
+        }
+        const auto slow = monitor.slowHandlers();
+        if (slow.size() != 1 || slow[0].fd != fds[3] || slow[0].opcode != 0xF406 || slow[0].duration_us < 100) {
+            std::cerr << "Unexpected slow handler log (" << slow.size() << " entries)\n";
+            return 1;
+        }
+
+        for (int fd : fds) {
+            ::close(fd);
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) DarkEmu
+ * Monster AI tests: SIMD kernels against the scalar scan, sleeping and waking, and the idle/chase/attack/return cycle.
+ */
+
+#include "GameServer/EntityStore.h"
+#include "GameServer/MonsterAi.h"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+using SimdLevel = MonsterAi::SimdLevel;
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+EntityHandle spawnMonster(EntityStore& store, MonsterAi& ai, uint8_t x, uint8_t y) {
+    EntitySpawn spawn;
+    spawn.kind = EntityKind::Monster;
+    spawn.x = x;
+    spawn.y = y;
+    spawn.life = 100;
+    spawn.view_range = 5;
+    spawn.attack_range = 1;
+    const EntityHandle monster = store.create(spawn);
+    ai.add(store, monster);
+    return monster;
+}
+
+EntityHandle spawnPlayer(EntityStore& store, uint8_t x, uint8_t y) {
+    EntitySpawn spawn;
+    spawn.kind = EntityKind::Player;
+    spawn.x = x;
+    spawn.y = y;
+    spawn.life = 110;
+    return store.create(spawn);
+}
+
+MonsterAi::State stateOf(const EntityStore& store, EntityHandle monster) {
+    return static_cast<MonsterAi::State>(store.aiState()[store.indexOf(monster)]);
+}
+
+// Every kernel finds the same candidate as the scalar scan, ties and chained calls included.
+bool checkKernels() {
+    std::mt19937 rng(3);
+    // A small coordinate range makes equal distances common.
+    std::uniform_int_distribution<int32_t> coordinate(0, 12);
+    for (int round = 0; round < 2000; ++round) {
+        const size_t count = rng() % 40;
+        std::vector<int32_t> xs(count);
+        std::vector<int32_t> ys(count);
+        for (size_t i = 0; i < count; ++i) {
+            xs[i] = coordinate(rng);
+            ys[i] = coordinate(rng);
+        }
+        const int32_t x = coordinate(rng);
+        const int32_t y = coordinate(rng);
+        const int32_t limit = static_cast<int32_t>(rng() % 60);
+        const size_t split = count / 2;
+        uint32_t expected = MonsterAi::kNone;
+        int32_t expected_best = limit;
+        for (size_t i = 0; i < count; ++i) {
+            const int32_t d2 = (xs[i] - x) * (xs[i] - x) + (ys[i] - y) * (ys[i] - y);
+            if (d2 < expected_best) {
+                expected_best = d2;
+                expected = static_cast<uint32_t>(i);
+            }
+        }
+        for (const SimdLevel level : {SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2}) {
+            // Two chained halves, the way nearestPlayer() walks cell rows.
+            int32_t best = limit;
+            const std::span<const int32_t> all_x(xs);
+            const std::span<const int32_t> all_y(ys);
+            uint32_t found = MonsterAi::findNearest(level, all_x.first(split), all_y.first(split), x, y, best);
+            const uint32_t second =
+                    MonsterAi::findNearest(level, all_x.subspan(split), all_y.subspan(split), x, y, best);
+            if (second != MonsterAi::kNone) {
+                found = static_cast<uint32_t>(split) + second;
+            }
+            if (found != expected || best != expected_best) {
+                return fail("Kernel " + std::string(SimpleModulus::simdLevelName(level)) + " picked " +
+                            std::to_string(found) + " instead of " + std::to_string(expected));
+            }
+        }
+    }
+    return true;
+}
+
+// Monsters far from every player sleep and cost no update; a player wakes only the ones around it.
+bool checkSleep() {
+    EntityStore store;
+    MonsterAi ai;
+    // 32x32 monsters, one every 8 tiles across the map.
+    for (int row = 0; row < 32; ++row) {
+        for (int column = 0; column < 32; ++column) {
+            spawnMonster(store, ai, static_cast<uint8_t>(column * 8 + 4), static_cast<uint8_t>(row * 8 + 4));
+        }
+    }
+    MonsterAi::TickStats stats = ai.update(store, {});
+    if (stats.awake != 0 || ai.awake() != 0 || ai.size() != 1024) {
+        return fail("Monsters without players nearby did not stay asleep");
+    }
+    const EntityHandle player = spawnPlayer(store, 128, 128);
+    const std::vector<EntityHandle> players{player};
+    stats = ai.update(store, players);
+    // The 5x5 cells around the player's cell, one monster each.
+    if (stats.woken != 25 || stats.awake != 25 || ai.size() != 1024) {
+        return fail("A player woke " + std::to_string(stats.woken) + " monsters instead of 25");
+    }
+    store.destroy(player);
+    stats = ai.update(store, {});
+    if (stats.slept != 25 || ai.awake() != 0) {
+        return fail("Idle monsters did not go back to sleep once the player left");
+    }
+    return true;
+}
+
+// Idle, chase, attack, and return home once the target is gone or leads the monster too far.
+bool checkStates() {
+    EntityStore store;
+    MonsterAi ai;
+    const EntityHandle monster = spawnMonster(store, ai, 100, 100);
+    const EntityHandle player = spawnPlayer(store, 110, 100);
+    const std::vector<EntityHandle> players{player};
+    auto tick = [&]() {
+        const MonsterAi::TickStats stats = ai.update(store, players);
+        stepTowardDestinations(store);
+        return stats;
+    };
+    tick();
+    if (stateOf(store, monster) != MonsterAi::State::Idle || ai.awake() != 1) {
+        return fail("A player out of view range was noticed, or the monster slept next to it");
+    }
+    store.place(player, 104, 101);
+    tick();
+    if (stateOf(store, monster) != MonsterAi::State::Chase || store.target()[store.indexOf(monster)] != player) {
+        return fail("The monster did not chase the player in view range");
+    }
+    uint32_t attacks = 0;
+    for (int i = 0; i < 6; ++i) {
+        attacks += tick().attacks;
+    }
+    const uint32_t index = store.indexOf(monster);
+    if (stateOf(store, monster) != MonsterAi::State::Attack || attacks == 0 || store.x()[index] != 103 ||
+        store.y()[index] != 101) {
+        return fail("The monster did not close in and attack");
+    }
+
+    // Lead it away: it gives up past the leash and walks home.
+    for (int i = 0; i < 30 && stateOf(store, monster) != MonsterAi::State::Return; ++i) {
+        store.place(player, static_cast<uint8_t>(store.x()[store.indexOf(monster)] + 2), 101);
+        tick();
+    }
+    if (stateOf(store, monster) != MonsterAi::State::Return || store.target()[store.indexOf(monster)]) {
+        return fail("The monster followed past its leash");
+    }
+    for (int i = 0; i < 30 && stateOf(store, monster) != MonsterAi::State::Idle; ++i) {
+        tick();
+    }
+    if (stateOf(store, monster) != MonsterAi::State::Idle || store.x()[store.indexOf(monster)] != 100 ||
+        store.y()[store.indexOf(monster)] != 100) {
+        return fail("The monster did not get back home");
+    }
+
+    // A target that disappears mid-chase sends it home too.
+    store.place(player, 102, 100);
+    tick();
+    store.destroy(player);
+    tick();
+    if (stateOf(store, monster) != MonsterAi::State::Return) {
+        return fail("The monster kept chasing a destroyed target");
+    }
+    ai.remove(monster);
+    return ai.empty() || fail("Removing the monster left it in the AI");
+}
+
+} // namespace
+
+int main() {
+    return checkKernels() && checkSleep() && checkStates() ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) DarkEmu
+ * Shared frame and outbox tests: reference counting, copied and shared frames in send order, partial writes.
+ */
+
+#include "Common/Network/Outbox.h"
+#include "Common/Network/SharedFrame.h"
+#include "Common/Network/Socket.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// A C1 frame of size bytes filled with seed, seed + 1, ...
+std::vector<uint8_t> frameOf(size_t size, uint8_t seed) {
+    std::vector<uint8_t> frame(size);
+    for (size_t i = 0; i < size; ++i) {
+        frame[i] = static_cast<uint8_t>(seed + i);
+    }
+    frame[0] = 0xC1;
+    return frame;
+}
+
+// Read whatever the peer has without blocking.
+void drain(int fd, std::vector<uint8_t>& out) {
+    uint8_t chunk[4096];
+    ssize_t got = 0;
+    while ((got = ::recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT)) > 0) {
+        out.insert(out.end(), chunk, chunk + got);
+    }
+}
+
+// Handles share one block; the last one frees it. Encrypted frames are refused.
+bool checkSharedFrame() {
+    const std::vector<uint8_t> bytes = frameOf(300, 1);
+    SharedFrame first = SharedFrame::copyOf(bytes);
+    SharedFrame second = first;
+    SharedFrame third;
+    third = second;
+    if (first.useCount() != 3 || std::vector<uint8_t>(third.bytes().begin(), third.bytes().end()) != bytes ||
+        first.bytes().data() != third.bytes().data()) {
+        return fail("Copies do not share one block");
+    }
+    SharedFrame moved = std::move(second);
+    third.reset();
+    if (second || !moved || first.useCount() != 2 || SharedFrame().useCount() != 0 ||
+        !SharedFrame().bytes().empty()) {
+        return fail("Move or reset left the count wrong");
+    }
+    for (const uint8_t type : {uint8_t{0xC3}, uint8_t{0xC4}}) {
+        std::vector<uint8_t> encrypted = bytes;
+        encrypted[0] = type;
+        try {
+            SharedFrame::copyOf(encrypted);
+            return fail("An encrypted frame was accepted for sharing");
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return true;
+}
+
+// Copied and shared frames come out in order; sent shared frames are released; small shared frames are copied.
+bool checkOrder() {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return fail("socketpair failed");
+    }
+    Socket socket(fds[0]);
+    const SharedFrame big = SharedFrame::copyOf(frameOf(Outbox::kMinSharedBytes, 50));
+    const SharedFrame small = SharedFrame::copyOf(frameOf(8, 90));
+    Outbox outbox;
+    std::vector<uint8_t> expected;
+    auto copy = [&](const std::vector<uint8_t>& frame) {
+        outbox.append(frame);
+        expected.insert(expected.end(), frame.begin(), frame.end());
+    };
+    auto share = [&](const SharedFrame& frame) {
+        outbox.append(frame);
+        expected.insert(expected.end(), frame.bytes().begin(), frame.bytes().end());
+    };
+    copy(frameOf(5, 1));
+    copy(frameOf(7, 2));
+    share(small);
+    share(big);
+    copy(frameOf(9, 3));
+    share(big);
+    // Copies (the small shared frame included) merge: copy run, big, copy, big.
+    if (outbox.segments() != 4 || big.useCount() != 3 || small.useCount() != 1 ||
+        outbox.pending() != expected.size()) {
+        return fail("Segments or references are wrong before the flush");
+    }
+    const Outbox::FlushResult result = outbox.flush(socket);
+    std::vector<uint8_t> received;
+    drain(fds[1], received);
+    ::close(fds[1]);
+    if (result.failed || result.calls != 1 || result.sent != expected.size() || received != expected) {
+        return fail("Flush did not write every frame in order with one call");
+    }
+    return (outbox.empty() && outbox.segments() == 0 && big.useCount() == 1) ||
+           fail("Sent frames were not released");
+}
+
+// A small socket buffer forces partial writes and EAGAIN; repeated flushes still deliver the exact stream.
+bool checkPartialWrites() {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) != 0) {
+        return fail("socketpair failed");
+    }
+    const int small = 4096;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    ::setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    Socket socket(fds[0]);
+    const SharedFrame shared = SharedFrame::copyOf(frameOf(700, 7));
+    Outbox outbox;
+    std::vector<uint8_t> expected;
+    // 300 alternating segments: more than kMaxIovecs per call and far more than the socket buffer.
+    for (int i = 0; i < 150; ++i) {
+        const std::vector<uint8_t> own = frameOf(11 + i % 40, static_cast<uint8_t>(i));
+        outbox.append(own);
+        expected.insert(expected.end(), own.begin(), own.end());
+        outbox.append(shared);
+        expected.insert(expected.end(), shared.bytes().begin(), shared.bytes().end());
+    }
+    std::vector<uint8_t> received;
+    uint32_t calls = 0;
+    bool partial = false;
+    for (int round = 0; round < 100000 && !outbox.empty(); ++round) {
+        const Outbox::FlushResult result = outbox.flush(socket);
+        if (result.failed) {
+            ::close(fds[1]);
+            return fail(std::string("Flush failed: ") + std::strerror(errno));
+        }
+        calls += result.calls;
+        partial = partial || !outbox.empty();
+        drain(fds[1], received);
+    }
+    drain(fds[1], received);
+    ::close(fds[1]);
+    if (!partial || calls < 2 || !outbox.empty() || received != expected) {
+        return fail("Partial writes lost, reordered or duplicated bytes");
+    }
+    return shared.useCount() == 1 || fail("Shared frame still referenced after everything was sent");
+}
+
+} // namespace
+
+int main() {
+    return checkSharedFrame() && checkOrder() && checkPartialWrites() ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) DarkEmu
+ * PacketWriter tests: header sizes, endian writers, spilling and the buffer pool.
+ */
+
+#include "Common/Network/PacketWriter.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+bool same(std::span<const uint8_t> actual, const std::vector<uint8_t>& expected) {
+    return std::vector<uint8_t>(actual.begin(), actual.end()) == expected;
+}
+
+// Packet struct used to check begin<T>(): C1 <size> F1 00 <value:BE16>.
+struct TestPacket {
+    using Header = C1SubHeader<0xF1, 0x00>;
+    Header header;
+    BigEndian<uint16_t> value;
+};
+
+// C1 and C2 headers get their size on finish(), and each writer stores its byte order.
+bool checkHeaders() {
+    PacketWriter<32> c1;
+    c1.begin(0xC1, 0xF3);
+    c1.writeU8(0x10);
+    c1.writeU16LE(0x1234);
+    c1.writeU16BE(0x1234);
+    c1.writeU32LE(0xA1B2C3D4);
+    c1.writeU32BE(0xA1B2C3D4);
+    c1.writeString("abc", 5);
+    if (!same(c1.finish(), {0xC1, 0x15, 0xF3, 0x10, 0x34, 0x12, 0x12, 0x34, 0xD4, 0xC3, 0xB2, 0xA1, 0xA1, 0xB2,
+                            0xC3, 0xD4, 'a', 'b', 'c', 0x00, 0x00})) {
+        return fail("C1 frame layout is wrong");
+    }
+
+    PacketWriter<16> c2;
+    c2.begin(0xC2, 0xF4);
+    c2.writeString("truncated name", 4);
+    if (!same(c2.finish(), {0xC2, 0x00, 0x08, 0xF4, 't', 'r', 'u', 0x00})) {
+        return fail("C2 frame layout or string truncation is wrong");
+    }
+
+    PacketWriter<sizeof(TestPacket)> typed;
+    typed.begin<TestPacket>().value = 0xBEEF;
+    if (!same(typed.finish(), {0xC1, 0x06, 0xF1, 0x00, 0xBE, 0xEF}) || typed.spilled()) {
+        return fail("Typed begin<T>() produced the wrong frame");
+    }
+    return true;
+}
+
+// Frames larger than the inline storage spill into a pooled buffer that is reused.
+bool checkSpill() {
+    std::vector<uint8_t> expected{0xC2, 0x01, 0x04, 0xF4};
+    {
+        PacketWriter<8> writer;
+        writer.begin(0xC2, 0xF4);
+        for (int i = 0; i < 256; ++i) {
+            writer.writeU8(static_cast<uint8_t>(i));
+            if (expected.size() < 0x104) {
+                expected.push_back(static_cast<uint8_t>(i));
+            }
+        }
+        if (!writer.spilled() || !same(writer.finish(), expected)) {
+            return fail("Spilled frame lost data");
+        }
+    }
+    if (PacketBufferPool::pooled() != 1) {
+        return fail("Spill buffer was not returned to the pool");
+    }
+    {
+        PacketWriter<8> writer;
+        writer.begin(0xC1, 0x01);
+        writer.writeBytes(std::vector<uint8_t>(20, 0xAA));
+        if (PacketBufferPool::pooled() != 0 || writer.finish().size() != 23) {
+            return fail("Second spill did not reuse the pooled buffer");
+        }
+    }
+    return true;
+}
+
+// Frames that outgrow their size field are refused.
+bool checkLimits() {
+    PacketWriter<300> c1;
+    c1.begin(0xC1, 0x00);
+    c1.writeBytes(std::vector<uint8_t>(253, 0));
+    try {
+        c1.finish();
+        return fail("Oversized C1 frame was accepted");
+    } catch (const std::length_error&) {
+    }
+    PacketWriter<4> empty;
+    try {
+        empty.finish();
+        return fail("finish() without begin() was accepted");
+    } catch (const std::logic_error&) {
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    try {
+        if (!checkHeaders() || !checkSpill() || !checkLimits()) {
+            return 1;
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) DarkEmu
+ * Capture and replay test: record ConnectServer sessions, reload them and replay at max speed.
+ */
+
+#include "Common/Network/SessionRecorder.h"
+#include "ConnectServer/Managers/ServerListManager.h"
+#include "ConnectServer/ServerEngine.h"
+#include "Tools/ReplayEngine.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kSessions = 5;
+
+// Send one server list request and wait for the server to close the connection.
+bool requestServerList(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return false;
+    }
+    timeval tv{1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        ::close(fd);
+        return false;
+    }
+    std::array<uint8_t, 4> request{0xC1, 0x04, 0xF4, 0x06};
+    if (::send(fd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size())) {
+        ::close(fd);
+        return false;
+    }
+    // The ConnectServer replies once and closes; drain until EOF.
+    std::array<uint8_t, 64> buffer{};
+    ssize_t received = 0;
+    size_t total = 0;
+    while ((received = ::recv(fd, buffer.data(), buffer.size(), 0)) > 0) {
+        total += static_cast<size_t>(received);
+    }
+    ::close(fd);
+    return total > 0;
+}
+
+} // namespace
+
+int main() {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / ("darkemu_replay_" + std::to_string(::getpid()) + ".demucap"))
+            .string();
+    try {
+        ServerListManager::Instance()->AddServer(0, "Test PVP", "127.0.0.1", 55901, true);
+
+        ServerEngine server(0);
+        server.enableCapture(path);
+        std::atomic_bool stop{false};
+        std::thread server_thread([&] {
+            while (!stop.load()) {
+                server.runOnce(20);
+            }
+        });
+        auto fail = [&](const std::string& message) {
+            std::cerr << message << '\n';
+            stop.store(true);
+            server_thread.join();
+            std::remove(path.c_str());
+            return 1;
+        };
+
+        // Capture a handful of request/close sessions.
+        for (int i = 0; i < kSessions; ++i) {
+            if (!requestServerList(server.port())) {
+                return fail("Capture request failed");
+            }
+        }
+        // Records reach the file with the reactor's next periodic flush.
+        std::this_thread::sleep_for(SessionRecorder::kFlushInterval + std::chrono::milliseconds(100));
+
+        std::vector<CaptureRecord> records;
+        if (!SessionRecorder::Load(path, records)) {
+            return fail("Capture file could not be loaded");
+        }
+        const std::vector<ReplaySession> sessions = buildReplaySessions(records);
+        if (sessions.size() != kSessions) {
+            return fail("Expected " + std::to_string(kSessions) + " sessions, got " + std::to_string(sessions.size()));
+        }
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            const ReplaySession& session = sessions[i];
+            if (session.frames.size() != 1 || session.frames[0].bytes != std::vector<uint8_t>{0xC1, 0x04, 0xF4, 0x06} ||
+                session.server_first || (i > 0 && session.open_us < sessions[i - 1].open_us)) {
+                return fail("Unexpected session layout for capture id " + std::to_string(session.id));
+            }
+        }
+
+        // A truncated final record is dropped rather than failing the load.
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 2);
+        std::vector<CaptureRecord> truncated;
+        if (!SessionRecorder::Load(path, truncated) || truncated.size() != records.size() - 1) {
+            return fail("Truncated capture was not recovered");
+        }
+
+        // Replay every session three times at max speed against the same server.
+        ReplayProfile profile;
+        profile.port = server.port();
+        profile.speed = 0.0;
+        profile.copies = 3;
+        profile.linger = std::chrono::milliseconds(500);
+        profile.timeout = std::chrono::milliseconds(1000);
+        ReplayEngine engine(profile, sessions);
+        const ReplayStats stats = engine.run();
+        if (stats.sessions != kSessions * 3 || stats.completed != stats.sessions ||
+            stats.frames_sent != stats.sessions || stats.totalErrors() != 0 || stats.bytes_received == 0) {
+            stats.print(std::cerr);
+            return fail("Replay did not complete cleanly");
+        }
+
+        stop.store(true);
+        server_thread.join();
+        std::remove(path.c_str());
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        std::remove(path.c_str());
+        return 1;
+    }
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) DarkEmu
+ * SimpleModulus tests: reference compatibility, kernel parity, frames and key files.
+ */
+
+#include "Common/Crypto/SimpleModulus.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+/*
+ * Literal port of the original bit-stream block code (AddBits/Shift over
+ * little-endian DWORDs), kept deliberately naive as the compatibility oracle.
+ */
+namespace reference {
+
+void shift(uint8_t* buffer, int size, int length) {
+    if (length > 0) {
+        for (int i = size - 1; i > 0; --i) {
+            buffer[i] = static_cast<uint8_t>((buffer[i - 1] << (8 - length)) | (buffer[i] >> length));
+        }
+        buffer[0] >>= length;
+    } else if (length < 0) {
+        length = -length;
+        for (int i = 0; i < size - 1; ++i) {
+            buffer[i] = static_cast<uint8_t>((buffer[i + 1] >> (8 - length)) | (buffer[i] << length));
+        }
+        buffer[size - 1] = static_cast<uint8_t>(buffer[size - 1] << length);
+    }
+}
+
+int addBits(void* dest, int destBitPos, const void* source, int sourceBitPos, int bitLength) {
+    const int source_end = bitLength + sourceBitPos;
+    const int temp_length = ((source_end - 1) >> 3) + 1 - (sourceBitPos >> 3);
+    std::vector<uint8_t> temp(static_cast<size_t>(temp_length) + 1, 0);
+    std::memcpy(temp.data(), static_cast<const uint8_t*>(source) + (sourceBitPos >> 3), static_cast<size_t>(temp_length));
+    if (source_end % 8 != 0) {
+        temp[static_cast<size_t>(temp_length) - 1] &= static_cast<uint8_t>(0xFF << (8 - source_end % 8));
+    }
+    const int shift_left = sourceBitPos % 8;
+    const int shift_right = destBitPos % 8;
+    shift(temp.data(), temp_length, -shift_left);
+    shift(temp.data(), temp_length + 1, shift_right);
+    const int new_length = (shift_right <= shift_left ? 0 : 1) + temp_length;
+    uint8_t* target = static_cast<uint8_t*>(dest) + (destBitPos >> 3);
+    for (int i = 0; i < new_length; ++i) {
+        target[i] |= temp[static_cast<size_t>(i)];
+    }
+    return destBitPos + bitLength;
+}
+
+void encryptBlock(const SimpleModulusKeys& keys, uint8_t* dest, const uint8_t* source, int size) {
+    uint32_t buffer[4];
+    uint32_t value = 0;
+    std::memset(dest, 0, 11);
+    for (int i = 0; i < 4; ++i) {
+        uint16_t word = 0;
+        std::memcpy(&word, source + 2 * i, 2);
+        buffer[i] = ((keys.xor_key[i] ^ word ^ value) * keys.encryption[i]) % keys.modulus[i];
+        value = buffer[i] & 0xFFFF;
+    }
+    for (int i = 0; i < 3; ++i) {
+        buffer[i] = buffer[i] ^ keys.xor_key[i] ^ (buffer[i + 1] & 0xFFFF);
+    }
+    int position = 0;
+    for (int i = 0; i < 4; ++i) {
+        position = addBits(dest, position, &buffer[i], 0, 16);
+        position = addBits(dest, position, &buffer[i], 22, 2);
+    }
+    uint8_t checksum = 0xF8;
+    for (int i = 0; i < 8; ++i) {
+        checksum ^= source[i];
+    }
+    uint8_t tail[4]{static_cast<uint8_t>(checksum ^ size ^ 0x3D), checksum, 0, 0};
+    addBits(dest, position, tail, 0, 16);
+}
+
+int decryptBlock(const SimpleModulusKeys& keys, uint8_t* dest, const uint8_t* source) {
+    std::memset(dest, 0, 8);
+    uint32_t buffer[4]{};
+    int position = 0;
+    for (int i = 0; i < 4; ++i) {
+        addBits(&buffer[i], 0, source, position, 16);
+        position += 16;
+        addBits(&buffer[i], 22, source, position, 2);
+        position += 2;
+    }
+    for (int i = 2; i >= 0; --i) {
+        buffer[i] = buffer[i] ^ keys.xor_key[i] ^ (buffer[i + 1] & 0xFFFF);
+    }
+    uint32_t previous = 0;
+    for (int i = 0; i < 4; ++i) {
+        const uint32_t word = ((keys.decryption[i] * buffer[i]) % keys.modulus[i]) ^ keys.xor_key[i] ^ previous;
+        previous = buffer[i] & 0xFFFF;
+        dest[2 * i] = static_cast<uint8_t>(word);
+        dest[2 * i + 1] = static_cast<uint8_t>(word >> 8);
+    }
+    uint8_t tail[4]{};
+    addBits(tail, 0, source, position, 16);
+    tail[0] = static_cast<uint8_t>(tail[1] ^ tail[0] ^ 0x3D);
+    uint8_t checksum = 0xF8;
+    for (int i = 0; i < 8; ++i) {
+        checksum ^= dest[i];
+    }
+    return checksum == tail[1] ? tail[0] : -1;
+}
+
+} // namespace reference
+
+constexpr SimpleModulus::SimdLevel kLevels[]{SimpleModulus::SimdLevel::Scalar, SimpleModulus::SimdLevel::Sse41,
+                                             SimpleModulus::SimdLevel::Avx2};
+
+// Encrypt with the reference block code (zero-padded final block).
+std::vector<uint8_t> referenceEncrypt(const SimpleModulusKeys& keys, const std::vector<uint8_t>& plain) {
+    std::vector<uint8_t> padded(plain);
+    padded.resize((plain.size() + 7) / 8 * 8, 0);
+    std::vector<uint8_t> cipher(padded.size() / 8 * 11);
+    for (size_t b = 0; b * 8 < plain.size(); ++b) {
+        const int size = static_cast<int>(std::min<size_t>(8, plain.size() - b * 8));
+        reference::encryptBlock(keys, cipher.data() + b * 11, padded.data() + b * 8, size);
+    }
+    return cipher;
+}
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// Every kernel must match the reference byte for byte in both directions.
+bool checkReferenceParity(const SimpleModulusKeys& keys, const char* label) {
+    std::mt19937 rng(1234);
+    for (size_t size = 1; size <= 300; ++size) {
+        std::vector<uint8_t> plain(size);
+        for (auto& byte : plain) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        const std::vector<uint8_t> expected = referenceEncrypt(keys, plain);
+
+        for (SimpleModulus::SimdLevel level : kLevels) {
+            SimpleModulus cipher(keys);
+            cipher.setSimdLevel(level);
+            const char* name = SimpleModulus::simdLevelName(cipher.simdLevel());
+
+            std::vector<uint8_t> encrypted(SimpleModulus::encryptedSize(size));
+            cipher.encrypt(encrypted, plain);
+            if (encrypted != expected) {
+                return fail(std::string(label) + ": " + name + " encrypt differs from reference at size " +
+                            std::to_string(size));
+            }
+
+            std::vector<uint8_t> decrypted(SimpleModulus::decryptedCapacity(encrypted.size()));
+            size_t plain_size = 0;
+            if (!cipher.decrypt(decrypted, encrypted, plain_size) || plain_size != size ||
+                !std::equal(plain.begin(), plain.end(), decrypted.begin())) {
+                return fail(std::string(label) + ": " + name + " decrypt round trip failed at size " +
+                            std::to_string(size));
+            }
+
+            // The reference decoder must accept our blocks too.
+            for (size_t b = 0; b < encrypted.size() / 11; ++b) {
+                uint8_t block[8];
+                const int block_size = reference::decryptBlock(keys, block, encrypted.data() + b * 11);
+                if (block_size != static_cast<int>(std::min<size_t>(8, size - b * 8)) ||
+                    std::memcmp(block, decrypted.data() + b * 8, 8) != 0) {
+                    return fail(std::string(label) + ": reference rejects block " + std::to_string(b));
+                }
+            }
+        }
+    }
+
+    // Arbitrary ciphertext (wrapped products, out-of-range residues) must decrypt identically on every kernel.
+    std::vector<uint8_t> noise(11 * 37);
+    for (auto& byte : noise) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> scalar_words(8 * 37);
+    for (size_t b = 0; b < 37; ++b) {
+        reference::decryptBlock(keys, scalar_words.data() + b * 8, noise.data() + b * 11);
+    }
+    for (SimpleModulus::SimdLevel level : kLevels) {
+        SimpleModulus cipher(keys);
+        cipher.setSimdLevel(level);
+        std::vector<uint8_t> words(8 * 37);
+        size_t ignored = 0;
+        cipher.decrypt(words, noise, ignored);
+        if (words != scalar_words) {
+            return fail(std::string(label) + ": " + SimpleModulus::simdLevelName(cipher.simdLevel()) +
+                        " decrypt of random blocks differs from reference");
+        }
+    }
+    return true;
+}
+
+// C1/C2 frames survive a C3/C4 round trip and damaged frames are rejected.
+bool checkFrames() {
+    SimpleModulus cipher(SimpleModulusKeys::clientToServer());
+
+    const std::vector<uint8_t> c1{0xC1, 0x0C, 0xF1, 0x01, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'};
+    std::vector<uint8_t> c3;
+    if (!cipher.encryptFrame(c1, 0x2A, c3) || c3[0] != 0xC3 || c3[1] != c3.size() || c3.size() != 2 + 22) {
+        return fail("C1 -> C3 encryption produced an unexpected frame");
+    }
+    std::vector<uint8_t> back;
+    uint8_t serial = 0;
+    if (!cipher.decryptFrame(c3, back, serial) || back != c1 || serial != 0x2A) {
+        return fail("C3 -> C1 round trip failed");
+    }
+
+    std::vector<uint8_t> c2{0xC2, 0x01, 0x2C, 0xF3};
+    while (c2.size() < 0x12C) {
+        c2.push_back(static_cast<uint8_t>(c2.size()));
+    }
+    std::vector<uint8_t> c4;
+    if (!cipher.encryptFrame(c2, 0x07, c4) || c4[0] != 0xC4 || ((c4[1] << 8) | c4[2]) != static_cast<int>(c4.size())) {
+        return fail("C2 -> C4 encryption produced an unexpected frame");
+    }
+    if (!cipher.decryptFrame(c4, back, serial) || back != c2 || serial != 0x07) {
+        return fail("C4 -> C2 round trip failed");
+    }
+
+    // A damaged checksum byte or a truncated block must not decrypt.
+    std::vector<uint8_t> damaged(c3);
+    damaged.back() ^= 0x01;
+    if (cipher.decryptFrame(damaged, back, serial)) {
+        return fail("Damaged C3 frame was accepted");
+    }
+    damaged.assign(c3.begin(), c3.end() - 1);
+    if (cipher.decryptFrame(damaged, back, serial)) {
+        return fail("Truncated C3 frame was accepted");
+    }
+
+    // A C1 body that no longer fits a one-byte C3 size is refused.
+    std::vector<uint8_t> big(0xFF, 0x00);
+    big[0] = 0xC1;
+    big[1] = 0xFF;
+    if (cipher.encryptFrame(big, 0, c3)) {
+        return fail("Oversized C1 frame was encrypted into a C3 frame");
+    }
+    return true;
+}
+
+// Key files round-trip and malformed files are refused.
+bool checkKeyFiles() {
+    const std::filesystem::path dir =
+        std::filesystem::temp_directory_path() / ("darkemu_keys_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(dir);
+    const SimpleModulusKeys keys = SimpleModulusKeys::serverToClient();
+    const std::string enc_path = (dir / "Enc1.dat").string();
+    const std::string dec_path = (dir / "Dec1.dat").string();
+    SimpleModulus writer(keys);
+    bool ok = writer.saveEncryptionKey(enc_path) && writer.saveDecryptionKey(dec_path);
+    if (ok && std::filesystem::file_size(enc_path) != 56) {
+        ok = fail("Key file has the wrong size");
+    }
+
+    SimpleModulus reader;
+    if (ok && (!reader.loadEncryptionKey(enc_path) || !reader.loadDecryptionKey(dec_path) ||
+               reader.keys().modulus != keys.modulus || reader.keys().encryption != keys.encryption ||
+               reader.keys().decryption != keys.decryption || reader.keys().xor_key != keys.xor_key)) {
+        ok = fail("Key files did not round-trip");
+    }
+
+    // Truncated or missing files.
+    std::filesystem::resize_file(dec_path, 40);
+    if (ok && reader.loadDecryptionKey(dec_path)) {
+        ok = fail("Truncated key file was accepted");
+    }
+    if (ok && reader.loadDecryptionKey((dir / "missing.dat").string())) {
+        ok = fail("Missing key file was accepted");
+    }
+    std::filesystem::remove_all(dir);
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    try {
+        std::cout << "SimpleModulus kernel: " << SimpleModulus::simdLevelName(SimpleModulus::supportedSimdLevel())
+                  << '\n';
+        if (!checkReferenceParity(SimpleModulusKeys::clientToServer(), "client->server") ||
+            !checkReferenceParity(SimpleModulusKeys::serverToClient(), "server->client") || !checkFrames() ||
+            !checkKeyFiles()) {
+            return 1;
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) DarkEmu
+ * Spatial grid tests: map edges, cell crossings, removal and random moves against a brute-force scan.
+ */
+
+#include "GameServer/SpatialGrid.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+std::vector<uint32_t> sortedQuery(const SpatialGrid& grid, uint8_t x, uint8_t y, uint8_t radius) {
+    std::vector<uint32_t> found;
+    grid.query(x, y, radius, found);
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+// Corners, radius 0, a whole-map radius, moves within and across cells, and removal.
+bool checkBasics() {
+    SpatialGrid grid;
+    grid.insert(1, 0, 0);
+    grid.insert(2, 255, 255);
+    grid.insert(3, 7, 7);
+    grid.insert(4, 8, 8);
+    if (grid.size() != 4 || !grid.contains(3) || grid.contains(5) || grid.contains(100000)) {
+        return fail("Size or membership is wrong after inserts");
+    }
+    if (sortedQuery(grid, 0, 0, 0) != std::vector<uint32_t>{1} ||
+        sortedQuery(grid, 255, 255, 0) != std::vector<uint32_t>{2}) {
+        return fail("Radius 0 at the map corners is wrong");
+    }
+    if (sortedQuery(grid, 7, 7, 1) != std::vector<uint32_t>{3, 4} ||
+        sortedQuery(grid, 128, 128, 255) != std::vector<uint32_t>{1, 2, 3, 4}) {
+        return fail("Ranges across cells or over the whole map are wrong");
+    }
+    grid.move(3, 6, 6);  // same cell
+    grid.move(4, 200, 9); // another cell
+    grid.insert(1, 3, 3); // insert of a present entity moves it
+    if (grid.size() != 4 || sortedQuery(grid, 6, 6, 3) != std::vector<uint32_t>{1, 3} ||
+        sortedQuery(grid, 200, 9, 0) != std::vector<uint32_t>{4}) {
+        return fail("Moves did not update the grid");
+    }
+    grid.remove(3);
+    grid.remove(3);
+    grid.remove(77);
+    if (grid.size() != 3 || grid.contains(3) || sortedQuery(grid, 6, 6, 3) != std::vector<uint32_t>{1}) {
+        return fail("Removal left the entity behind");
+    }
+    return true;
+}
+
+// Thousands of random inserts, moves and removals agree with a brute-force scan of the positions.
+bool checkAgainstBruteForce() {
+    constexpr uint32_t kEntities = 3000;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> tile(0, 255);
+    std::uniform_int_distribution<int> step(-3, 3);
+    std::uniform_int_distribution<uint32_t> pick(0, kEntities - 1);
+    SpatialGrid grid;
+    struct Position {
+        bool present{false};
+        uint8_t x{0};
+        uint8_t y{0};
+    };
+    std::vector<Position> positions(kEntities);
+    for (int round = 0; round < 20000; ++round) {
+        const uint32_t entity = pick(rng);
+        Position& position = positions[entity];
+        const int action = round % 10;
+        if (!position.present || action == 0) {
+            position = {true, static_cast<uint8_t>(tile(rng)), static_cast<uint8_t>(tile(rng))};
+            grid.insert(entity, position.x, position.y);
+        } else if (action == 1) {
+            position.present = false;
+            grid.remove(entity);
+        } else {
+            // Walk-sized steps, clamped to the map, so many moves stay in their cell.
+            position.x = static_cast<uint8_t>(std::clamp(position.x + step(rng), 0, 255));
+            position.y = static_cast<uint8_t>(std::clamp(position.y + step(rng), 0, 255));
+            grid.move(entity, position.x, position.y);
+        }
+        if (round % 500 != 0) {
+            continue;
+        }
+        const auto x = static_cast<uint8_t>(tile(rng));
+        const auto y = static_cast<uint8_t>(tile(rng));
+        const auto radius = static_cast<uint8_t>(round % 40);
+        std::vector<uint32_t> expected;
+        for (uint32_t id = 0; id < kEntities; ++id) {
+            const Position& p = positions[id];
+            if (p.present && std::abs(p.x - x) <= radius && std::abs(p.y - y) <= radius) {
+                expected.push_back(id);
+            }
+        }
+        if (sortedQuery(grid, x, y, radius) != expected) {
+            return fail("Query at round " + std::to_string(round) + " disagrees with the brute-force scan");
+        }
+    }
+    const auto present = static_cast<size_t>(
+            std::count_if(positions.begin(), positions.end(), [](const Position& p) { return p.present; }));
+    return grid.size() == present || fail("Grid size drifted from the number of present entities");
+}
+
+} // namespace
+
+int main() {
+    return checkBasics() && checkAgainstBruteForce() ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) DarkEmu
+ * SPSC queue tests: capacity rounding, full/empty edges, slot reuse and cross-thread ordering.
+ */
+
+#include "Common/Utils/SpscQueue.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// Capacity rounds up to a power of two and never drops below two.
+bool checkCapacity() {
+    if (SpscQueue<int>(0).capacity() != 2 || SpscQueue<int>(5).capacity() != 8 ||
+        SpscQueue<int>(64).capacity() != 64) {
+        return fail("Capacity is not rounded up to a power of two");
+    }
+    return true;
+}
+
+// A full queue refuses pushes until the consumer pops, and pops in FIFO order.
+bool checkFullAndEmpty() {
+    SpscQueue<int> queue(4);
+    int out = 0;
+    if (queue.front() != nullptr || queue.tryPop(out)) {
+        return fail("New queue is not empty");
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (!queue.tryPush(int{i})) {
+            return fail("Push failed before the queue was full");
+        }
+    }
+    if (queue.prepare() != nullptr || queue.tryPush(4) || queue.sizeApprox() != 4) {
+        return fail("Full queue accepted another element");
+    }
+    if (!queue.tryPop(out) || out != 0 || !queue.tryPush(4)) {
+        return fail("Pop did not free a slot");
+    }
+    for (int expected = 1; expected <= 4; ++expected) {
+        if (!queue.tryPop(out) || out != expected) {
+            return fail("Elements came out of order");
+        }
+    }
+    return queue.front() == nullptr || fail("Drained queue is not empty");
+}
+
+// prepare()/commit() fill slots in place, so a payload keeps its capacity once the ring wraps.
+bool checkSlotReuse() {
+    SpscQueue<std::vector<uint8_t>> queue(2);
+    const uint8_t* first = nullptr;
+    for (int round = 0; round < 4; ++round) {
+        std::vector<uint8_t>* slot = queue.prepare();
+        slot->assign(64, static_cast<uint8_t>(round));
+        if (round == 0) {
+            first = slot->data();
+        }
+        queue.commit();
+        std::vector<uint8_t>* head = queue.front();
+        if (head == nullptr || head->size() != 64 || (*head)[0] != round) {
+            return fail("Prepared slot did not arrive intact");
+        }
+        queue.pop();
+    }
+    // Rounds 0 and 2 used the same slot; assign() into it must not have reallocated.
+    return queue.prepare()->data() == first || fail("Slot payload was reallocated on reuse");
+}
+
+// One producer and one consumer thread move a long sequence through a small ring without loss.
+bool checkThreads() {
+    constexpr uint64_t kCount = 1'000'000;
+    SpscQueue<uint64_t> queue(64);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < kCount; ++i) {
+            while (!queue.tryPush(uint64_t{i})) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < kCount) {
+        uint64_t value = 0;
+        if (!queue.tryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && value == expected;
+        ++expected;
+    }
+    producer.join();
+    return ordered || fail("Consumer saw elements out of order");
+}
+
+} // namespace
+
+int main() {
+    return checkCapacity() && checkFullAndEmpty() && checkSlotReuse() && checkThreads() ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) DarkEmu
+ * Scrape test for the HTTP metrics endpoint on the ConnectServer reactor, including a scraper that half-closes.
+ */
+
+#include "ConnectServer/Managers/ServerListManager.h"
+#include "ConnectServer/ServerEngine.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+// Issue one HTTP/1.0 request and return the full response (empty on failure). With paused set, the request and a
+// half-close are sent while the server loop is paused, so both arrive in the same wake-up, and the loop resumes after.
+std::string httpGet(uint16_t port, const std::string& path, std::atomic_bool* paused = nullptr) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return {};
+    }
+
+    // Configure a receive timeout so the test doesn't hang.
+    timeval tv{};
+    tv.tv_sec = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        std::cerr << "Connect failed: " << std::strerror(errno) << '\n';
+        ::close(fd);
+        return {};
+    }
+
+    const std::string request = "GET " + path + " HTTP/1.0\r\nHost: localhost\r\n\r\n";
+    if (paused != nullptr) {
+        paused->store(true);
+        // Outlast the runOnce(50) that may still be waiting.
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (::send(fd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size()) ||
+        (paused != nullptr && ::shutdown(fd, SHUT_WR) == -1)) {
+        if (paused != nullptr) {
+            paused->store(false);
+        }
+        ::close(fd);
+        return {};
+    }
+    if (paused != nullptr) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        paused->store(false);
+    }
+
+    // The server closes the connection after the response.
+    std::string response;
+    char buffer[1024];
+    while (true) {
+        ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            response.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received == -1 && errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+    ::close(fd);
+    return response;
+}
+
+} // namespace
+
+int main() {
+    try {
+        // Seed the server list to avoid external config dependencies.
+        ServerListManager::Instance()->AddServer(0, "Test PVP", "127.0.0.1", 55901, true);
+        ServerListManager::Instance()->AddServer(20, "Test VIP", "127.0.0.1", 55919, true);
+        const uint64_t version = ServerListManager::Instance()->Version();
+
+        // Start the server with the metrics endpoint on an ephemeral port.
+        ServerEngine server(0);
+        server.enableStatusEndpoint(0);
+        std::atomic_bool stop{false};
+        std::atomic_bool paused{false};
+        std::thread server_thread([&] {
+            while (!stop.load()) {
+                if (paused.load()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                server.runOnce(50);
+            }
+        });
+
+        const std::string metrics = httpGet(server.statusPort(), "/metrics");
+        const std::string missing = httpGet(server.statusPort(), "/nope");
+        // A scraper that shuts down its side right after the request still gets the response.
+        const std::string half_closed = httpGet(server.statusPort(), "/metrics", &paused);
+        stop.store(true);
+        server_thread.join();
+
+        // Validate status line, content type and the exported series.
+        if (!metrics.starts_with("HTTP/1.0 200 OK\r\n")) {
+            std::cerr << "Unexpected status line: " << metrics.substr(0, 32) << '\n';
+            return 1;
+        }
+        if (metrics.find("Content-Type: text/plain; version=0.0.4") == std::string::npos) {
+            std::cerr << "Missing Prometheus content type\n";
+            return 1;
+        }
+        const std::string expected_version = "darkemu_connect_serverlist_version " + std::to_string(version) + "\n";
+        for (const std::string& needle : {std::string("# TYPE darkemu_connect_connections_accepted_total counter"),
+                                          std::string("darkemu_connect_connections_active"),
+                                          std::string("darkemu_connect_request_duration_seconds_bucket{le=\"+Inf\"}"),
+                                          expected_version}) {
+            if (metrics.find(needle) == std::string::npos) {
+                std::cerr << "Missing series: " << needle << '\n';
+                return 1;
+            }
+        }
+        if (!missing.starts_with("HTTP/1.0 404 Not Found\r\n")) {
+            std::cerr << "Unknown path did not return 404\n";
+            return 1;
+        }
+        if (!half_closed.starts_with("HTTP/1.0 200 OK\r\n")) {
+            std::cerr << "Request followed by a half-close got no response\n";
+            return 1;
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
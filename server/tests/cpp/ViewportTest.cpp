@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) DarkEmu
+ * Viewport tracker tests: enter/leave deltas, cancellation within a tick, removal, and random walks replayed
+ * against a brute-force visibility scan.
+ */
+
+#include "GameServer/Viewport.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// What each recipient was told by one update().
+struct Delta {
+    std::vector<uint32_t> enters;
+    std::vector<uint32_t> leaves;
+};
+
+std::map<uint32_t, Delta> collect(ViewportTracker& tracker) {
+    std::map<uint32_t, Delta> deltas;
+    tracker.update([&deltas](uint32_t recipient, std::span<const uint32_t> enters, std::span<const uint32_t> leaves) {
+        Delta& delta = deltas[recipient];
+        delta.enters.assign(enters.begin(), enters.end());
+        delta.leaves.assign(leaves.begin(), leaves.end());
+        std::sort(delta.enters.begin(), delta.enters.end());
+        std::sort(delta.leaves.begin(), delta.leaves.end());
+    });
+    return deltas;
+}
+
+bool sees(const ViewportTracker& tracker, uint32_t viewer, std::vector<uint32_t> expected) {
+    const std::span<const uint32_t> visible = tracker.visible(viewer);
+    return std::vector<uint32_t>(visible.begin(), visible.end()) == expected;
+}
+
+// Entering, steps inside a cell, leaving, same-tick cancellation and removal.
+bool checkDeltas() {
+    ViewportTracker tracker;
+    tracker.add(1, 100, 100);
+    tracker.add(2, 110, 100); // two cells east: visible
+    tracker.add(3, 140, 100); // six cells east: not visible
+    auto deltas = collect(tracker);
+    if (deltas.size() != 2 || deltas[1].enters != std::vector<uint32_t>{2} ||
+        deltas[2].enters != std::vector<uint32_t>{1} || !sees(tracker, 1, {2}) || !sees(tracker, 3, {})) {
+        return fail("Initial enters are wrong");
+    }
+    // Steps that stay inside their cell produce nothing.
+    tracker.move(1, 103, 102);
+    tracker.move(2, 111, 101);
+    if (!collect(tracker).empty()) {
+        return fail("In-cell steps produced deltas");
+    }
+    // 2 walks far east: it leaves 1's view and enters 3's.
+    tracker.move(2, 150, 100);
+    deltas = collect(tracker);
+    if (deltas.size() != 3 || deltas[1].leaves != std::vector<uint32_t>{2} ||
+        deltas[2].leaves != std::vector<uint32_t>{1} || deltas[2].enters != std::vector<uint32_t>{3} ||
+        deltas[3].enters != std::vector<uint32_t>{2} || !deltas[1].enters.empty()) {
+        return fail("Walking across the view edge produced the wrong deltas");
+    }
+    // Into view and back out within one tick: 1 never hears about it.
+    tracker.move(2, 110, 100);
+    tracker.move(2, 150, 100);
+    if (!collect(tracker).empty() || !sees(tracker, 1, {})) {
+        return fail("Same-tick enter and leave did not cancel");
+    }
+    // Removal: the watchers are told, and the removed entity's pending changes are dropped.
+    tracker.add(4, 150, 104);
+    tracker.remove(4);
+    if (!collect(tracker).empty()) {
+        return fail("An entity added and removed within a tick was announced");
+    }
+    tracker.remove(3);
+    deltas = collect(tracker);
+    if (deltas.size() != 1 || deltas[2].leaves != std::vector<uint32_t>{3} || !sees(tracker, 2, {}) ||
+        !tracker.visible(3).empty() || tracker.grid().contains(3)) {
+        return fail("Removal did not reach the watchers");
+    }
+    return true;
+}
+
+// Random walks, warps and removals: replaying every delta on a model client must give the brute-force viewport.
+bool checkAgainstBruteForce() {
+    constexpr uint32_t kEntities = 400;
+    constexpr int kRadius = ViewportTracker::kRadiusCells;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> tile(64, 191);
+    std::uniform_int_distribution<int> step(-2, 2);
+    std::uniform_int_distribution<int> action(0, 99);
+    struct Entity {
+        bool present{false};
+        uint8_t x{0};
+        uint8_t y{0};
+        std::set<uint32_t> client; ///< What this entity's client was told it sees.
+    };
+    std::vector<Entity> entities(kEntities);
+    ViewportTracker tracker;
+    for (int tick = 0; tick < 300; ++tick) {
+        for (uint32_t id = 0; id < kEntities; ++id) {
+            Entity& entity = entities[id];
+            const int roll = action(rng);
+            if (!entity.present) {
+                if (roll < 20) {
+                    entity = Entity{true, static_cast<uint8_t>(tile(rng)), static_cast<uint8_t>(tile(rng)), {}};
+                    tracker.add(id, entity.x, entity.y);
+                }
+            } else if (roll == 0) {
+                // Logging out or warping away: the client forgets its viewport.
+                entity.present = false;
+                entity.client.clear();
+                tracker.remove(id);
+            } else if (roll < 60) {
+                entity.x = static_cast<uint8_t>(std::clamp(entity.x + step(rng), 0, 255));
+                entity.y = static_cast<uint8_t>(std::clamp(entity.y + step(rng), 0, 255));
+                tracker.move(id, entity.x, entity.y);
+            }
+        }
+        bool consistent = true;
+        tracker.update([&](uint32_t recipient, std::span<const uint32_t> enters, std::span<const uint32_t> leaves) {
+            std::set<uint32_t>& client = entities[recipient].client;
+            for (uint32_t other : leaves) {
+                consistent = client.erase(other) == 1 && consistent;
+            }
+            for (uint32_t other : enters) {
+                consistent = client.insert(other).second && consistent;
+            }
+        });
+        if (!consistent) {
+            return fail("Tick " + std::to_string(tick) + " entered a known entity or removed an unknown one");
+        }
+        for (uint32_t id = 0; id < kEntities; ++id) {
+            const Entity& entity = entities[id];
+            if (!entity.present) {
+                continue;
+            }
+            std::vector<uint32_t> expected;
+            for (uint32_t other = 0; other < kEntities; ++other) {
+                const Entity& candidate = entities[other];
+                if (other != id && candidate.present &&
+                    std::abs(candidate.x / 8 - entity.x / 8) <= kRadius &&
+                    std::abs(candidate.y / 8 - entity.y / 8) <= kRadius) {
+                    expected.push_back(other);
+                }
+            }
+            if (std::vector<uint32_t>(entity.client.begin(), entity.client.end()) != expected ||
+                !sees(tracker, id, expected)) {
+                return fail("Tick " + std::to_string(tick) + ": viewport of " + std::to_string(id) +
+                            " disagrees with the brute-force scan");
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    return checkDeltas() && checkAgainstBruteForce() ? 0 : 1;
+}
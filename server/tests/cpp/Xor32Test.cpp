@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) DarkEmu
+ * XOR32 tests: known frame, kernel parity against a reference and in-place framing.
+ */
+
+#include "Common/Crypto/Xor32.h"
+#include "Common/Network/PacketFramer.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr Xor32::SimdLevel kLevels[]{Xor32::SimdLevel::Scalar, Xor32::SimdLevel::Sse41, Xor32::SimdLevel::Avx2};
+
+bool fail(const std::string& message) {
+    std::cerr << message << '\n';
+    return false;
+}
+
+// Straightforward client-side encode: each body byte chains on the encoded byte before it.
+std::vector<uint8_t> referenceEncode(std::vector<uint8_t> frame, const Xor32::Key& key) {
+    for (size_t i = PacketFramer::headerSize(frame[0]) + 1; i < frame.size(); ++i) {
+        frame[i] ^= frame[i - 1] ^ key[i % Xor32::kKeySize];
+    }
+    return frame;
+}
+
+// Build a C1 (size < 256) or C2 frame with a random head code and body.
+std::vector<uint8_t> randomFrame(size_t size, std::mt19937& rng) {
+    std::vector<uint8_t> frame(size);
+    const bool wide = size >= 256;
+    frame[0] = wide ? 0xC2 : 0xC1;
+    if (wide) {
+        frame[1] = static_cast<uint8_t>(size >> 8);
+        frame[2] = static_cast<uint8_t>(size);
+    } else {
+        frame[1] = static_cast<uint8_t>(size);
+    }
+    for (size_t i = PacketFramer::headerSize(frame[0]); i < size; ++i) {
+        frame[i] = static_cast<uint8_t>(rng());
+    }
+    return frame;
+}
+
+// A hand-computed frame pins the key and the byte the chain starts from.
+bool checkKnownFrame() {
+    // 0xAA ^ key[3] (0xFE) ^ 0xF1 = 0xA5; 0xBB ^ key[4] (0x18) ^ 0xA5 = 0x06.
+    const std::vector<uint8_t> plain{0xC1, 0x05, 0xF1, 0xAA, 0xBB};
+    const std::vector<uint8_t> wire{0xC1, 0x05, 0xF1, 0xA5, 0x06};
+    for (Xor32::SimdLevel level : kLevels) {
+        Xor32 coder;
+        coder.setSimdLevel(level);
+        std::vector<uint8_t> frame(plain);
+        coder.encodeFrame(frame);
+        if (frame != wire) {
+            return fail("Known frame encoded incorrectly");
+        }
+        coder.decodeFrame(frame);
+        if (frame != plain) {
+            return fail("Known frame decoded incorrectly");
+        }
+    }
+    // Frames without body bytes after the head code are left alone.
+    std::vector<uint8_t> bare{0xC1, 0x03, 0xF1};
+    Xor32().decodeFrame(bare);
+    if (bare != std::vector<uint8_t>{0xC1, 0x03, 0xF1}) {
+        return fail("Frame without a body was modified");
+    }
+    return true;
+}
+
+// Every kernel matches the reference for C1 and C2 frames of every alignment, with both keys.
+bool checkParity() {
+    std::mt19937 rng(0x5EED);
+    Xor32::Key custom{};
+    for (auto& byte : custom) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    for (const Xor32::Key& key : {Xor32::kDefaultKey, custom}) {
+        for (size_t size = 3; size < 700; ++size) {
+            const std::vector<uint8_t> plain = randomFrame(size, rng);
+            const std::vector<uint8_t> wire = referenceEncode(plain, key);
+            for (Xor32::SimdLevel level : kLevels) {
+                Xor32 coder(key);
+                coder.setSimdLevel(level);
+                std::vector<uint8_t> frame(plain);
+                coder.encodeFrame(frame);
+                if (frame != wire) {
+                    return fail("Encode differs from reference at size " + std::to_string(size) + " (level " +
+                                SimpleModulus::simdLevelName(coder.simdLevel()) + ")");
+                }
+                coder.decodeFrame(frame);
+                if (frame != plain) {
+                    return fail("Decode differs from reference at size " + std::to_string(size) + " (level " +
+                                SimpleModulus::simdLevelName(coder.simdLevel()) + ")");
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Frames decoded in place inside a receive buffer leave their neighbours intact.
+bool checkInPlaceFraming() {
+    std::mt19937 rng(7);
+    const Xor32 coder;
+    std::vector<uint8_t> plain_stream;
+    std::vector<uint8_t> wire_stream;
+    for (size_t size : {5, 40, 300, 17, 255, 64}) {
+        const std::vector<uint8_t> plain = randomFrame(size, rng);
+        const std::vector<uint8_t> wire = referenceEncode(plain, Xor32::kDefaultKey);
+        plain_stream.insert(plain_stream.end(), plain.begin(), plain.end());
+        wire_stream.insert(wire_stream.end(), wire.begin(), wire.end());
+    }
+    bool invalid = false;
+    size_t frames = 0;
+    const size_t consumed = PacketFramer::forEachFrameInPlace(wire_stream, [&](std::span<uint8_t> frame) {
+        coder.decodeFrame(frame);
+        ++frames;
+    }, invalid);
+    if (invalid || frames != 6 || consumed != wire_stream.size() || wire_stream != plain_stream) {
+        return fail("In-place decoding of a frame stream failed");
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    try {
+        std::cout << "Xor32 kernel: " << SimpleModulus::simdLevelName(Xor32().simdLevel()) << '\n';
+        if (!checkKnownFrame() || !checkParity() || !checkInPlaceFraming()) {
+            return 1;
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Test failed: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) DarkEmu
+ * Performance regression gate: allocation counts (and, opt-in, throughput) against a checked-in baseline.
+ */
+
+#include "tests/bench/AllocationCounter.h"
+
+#include "Common/Crypto/Xor32.h"
+#include "Common/Network/Socket.h"
+#include "ConnectServer/Managers/ServerListManager.h"
+#include "ConnectServer/Packets/PacketHandler.h"
+#include "ConnectServer/ServerEngine.h"
+#include "GameServer/GamePackets.h"
+#include "GameServer/GameServer.h"
+
+#include "common/Utils/json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// GameServer packets of the Season 6 client.
+using Packets = GamePackets<Season6Protocol>;
+
+constexpr const char* kUsage = "usage: Perf_RegressionTest --baseline FILE [--update] [--out FILE]\n";
+
+// Timed rounds per throughput metric; the best round is compared.
+constexpr int kRounds = 3;
+
+// Command-line options.
+struct Options {
+    std::string baseline_path;
+    std::string out_path;
+    bool update{false};
+};
+
+// How a metric is compared against its baseline.
+enum class MetricKind { Throughput, Allocations };
+
+// One measured value.
+struct Measurement {
+    std::string name;
+    MetricKind kind;
+    double value;
+};
+
+// Parse --baseline, --update and --out.
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--baseline") {
+            options.baseline_path = next();
+        } else if (arg == "--out") {
+            options.out_path = next();
+        } else if (arg == "--update") {
+            options.update = true;
+        } else {
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    if (options.baseline_path.empty()) {
+        throw std::runtime_error("--baseline is required");
+    }
+    return options;
+}
+
+// Blocking loopback client connected to port.
+int connectClient(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        throw std::runtime_error("socket failed");
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        ::close(fd);
+        throw std::runtime_error("connect failed");
+    }
+    return fd;
+}
+
+// Send every byte on a blocking descriptor.
+void sendAll(int fd, const uint8_t* data, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        const ssize_t sent = ::send(fd, data + offset, size - offset, MSG_NOSIGNAL);
+        if (sent <= 0 && errno != EINTR) {
+            throw std::runtime_error("client send failed");
+        }
+        offset += static_cast<size_t>(std::max<ssize_t>(sent, 0));
+    }
+}
+
+/**
+ * One ConnectServer session driven from this thread: connect, request the server
+ * list, pump the reactor until the reply and the server-side close arrive.
+ * The client side uses only syscalls, so every counted allocation is the server's.
+ */
+void serverListSession(ServerEngine& server, size_t replySize) {
+    const int fd = connectClient(server.port());
+    const std::array<uint8_t, 4> request{0xC1, 0x04, 0xF4, 0x06};
+    sendAll(fd, request.data(), request.size());
+
+    std::array<uint8_t, 256> reply{};
+    size_t received = 0;
+    bool closed = false;
+    for (int spins = 0; !closed; ++spins) {
+        if (spins > 10000) {
+            ::close(fd);
+            throw std::runtime_error("server list session did not complete");
+        }
+        server.runOnce(0);
+        while (true) {
+            const ssize_t bytes = ::recv(fd, reply.data(), reply.size(), MSG_DONTWAIT);
+            if (bytes > 0) {
+                received += static_cast<size_t>(bytes);
+                continue;
+            }
+            closed = bytes == 0;
+            break;
+        }
+    }
+    ::close(fd);
+    if (received != replySize) {
+        throw std::runtime_error("unexpected server list reply size " + std::to_string(received));
+    }
+}
+
+// Best-of-kRounds operations per second for fn(n).
+double bestRate(const std::function<void(uint64_t)>& fn, uint64_t n) {
+    double best = 0.0;
+    for (int round = 0; round < kRounds; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        fn(n);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::max(best, static_cast<double>(n) / std::max(seconds, 1e-9));
+    }
+    return best;
+}
+
+// Allocations per operation over n operations after the first warm-up.
+double allocationsPerOp(const std::function<void(uint64_t)>& fn, uint64_t n) {
+    fn(n);
+    const uint64_t before = AllocationCounter::allocations();
+    fn(n);
+    return static_cast<double>(AllocationCounter::allocations() - before) / static_cast<double>(n);
+}
+
+// ConnectServer: full request cycle and the packet handler alone.
+void measureConnectServer(std::vector<Measurement>& results) {
+    ServerEngine server(0);
+    // A slow-handler log line allocates; keep scheduler hiccups from leaking into the counts.
+    server.setHandlerBudget(std::chrono::seconds(10));
+    std::vector<uint8_t> expected;
+    ServerListManager::Instance()->GetPacket(expected);
+
+    auto sessions = [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            serverListSession(server, expected.size());
+        }
+    };
+    results.push_back({"cs.allocs_per_request", MetricKind::Allocations, allocationsPerOp(sessions, 200)});
+    results.push_back({"cs.server_list_requests_per_sec", MetricKind::Throughput, bestRate(sessions, 2000)});
+
+    // Handler only, over a socketpair: isolates response building from accept/close bookkeeping.
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+        throw std::runtime_error("socketpair failed");
+    }
+    Socket socket(fds[0]);
+    const int client_fd = fds[1];
+    std::vector<uint8_t> reply(expected.size());
+    const std::array<uint8_t, 4> request{0xC1, 0x04, 0xF4, 0x06};
+    auto handle = [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            PacketHandler::Instance()->HandlePacket(socket, request);
+            if (::recv(client_fd, reply.data(), reply.size(), MSG_WAITALL) != static_cast<ssize_t>(reply.size())) {
+                throw std::runtime_error("handler reply missing");
+            }
+        }
+    };
+    results.push_back({"cs.handler_allocs_per_request", MetricKind::Allocations, allocationsPerOp(handle, 1000)});
+    ::close(client_fd);
+}
+
+// GameServer: frame ingest over one connection, in batches of walk-sized frames.
+void measureGameServer(std::vector<Measurement>& results) {
+    constexpr size_t kFramesPerWrite = 32;
+    GameServer server(0);
+    server.SetHandlerBudget(std::chrono::seconds(10));
+    // The walk route is rate limited per client; one client carries the whole load here.
+    server.SetRateLimit(GameServer::RateClass::Movement, 0);
+    const int fd = connectClient(server.Port());
+    // After the login reply a delayed ACK would let Nagle hold back the next batch.
+    const int nodelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    server.RunOnce(0);
+
+    // Log in and enter the world (unencrypted C1 login is accepted), then drop the replies.
+    Xor32 xor32;
+    std::vector<uint8_t> setup;
+    auto append = [&](std::span<const uint8_t> frame) {
+        std::vector<uint8_t> encoded(frame.begin(), frame.end());
+        xor32.encodeFrame(encoded);
+        setup.insert(setup.end(), encoded.begin(), encoded.end());
+    };
+    Packets::LoginRequest login = makePacket<Packets::LoginRequest>();
+    std::memcpy(login.account, "perf", 4);
+    buxConvert(login.account);
+    append(packetBytes(login));
+    Packets::SelectCharacterRequest select = makePacket<Packets::SelectCharacterRequest>();
+    std::memcpy(select.name, "perf", 4);
+    append(packetBytes(select));
+    sendAll(fd, setup.data(), setup.size());
+    for (int spins = 0; server.PacketsDispatched() < 2; ++spins) {
+        if (spins > 10000) {
+            throw std::runtime_error("GameServer did not accept the login");
+        }
+        server.RunOnce(0);
+    }
+    std::array<uint8_t, 256> replies{};
+    while (::recv(fd, replies.data(), replies.size(), MSG_DONTWAIT) > 0) {
+    }
+
+    std::vector<uint8_t> walk{0xC1, 0x08, 0xD4, 0x80, 0x80, 0x01, 0x23, 0x00};
+    xor32.encodeFrame(walk);
+    std::vector<uint8_t> batch;
+    for (size_t i = 0; i < kFramesPerWrite; ++i) {
+        batch.insert(batch.end(), walk.begin(), walk.end());
+    }
+
+    // Each batch is written and drained before the next, so recv sizes repeat exactly.
+    auto ingest = [&](uint64_t n) {
+        for (uint64_t sent = 0; sent < n; sent += kFramesPerWrite) {
+            const size_t target = server.BytesReceived() + batch.size();
+            sendAll(fd, batch.data(), batch.size());
+            for (int spins = 0; server.BytesReceived() < target; ++spins) {
+                if (spins > 10000) {
+                    throw std::runtime_error("GameServer stopped ingesting");
+                }
+                server.RunOnce(0);
+            }
+        }
+    };
+
+    // Counted per write, not per packet: spread over a batch, one extra allocation per wake-up would stay under the
+    // tolerance.
+    const double allocs = allocationsPerOp(ingest, 32 * kFramesPerWrite) * kFramesPerWrite;
+    const double rate = bestRate(ingest, 1000 * kFramesPerWrite);
+
+    results.push_back({"gs.allocs_per_write", MetricKind::Allocations, allocs});
+    results.push_back({"gs.packets_per_sec", MetricKind::Throughput, rate});
+    ::close(fd);
+}
+
+/**
+ * Compare measurements with the baseline and print one line per metric.
+ * Allocations fail above value + tolerance (an absolute count per operation).
+ * Throughput depends on the machine, so it fails below value * (1 - tolerance)
+ * only when DARKEMU_PERF_THROUGHPUT=1 is set on an optimized build.
+ */
+bool compare(const std::vector<Measurement>& results, const nlohmann::json& baseline) {
+    std::map<std::string, nlohmann::json> by_name;
+    for (const auto& entry : baseline.at("metrics")) {
+        by_name[entry.at("name").get<std::string>()] = entry;
+    }
+#ifdef NDEBUG
+    const char* opt_in = std::getenv("DARKEMU_PERF_THROUGHPUT");
+    const bool enforce_throughput = opt_in != nullptr && std::strcmp(opt_in, "1") == 0;
+    const char* not_enforced = "slow (not enforced without DARKEMU_PERF_THROUGHPUT=1)";
+#else
+    const bool enforce_throughput = false;
+    const char* not_enforced = "slow (not enforced in unoptimized builds)";
+#endif
+
+    bool ok = true;
+    std::printf("%-34s %14s %14s %14s  %s\n", "metric", "baseline", "limit", "measured", "status");
+    for (const Measurement& m : results) {
+        auto it = by_name.find(m.name);
+        if (it == by_name.end()) {
+            std::printf("%-34s %14s %14s %14.2f  missing from baseline\n", m.name.c_str(), "-", "-", m.value);
+            ok = false;
+            continue;
+        }
+        const double value = it->second.at("value").get<double>();
+        const double tolerance = it->second.at("tolerance").get<double>();
+        const char* status = "ok";
+        double limit = 0.0;
+        if (m.kind == MetricKind::Throughput) {
+            limit = value * (1.0 - tolerance);
+            if (m.value < limit) {
+                status = enforce_throughput ? "REGRESSION" : not_enforced;
+                ok = ok && !enforce_throughput;
+            }
+        } else {
+            limit = value + tolerance;
+            if (m.value > limit) {
+                status = "REGRESSION";
+                ok = false;
+            } else if (m.value + tolerance < value) {
+                status = "improved (lower the baseline)";
+            }
+        }
+        std::printf("%-34s %14.2f %14.2f %14.2f  %s\n", m.name.c_str(), value, limit, m.value, status);
+    }
+    return ok;
+}
+
+// Rewrite baseline values from this run, keeping tolerances.
+void updateBaseline(const std::vector<Measurement>& results, nlohmann::json& baseline, const std::string& path) {
+    for (auto& entry : baseline.at("metrics")) {
+        const std::string name = entry.at("name").get<std::string>();
+        for (const Measurement& m : results) {
+            if (m.name == name) {
+                // Round throughput down to three significant figures so reruns do not churn the file.
+                double value = m.value;
+                if (m.kind == MetricKind::Throughput && value >= 1000.0) {
+                    double scale = 1.0;
+                    while (value / scale >= 1000.0) {
+                        scale *= 10.0;
+                    }
+                    value = static_cast<double>(static_cast<uint64_t>(value / scale)) * scale;
+                }
+                entry["value"] = value;
+            }
+        }
+    }
+    std::ofstream out(path);
+    out << baseline.dump(2) << '\n';
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        std::ifstream input(options.baseline_path);
+        if (!input.is_open()) {
+            throw std::runtime_error("unable to open baseline " + options.baseline_path);
+        }
+        nlohmann::json baseline;
+        input >> baseline;
+
+        // Seed the server list to avoid external config dependencies.
+        ServerListManager::Instance()->AddServer(0, "Perf PVP", "127.0.0.1", 55901, true);
+        ServerListManager::Instance()->AddServer(20, "Perf VIP", "127.0.0.1", 55919, true);
+
+        std::vector<Measurement> results;
+        measureConnectServer(results);
+        measureGameServer(results);
+
+        if (!options.out_path.empty()) {
+            nlohmann::json out;
+            for (const Measurement& m : results) {
+                out[m.name] = m.value;
+            }
+            std::ofstream file(options.out_path);
+            file << out.dump(2) << '\n';
+        }
+        if (options.update) {
+            updateBaseline(results, baseline, options.baseline_path);
+            std::cout << "Baseline updated: " << options.baseline_path << '\n';
+            return 0;
+        }
+        return compare(results, baseline) ? 0 : 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Perf test failed: " << ex.what() << '\n' << kUsage;
+        return 1;
+    }
+}
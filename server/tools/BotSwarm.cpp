@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) DarkEmu
+ * Simulated-player bot swarm for GameServer capacity testing.
+ */
+
+#include "Tools/BotSwarm.h"
+
+#include "GameServer/GamePackets.h"
+
+#include "Common/Network/PacketFramer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace {
+
+// GameServer packets of the Season 6 client.
+using Packets = GamePackets<Season6Protocol>;
+
+// Join result: C1 0C F1 00 <result> <index hi> <index lo> <version x5>.
+constexpr size_t kJoinResultSize = sizeof(Packets::JoinResult);
+// Per-bot send queue cap; beyond it the server is not reading and frames are skipped.
+constexpr size_t kMaxQueuedBytes = 64 * 1024;
+
+} // namespace
+
+uint64_t SwarmStepStats::totalErrors() const noexcept {
+    uint64_t total = 0;
+    for (uint64_t count : errors) {
+        total += count;
+    }
+    return total;
+}
+
+double SwarmStepStats::offeredBytesPerSec() const noexcept {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0.0 ? static_cast<double>(bytes_sent) / seconds : 0.0;
+}
+
+BotSwarm::BotSwarm(SwarmProfile profile) : profile_(profile), events_(1024), rng_(profile.seed) {
+    if (profile_.connect_rate <= 0.0) {
+        throw std::runtime_error("bot connect rate must be positive");
+    }
+}
+
+SwarmStepStats BotSwarm::runStep(size_t bots, std::chrono::milliseconds window) {
+    SwarmStepStats stats;
+    step_ = &stats;
+
+    // Grow at the configured connect rate; failed bots are replaced until the
+    // target is reached or growth stalls for longer than the timeout.
+    const Clock::time_point grow_start = Clock::now();
+    const double connect_gap_ns = 1e9 / profile_.connect_rate;
+    uint64_t launched = 0;
+    Clock::time_point last_progress = grow_start;
+    size_t last_playing = playing_;
+    Clock::time_point next_sweep = grow_start;
+    while (playing_ < bots) {
+        const Clock::time_point now = Clock::now();
+        while (playing_ + pending_ < bots) {
+            const auto due = grow_start + std::chrono::nanoseconds(static_cast<int64_t>(
+                                                  static_cast<double>(launched) * connect_gap_ns));
+            if (due > now) {
+                break;
+            }
+            connect(false);
+            ++launched;
+        }
+        if (playing_ != last_playing) {
+            last_playing = playing_;
+            last_progress = now;
+        } else if (now - last_progress > profile_.timeout * 2) {
+            break;
+        }
+        // Playing bots stay quiet while the swarm grows so the window measures steady state only.
+        fireTimers(now, false);
+        const int ready = epoll_.wait(events_, 1);
+        for (int i = 0; i < ready; ++i) {
+            handleEvent(events_[static_cast<size_t>(i)]);
+        }
+        if (now >= next_sweep) {
+            sweep(now);
+            next_sweep = now + std::chrono::milliseconds(5);
+        }
+    }
+
+    // Measurement window: only traffic and probes from here on are counted.
+    stats.frames_sent = 0;
+    stats.frames_skipped = 0;
+    stats.bytes_sent = 0;
+    stats.frames_by_action = {};
+    stats.send_backlog_us = 0;
+    const Clock::time_point window_start = Clock::now();
+    const Clock::time_point window_end = window_start + window;
+    Clock::time_point next_probe = window_start;
+    while (true) {
+        const Clock::time_point now = Clock::now();
+        if (now >= window_end) {
+            break;
+        }
+        if (now >= next_probe) {
+            connect(true);
+            next_probe += profile_.probe_interval;
+        }
+        fireTimers(now, true);
+        const int ready = epoll_.wait(events_, 1);
+        for (int i = 0; i < ready; ++i) {
+            handleEvent(events_[static_cast<size_t>(i)]);
+        }
+        if (static_cast<size_t>(ready) == events_.size()) {
+            events_.resize(events_.size() * 2);
+        }
+        if (now >= next_sweep) {
+            sweep(now);
+            next_sweep = now + std::chrono::milliseconds(5);
+        }
+    }
+    stats.elapsed = Clock::now() - window_start;
+
+    // Probes still waiting at the end of the window are counted as timeouts.
+    std::vector<int> probes;
+    for (const auto& [fd, bot] : bots_) {
+        if (bot.probe) {
+            probes.push_back(fd);
+        }
+    }
+    for (int fd : probes) {
+        drop(fd, LoadError::ResponseTimeout);
+    }
+
+    stats.bots = playing_;
+    step_ = nullptr;
+    return stats;
+}
+
+void BotSwarm::connect(bool probe) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        const bool limit = errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM;
+        ++step_->errors[static_cast<size_t>(limit ? LoadError::SocketLimit : LoadError::ConnectFailed)];
+        return;
+    }
+    Socket socket(fd);
+    if (profile_.reset_on_close) {
+        linger option{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &option, sizeof(option));
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(profile_.port);
+    addr.sin_addr.s_addr = htonl(profile_.address);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 && errno != EINPROGRESS) {
+        const LoadError error = errno == ECONNREFUSED ? LoadError::ConnectRefused
+                                : errno == EADDRNOTAVAIL ? LoadError::SocketLimit
+                                                         : LoadError::ConnectFailed;
+        ++step_->errors[static_cast<size_t>(error)];
+        return;
+    }
+
+    epoll_.add(fd, EPOLLOUT | EPOLLIN | EPOLLRDHUP);
+    Bot bot;
+    bot.id = next_id_++;
+    bot.socket = std::move(socket);
+    bot.probe = probe;
+    bot.started = Clock::now();
+    bots_.emplace(fd, std::move(bot));
+    if (!probe) {
+        ++pending_;
+    }
+}
+
+void BotSwarm::handleEvent(const epoll_event& event) {
+    const int fd = event.data.fd;
+    auto it = bots_.find(fd);
+    if (it == bots_.end()) {
+        return;
+    }
+    Bot& bot = it->second;
+
+    if (bot.phase == Phase::Connecting && (event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1) {
+            err = errno;
+        }
+        if (err != 0) {
+            drop(fd, err == ECONNREFUSED ? LoadError::ConnectRefused
+                     : err == ETIMEDOUT  ? LoadError::ConnectTimeout
+                                         : LoadError::ConnectFailed);
+            return;
+        }
+        // The server speaks first; wait for the join result.
+        bot.phase = Phase::Joining;
+        epoll_.modify(fd, EPOLLIN | EPOLLRDHUP);
+    }
+
+    // Flush frames queued while the socket was full.
+    if ((event.events & EPOLLOUT) && bot.phase == Phase::Playing && !bot.outbound.empty()) {
+        const ssize_t sent = bot.socket.send(bot.outbound, MSG_NOSIGNAL);
+        if (sent > 0) {
+            bot.outbound.erase(bot.outbound.begin(), bot.outbound.begin() + sent);
+        } else if (sent == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            drop(fd, errno == ECONNRESET || errno == EPIPE ? LoadError::Reset : LoadError::PeerClosed);
+            return;
+        }
+        if (bot.outbound.empty()) {
+            epoll_.modify(fd, EPOLLIN | EPOLLRDHUP);
+        }
+    }
+
+    if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        handleReadable(fd, bot);
+    }
+}
+
+void BotSwarm::handleReadable(int fd, Bot& bot) {
+    std::array<uint8_t, 4096> temp{};
+    bool closed = false;
+    while (true) {
+        const ssize_t bytes = bot.socket.recv(temp);
+        if (bytes > 0) {
+            // In-game pushes are not interpreted yet; only the join result matters.
+            if (bot.phase != Phase::Playing) {
+                bot.inbound.insert(bot.inbound.end(), temp.begin(), temp.begin() + bytes);
+            }
+            continue;
+        }
+        if (bytes == 0) {
+            closed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        drop(fd, errno == ECONNRESET ? LoadError::Reset : LoadError::PeerClosed);
+        return;
+    }
+
+    if (bot.phase == Phase::Joining) {
+        size_t size = 0;
+        const PacketFramer::Status status = PacketFramer::peek(bot.inbound, size);
+        if (status == PacketFramer::Status::Invalid) {
+            drop(fd, LoadError::BadFrame);
+            return;
+        }
+        if (status == PacketFramer::Status::Complete) {
+            const std::vector<uint8_t>& frame = bot.inbound;
+            if (size != kJoinResultSize || frame[2] != 0xF1 || frame[3] != 0x00 || frame[4] != 0x01) {
+                drop(fd, LoadError::UnexpectedReply);
+                return;
+            }
+            const uint64_t latency = microsBetween(bot.started, Clock::now());
+            if (bot.probe) {
+                step_->probe_us.record(latency);
+                drop(fd, LoadError::Count);
+                return;
+            }
+            step_->join_us.record(latency);
+            ++step_->joined;
+            bot.index = static_cast<uint16_t>((frame[5] << 8) | frame[6]);
+            bot.inbound.clear();
+            bot.inbound.shrink_to_fit();
+            bot.phase = Phase::Playing;
+            --pending_;
+            ++playing_;
+            if (!enterWorld(fd, bot)) {
+                return;
+            }
+            // Stagger the first sends so bots do not fire in lockstep.
+            const Clock::time_point now = Clock::now();
+            for (size_t a = 0; a < static_cast<size_t>(BotAction::Count); ++a) {
+                schedule(fd, bot, static_cast<BotAction>(a), now);
+            }
+        }
+    }
+
+    if (closed) {
+        drop(fd, LoadError::PeerClosed);
+    }
+}
+
+bool BotSwarm::write(int fd, Bot& bot, const std::vector<uint8_t>& frame) {
+    if (!bot.outbound.empty()) {
+        if (bot.outbound.size() + frame.size() > kMaxQueuedBytes) {
+            ++step_->frames_skipped;
+            return true;
+        }
+        bot.outbound.insert(bot.outbound.end(), frame.begin(), frame.end());
+        return true;
+    }
+    const ssize_t sent = bot.socket.send(frame, MSG_NOSIGNAL);
+    if (sent == static_cast<ssize_t>(frame.size())) {
+        return true;
+    }
+    if (sent >= 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        // Keep the unsent tail so frames stay contiguous on the wire.
+        bot.outbound.assign(frame.begin() + std::max<ssize_t>(sent, 0), frame.end());
+        epoll_.modify(fd, EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+        return true;
+    }
+    drop(fd, errno == ECONNRESET || errno == EPIPE ? LoadError::Reset : LoadError::PeerClosed);
+    return false;
+}
+
+bool BotSwarm::enterWorld(int fd, Bot& bot) {
+    std::array<char, 11> name{};
+    std::snprintf(name.data(), name.size(), "bot%05u", static_cast<unsigned>(bot.index));
+
+    // The server replies to login and list requests; those replies are read and discarded.
+    Packets::LoginRequest login = makePacket<Packets::LoginRequest>();
+    std::memcpy(login.account, name.data(), sizeof(login.account));
+    buxConvert(login.account);
+    std::vector<uint8_t> plain(packetBytes(login).begin(), packetBytes(login).end());
+    xor_.encodeFrame(plain);
+    std::vector<uint8_t> frame;
+    encryptor_.encryptFrame(plain, 0, frame);
+    if (!write(fd, bot, frame)) {
+        return false;
+    }
+
+    const Packets::CharacterListRequest list = makePacket<Packets::CharacterListRequest>();
+    frame.assign(packetBytes(list).begin(), packetBytes(list).end());
+    xor_.encodeFrame(frame);
+    if (!write(fd, bot, frame)) {
+        return false;
+    }
+
+    Packets::SelectCharacterRequest select = makePacket<Packets::SelectCharacterRequest>();
+    std::memcpy(select.name, name.data(), sizeof(select.name));
+    frame.assign(packetBytes(select).begin(), packetBytes(select).end());
+    xor_.encodeFrame(frame);
+    return write(fd, bot, frame);
+}
+
+std::vector<uint8_t> BotSwarm::buildFrame(BotAction action, const Bot& bot) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    switch (action) {
+    case BotAction::Walk: {
+        // C1 08 D4: target x, y, path direction count, packed direction steps.
+        std::uniform_int_distribution<int> coord(120, 140);
+        return {0xC1, 0x08, 0xD4, static_cast<uint8_t>(coord(rng_)), static_cast<uint8_t>(coord(rng_)), 0x02,
+                static_cast<uint8_t>(byte(rng_) & 0x77), 0x00};
+    }
+    case BotAction::Attack: {
+        // C1 07 11: target index (big-endian), attack action, direction.
+        std::uniform_int_distribution<int> target(0, 999);
+        const auto index = static_cast<uint16_t>(target(rng_));
+        return {0xC1, 0x07, 0x11, static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index & 0xFF), 0x78,
+                static_cast<uint8_t>(byte(rng_) & 0x07)};
+    }
+    case BotAction::Chat: {
+        // C1 xx 00: 10-byte character name, NUL-terminated message.
+        std::array<char, 11> name{};
+        std::snprintf(name.data(), name.size(), "bot%05u", static_cast<unsigned>(bot.index));
+        static constexpr char kMessage[] = "selling jewel of bless x10";
+        std::vector<uint8_t> frame(3 + 10 + sizeof(kMessage), 0);
+        frame[0] = 0xC1;
+        frame[1] = static_cast<uint8_t>(frame.size());
+        std::memcpy(frame.data() + 3, name.data(), 10);
+        std::memcpy(frame.data() + 13, kMessage, sizeof(kMessage));
+        return frame;
+    }
+    case BotAction::Item:
+    default: {
+        // C1 05 22: item index on the ground (big-endian).
+        std::uniform_int_distribution<int> item(0, 511);
+        const auto index = static_cast<uint16_t>(item(rng_));
+        return {0xC1, 0x05, 0x22, static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index & 0xFF)};
+    }
+    }
+}
+
+void BotSwarm::schedule(int fd, const Bot& bot, BotAction action, Clock::time_point from) {
+    const double rate = profile_.mix.rate_hz[static_cast<size_t>(action)];
+    if (rate <= 0.0) {
+        return;
+    }
+    std::exponential_distribution<double> gap(rate);
+    const auto delay = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(rng_)));
+    timers_.push(Timer{from + delay, bot.id, fd, action});
+}
+
+void BotSwarm::fireTimers(Clock::time_point now, bool send) {
+    while (!timers_.empty() && timers_.top().due <= now) {
+        const Timer timer = timers_.top();
+        timers_.pop();
+        auto it = bots_.find(timer.fd);
+        if (it == bots_.end() || it->second.id != timer.id) {
+            continue;
+        }
+        Bot& bot = it->second;
+        if (!send) {
+            schedule(timer.fd, bot, timer.action, timer.due);
+            continue;
+        }
+        step_->send_backlog_us = std::max(step_->send_backlog_us, microsBetween(timer.due, now));
+        // Encode the body like the real client so the server decodes sensible bytes.
+        std::vector<uint8_t> frame = buildFrame(timer.action, bot);
+        xor_.encodeFrame(frame);
+        if (!write(timer.fd, bot, frame)) {
+            continue;
+        }
+        ++step_->frames_sent;
+        ++step_->frames_by_action[static_cast<size_t>(timer.action)];
+        step_->bytes_sent += frame.size();
+        // Schedule from the due time so the long-run rate holds even when late.
+        schedule(timer.fd, bot, timer.action, timer.due);
+    }
+}
+
+void BotSwarm::sweep(Clock::time_point now) {
+    std::vector<int> expired;
+    for (const auto& [fd, bot] : bots_) {
+        if (bot.phase != Phase::Playing && now - bot.started > profile_.timeout) {
+            expired.push_back(fd);
+        }
+    }
+    for (int fd : expired) {
+        const bool connecting = bots_.at(fd).phase == Phase::Connecting;
+        drop(fd, connecting ? LoadError::ConnectTimeout : LoadError::ResponseTimeout);
+    }
+}
+
+void BotSwarm::drop(int fd, LoadError error) {
+    auto it = bots_.find(fd);
+    if (it == bots_.end()) {
+        return;
+    }
+    if (error != LoadError::Count && step_ != nullptr) {
+        ++step_->errors[static_cast<size_t>(error)];
+    }
+    if (!it->second.probe) {
+        if (it->second.phase == Phase::Playing) {
+            --playing_;
+        } else {
+            --pending_;
+        }
+    }
+    epoll_.remove(fd);
+    bots_.erase(it);
+}
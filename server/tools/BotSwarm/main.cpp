@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) DarkEmu
+ * Bot-swarm ramp that finds the GameServer saturation point.
+ */
+
+#include "Tools/BotSwarm.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* kUsage =
+        "usage: DarkEmu_BotSwarm [--host A.B.C.D] [--port N] [--start N] [--step N] [--max N] [--window-s N]\n"
+        "                        [--connect-rate N] [--walk-hz F] [--attack-hz F] [--chat-hz F] [--item-hz F]\n"
+        "                        [--max-p99-ms N] [--status-port N] [--timeout-ms N] [--rst] [--json FILE]\n";
+
+// Command-line options.
+struct Options {
+    std::string host{"127.0.0.1"};
+    uint16_t port{55901};
+    size_t start{500};
+    size_t step{500};
+    size_t max{10000};
+    int window_s{5};
+    double connect_rate{1000.0};
+    BotMix mix;
+    int max_p99_ms{50};
+    uint16_t status_port{0};
+    int timeout_ms{2000};
+    bool reset_on_close{false};
+    std::string json_path;
+};
+
+// Parse flags; throws on unknown or malformed input.
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--host") {
+            options.host = next();
+        } else if (arg == "--port") {
+            options.port = static_cast<uint16_t>(std::stoul(next()));
+        } else if (arg == "--start") {
+            options.start = std::stoul(next());
+        } else if (arg == "--step") {
+            options.step = std::stoul(next());
+        } else if (arg == "--max") {
+            options.max = std::stoul(next());
+        } else if (arg == "--window-s") {
+            options.window_s = std::max(1, std::stoi(next()));
+        } else if (arg == "--connect-rate") {
+            options.connect_rate = std::stod(next());
+        } else if (arg == "--walk-hz") {
+            options.mix.rate_hz[static_cast<size_t>(BotAction::Walk)] = std::stod(next());
+        } else if (arg == "--attack-hz") {
+            options.mix.rate_hz[static_cast<size_t>(BotAction::Attack)] = std::stod(next());
+        } else if (arg == "--chat-hz") {
+            options.mix.rate_hz[static_cast<size_t>(BotAction::Chat)] = std::stod(next());
+        } else if (arg == "--item-hz") {
+            options.mix.rate_hz[static_cast<size_t>(BotAction::Item)] = std::stod(next());
+        } else if (arg == "--max-p99-ms") {
+            options.max_p99_ms = std::stoi(next());
+        } else if (arg == "--status-port") {
+            options.status_port = static_cast<uint16_t>(std::stoul(next()));
+        } else if (arg == "--timeout-ms") {
+            options.timeout_ms = std::stoi(next());
+        } else if (arg == "--rst") {
+            options.reset_on_close = true;
+        } else if (arg == "--json") {
+            options.json_path = next();
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << kUsage;
+            std::exit(0);
+        } else {
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    if (options.step == 0 && options.start < options.max) {
+        throw std::runtime_error("--step must be positive");
+    }
+    return options;
+}
+
+// Read one counter from the GameServer status endpoint (blocking, 1 s timeout).
+std::optional<double> scrapeMetric(uint32_t address, uint16_t port, const std::string& name) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return std::nullopt;
+    }
+    timeval tv{1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(address);
+    std::string body;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        static constexpr char kRequest[] = "GET /metrics HTTP/1.0\r\n\r\n";
+        if (::send(fd, kRequest, sizeof(kRequest) - 1, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(kRequest) - 1)) {
+            char buffer[4096];
+            ssize_t received;
+            while ((received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                body.append(buffer, static_cast<size_t>(received));
+            }
+        }
+    }
+    ::close(fd);
+
+    // Series lines look like "<name> <value>".
+    std::istringstream lines(body);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.size() > name.size() && line.compare(0, name.size(), name) == 0 && line[name.size()] == ' ') {
+            return std::stod(line.substr(name.size() + 1));
+        }
+    }
+    return std::nullopt;
+}
+
+// Lift the soft descriptor limit so thousands of bots can be connected.
+void raiseDescriptorLimit() {
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// One ramp step with its verdict.
+struct StepReport {
+    SwarmStepStats stats;
+    std::optional<double> ingest_ratio; ///< Server bytes received / bot bytes sent.
+    bool healthy{true};
+    std::string reason;
+};
+
+// Apply the saturation criteria to a step.
+void judge(StepReport& report, const Options& options) {
+    const uint64_t budget_us = static_cast<uint64_t>(options.max_p99_ms) * 1000;
+    const SwarmStepStats& s = report.stats;
+    if (s.totalErrors() != 0) {
+        report.reason = "errors";
+    } else if (s.frames_skipped != 0) {
+        report.reason = "server not reading (send queues full)";
+    } else if (s.probe_us.count() == 0 || s.probe_us.percentile(0.99) > budget_us) {
+        report.reason = "probe p99 over budget";
+    } else if (s.send_backlog_us > budget_us) {
+        report.reason = "bot send lag over budget (client-bound)";
+    } else if (report.ingest_ratio && *report.ingest_ratio < 0.95) {
+        report.reason = "server ingest below offered load";
+    }
+    report.healthy = report.reason.empty();
+}
+
+// Print one table row.
+void printRow(std::ostream& out, const StepReport& report) {
+    const SwarmStepStats& s = report.stats;
+    const double seconds = std::max(1e-9, std::chrono::duration<double>(s.elapsed).count());
+    out << std::fixed << std::setprecision(0) << std::setw(7) << s.bots << std::setw(10)
+        << static_cast<double>(s.frames_sent) / seconds << std::setw(10) << s.offeredBytesPerSec() / 1024.0
+        << std::setw(9);
+    if (report.ingest_ratio) {
+        out << std::setprecision(2) << *report.ingest_ratio;
+    } else {
+        out << '-';
+    }
+    out << std::setw(9) << s.probe_us.percentile(0.50) << std::setw(9) << s.probe_us.percentile(0.99)
+        << std::setw(10) << s.probe_us.percentile(0.999) << std::setw(10) << s.join_us.percentile(0.99)
+        << std::setw(10) << s.send_backlog_us << std::setw(7) << s.totalErrors() << "  "
+        << (report.healthy ? "ok" : report.reason) << '\n';
+}
+
+// Write all steps and the verdict as JSON.
+void writeJson(std::ostream& out, const std::vector<StepReport>& steps, size_t sustained) {
+    out << std::fixed << std::setprecision(3) << "{\n  \"sustained_bots\": " << sustained << ",\n  \"steps\": [\n";
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const SwarmStepStats& s = steps[i].stats;
+        const double seconds = std::max(1e-9, std::chrono::duration<double>(s.elapsed).count());
+        out << "    {\"bots\": " << s.bots << ", \"frames_per_sec\": " << static_cast<double>(s.frames_sent) / seconds
+            << ", \"offered_bytes_per_sec\": " << s.offeredBytesPerSec() << ", \"ingest_ratio\": ";
+        if (steps[i].ingest_ratio) {
+            out << *steps[i].ingest_ratio;
+        } else {
+            out << "null";
+        }
+        out << ", \"probe_p50_us\": " << s.probe_us.percentile(0.50) << ", \"probe_p99_us\": "
+            << s.probe_us.percentile(0.99) << ", \"probe_p999_us\": " << s.probe_us.percentile(0.999)
+            << ", \"join_p99_us\": " << s.join_us.percentile(0.99) << ", \"send_backlog_us\": " << s.send_backlog_us
+            << ", \"frames_skipped\": " << s.frames_skipped << ", \"errors\": {";
+        for (size_t e = 0; e < s.errors.size(); ++e) {
+            out << (e == 0 ? "" : ", ") << '"' << loadErrorName(static_cast<LoadError>(e)) << "\": " << s.errors[e];
+        }
+        out << "}, \"healthy\": " << (steps[i].healthy ? "true" : "false") << '}'
+            << (i + 1 < steps.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        raiseDescriptorLimit();
+
+        SwarmProfile profile;
+        in_addr addr{};
+        if (::inet_pton(AF_INET, options.host.c_str(), &addr) != 1) {
+            throw std::runtime_error("invalid IPv4 address " + options.host);
+        }
+        profile.address = ntohl(addr.s_addr);
+        profile.port = options.port;
+        profile.connect_rate = options.connect_rate;
+        profile.mix = options.mix;
+        profile.timeout = std::chrono::milliseconds(options.timeout_ms);
+        profile.reset_on_close = options.reset_on_close;
+        BotSwarm swarm(profile);
+
+        std::cout << "   bots  frames/s  sent KB/s   ingest  probe50  probe99  probe999  join p99  lag(us) errors\n";
+        std::vector<StepReport> steps;
+        size_t sustained = 0;
+        const std::string ingest_series = "darkemu_game_bytes_received_total";
+        for (size_t bots = options.start; bots <= options.max; bots += std::max<size_t>(options.step, 1)) {
+            std::optional<double> before;
+            if (options.status_port != 0) {
+                before = scrapeMetric(profile.address, options.status_port, ingest_series);
+            }
+
+            StepReport report;
+            report.stats = swarm.runStep(bots, std::chrono::seconds(options.window_s));
+
+            if (before) {
+                // Bots are idle between steps; wait out the endpoint's 1 s snapshot interval.
+                std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+                const std::optional<double> after = scrapeMetric(profile.address, options.status_port, ingest_series);
+                if (after && report.stats.bytes_sent != 0) {
+                    // Probe join results are not counted by the server, so this compares in-game bytes only.
+                    report.ingest_ratio = (*after - *before) / static_cast<double>(report.stats.bytes_sent);
+                }
+            }
+            judge(report, options);
+            printRow(std::cout, report);
+            std::cout.flush();
+            steps.push_back(report);
+
+            // The first unhealthy step marks saturation; the previous step is the sustained capacity.
+            if (!report.healthy) {
+                break;
+            }
+            sustained = report.stats.bots;
+            if (options.step == 0) {
+                break;
+            }
+        }
+
+        std::cout << "sustained " << sustained << " bots";
+        if (!steps.empty() && !steps.back().healthy) {
+            std::cout << "; saturated at " << steps.back().stats.bots << " (" << steps.back().reason << ")";
+        } else {
+            std::cout << "; no saturation up to --max";
+        }
+        std::cout << '\n';
+
+        if (!options.json_path.empty()) {
+            std::ofstream out(options.json_path);
+            writeJson(out, steps, sustained);
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "BotSwarm failed: " << ex.what() << '\n' << kUsage;
+        return 1;
+    }
+}
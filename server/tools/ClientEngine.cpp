@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) DarkEmu
+ * Epoll-driven open-loop client engine for load generation.
+ */
+
+#include "Tools/ClientEngine.h"
+
+#include "Common/Network/PacketFramer.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace {
+
+// Error names, indexed by LoadError.
+constexpr std::array<const char*, static_cast<size_t>(LoadError::Count)> kErrorNames{
+    "connect_refused", "connect_timeout", "connect_failed", "socket_limit", "reset",
+    "peer_closed",     "response_timeout", "bad_frame",     "unexpected_reply",
+};
+
+// Map a connect errno to its error class.
+LoadError connectError(int err) {
+    switch (err) {
+    case ECONNREFUSED:
+        return LoadError::ConnectRefused;
+    case ETIMEDOUT:
+        return LoadError::ConnectTimeout;
+    default:
+        return LoadError::ConnectFailed;
+    }
+}
+
+// Print one latency line in microseconds.
+void printLatency(std::ostream& out, const char* label, const LatencyHistogram& h) {
+    out << "  " << std::left << std::setw(10) << label << std::right << " n=" << h.count()
+        << " mean=" << std::fixed << std::setprecision(1) << h.mean() << "us"
+        << " p50=" << h.percentile(0.50) << "us p99=" << h.percentile(0.99) << "us p999=" << h.percentile(0.999)
+        << "us max=" << h.max() << "us\n";
+}
+
+// Write one latency object for the JSON report.
+void writeLatencyJson(std::ostream& out, const LatencyHistogram& h) {
+    out << "{\"count\": " << h.count() << ", \"mean_us\": " << std::fixed << std::setprecision(1) << h.mean()
+        << ", \"p50_us\": " << h.percentile(0.50) << ", \"p99_us\": " << h.percentile(0.99)
+        << ", \"p999_us\": " << h.percentile(0.999) << ", \"max_us\": " << h.max() << '}';
+}
+
+} // namespace
+
+const char* loadErrorName(LoadError error) noexcept {
+    const auto index = static_cast<size_t>(error);
+    return index < kErrorNames.size() ? kErrorNames[index] : "unknown";
+}
+
+void LoadStats::merge(const LoadStats& other) {
+    started += other.started;
+    connected += other.connected;
+    completed += other.completed;
+    requests += other.requests;
+    responses += other.responses;
+    bytes_sent += other.bytes_sent;
+    bytes_received += other.bytes_received;
+    // Threads run concurrently, so their peaks add up.
+    peak_concurrent += other.peak_concurrent;
+    elapsed = std::max(elapsed, other.elapsed);
+    for (size_t i = 0; i < errors.size(); ++i) {
+        errors[i] += other.errors[i];
+    }
+    connect_us.merge(other.connect_us);
+    response_us.merge(other.response_us);
+}
+
+uint64_t LoadStats::totalErrors() const noexcept {
+    uint64_t total = 0;
+    for (uint64_t count : errors) {
+        total += count;
+    }
+    return total;
+}
+
+void LoadStats::print(std::ostream& out) const {
+    const double seconds = std::max(1e-9, std::chrono::duration<double>(elapsed).count());
+    const std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "elapsed " << seconds << "s, sessions " << started << " started / " << completed << " completed, peak "
+        << peak_concurrent << " concurrent\n";
+    out << "  connects/sec " << static_cast<double>(connected) / seconds << ", requests/sec "
+        << static_cast<double>(requests) / seconds << ", responses/sec " << static_cast<double>(responses) / seconds
+        << '\n';
+    out << "  sent " << bytes_sent << " B, received " << bytes_received << " B\n";
+    printLatency(out, "connect", connect_us);
+    printLatency(out, "response", response_us);
+    out << "  errors " << totalErrors();
+    for (size_t i = 0; i < errors.size(); ++i) {
+        if (errors[i] != 0) {
+            out << ' ' << kErrorNames[i] << '=' << errors[i];
+        }
+    }
+    out << '\n';
+    out.flags(flags);
+}
+
+void LoadStats::writeJson(std::ostream& out) const {
+    const double seconds = std::max(1e-9, std::chrono::duration<double>(elapsed).count());
+    const std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"elapsed_s\": " << seconds << ",\n  \"started\": " << started << ",\n  \"connected\": "
+        << connected << ",\n  \"completed\": " << completed << ",\n  \"requests\": " << requests
+        << ",\n  \"responses\": " << responses << ",\n  \"bytes_sent\": " << bytes_sent
+        << ",\n  \"bytes_received\": " << bytes_received << ",\n  \"peak_concurrent\": " << peak_concurrent
+        << ",\n  \"connects_per_sec\": " << static_cast<double>(connected) / seconds
+        << ",\n  \"responses_per_sec\": " << static_cast<double>(responses) / seconds << ",\n  \"connect\": ";
+    writeLatencyJson(out, connect_us);
+    out << ",\n  \"response\": ";
+    writeLatencyJson(out, response_us);
+    out << ",\n  \"errors\": {";
+    for (size_t i = 0; i < errors.size(); ++i) {
+        out << (i == 0 ? "" : ", ") << '"' << kErrorNames[i] << "\": " << errors[i];
+    }
+    out << "}\n}\n";
+    out.flags(flags);
+}
+
+ClientEngine::ClientEngine(LoadProfile profile) : profile_(std::move(profile)), events_(1024) {
+    if (profile_.rate <= 0.0) {
+        throw std::runtime_error("load rate must be positive");
+    }
+    if (profile_.requests_per_session < 0) {
+        throw std::runtime_error("requests per session must not be negative");
+    }
+}
+
+LoadStats ClientEngine::run() {
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point arrivals_end = start + profile_.duration;
+    // In-flight sessions get one timeout (plus their hold) to drain after the window.
+    const Clock::time_point drain_end = arrivals_end + profile_.timeout + profile_.hold;
+    const double interval_ns = 1e9 / profile_.rate;
+    Clock::time_point next_sweep = start;
+
+    while (true) {
+        Clock::time_point now = Clock::now();
+
+        // Launch every arrival that is due, even if earlier sessions are still open.
+        while (true) {
+            const auto offset = std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(stats_.started) *
+                                                                              interval_ns));
+            const Clock::time_point due = start + offset;
+            if (due > now || due >= arrivals_end) {
+                break;
+            }
+            launch(due);
+        }
+
+        if (now >= arrivals_end && (sessions_.empty() || now >= drain_end)) {
+            break;
+        }
+
+        // A 1 ms tick keeps arrival jitter low without spinning.
+        const int ready = epoll_.wait(events_, 1);
+        for (int i = 0; i < ready; ++i) {
+            handleEvent(events_[static_cast<size_t>(i)]);
+        }
+        if (static_cast<size_t>(ready) == events_.size()) {
+            events_.resize(events_.size() * 2);
+        }
+
+        now = Clock::now();
+        if (now >= next_sweep) {
+            sweep(now);
+            next_sweep = now + std::chrono::milliseconds(5);
+        }
+    }
+
+    // Anything still open missed the drain window.
+    while (!sessions_.empty()) {
+        auto it = sessions_.begin();
+        const bool connecting = it->second.phase == Phase::Connecting;
+        const bool holding = it->second.phase == Phase::Holding;
+        finish(it->first, holding, connecting ? LoadError::ConnectTimeout : LoadError::ResponseTimeout);
+    }
+    stats_.elapsed = Clock::now() - start;
+    return stats_;
+}
+
+void ClientEngine::launch(Clock::time_point scheduled) {
+    ++stats_.started;
+    if (sessions_.size() >= profile_.max_concurrent) {
+        ++stats_.errors[static_cast<size_t>(LoadError::SocketLimit)];
+        return;
+    }
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        const bool limit = errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM;
+        ++stats_.errors[static_cast<size_t>(limit ? LoadError::SocketLimit : LoadError::ConnectFailed)];
+        return;
+    }
+    Socket socket(fd);
+
+    if (profile_.reset_on_close) {
+        linger option{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &option, sizeof(option));
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(profile_.port);
+    addr.sin_addr.s_addr = htonl(profile_.address);
+    const int rc = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    if (rc == -1 && errno != EINPROGRESS) {
+        const bool limit = errno == EADDRNOTAVAIL || errno == EAGAIN;
+        ++stats_.errors[static_cast<size_t>(limit ? LoadError::SocketLimit : connectError(errno))];
+        return;
+    }
+
+    // Writability signals handshake completion (or failure, via SO_ERROR).
+    epoll_.add(fd, EPOLLOUT | EPOLLIN | EPOLLRDHUP);
+    Session session;
+    session.socket = std::move(socket);
+    session.scheduled = scheduled;
+    session.deadline = Clock::now() + profile_.timeout;
+    session.remaining = profile_.requests_per_session;
+    sessions_.emplace(fd, std::move(session));
+    stats_.peak_concurrent = std::max(stats_.peak_concurrent, sessions_.size());
+}
+
+void ClientEngine::handleEvent(const epoll_event& event) {
+    const int fd = event.data.fd;
+    auto it = sessions_.find(fd);
+    if (it == sessions_.end()) {
+        return;
+    }
+    Session& session = it->second;
+
+    if (session.phase == Phase::Connecting) {
+        if ((event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) == 0) {
+            return;
+        }
+        handleConnected(fd, session);
+        return;
+    }
+
+    // Pending request bytes go out first so replies are matched to complete requests.
+    if ((event.events & EPOLLOUT) && !session.outbound.empty()) {
+        if (!flush(fd, session)) {
+            return;
+        }
+        if (session.outbound.empty() && !profile_.expect_reply) {
+            sendNext(fd, session);
+            if (sessions_.find(fd) == sessions_.end()) {
+                return;
+            }
+        }
+    }
+    if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        handleReadable(fd, session);
+    }
+}
+
+void ClientEngine::handleConnected(int fd, Session& session) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1) {
+        err = errno;
+    }
+    if (err != 0) {
+        finish(fd, false, connectError(err));
+        return;
+    }
+
+    ++stats_.connected;
+    stats_.connect_us.record(microsBetween(session.scheduled, Clock::now()));
+    // Only wait for writability again when a send would block.
+    epoll_.modify(fd, EPOLLIN | EPOLLRDHUP);
+    session.phase = Phase::Awaiting;
+    sendNext(fd, session);
+}
+
+void ClientEngine::sendNext(int fd, Session& session) {
+    while (session.remaining > 0) {
+        --session.remaining;
+        session.outbound.assign(profile_.request.begin(), profile_.request.end());
+        session.out_offset = 0;
+        session.sent_at = Clock::now();
+        session.deadline = session.sent_at + profile_.timeout;
+        ++stats_.requests;
+        if (!flush(fd, session)) {
+            return;
+        }
+        // A partial write resumes from handleEvent once the socket drains.
+        if (!session.outbound.empty() || profile_.expect_reply) {
+            session.phase = Phase::Awaiting;
+            return;
+        }
+    }
+
+    // Every request answered (or fire-and-forget): idle until the hold expires.
+    session.phase = Phase::Holding;
+    session.deadline = Clock::now() + profile_.hold;
+}
+
+bool ClientEngine::flush(int fd, Session& session) {
+    while (session.out_offset < session.outbound.size()) {
+        const std::span<const uint8_t> pending(session.outbound.data() + session.out_offset,
+                                               session.outbound.size() - session.out_offset);
+        const ssize_t sent = session.socket.send(pending, MSG_NOSIGNAL);
+        if (sent > 0) {
+            session.out_offset += static_cast<size_t>(sent);
+            stats_.bytes_sent += static_cast<uint64_t>(sent);
+            continue;
+        }
+        if (sent == -1 && errno == EINTR) {
+            continue;
+        }
+        if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            epoll_.modify(fd, EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+            return true;
+        }
+        finish(fd, false, errno == ECONNRESET || errno == EPIPE ? LoadError::Reset : LoadError::PeerClosed);
+        return false;
+    }
+    if (!session.outbound.empty()) {
+        session.outbound.clear();
+        session.out_offset = 0;
+        epoll_.modify(fd, EPOLLIN | EPOLLRDHUP);
+    }
+    return true;
+}
+
+void ClientEngine::handleReadable(int fd, Session& session) {
+    std::array<uint8_t, 4096> temp{};
+    bool closed = false;
+    while (true) {
+        const ssize_t bytes = session.socket.recv(temp);
+        if (bytes > 0) {
+            session.inbound.insert(session.inbound.end(), temp.begin(), temp.begin() + bytes);
+            stats_.bytes_received += static_cast<uint64_t>(bytes);
+            continue;
+        }
+        if (bytes == 0) {
+            closed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        finish(fd, false, errno == ECONNRESET ? LoadError::Reset : LoadError::PeerClosed);
+        return;
+    }
+
+    // Consume reply frames one request at a time.
+    while (profile_.expect_reply && session.phase == Phase::Awaiting && session.outbound.empty()) {
+        size_t size = 0;
+        const PacketFramer::Status status = PacketFramer::peek(session.inbound, size);
+        if (status == PacketFramer::Status::Incomplete) {
+            break;
+        }
+        if (status == PacketFramer::Status::Invalid) {
+            finish(fd, false, LoadError::BadFrame);
+            return;
+        }
+        const bool matches = profile_.expected_reply.empty() ||
+                             (size == profile_.expected_reply.size() &&
+                              std::equal(profile_.expected_reply.begin(), profile_.expected_reply.end(),
+                                         session.inbound.begin()));
+        session.inbound.erase(session.inbound.begin(), session.inbound.begin() + static_cast<std::ptrdiff_t>(size));
+        if (!matches) {
+            finish(fd, false, LoadError::UnexpectedReply);
+            return;
+        }
+        ++stats_.responses;
+        stats_.response_us.record(microsBetween(session.sent_at, Clock::now()));
+        sendNext(fd, session);
+        if (sessions_.find(fd) == sessions_.end()) {
+            return;
+        }
+    }
+    // Unsolicited frames (server pushes, fire-and-forget mode) are discarded.
+    if (session.phase == Phase::Holding || !profile_.expect_reply) {
+        session.inbound.clear();
+    }
+
+    if (closed) {
+        // A close after the last reply still counts as a completed session.
+        finish(fd, session.phase == Phase::Holding, LoadError::PeerClosed);
+    }
+}
+
+void ClientEngine::sweep(Clock::time_point now) {
+    std::vector<int> expired;
+    for (const auto& [fd, session] : sessions_) {
+        if (now >= session.deadline) {
+            expired.push_back(fd);
+        }
+    }
+    for (int fd : expired) {
+        const Phase phase = sessions_.at(fd).phase;
+        if (phase == Phase::Holding) {
+            finish(fd, true);
+        } else {
+            finish(fd, false, phase == Phase::Connecting ? LoadError::ConnectTimeout : LoadError::ResponseTimeout);
+        }
+    }
+}
+
+void ClientEngine::finish(int fd, bool ok, LoadError error) {
+    auto it = sessions_.find(fd);
+    if (it == sessions_.end()) {
+        return;
+    }
+    if (ok) {
+        ++stats_.completed;
+    } else if (error != LoadError::Count) {
+        ++stats_.errors[static_cast<size_t>(error)];
+    }
+    epoll_.remove(fd);
+    sessions_.erase(it);
+}
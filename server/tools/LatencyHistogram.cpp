@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) DarkEmu
+ * Log-linear latency histogram for load-generation tools.
+ */
+
+#include "Tools/LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+
+// Values below this are stored one per bucket.
+constexpr uint64_t kLinearLimit = uint64_t{2} << LatencyHistogram::kSubBits;
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() : buckets_(kBuckets, 0) {}
+
+size_t LatencyHistogram::indexOf(uint64_t value) noexcept {
+    if (value < kLinearLimit) {
+        return static_cast<size_t>(value);
+    }
+    // The top kSubBits+1 bits select the bucket within this power of two.
+    const unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+    const unsigned shift = exponent - kSubBits;
+    const size_t sub = static_cast<size_t>(value >> shift) - (size_t{1} << kSubBits);
+    return static_cast<size_t>(kLinearLimit) + (exponent - kSubBits - 1) * (size_t{1} << kSubBits) + sub;
+}
+
+uint64_t LatencyHistogram::upperBound(size_t index) noexcept {
+    if (index < kLinearLimit) {
+        return index;
+    }
+    const size_t offset = index - static_cast<size_t>(kLinearLimit);
+    const unsigned shift = static_cast<unsigned>(offset >> kSubBits) + 1;
+    const uint64_t top = (uint64_t{1} << kSubBits) + (offset & ((size_t{1} << kSubBits) - 1));
+    // Last bucket of the range saturates instead of overflowing.
+    if (shift + kSubBits + 1 >= 64 && top == (uint64_t{2} << kSubBits) - 1) {
+        return UINT64_MAX;
+    }
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) noexcept {
+    ++buckets_[indexOf(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+    sum_ += static_cast<long double>(value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+double LatencyHistogram::mean() const noexcept {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_ / static_cast<long double>(count_));
+}
+
+uint64_t LatencyHistogram::percentile(double q) const noexcept {
+    if (count_ == 0) {
+        return 0;
+    }
+    // Rank of the requested observation (1-based, nearest-rank method).
+    const double clamped = std::clamp(q, 0.0, 1.0);
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::min(upperBound(i), max_);
+        }
+    }
+    return max_;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) DarkEmu
+ * Open-loop load generator for the ConnectServer and GameServer.
+ */
+
+#include "Tools/ClientEngine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/resource.h>
+
+namespace {
+
+constexpr const char* kUsage =
+        "usage: DarkEmu_LoadGen [--mode cs|gs] [--host A.B.C.D] [--port N] [--rate SESSIONS_PER_SEC]\n"
+        "                       [--duration-s N] [--threads N] [--requests N] [--hold-ms N] [--timeout-ms N]\n"
+        "                       [--max-concurrent N] [--rst] [--json FILE]\n";
+
+// Command-line options.
+struct Options {
+    std::string mode{"cs"};
+    std::string host{"127.0.0.1"};
+    uint16_t port{0};
+    double rate{500.0};
+    int duration_s{10};
+    int threads{1};
+    int requests{1};
+    int hold_ms{0};
+    int timeout_ms{2000};
+    size_t max_concurrent{100000};
+    bool reset_on_close{false};
+    std::string json_path;
+};
+
+// Parse flags; throws on unknown or malformed input.
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--mode") {
+            options.mode = next();
+        } else if (arg == "--host") {
+            options.host = next();
+        } else if (arg == "--port") {
+            options.port = static_cast<uint16_t>(std::stoul(next()));
+        } else if (arg == "--rate") {
+            options.rate = std::stod(next());
+        } else if (arg == "--duration-s") {
+            options.duration_s = std::stoi(next());
+        } else if (arg == "--threads") {
+            options.threads = std::max(1, std::stoi(next()));
+        } else if (arg == "--requests") {
+            options.requests = std::stoi(next());
+        } else if (arg == "--hold-ms") {
+            options.hold_ms = std::stoi(next());
+        } else if (arg == "--timeout-ms") {
+            options.timeout_ms = std::stoi(next());
+        } else if (arg == "--max-concurrent") {
+            options.max_concurrent = std::stoul(next());
+        } else if (arg == "--rst") {
+            options.reset_on_close = true;
+        } else if (arg == "--json") {
+            options.json_path = next();
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << kUsage;
+            std::exit(0);
+        } else {
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    if (options.mode != "cs" && options.mode != "gs") {
+        throw std::runtime_error("--mode must be cs or gs");
+    }
+    return options;
+}
+
+// Build the per-session profile for the selected server.
+LoadProfile buildProfile(const Options& options) {
+    LoadProfile profile;
+    in_addr addr{};
+    if (::inet_pton(AF_INET, options.host.c_str(), &addr) != 1) {
+        throw std::runtime_error("invalid IPv4 address " + options.host);
+    }
+    profile.address = ntohl(addr.s_addr);
+    profile.rate = options.rate / options.threads;
+    profile.duration = std::chrono::seconds(options.duration_s);
+    profile.requests_per_session = options.requests;
+    profile.hold = std::chrono::milliseconds(options.hold_ms);
+    profile.timeout = std::chrono::milliseconds(options.timeout_ms);
+    profile.max_concurrent = options.max_concurrent / static_cast<size_t>(options.threads);
+    profile.reset_on_close = options.reset_on_close;
+
+    if (options.mode == "cs") {
+        // Server list request; the ConnectServer answers once and then closes the connection.
+        if (options.requests > 1) {
+            std::cerr << "LoadGen: ConnectServer closes after one reply, using --requests 1\n";
+            profile.requests_per_session = 1;
+        }
+        profile.port = options.port != 0 ? options.port : 44405;
+        profile.request = {0xC1, 0x04, 0xF4, 0x06};
+        profile.expect_reply = true;
+    } else {
+        // Walk-sized C1 frame; the GameServer does not answer, so only connects and sends are measured.
+        profile.port = options.port != 0 ? options.port : 55901;
+        profile.request = {0xC1, 0x08, 0xD4, 0x80, 0x80, 0x01, 0x23, 0x00};
+        profile.expect_reply = false;
+    }
+    return profile;
+}
+
+// Lift the soft descriptor limit so thousands of sessions can be open at once.
+void raiseDescriptorLimit() {
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        const LoadProfile profile = buildProfile(options);
+        raiseDescriptorLimit();
+
+        std::cerr << "LoadGen: " << options.mode << " target " << options.host << ':' << profile.port << ", "
+                  << options.rate << " sessions/s for " << options.duration_s << "s on " << options.threads
+                  << " thread(s)\n";
+
+        // One independent engine per thread; results are merged afterwards.
+        std::vector<LoadStats> results(static_cast<size_t>(options.threads));
+        std::vector<std::thread> workers;
+        for (int t = 0; t < options.threads; ++t) {
+            workers.emplace_back([&, t] {
+                ClientEngine engine(profile);
+                results[static_cast<size_t>(t)] = engine.run();
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        LoadStats total;
+        for (const LoadStats& result : results) {
+            total.merge(result);
+        }
+        total.print(std::cout);
+        if (!options.json_path.empty()) {
+            std::ofstream out(options.json_path);
+            total.writeJson(out);
+        }
+        return total.totalErrors() == 0 ? 0 : 2;
+    } catch (const std::exception& ex) {
+        std::cerr << "LoadGen failed: " << ex.what() << '\n' << kUsage;
+        return 1;
+    }
+}
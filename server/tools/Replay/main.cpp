@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) DarkEmu
+ * Replays a session capture against a test server and compares runs.
+ */
+
+#include "Tools/ReplayEngine.h"
+
+#include "common/Utils/json.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/resource.h>
+
+namespace {
+
+constexpr const char* kUsage =
+        "usage: DarkEmu_Replay --capture FILE --port N [--host A.B.C.D] [--speed 1|N|max] [--copies N]\n"
+        "                      [--threads N] [--max-concurrent N] [--linger-ms N] [--timeout-ms N] [--rst]\n"
+        "                      [--json FILE] [--baseline FILE]\n";
+
+// Command-line options.
+struct Options {
+    std::string capture_path;
+    std::string host{"127.0.0.1"};
+    uint16_t port{0};
+    double speed{1.0};
+    size_t copies{1};
+    int threads{1};
+    size_t max_concurrent{1000};
+    int linger_ms{20};
+    int timeout_ms{2000};
+    bool reset_on_close{false};
+    std::string json_path;
+    std::string baseline_path;
+};
+
+// Parse flags; throws on unknown or malformed input.
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--capture") {
+            options.capture_path = next();
+        } else if (arg == "--host") {
+            options.host = next();
+        } else if (arg == "--port") {
+            options.port = static_cast<uint16_t>(std::stoul(next()));
+        } else if (arg == "--speed") {
+            const std::string value = next();
+            options.speed = value == "max" ? 0.0 : std::stod(value);
+        } else if (arg == "--copies") {
+            options.copies = std::max<size_t>(1, std::stoul(next()));
+        } else if (arg == "--threads") {
+            options.threads = std::max(1, std::stoi(next()));
+        } else if (arg == "--max-concurrent") {
+            options.max_concurrent = std::stoul(next());
+        } else if (arg == "--linger-ms") {
+            options.linger_ms = std::stoi(next());
+        } else if (arg == "--timeout-ms") {
+            options.timeout_ms = std::stoi(next());
+        } else if (arg == "--rst") {
+            options.reset_on_close = true;
+        } else if (arg == "--json") {
+            options.json_path = next();
+        } else if (arg == "--baseline") {
+            options.baseline_path = next();
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << kUsage;
+            std::exit(0);
+        } else {
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    if (options.capture_path.empty() || options.port == 0) {
+        throw std::runtime_error("--capture and --port are required");
+    }
+    return options;
+}
+
+// Lift the soft descriptor limit for many parallel session copies.
+void raiseDescriptorLimit() {
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Print throughput and latency deltas against an earlier --json result.
+void printBaseline(const ReplayStats& stats, const std::string& path) {
+    std::ifstream input(path);
+    if (!input.is_open()) {
+        throw std::runtime_error("unable to open baseline file " + path);
+    }
+    nlohmann::json baseline;
+    input >> baseline;
+
+    const double seconds = std::max(1e-9, std::chrono::duration<double>(stats.elapsed).count());
+    struct Row {
+        const char* label;
+        double old_value;
+        double new_value;
+    };
+    const std::vector<Row> rows{
+        {"frames/sec", baseline.at("frames_per_sec").get<double>(), static_cast<double>(stats.frames_sent) / seconds},
+        {"bytes/sec", baseline.at("bytes_per_sec").get<double>(), static_cast<double>(stats.bytes_sent) / seconds},
+        {"connect p50 us", baseline.at("connect").at("p50_us").get<double>(),
+         static_cast<double>(stats.connect_us.percentile(0.50))},
+        {"connect p99 us", baseline.at("connect").at("p99_us").get<double>(),
+         static_cast<double>(stats.connect_us.percentile(0.99))},
+        {"response p50 us", baseline.at("response").at("p50_us").get<double>(),
+         static_cast<double>(stats.response_us.percentile(0.50))},
+        {"response p99 us", baseline.at("response").at("p99_us").get<double>(),
+         static_cast<double>(stats.response_us.percentile(0.99))},
+        {"response p999 us", baseline.at("response").at("p999_us").get<double>(),
+         static_cast<double>(stats.response_us.percentile(0.999))},
+        {"completed", baseline.at("completed").get<double>(), static_cast<double>(stats.completed)},
+    };
+
+    std::printf("%-18s %14s %14s %9s\n", "metric", "baseline", "current", "delta");
+    for (const Row& row : rows) {
+        if (row.old_value == 0.0) {
+            std::printf("%-18s %14.1f %14.1f %9s\n", row.label, row.old_value, row.new_value, "-");
+            continue;
+        }
+        const double delta = (row.new_value - row.old_value) / row.old_value * 100.0;
+        std::printf("%-18s %14.1f %14.1f %+8.1f%%\n", row.label, row.old_value, row.new_value, delta);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        raiseDescriptorLimit();
+
+        std::vector<CaptureRecord> records;
+        if (!SessionRecorder::Load(options.capture_path, records)) {
+            throw std::runtime_error("unable to read capture " + options.capture_path);
+        }
+        const std::vector<ReplaySession> sessions = buildReplaySessions(records);
+        size_t frames = 0;
+        for (const ReplaySession& session : sessions) {
+            frames += session.frames.size();
+        }
+        std::cerr << "Replay: " << sessions.size() << " sessions, " << frames << " frames x " << options.copies
+                  << " copies at " << (options.speed == 0.0 ? std::string("max") : std::to_string(options.speed))
+                  << " speed on " << options.threads << " thread(s)\n";
+
+        ReplayProfile profile;
+        in_addr addr{};
+        if (::inet_pton(AF_INET, options.host.c_str(), &addr) != 1) {
+            throw std::runtime_error("invalid IPv4 address " + options.host);
+        }
+        profile.address = ntohl(addr.s_addr);
+        profile.port = options.port;
+        profile.speed = options.speed;
+        profile.copies = options.copies;
+        profile.max_concurrent = std::max<size_t>(1, options.max_concurrent / static_cast<size_t>(options.threads));
+        profile.linger = std::chrono::milliseconds(options.linger_ms);
+        profile.timeout = std::chrono::milliseconds(options.timeout_ms);
+        profile.reset_on_close = options.reset_on_close;
+
+        // Workers split the session copies round-robin and run independent reactors.
+        std::vector<ReplayStats> results(static_cast<size_t>(options.threads));
+        std::vector<std::thread> workers;
+        for (int t = 0; t < options.threads; ++t) {
+            workers.emplace_back([&, t] {
+                ReplayEngine engine(profile, sessions, static_cast<size_t>(t), static_cast<size_t>(options.threads));
+                results[static_cast<size_t>(t)] = engine.run();
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        ReplayStats total;
+        for (const ReplayStats& result : results) {
+            total.merge(result);
+        }
+        total.print(std::cout);
+        if (!options.json_path.empty()) {
+            std::ofstream out(options.json_path);
+            total.writeJson(out);
+        }
+        if (!options.baseline_path.empty()) {
+            printBaseline(total, options.baseline_path);
+        }
+        return total.totalErrors() == 0 ? 0 : 2;
+    } catch (const std::exception& ex) {
+        std::cerr << "Replay failed: " << ex.what() << '\n' << kUsage;
+        return 1;
+    }
+}
@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) DarkEmu
+ * Replays captured client sessions against a test server.
+ */
+
+#include "Tools/ReplayEngine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace {
+
+// Print one latency line in microseconds.
+void printLatency(std::ostream& out, const char* label, const LatencyHistogram& h) {
+    out << "  " << std::left << std::setw(9) << label << std::right << " n=" << h.count() << " p50=" << h.percentile(0.50)
+        << "us p99=" << h.percentile(0.99) << "us p999=" << h.percentile(0.999) << "us max=" << h.max() << "us\n";
+}
+
+// Write one latency object for the JSON report.
+void writeLatencyJson(std::ostream& out, const LatencyHistogram& h) {
+    out << "{\"count\": " << h.count() << ", \"p50_us\": " << h.percentile(0.50) << ", \"p99_us\": "
+        << h.percentile(0.99) << ", \"p999_us\": " << h.percentile(0.999) << ", \"max_us\": " << h.max() << '}';
+}
+
+} // namespace
+
+std::vector<ReplaySession> buildReplaySessions(const std::vector<CaptureRecord>& records) {
+    std::map<uint32_t, ReplaySession> by_id;
+    std::map<uint32_t, uint64_t> opened_at;
+    uint64_t first_open = UINT64_MAX;
+    for (const CaptureRecord& record : records) {
+        if (record.type == CaptureRecordType::Open) {
+            ReplaySession& session = by_id[record.session];
+            session.id = record.session;
+            opened_at[record.session] = record.timestamp_us;
+            first_open = std::min(first_open, record.timestamp_us);
+            continue;
+        }
+        auto open = opened_at.find(record.session);
+        if (open == opened_at.end()) {
+            continue;
+        }
+        ReplaySession& session = by_id[record.session];
+        const uint64_t offset = record.timestamp_us - open->second;
+        switch (record.type) {
+        case CaptureRecordType::ClientData:
+            session.frames.push_back(ReplayFrame{offset, record.payload});
+            session.close_offset_us = std::max(session.close_offset_us, offset);
+            break;
+        case CaptureRecordType::ServerData:
+            if (session.frames.empty()) {
+                session.server_first = true;
+            }
+            break;
+        case CaptureRecordType::Close:
+            session.close_offset_us = std::max(session.close_offset_us, offset);
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::vector<ReplaySession> sessions;
+    sessions.reserve(by_id.size());
+    for (auto& [id, session] : by_id) {
+        session.open_us = opened_at[id] - first_open;
+        sessions.push_back(std::move(session));
+    }
+    std::stable_sort(sessions.begin(), sessions.end(),
+                     [](const ReplaySession& a, const ReplaySession& b) { return a.open_us < b.open_us; });
+    return sessions;
+}
+
+void ReplayStats::merge(const ReplayStats& other) {
+    sessions += other.sessions;
+    completed += other.completed;
+    frames_sent += other.frames_sent;
+    bytes_sent += other.bytes_sent;
+    bytes_received += other.bytes_received;
+    elapsed = std::max(elapsed, other.elapsed);
+    for (size_t i = 0; i < errors.size(); ++i) {
+        errors[i] += other.errors[i];
+    }
+    connect_us.merge(other.connect_us);
+    response_us.merge(other.response_us);
+    lag_us.merge(other.lag_us);
+}
+
+uint64_t ReplayStats::totalErrors() const noexcept {
+    uint64_t total = 0;
+    for (uint64_t count : errors) {
+        total += count;
+    }
+    return total;
+}
+
+void ReplayStats::print(std::ostream& out) const {
+    const double seconds = std::max(1e-9, std::chrono::duration<double>(elapsed).count());
+    const std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "elapsed " << seconds << "s, sessions " << sessions << " started / " << completed << " completed\n";
+    out << "  frames/sec " << static_cast<double>(frames_sent) / seconds << ", sent " << bytes_sent << " B ("
+        << static_cast<double>(bytes_sent) / seconds / 1024.0 << " KB/s), received " << bytes_received << " B\n";
+    printLatency(out, "connect", connect_us);
+    printLatency(out, "response", response_us);
+    printLatency(out, "lag", lag_us);
+    out << "  errors " << totalErrors();
+    for (size_t i = 0; i < errors.size(); ++i) {
+        if (errors[i] != 0) {
+            out << ' ' << loadErrorName(static_cast<LoadError>(i)) << '=' << errors[i];
+        }
+    }
+    out << '\n';
+    out.flags(flags);
+}
+
+void ReplayStats::writeJson(std::ostream& out) const {
+    const double seconds = std::max(1e-9, std::chrono::duration<double>(elapsed).count());
+    const std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"elapsed_s\": " << seconds << ",\n  \"sessions\": " << sessions << ",\n  \"completed\": "
+        << completed << ",\n  \"frames_sent\": " << frames_sent << ",\n  \"bytes_sent\": " << bytes_sent
+        << ",\n  \"bytes_received\": " << bytes_received << ",\n  \"frames_per_sec\": "
+        << static_cast<double>(frames_sent) / seconds << ",\n  \"bytes_per_sec\": "
+        << static_cast<double>(bytes_sent) / seconds << ",\n  \"connect\": ";
+    writeLatencyJson(out, connect_us);
+    out << ",\n  \"response\": ";
+    writeLatencyJson(out, response_us);
+    out << ",\n  \"lag\": ";
+    writeLatencyJson(out, lag_us);
+    out << ",\n  \"errors\": {";
+    for (size_t i = 0; i < errors.size(); ++i) {
+        out << (i == 0 ? "" : ", ") << '"' << loadErrorName(static_cast<LoadError>(i)) << "\": " << errors[i];
+    }
+    out << "}\n}\n";
+    out.flags(flags);
+}
+
+ReplayEngine::ReplayEngine(ReplayProfile profile, const std::vector<ReplaySession>& sessions, size_t worker,
+                           size_t workers) :
+    profile_(profile), events_(1024) {
+    if (profile_.speed < 0.0) {
+        throw std::runtime_error("replay speed must not be negative");
+    }
+    if (workers == 0 || worker >= workers) {
+        throw std::runtime_error("invalid replay worker index");
+    }
+    // Copies of a session start together; sessions keep their captured order.
+    size_t index = 0;
+    for (const ReplaySession& session : sessions) {
+        for (size_t copy = 0; copy < profile_.copies; ++copy, ++index) {
+            if (index % workers == worker) {
+                assigned_.emplace_back(&session, copy);
+            }
+        }
+    }
+}
+
+ReplayEngine::Clock::time_point ReplayEngine::dueAt(const Conn& conn, uint64_t offset_us) const {
+    if (profile_.speed == 0.0) {
+        return conn.base;
+    }
+    return conn.base + std::chrono::microseconds(static_cast<int64_t>(static_cast<double>(offset_us) / profile_.speed));
+}
+
+ReplayStats ReplayEngine::run() {
+    const Clock::time_point start = Clock::now();
+    const bool max_speed = profile_.speed == 0.0;
+    size_t cursor = 0;
+    Clock::time_point next_sweep = start;
+
+    while (cursor < assigned_.size() || !conns_.empty()) {
+        const Clock::time_point now = Clock::now();
+
+        // Start sessions at their scaled capture time, or as fast as the concurrency cap allows.
+        while (cursor < assigned_.size()) {
+            const ReplaySession& session = *assigned_[cursor].first;
+            Clock::time_point base = now;
+            if (max_speed) {
+                if (conns_.size() >= profile_.max_concurrent) {
+                    break;
+                }
+            } else {
+                base = start + std::chrono::microseconds(
+                                       static_cast<int64_t>(static_cast<double>(session.open_us) / profile_.speed));
+                if (base > now) {
+                    break;
+                }
+            }
+            startSession(session, base);
+            ++cursor;
+        }
+
+        fireTimers(now);
+        const int ready = epoll_.wait(events_, 1);
+        for (int i = 0; i < ready; ++i) {
+            handleEvent(events_[static_cast<size_t>(i)]);
+        }
+        if (static_cast<size_t>(ready) == events_.size()) {
+            events_.resize(events_.size() * 2);
+        }
+        if (now >= next_sweep) {
+            sweep(now);
+            next_sweep = now + std::chrono::milliseconds(5);
+        }
+    }
+    stats_.elapsed = Clock::now() - start;
+    return stats_;
+}
+
+void ReplayEngine::startSession(const ReplaySession& session, Clock::time_point base) {
+    ++stats_.sessions;
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        ++stats_.errors[static_cast<size_t>(LoadError::SocketLimit)];
+        return;
+    }
+    Socket socket(fd);
+    if (profile_.reset_on_close) {
+        linger option{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &option, sizeof(option));
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(profile_.port);
+    addr.sin_addr.s_addr = htonl(profile_.address);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 && errno != EINPROGRESS) {
+        ++stats_.errors[static_cast<size_t>(errno == ECONNREFUSED ? LoadError::ConnectRefused
+                                                                  : LoadError::ConnectFailed)];
+        return;
+    }
+
+    epoll_.add(fd, EPOLLOUT | EPOLLIN | EPOLLRDHUP);
+    Conn conn;
+    conn.id = next_id_++;
+    conn.session = &session;
+    conn.socket = std::move(socket);
+    conn.base = base;
+    conn.deadline = Clock::now() + profile_.timeout;
+    conns_.emplace(fd, std::move(conn));
+}
+
+void ReplayEngine::handleEvent(const epoll_event& event) {
+    const int fd = event.data.fd;
+    auto it = conns_.find(fd);
+    if (it == conns_.end()) {
+        return;
+    }
+    Conn& conn = it->second;
+
+    if (conn.phase == Phase::Connecting) {
+        if ((event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) == 0) {
+            return;
+        }
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1) {
+            err = errno;
+        }
+        if (err != 0) {
+            finish(fd, err == ECONNREFUSED ? LoadError::ConnectRefused
+                       : err == ETIMEDOUT  ? LoadError::ConnectTimeout
+                                           : LoadError::ConnectFailed);
+            return;
+        }
+        stats_.connect_us.record(microsBetween(conn.base, Clock::now()));
+        epoll_.modify(fd, EPOLLIN | EPOLLRDHUP);
+        if (conn.session->server_first) {
+            conn.phase = Phase::WaitingServer;
+            conn.deadline = Clock::now() + profile_.timeout;
+        } else {
+            beginSending(fd, conn);
+            if (conns_.find(fd) == conns_.end()) {
+                return;
+            }
+        }
+    }
+
+    // Flush queued frames once the socket drains.
+    if ((event.events & EPOLLOUT) && !conn.outbound.empty()) {
+        const ssize_t sent = conn.socket.send(conn.outbound, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.outbound.erase(conn.outbound.begin(), conn.outbound.begin() + sent);
+        } else if (sent == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            finish(fd, errno == ECONNRESET || errno == EPIPE ? LoadError::Reset : LoadError::PeerClosed);
+            return;
+        }
+        if (conn.outbound.empty()) {
+            epoll_.modify(fd, EPOLLIN | EPOLLRDHUP);
+        }
+    }
+
+    if ((event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) == 0) {
+        return;
+    }
+    std::array<uint8_t, 4096> temp{};
+    bool closed = false;
+    bool received = false;
+    while (true) {
+        const ssize_t bytes = conn.socket.recv(temp);
+        if (bytes > 0) {
+            stats_.bytes_received += static_cast<uint64_t>(bytes);
+            received = true;
+            continue;
+        }
+        if (bytes == 0) {
+            closed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        finish(fd, errno == ECONNRESET ? LoadError::Reset : LoadError::PeerClosed);
+        return;
+    }
+
+    if (received) {
+        // The first server bytes after a frame answer it.
+        if (conn.awaiting) {
+            stats_.response_us.record(microsBetween(conn.sent_at, Clock::now()));
+            conn.awaiting = false;
+        }
+        if (conn.phase == Phase::WaitingServer) {
+            beginSending(fd, conn);
+            if (conns_.find(fd) == conns_.end()) {
+                return;
+            }
+        }
+    }
+
+    if (closed) {
+        // A server that closes after the last frame (ConnectServer) ends the session cleanly.
+        const bool done = conn.next_frame >= conn.session->frames.size() && conn.outbound.empty();
+        finish(fd, done ? LoadError::Count : LoadError::PeerClosed);
+    }
+}
+
+void ReplayEngine::beginSending(int fd, Conn& conn) {
+    conn.phase = Phase::Sending;
+    pump(fd, conn, Clock::now());
+}
+
+void ReplayEngine::pump(int fd, Conn& conn, Clock::time_point now) {
+    const std::vector<ReplayFrame>& frames = conn.session->frames;
+    while (conn.next_frame < frames.size()) {
+        const ReplayFrame& frame = frames[conn.next_frame];
+        const Clock::time_point due = dueAt(conn, frame.offset_us);
+        if (due > now) {
+            timers_.push(Timer{due, conn.id, fd});
+            return;
+        }
+        if (profile_.speed != 0.0) {
+            stats_.lag_us.record(microsBetween(due, now));
+        }
+        if (!write(fd, conn, frame.bytes)) {
+            return;
+        }
+        ++conn.next_frame;
+        ++stats_.frames_sent;
+        stats_.bytes_sent += frame.bytes.size();
+        conn.sent_at = now;
+        conn.awaiting = true;
+    }
+
+    // All frames sent: hold the connection until its captured close (or a short linger at max speed).
+    conn.phase = Phase::Lingering;
+    conn.deadline = profile_.speed == 0.0 ? now + profile_.linger
+                                          : std::max(now, dueAt(conn, conn.session->close_offset_us));
+}
+
+bool ReplayEngine::write(int fd, Conn& conn, const std::vector<uint8_t>& bytes) {
+    if (!conn.outbound.empty()) {
+        conn.outbound.insert(conn.outbound.end(), bytes.begin(), bytes.end());
+        return true;
+    }
+    const ssize_t sent = conn.socket.send(bytes, MSG_NOSIGNAL);
+    if (sent == static_cast<ssize_t>(bytes.size())) {
+        return true;
+    }
+    if (sent >= 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        conn.outbound.assign(bytes.begin() + std::max<ssize_t>(sent, 0), bytes.end());
+        epoll_.modify(fd, EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+        return true;
+    }
+    finish(fd, errno == ECONNRESET || errno == EPIPE ? LoadError::Reset : LoadError::PeerClosed);
+    return false;
+}
+
+void ReplayEngine::fireTimers(Clock::time_point now) {
+    while (!timers_.empty() && timers_.top().due <= now) {
+        const Timer timer = timers_.top();
+        timers_.pop();
+        auto it = conns_.find(timer.fd);
+        if (it == conns_.end() || it->second.id != timer.id || it->second.phase != Phase::Sending) {
+            continue;
+        }
+        pump(timer.fd, it->second, now);
+    }
+}
+
+void ReplayEngine::sweep(Clock::time_point now) {
+    std::vector<std::pair<int, LoadError>> expired;
+    for (const auto& [fd, conn] : conns_) {
+        if (conn.phase == Phase::Sending || now < conn.deadline) {
+            continue;
+        }
+        switch (conn.phase) {
+        case Phase::Connecting:
+            expired.emplace_back(fd, LoadError::ConnectTimeout);
+            break;
+        case Phase::WaitingServer:
+            expired.emplace_back(fd, LoadError::ResponseTimeout);
+            break;
+        default:
+            // Linger finished; unsent queued bytes still count as a clean close.
+            expired.emplace_back(fd, LoadError::Count);
+            break;
+        }
+    }
+    for (const auto& [fd, error] : expired) {
+        finish(fd, error);
+    }
+}
+
+void ReplayEngine::finish(int fd, LoadError error) {
+    auto it = conns_.find(fd);
+    if (it == conns_.end()) {
+        return;
+    }
+    if (error == LoadError::Count) {
+        ++stats_.completed;
+    } else {
+        ++stats_.errors[static_cast<size_t>(error)];
+    }
+    epoll_.remove(fd);
+    conns_.erase(it);
+}